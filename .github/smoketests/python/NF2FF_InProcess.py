@@ -0,0 +1,92 @@
+"""
+ Short dipole with a far-field calculated during the simulation
+
+ Compares the far-field of an nf2ff box with far_field settings (calculated
+ in openEMS) with the far-field of a regular frequency domain nf2ff box
+ (calculated from the surface field dumps after the simulation).
+"""
+
+### Import Libraries
+import os, tempfile
+
+from numpy import *
+
+from CSXCAD  import ContinuousStructure
+from openEMS import openEMS
+from openEMS.physical_constants import *
+
+### Setup the simulation
+Sim_Path = os.path.join(tempfile.gettempdir(), 'NF2FF_InProcess')
+
+unit = 1e-3 # specify everything in mm
+f0 = 1e9
+dipole_length = 100
+feed_gap = 2
+box_size = 200
+
+theta = arange(0, 181, 10)
+phi   = array([0, 90])
+
+### Setup FDTD parameters & excitation function
+
+# It's only a smoke test, terminate as soon as possible, otherwise we waste
+# CPU time on GitHub Actions (especially for emulated ARM64 systems).
+FDTD = openEMS(NrTS=2000)
+
+FDTD.SetGaussExcite( f0, f0/2 )
+FDTD.SetBoundaryCond( ['PML_8']*6 )
+
+### Setup Geometry & Mesh
+CSX = ContinuousStructure()
+FDTD.SetCSX(CSX)
+mesh = CSX.GetGrid()
+mesh.SetDeltaUnit(unit)
+
+resolution = C0/(f0*1.5)/unit/20 # resolution of lambda/20
+for ny in 'xy':
+    mesh.AddLine(ny, [-box_size, 0, box_size])
+mesh.AddLine('z', [-box_size, -feed_gap/2, feed_gap/2, box_size])
+mesh.AddLine('z', [-dipole_length/2, dipole_length/2])
+mesh.SmoothMeshLines('all', resolution, 1.4)
+
+## dipole arms and feeding port
+pec = CSX.AddMetal( 'PEC' )
+pec.AddBox([0, 0, -dipole_length/2], [0, 0, -feed_gap/2], priority=10)
+pec.AddBox([0, 0,  feed_gap/2], [0, 0,  dipole_length/2], priority=10)
+
+port = FDTD.AddLumpedPort(1, 50, [0, 0, -feed_gap/2], [0, 0, feed_gap/2], 'z', 1, priority=5)
+
+## nf2ff boxes, one post-processed and one calculated during the simulation
+nf2ff_post = FDTD.CreateNF2FFBox(name='nf2ff_post', frequency=f0)
+nf2ff_run  = FDTD.CreateNF2FFBox(name='nf2ff_run', frequency=f0, far_field=dict(theta=theta, phi=phi))
+
+FDTD.Run(Sim_Path, cleanup=True)
+
+### Post-processing
+res_post = nf2ff_post.CalcNF2FF(Sim_Path, f0, theta, phi)
+res_run  = nf2ff_run.CalcNF2FF(Sim_Path, f0, theta, phi)
+
+E_max = abs(res_post.E_norm[0]).max()
+assert E_max>0, 'no far-field found'
+for name in ['E_theta', 'E_phi']:
+    E_post = getattr(res_post, name)[0]
+    E_run  = getattr(res_run, name)[0]
+    err = abs(E_post-E_run).max()/E_max
+    assert err<1e-3, '{} of the in-process far-field does not match (max. rel. error {})'.format(name, err)
+assert abs(res_post.Prad[0]-res_run.Prad[0])/res_post.Prad[0]<1e-3, 'radiated power does not match'
+
+# far-field settings that differ from the simulation setup must be rejected
+for kw in [dict(outfile='other.h5'), dict(center=[0, 0, 10]), dict(radius=2)]:
+    try:
+        nf2ff_run.CalcNF2FF(Sim_Path, f0, theta, phi, **kw)
+    except Exception:
+        continue
+    raise AssertionError('CalcNF2FF did not reject the mismatching argument {}'.format(kw))
+try:
+    nf2ff_run.CalcNF2FF(Sim_Path, f0, theta[1:], phi)
+except Exception:
+    pass
+else:
+    raise AssertionError('CalcNF2FF did not reject the mismatching theta angles')
+
+print('NF2FF_InProcess: pass')
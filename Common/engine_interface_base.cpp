@@ -24,6 +24,64 @@ Engine_Interface_Base::Engine_Interface_Base(Operator_Base* base_op)
 	m_InterpolType = NO_INTERPOLATION;
 }
 
+double* Engine_Interface_Base::GetField(FieldType type, const unsigned int* pos, double* out) const
+{
+	switch (type)
+	{
+	case E_FIELD:
+		return GetEField(pos, out);
+	case H_FIELD:
+		return GetHField(pos, out);
+	case J_FIELD:
+		return GetJField(pos, out);
+	case ROTH_FIELD:
+		return GetRotHField(pos, out);
+	case D_FIELD:
+		return GetDField(pos, out);
+	case B_FIELD:
+		return GetBField(pos, out);
+	}
+	return out;
+}
+
+void Engine_Interface_Base::SetFieldBox(unsigned int const* numLines, unsigned int const* const* posLines)
+{
+	for (int n=0; n<3; ++n)
+		m_BoxLines[n].assign(posLines[n], posLines[n]+numLines[n]);
+}
+
+bool Engine_Interface_Base::GetFieldLine(FieldType type, unsigned int i, unsigned int j, FDTD_FLOAT* line[3]) const
+{
+	// generic point by point access, engine interfaces should overload this with a faster bulk access
+	if ((i>=m_BoxLines[0].size()) || (j>=m_BoxLines[1].size()))
+		return false;
+	unsigned int pos[3] = {m_BoxLines[0][i], m_BoxLines[1][j], 0};
+	double out[3];
+	for (size_t k=0; k<m_BoxLines[2].size(); ++k)
+	{
+		pos[2] = m_BoxLines[2][k];
+		GetField(type, pos, out);
+		line[0][k] = out[0];
+		line[1][k] = out[1];
+		line[2][k] = out[2];
+	}
+	return true;
+}
+
+bool Engine_Interface_Base::GetFieldBox(FieldType type, FDTD_FLOAT**** field) const
+{
+	FDTD_FLOAT* line[3];
+	for (unsigned int i=0; i<m_BoxLines[0].size(); ++i)
+		for (unsigned int j=0; j<m_BoxLines[1].size(); ++j)
+		{
+			for (int n=0; n<3; ++n)
+				line[n] = field[n][i][j];
+			if (GetFieldLine(type, i, j, line)==false)
+				return false;
+		}
+	return true;
+}
+
 std::string Engine_Interface_Base::GetInterpolationNameByType(InterpolationType mode)
 {
 	switch (mode)
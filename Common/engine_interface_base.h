@@ -19,6 +19,9 @@
 #define ENGINE_INTERFACE_BASE_H
 
 #include "tools/global.h"
+#include "tools/constants.h"
+
+#include <vector>
 
 class Operator_Base;
 
@@ -31,6 +34,8 @@ class Engine_Interface_Base
 {
 public:
 	enum InterpolationType { NO_INTERPOLATION, NODE_INTERPOLATE, CELL_INTERPOLATE };
+	//! Field types of the bulk field access \sa GetFieldLine
+	enum FieldType { E_FIELD, H_FIELD, J_FIELD, ROTH_FIELD, D_FIELD, B_FIELD };
 
 	virtual ~Engine_Interface_Base() {;} //!< provide a virtual destructor to correctly delete derived objects
 
@@ -61,6 +66,20 @@ public:
 	//! Get the (interpolated) magnetic flux density field at \p pos. \sa SetInterpolationType
 	virtual double* GetBField(const unsigned int* pos, double* out) const =0;
 
+	//! Get the (interpolated) field of the given \a type at \p pos. \sa SetInterpolationType
+	double* GetField(FieldType type, const unsigned int* pos, double* out) const;
+
+	//! Define the box for the bulk field access, given by the lines \a posLines[n][0..numLines[n]-1] in each direction (e.g. a sub-sampled field dump).
+	/*!
+	  Everything needed for the current interpolation type is calculated once, e.g. the interpolation weights.
+	  \sa GetFieldLine GetFieldBox
+	  */
+	virtual void SetFieldBox(unsigned int const* numLines, unsigned int const* const* posLines);
+	//! Get the (interpolated) field of the given \a type along the z-line (\a i,\a j) of the field box into \a line (one array of numLines[2] values per component). Thread-safe. \sa SetFieldBox
+	virtual bool GetFieldLine(FieldType type, unsigned int i, unsigned int j, FDTD_FLOAT* line[3]) const;
+	//! Get the (interpolated) field of the given \a type in the whole field box into \a field[n][i][j][k]. \sa SetFieldBox
+	bool GetFieldBox(FieldType type, FDTD_FLOAT**** field) const;
+
 	//! Calculate the electric field integral along a given line
 	virtual double CalcVoltageIntegral(const unsigned int* start, const unsigned int* stop) const =0;
 
@@ -73,6 +92,9 @@ public:
 	//! Get the current number of timesteps
 	virtual unsigned int GetNumberOfTimesteps() const =0;
 
+	//! Get the number of worker threads of the engine. These threads are idle during processing and the processing may use as many threads.
+	virtual unsigned int GetNumberOfThreads() const {return 1;}
+
 	//! Calc (roughly) the total energy
 	/*!
 	  This method only calculates a very rough estimate of the total energy in the simulation domain.
@@ -87,6 +109,9 @@ protected:
 	Operator_Base* m_Op_Base;
 
 	InterpolationType m_InterpolType;
+
+	//! lines of the field box in each direction \sa SetFieldBox
+	std::vector<unsigned int> m_BoxLines[3];
 };
 
 #endif // ENGINE_INTERFACE_BASE_H
@@ -74,19 +74,35 @@ void ProcessFieldProbe::SetFieldType(int type)
 	m_ModeFieldType = type;
 }
 
+void ProcessFieldProbe::InitProcess()
+{
+	ProcessIntegral::InitProcess();
+	if (!Enabled) return;
+
+	// the probe is a single point field box
+	m_Eng_Interface->SetInterpolationType(Engine_Interface_Base::NO_INTERPOLATION);
+	unsigned int numLines[3] = {1,1,1};
+	unsigned int const* posLines[3] = {&start[0],&start[1],&start[2]};
+	m_Eng_Interface->SetFieldBox(numLines, posLines);
+}
+
 double* ProcessFieldProbe::CalcMultipleIntegrals()
 {
 	m_Eng_Interface->SetInterpolationType(Engine_Interface_Base::NO_INTERPOLATION);
 
+	FDTD_FLOAT value[3];
+	FDTD_FLOAT* line[3] = {&value[0],&value[1],&value[2]};
 	switch (m_ModeFieldType)
 	{
 	case 0:
 	default:
-		m_Eng_Interface->GetEField(start,m_Results);
+		m_Eng_Interface->GetFieldLine(Engine_Interface_Base::E_FIELD, 0, 0, line);
 		break;
 	case 1:
-		m_Eng_Interface->GetHField(start,m_Results);
+		m_Eng_Interface->GetFieldLine(Engine_Interface_Base::H_FIELD, 0, 0, line);
 		break;
 	}
+	for (int n=0; n<3; ++n)
+		m_Results[n] = value[n];
 	return m_Results;
 }
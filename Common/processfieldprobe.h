@@ -30,6 +30,8 @@ public:
 
 	virtual std::string GetIntegralName(int row) const;
 
+	virtual void InitProcess();
+
 	//! Set the field type (0 electric field, 1 magnetic field)
 	void SetFieldType(int type);
 
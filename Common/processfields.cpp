@@ -16,12 +16,15 @@
 */
 
 #include <iomanip>
+#include <algorithm>
 #include "tools/global.h"
 #include "tools/vtk_file_writer.h"
 #include "tools/hdf5_file_writer.h"
 #include "processfields.h"
 #include "FDTD/engine_interface_fdtd.h"
 
+namespace po = boost::program_options;
+
 ProcessFields::ProcessFields(Engine_Interface_Base* eng_if) : Processing(eng_if)
 {
 	m_DumpType = E_FIELD_DUMP;
@@ -30,6 +33,10 @@ ProcessFields::ProcessFields(Engine_Interface_Base* eng_if) : Processing(eng_if)
 	m_SampleType = NONE;
 	m_Vtk_Dump_File = NULL;
 	m_HDF5_Dump_File = NULL;
+	m_FileOutput = true;
+#ifdef MPI_SUPPORT
+	m_MPI_Comm = MPI_COMM_NULL;
+#endif
 	SetPrecision(6);
 	m_dualTime = false;
 
@@ -57,6 +64,12 @@ ProcessFields::~ProcessFields()
 		delete[] discLines[n];
 		discLines[n]=NULL;
 	}
+#ifdef MPI_SUPPORT
+	int finalized = 0;
+	MPI_Finalized(&finalized);
+	if ((m_MPI_Comm!=MPI_COMM_NULL) && !finalized)
+		MPI_Comm_free(&m_MPI_Comm);
+#endif
 }
 
 string ProcessFields::GetFieldNameByType(DumpType type)
@@ -123,11 +136,32 @@ bool ProcessFields::NeedPermeability() const
 	return false;
 }
 
+po::options_description ProcessFields::optionDesc()
+{
+	po::options_description optdesc("Field dump arguments");
+	optdesc.add_options()
+		(
+			"fieldDumpCompression",
+			po::value<int>()->default_value(0),
+			"Deflate compression level (1-9) of chunked hdf5 field dumps, 0 to disable compression"
+		)
+		(
+			"extendibleTDFieldDumps",
+			po::bool_switch(),
+			"Write all hdf5 time domain field dumps into the single extendible dataset /FieldData/TD/values instead of one dataset per timestep"
+		);
+	return optdesc;
+}
+
 void ProcessFields::InitProcess()
 {
 	if (Enabled==false) return;
 
 	CalcMeshPos();
+	m_Eng_Interface->SetFieldBox(numLines, posLines);
+
+	if (m_FileOutput==false)
+		return;
 
 	if (m_fileType==VTK_FILETYPE)
 	{
@@ -145,19 +179,137 @@ void ProcessFields::InitProcess()
 	if (m_fileType==HDF5_FILETYPE)
 	{
 		delete m_HDF5_Dump_File;
+		unsigned int* meshNumLines = numLines;
+		double* meshLines[3] = {discLines[0], discLines[1], discLines[2]};
+#ifdef HDF5_PARALLEL_DUMPS
+		unsigned int localSize[3], globalSize[3], offset[3];
+		vector<double> globalLines[3];
+		if ((m_MPI_Comm!=MPI_COMM_NULL) && !CalcCollectiveDomain(localSize, globalSize, offset, globalLines))
+		{
+			// fall back to one file per rank
+			int commRank, rank;
+			MPI_Comm_rank(m_MPI_Comm, &commRank);
+			MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+			if (commRank==0)
+				cerr << "ProcessFields::InitProcess: Warning: the dump mesh of " << m_Name << " is inconsistent between the ranks, every rank writes its own file..." << endl;
+			MPI_Comm_free(&m_MPI_Comm);
+			m_MPI_Comm = MPI_COMM_NULL;
+			stringstream name_ss;
+			name_ss << "ID" << rank << "_" << m_Name;
+			SetName(name_ss.str());
+			SetFileName(name_ss.str());
+		}
+		if (m_MPI_Comm!=MPI_COMM_NULL)
+		{
+			// all ranks of this dump write into one file, the mesh is the global dump mesh
+			m_HDF5_Dump_File = new HDF5_File_Writer(m_filename+".h5", m_MPI_Comm);
+			m_HDF5_Dump_File->SetDomain(localSize, globalSize, offset);
+			meshNumLines = globalSize;
+			for (int n=0; n<3; ++n)
+				meshLines[n] = &globalLines[n][0];
+		}
+		else
+#endif
 		m_HDF5_Dump_File = new HDF5_File_Writer(m_filename+".h5");
+		if (g_settings.hasOption("fieldDumpCompression"))
+			m_HDF5_Dump_File->SetCompression(g_settings.getOption("fieldDumpCompression").as<int>());
 
 		#ifdef OUTPUT_IN_DRAWINGUNITS
 		double discScaling = 1;
 		#else
 		double discScaling = Op->GetGridDelta();
 		#endif
-		m_HDF5_Dump_File->WriteRectMesh(numLines,discLines,(int)m_Mesh_Type,discScaling);
+		m_HDF5_Dump_File->WriteRectMesh(meshNumLines,meshLines,(int)m_Mesh_Type,discScaling);
 
 		m_HDF5_Dump_File->WriteAtrribute("/","openEMS_HDF5_version",0.2);
 	}
 }
 
+bool ProcessFields::IsCollectiveDump() const
+{
+#ifdef MPI_SUPPORT
+	return m_MPI_Comm!=MPI_COMM_NULL;
+#else
+	return false;
+#endif
+}
+
+#ifdef MPI_SUPPORT
+bool ProcessFields::SupportsCollectiveDump() const
+{
+#ifdef HDF5_PARALLEL_DUMPS
+	return (m_fileType==HDF5_FILETYPE) && m_FileOutput;
+#else
+	return false;
+#endif
+}
+
+bool ProcessFields::CalcCollectiveDomain(unsigned int* localSize, unsigned int* globalSize, unsigned int* offset, vector<double>* globalLines) const
+{
+	int numProc = 0;
+	int myRank = 0;
+	MPI_Comm_size(m_MPI_Comm, &numProc);
+	MPI_Comm_rank(m_MPI_Comm, &myRank);
+	int valid = 1;
+	for (int n=0; n<3; ++n)
+	{
+		// gather the dump lines of all ranks in this direction
+		int num = numLines[n];
+		vector<int> counts(numProc), displ(numProc, 0);
+		MPI_Allgather(&num, 1, MPI_INT, &counts[0], 1, MPI_INT, m_MPI_Comm);
+		for (int r=1; r<numProc; ++r)
+			displ[r] = displ[r-1] + counts[r-1];
+		vector<double> lines(displ[numProc-1] + counts[numProc-1]);
+		MPI_Allgatherv(discLines[n], num, MPI_DOUBLE, &lines[0], &counts[0], &displ[0], MPI_DOUBLE, m_MPI_Comm);
+
+		// a rank owns all its lines below the first line of the next upper rank, the global mesh is the union of all owned lines
+		globalLines[n].clear();
+		localSize[n] = 0;
+		for (int r=0; r<numProc; ++r)
+		{
+			if (counts[r]==0)
+				continue;
+			double first = lines[displ[r]];
+			bool hasUpper = false;
+			double cutoff = 0;
+			for (int q=0; q<numProc; ++q)
+				if ((counts[q]>0) && (lines[displ[q]]>first) && (!hasUpper || (lines[displ[q]]<cutoff)))
+				{
+					cutoff = lines[displ[q]];
+					hasUpper = true;
+				}
+			int owned = 0;
+			while ((owned<counts[r]) && (!hasUpper || (lines[displ[r]+owned]<cutoff)))
+				globalLines[n].push_back(lines[displ[r]+owned++]);
+			if (r==myRank)
+				localSize[n] = owned;
+		}
+		sort(globalLines[n].begin(), globalLines[n].end());
+		globalLines[n].erase(unique(globalLines[n].begin(), globalLines[n].end()), globalLines[n].end());
+		globalSize[n] = globalLines[n].size();
+
+		// the owned lines have to be contiguous in the global mesh
+		offset[n] = 0;
+		if (localSize[n]==0)
+			continue;
+		offset[n] = lower_bound(globalLines[n].begin(), globalLines[n].end(), discLines[n][0]) - globalLines[n].begin();
+		for (unsigned int i=0; i<localSize[n]; ++i)
+			if ((offset[n]+i>=globalSize[n]) || (globalLines[n][offset[n]+i]!=discLines[n][i]))
+				valid = 0;
+	}
+	int allValid = 0;
+	MPI_Allreduce(&valid, &allValid, 1, MPI_INT, MPI_MIN, m_MPI_Comm);
+	return allValid>0;
+}
+#endif
+
+void ProcessFields::PostProcess()
+{
+	Processing::PostProcess();
+	if (m_HDF5_Dump_File)
+		m_HDF5_Dump_File->Close();
+}
+
 void ProcessFields::SetDumpMode(Engine_Interface_Base::InterpolationType mode)
 {
 	m_Eng_Interface->SetInterpolationType(mode);
@@ -277,131 +429,50 @@ void ProcessFields::CalcMeshPos()
 	}
 }
 
-FDTD_FLOAT**** ProcessFields::CalcField()
+FDTD_FLOAT**** ProcessFields::CalcField(FDTD_FLOAT**** field)
 {
-	unsigned int pos[3];
-	double out[3];
 	//create array
-	FDTD_FLOAT**** field = Create_N_3DArray<FDTD_FLOAT>(numLines);
+	if (field==NULL)
+		field = Create_N_3DArray<FDTD_FLOAT>(numLines);
+	FDTD_FLOAT* line[3];
+	for (unsigned int i=0; i<numLines[0]; ++i)
+		for (unsigned int j=0; j<numLines[1]; ++j)
+		{
+			for (int n=0; n<3; ++n)
+				line[n] = field[n][i][j];
+			if (CalcFieldLine(i, j, line)==false)
+				return field;
+		}
+	return field;
+}
+
+bool ProcessFields::CalcFieldLine(unsigned int i, unsigned int j, FDTD_FLOAT* line[3]) const
+{
+	Engine_Interface_Base::FieldType type;
 	switch (m_DumpType)
 	{
 	case E_FIELD_DUMP:
-		for (unsigned int i=0; i<numLines[0]; ++i)
-		{
-			pos[0]=posLines[0][i];
-			for (unsigned int j=0; j<numLines[1]; ++j)
-			{
-				pos[1]=posLines[1][j];
-				for (unsigned int k=0; k<numLines[2]; ++k)
-				{
-					pos[2]=posLines[2][k];
-
-					m_Eng_Interface->GetEField(pos,out);
-					field[0][i][j][k] = out[0];
-					field[1][i][j][k] = out[1];
-					field[2][i][j][k] = out[2];
-				}
-			}
-		}
-		return field;
+		type = Engine_Interface_Base::E_FIELD;
+		break;
 	case H_FIELD_DUMP:
-		for (unsigned int i=0; i<numLines[0]; ++i)
-		{
-			pos[0]=posLines[0][i];
-			for (unsigned int j=0; j<numLines[1]; ++j)
-			{
-				pos[1]=posLines[1][j];
-				for (unsigned int k=0; k<numLines[2]; ++k)
-				{
-					pos[2]=posLines[2][k];
-
-					m_Eng_Interface->GetHField(pos,out);
-					field[0][i][j][k] = out[0];
-					field[1][i][j][k] = out[1];
-					field[2][i][j][k] = out[2];
-				}
-			}
-		}
-		return field;
+		type = Engine_Interface_Base::H_FIELD;
+		break;
 	case J_FIELD_DUMP:
-		for (unsigned int i=0; i<numLines[0]; ++i)
-		{
-			pos[0]=posLines[0][i];
-			for (unsigned int j=0; j<numLines[1]; ++j)
-			{
-				pos[1]=posLines[1][j];
-				for (unsigned int k=0; k<numLines[2]; ++k)
-				{
-					pos[2]=posLines[2][k];
-
-					m_Eng_Interface->GetJField(pos,out);
-					field[0][i][j][k] = out[0];
-					field[1][i][j][k] = out[1];
-					field[2][i][j][k] = out[2];
-				}
-			}
-		}
-		return field;
+		type = Engine_Interface_Base::J_FIELD;
+		break;
 	case ROTH_FIELD_DUMP:
-		for (unsigned int i=0; i<numLines[0]; ++i)
-		{
-			pos[0]=posLines[0][i];
-			for (unsigned int j=0; j<numLines[1]; ++j)
-			{
-				pos[1]=posLines[1][j];
-				for (unsigned int k=0; k<numLines[2]; ++k)
-				{
-					pos[2]=posLines[2][k];
-
-					m_Eng_Interface->GetRotHField(pos,out);
-					field[0][i][j][k] = out[0];
-					field[1][i][j][k] = out[1];
-					field[2][i][j][k] = out[2];
-				}
-			}
-		}
-		return field;
+		type = Engine_Interface_Base::ROTH_FIELD;
+		break;
 	case D_FIELD_DUMP:
-		for (unsigned int i=0; i<numLines[0]; ++i)
-		{
-			pos[0]=posLines[0][i];
-			for (unsigned int j=0; j<numLines[1]; ++j)
-			{
-				pos[1]=posLines[1][j];
-				for (unsigned int k=0; k<numLines[2]; ++k)
-				{
-					pos[2]=posLines[2][k];
-
-					m_Eng_Interface->GetDField(pos,out);
-					field[0][i][j][k] = out[0];
-					field[1][i][j][k] = out[1];
-					field[2][i][j][k] = out[2];
-				}
-			}
-		}
-		return field;
+		type = Engine_Interface_Base::D_FIELD;
+		break;
 	case B_FIELD_DUMP:
-		for (unsigned int i=0; i<numLines[0]; ++i)
-		{
-			pos[0]=posLines[0][i];
-			for (unsigned int j=0; j<numLines[1]; ++j)
-			{
-				pos[1]=posLines[1][j];
-				for (unsigned int k=0; k<numLines[2]; ++k)
-				{
-					pos[2]=posLines[2][k];
-
-					m_Eng_Interface->GetBField(pos,out);
-					field[0][i][j][k] = out[0];
-					field[1][i][j][k] = out[1];
-					field[2][i][j][k] = out[2];
-				}
-			}
-		}
-		return field;
+		type = Engine_Interface_Base::B_FIELD;
+		break;
 	default:
 		cerr << "ProcessFields::CalcField(): Error, unknown dump type..." << endl;
-		return field;
+		return false;
 	}
+	return m_Eng_Interface->GetFieldLine(type, i, j, line);
 }
 
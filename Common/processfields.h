@@ -21,6 +21,12 @@
 #include "processing.h"
 #include "tools/array_ops.h"
 
+#include <boost/program_options.hpp>
+
+#ifdef MPI_SUPPORT
+#include "mpi.h"
+#endif
+
 #define __VTK_DATA_TYPE__ "double"
 
 class VTK_File_Writer;
@@ -42,10 +48,15 @@ public:
 	  */
 	enum DumpType { E_FIELD_DUMP=0, H_FIELD_DUMP=1, J_FIELD_DUMP=2, ROTH_FIELD_DUMP=3, D_FIELD_DUMP=4, B_FIELD_DUMP=5, SAR_LOCAL_DUMP=20, SAR_1G_DUMP=21, SAR_10G_DUMP=22, SAR_RAW_DATA=29};
 
+	static boost::program_options::options_description optionDesc();
+
 	virtual std::string GetProcessingName() const {return "common field processing";}
 
 	virtual void InitProcess();
 
+	//! Flush and close the dump file, it is re-opened if written again
+	virtual void PostProcess();
+
 	virtual void DefineStartStopCoord(double* dstart, double* dstop);
 
 	//! Define a field dump sub sampling rate for a given direction (default: \a dir = -1 means all directions)
@@ -72,8 +83,24 @@ public:
 
 	void SetFileType(FileType fileType) {m_fileType=fileType;}
 
+	//! Enable or disable writing the fields to file (default enabled), e.g. if the fields are only used by another processing (frequency domain fields only)
+	void SetFileOutput(bool val) {m_FileOutput=val;}
+
+	//! Get the number of dump lines in the given direction
+	unsigned int GetNumLines(int ny) const {return numLines[ny];}
+	//! Get the (unscaled) dump mesh lines in the given direction
+	const double* GetDiscLines(int ny) const {return discLines[ny];}
+
 	static std::string GetFieldNameByType(DumpType type);
 
+#ifdef MPI_SUPPORT
+	//! Check if the parts of this dump of all MPI ranks can be written collectively into one file (hdf5 with MPI-IO support only)
+	virtual bool SupportsCollectiveDump() const;
+	//! Write this dump collectively with all ranks of \a comm into one file, the communicator is freed by this processing
+	void SetCollectiveDump(MPI_Comm comm) {m_MPI_Comm=comm;}
+#endif
+	bool IsCollectiveDump() const;
+
 	virtual bool NeedConductivity() const;
 	virtual bool NeedPermittivity() const;
 	virtual bool NeedPermeability() const;
@@ -81,6 +108,7 @@ public:
 protected:
 	DumpType m_DumpType;
 	FileType m_fileType;
+	bool m_FileOutput;
 
 	VTK_File_Writer* m_Vtk_Dump_File;
 	HDF5_File_Writer* m_HDF5_Dump_File;
@@ -99,8 +127,20 @@ protected:
 	unsigned int* posLines[3];	//grid positions to dump
 	double* discLines[3];		//mesh disc lines to dump
 
-	//! Calculate and return the defined field. Caller has to cleanup the array.
-	FDTD_FLOAT**** CalcField();
+	//! Calculate and return the defined field into \a field, or into a new array if \a field is NULL. Caller has to cleanup the array.
+	FDTD_FLOAT**** CalcField(FDTD_FLOAT**** field=NULL);
+#ifdef MPI_SUPPORT
+	MPI_Comm m_MPI_Comm;
+	//! Calculate the dump lines written by this rank and their offset in the global dump mesh of all ranks of m_MPI_Comm
+	/*!
+	  Lines shared by neighboring ranks are written by the upper rank, thus only the leading \a localSize lines of this rank are written.
+	  Returns false (on all ranks) if the global dump mesh isn't consistent, e.g. due to a different sub-sampling.
+	  */
+	bool CalcCollectiveDomain(unsigned int* localSize, unsigned int* globalSize, unsigned int* offset, std::vector<double>* globalLines) const;
+#endif
+
+	//! Calculate the defined field along the z-line at dump position (\a i,\a j) into \a line (one array of numLines[2] values per component). Thread-safe.
+	bool CalcFieldLine(unsigned int i, unsigned int j, FDTD_FLOAT* line[3]) const;
 };
 
 #endif // PROCESSFIELDS_H
@@ -19,22 +19,34 @@
 #include "Common/operator_base.h"
 #include "tools/vtk_file_writer.h"
 #include "tools/hdf5_file_writer.h"
+#include "tools/useful.h"
+#include <boost/thread.hpp>
+#include <boost/bind.hpp>
 #include <iomanip>
 #include <sstream>
 #include <string>
 
 using namespace std;
 
+// recalculate the DFT phasors exactly after this many samples, to limit the accumulated rounding error of the recurrence
+#define PHASOR_RESYNC_INTERVAL 1024
+// minimal number of dump values per thread for a multithreaded DFT
+#define MIN_DFT_VALUES_PER_THREAD 32768
+
 ProcessFieldsFD::ProcessFieldsFD(Engine_Interface_Base* eng_if) : ProcessFields(eng_if)
 {
+	m_LastSampleTS = 0;
+	m_DFT_Threads = NULL;
+	m_DFT_StartBarrier = NULL;
+	m_DFT_StopBarrier = NULL;
+	m_DFT_StopThreads = false;
 }
 
 ProcessFieldsFD::~ProcessFieldsFD()
 {
+	StopDFTThreads();
 	for (size_t n = 0; n<m_FD_Fields.size(); ++n)
-	{
-		Delete_N_3DArray(m_FD_Fields.at(n),numLines);
-	}
+		delete m_FD_Fields.at(n);
 	m_FD_Fields.clear();
 }
 
@@ -62,10 +74,88 @@ void ProcessFieldsFD::InitProcess()
 	}
 
 	//create data structures...
+	for (size_t n = 0; n<m_FD_Fields.size(); ++n)
+		delete m_FD_Fields.at(n);
+	m_FD_Fields.clear();
 	for (size_t n = 0; n<m_FD_Samples.size(); ++n)
 	{
-		std::complex<float>**** field_fd = Create_N_3DArray<std::complex<float> >(numLines);
-		m_FD_Fields.push_back(field_fd);
+		stringstream ss;
+		ss << "FD_Field_f" << n;
+		m_FD_Fields.push_back(new ArrayLib::ArrayNIJK<std::complex<float> >(ss.str(), numLines));
+	}
+
+	size_t numFreq = m_FD_Samples.size();
+	m_Phasor_Re.assign(numFreq, 0);
+	m_Phasor_Im.assign(numFreq, 0);
+	m_PhasorStep_Re.resize(numFreq);
+	m_PhasorStep_Im.resize(numFreq);
+	m_Weight_Re.assign(numFreq, 0);
+	m_Weight_Im.assign(numFreq, 0);
+	double dT = Op->GetTimestep() * m_FD_Interval;
+	for (size_t n = 0; n<numFreq; ++n)
+	{
+		m_PhasorStep_Re.at(n) = cos(-2.0 * M_PI * m_FD_Samples.at(n) * dT);
+		m_PhasorStep_Im.at(n) = sin(-2.0 * M_PI * m_FD_Samples.at(n) * dT);
+	}
+	m_LastSampleTS = 0;
+
+	StartDFTThreads();
+}
+
+void ProcessFieldsFD::StartDFTThreads()
+{
+	StopDFTThreads();
+
+	// the engine threads are idle during processing, use as many threads for large dumps
+	unsigned int numThreads = m_Eng_Interface->GetNumberOfThreads();
+	double numValues = (double)numLines[0]*numLines[1]*numLines[2]*m_FD_Samples.size();
+	numThreads = min(numThreads, (unsigned int)(numValues/MIN_DFT_VALUES_PER_THREAD)+1);
+
+	m_DFT_JobStart.clear();
+	m_DFT_JobNum.clear();
+	vector<unsigned int> jobs = AssignJobs2Threads(numLines[0], max(numThreads,1u), true);
+	unsigned int start = 0;
+	for (size_t n=0; n<jobs.size(); ++n)
+	{
+		m_DFT_JobStart.push_back(start);
+		m_DFT_JobNum.push_back(jobs.at(n));
+		start += jobs.at(n);
+	}
+	if (jobs.size()<=1)
+		return;
+
+	m_DFT_StopThreads = false;
+	m_DFT_StartBarrier = new boost::barrier(jobs.size()); // workers + 1 controller
+	m_DFT_StopBarrier = new boost::barrier(jobs.size());  // workers + 1 controller
+	m_DFT_Threads = new boost::thread_group();
+	for (size_t n=0; n<jobs.size()-1; ++n)
+		m_DFT_Threads->create_thread(boost::bind(&ProcessFieldsFD::DFTWorker, this, m_DFT_JobStart.at(n), m_DFT_JobNum.at(n)));
+}
+
+void ProcessFieldsFD::StopDFTThreads()
+{
+	if (m_DFT_Threads==NULL)
+		return;
+	m_DFT_StopThreads = true;
+	m_DFT_StartBarrier->wait(); // release the workers to let them see the stop request
+	m_DFT_Threads->join_all();
+	delete m_DFT_Threads;
+	m_DFT_Threads = NULL;
+	delete m_DFT_StartBarrier;
+	m_DFT_StartBarrier = NULL;
+	delete m_DFT_StopBarrier;
+	m_DFT_StopBarrier = NULL;
+}
+
+void ProcessFieldsFD::DFTWorker(unsigned int start, unsigned int num)
+{
+	while (true)
+	{
+		m_DFT_StartBarrier->wait(); // wait for the next sample
+		if (m_DFT_StopThreads)
+			return;
+		AccumulateDFT(start, num);
+		m_DFT_StopBarrier->wait(); // sample done
 	}
 }
 
@@ -77,38 +167,100 @@ int ProcessFieldsFD::Process()
 	if ((m_FD_Interval==0) || (m_Eng_Interface->GetNumberOfTimesteps()%m_FD_Interval!=0))
 		return GetNextInterval();
 
-	FDTD_FLOAT**** field_td = CalcField();
-	std::complex<float>**** field_fd = NULL;
+	UpdatePhasors();
 
-	double T = m_Eng_Interface->GetTime(m_dualTime);
-	unsigned int pos[3];
-	for (size_t n = 0; n<m_FD_Samples.size(); ++n)
+	if (m_DFT_Threads==NULL)
+		AccumulateDFT(0, numLines[0]);
+	else
+	{
+		m_DFT_StartBarrier->wait(); // start the workers
+		AccumulateDFT(m_DFT_JobStart.back(), m_DFT_JobNum.back());
+		m_DFT_StopBarrier->wait(); // wait for all workers to finish this sample
+	}
+
+	++m_FD_SampleCount;
+	return GetNextInterval();
+}
+
+void ProcessFieldsFD::UpdatePhasors()
+{
+	unsigned int ts = m_Eng_Interface->GetNumberOfTimesteps();
+	size_t numFreq = m_FD_Samples.size();
+	if ((m_FD_SampleCount%PHASOR_RESYNC_INTERVAL==0) || (ts!=m_LastSampleTS+m_FD_Interval))
 	{
-		std::complex<float> exp_jwt_2_dt = std::exp( (std::complex<float>)(-2.0 * _I * M_PI * m_FD_Samples.at(n) * T) );
-		exp_jwt_2_dt *= 2; // *2 for single-sided spectrum
-		exp_jwt_2_dt *= Op->GetTimestep() * m_FD_Interval; // multiply with timestep-interval
-		field_fd = m_FD_Fields.at(n);
-		for (pos[0]=0; pos[0]<numLines[0]; ++pos[0])
+		double T = m_Eng_Interface->GetTime(m_dualTime);
+		for (size_t n = 0; n<numFreq; ++n)
 		{
-			for (pos[1]=0; pos[1]<numLines[1]; ++pos[1])
+			m_Phasor_Re[n] = cos(-2.0 * M_PI * m_FD_Samples.at(n) * T);
+			m_Phasor_Im[n] = sin(-2.0 * M_PI * m_FD_Samples.at(n) * T);
+		}
+	}
+	else
+	{
+		// exp(-j*w*(T+dT)) = exp(-j*w*T) * exp(-j*w*dT)
+		for (size_t n = 0; n<numFreq; ++n)
+		{
+			double re = m_Phasor_Re[n]*m_PhasorStep_Re[n] - m_Phasor_Im[n]*m_PhasorStep_Im[n];
+			double im = m_Phasor_Re[n]*m_PhasorStep_Im[n] + m_Phasor_Im[n]*m_PhasorStep_Re[n];
+			m_Phasor_Re[n] = re;
+			m_Phasor_Im[n] = im;
+		}
+	}
+	m_LastSampleTS = ts;
+
+	// *2 for single-sided spectrum, multiply with timestep-interval
+	double scale = 2.0 * Op->GetTimestep() * m_FD_Interval;
+	for (size_t n = 0; n<numFreq; ++n)
+	{
+		m_Weight_Re[n] = scale*m_Phasor_Re[n];
+		m_Weight_Im[n] = scale*m_Phasor_Im[n];
+	}
+}
+
+void ProcessFieldsFD::AccumulateDFT(unsigned int start, unsigned int num)
+{
+	// one z-line of the time domain field at a time, read with the bulk field box access (see SetFieldBox in ProcessFields::InitProcess),
+	// all frequencies are updated while it is in cache
+	unsigned int numZ = numLines[2];
+	vector<FDTD_FLOAT> buffer(3*numZ);
+	FDTD_FLOAT* field_td[3] = {&buffer[0], &buffer[numZ], &buffer[2*numZ]};
+	// same (k,n) order as a z-line of the frequency domain arrays
+	vector<FDTD_FLOAT> line(3*numZ);
+	for (unsigned int i=start; i<start+num; ++i)
+	{
+		for (unsigned int j=0; j<numLines[1]; ++j)
+		{
+			if (CalcFieldLine(i, j, field_td)==false)
+				return;
+			for (unsigned int k=0; k<numZ; ++k)
+			{
+				line[3*k]   = field_td[0][k];
+				line[3*k+1] = field_td[1][k];
+				line[3*k+2] = field_td[2][k];
+			}
+			const FDTD_FLOAT* td = &line[0];
+			for (size_t n = 0; n<m_FD_Samples.size(); ++n)
 			{
-				for (pos[2]=0; pos[2]<numLines[2]; ++pos[2])
+				float w_re = m_Weight_Re[n];
+				float w_im = m_Weight_Im[n];
+				// the z-line is contiguous, with interleaved real and imaginary parts
+				float* field_fd = reinterpret_cast<float*>(&(*m_FD_Fields[n])(0,i,j,0));
+				for (unsigned int m=0; m<3*numZ; ++m)
 				{
-					field_fd[0][pos[0]][pos[1]][pos[2]] += field_td[0][pos[0]][pos[1]][pos[2]] * exp_jwt_2_dt;
-					field_fd[1][pos[0]][pos[1]][pos[2]] += field_td[1][pos[0]][pos[1]][pos[2]] * exp_jwt_2_dt;
-					field_fd[2][pos[0]][pos[1]][pos[2]] += field_td[2][pos[0]][pos[1]][pos[2]] * exp_jwt_2_dt;
+					field_fd[2*m]   += td[m]*w_re;
+					field_fd[2*m+1] += td[m]*w_im;
 				}
 			}
 		}
 	}
-	Delete_N_3DArray<FDTD_FLOAT>(field_td,numLines);
-	++m_FD_SampleCount;
-	return GetNextInterval();
 }
 
 void ProcessFieldsFD::PostProcess()
 {
-	DumpFDData();
+	StopDFTThreads();
+	if (m_FileOutput)
+		DumpFDData();
+	ProcessFields::PostProcess();
 }
 
 void ProcessFieldsFD::DumpFDData()
@@ -116,13 +268,13 @@ void ProcessFieldsFD::DumpFDData()
 	if (m_fileType==VTK_FILETYPE)
 	{
 		unsigned int pos[3];
-		FDTD_FLOAT**** field = Create_N_3DArray<float>(numLines);
-		std::complex<float>**** field_fd = NULL;
+		ArrayLib::ArrayNIJK<float> field("FD_Dump", numLines);
 		double angle=0;
 		int Nr_Ph = 21;
 
 		for (size_t n = 0; n<m_FD_Samples.size(); ++n)
 		{
+			ArrayLib::ArrayNIJK<std::complex<float> >& field_fd = *m_FD_Fields.at(n);
 			std::string str_freq;
 			double freq = m_FD_Samples.at(n);
 			if ((freq-long(freq))==0)
@@ -136,7 +288,6 @@ void ProcessFieldsFD::DumpFDData()
 			{
 				angle = 2.0 * M_PI * p / Nr_Ph;
 				std::complex<float> exp_jwt = std::exp( (std::complex<float>)( _I * angle) );
-				field_fd = m_FD_Fields.at(n);
 				for (pos[0]=0; pos[0]<numLines[0]; ++pos[0])
 				{
 					for (pos[1]=0; pos[1]<numLines[1]; ++pos[1])
@@ -205,7 +356,6 @@ void ProcessFieldsFD::DumpFDData()
 					cerr << "ProcessFieldsFD::Process: can't dump to file... abort! " << endl;
 			}
 		}
-		Delete_N_3DArray(field,numLines);
 		return;
 	}
 
@@ -216,7 +366,7 @@ void ProcessFieldsFD::DumpFDData()
 			stringstream ss;
 			ss << "f" << n;
 			size_t datasize[]={numLines[0],numLines[1],numLines[2]};
-			if (m_HDF5_Dump_File->WriteVectorField(ss.str(), m_FD_Fields.at(n), datasize)==false)
+			if (m_HDF5_Dump_File->WriteVectorField(ss.str(), *m_FD_Fields.at(n), datasize)==false)
 				cerr << "ProcessFieldsFD::Process: can't dump to file...! " << endl;
 
 			//legacy support, use /FieldData/FD frequency-Attribute in the future
@@ -19,6 +19,13 @@
 #define PROCESSFIELDS_FD_H
 
 #include "processfields.h"
+#include "tools/arraylib/array_nijk.h"
+
+namespace boost
+{
+	class thread_group;
+	class barrier;
+}
 
 class ProcessFieldsFD : public ProcessFields
 {
@@ -33,11 +40,41 @@ public:
 	virtual int Process();
 	virtual void PostProcess();
 
+	//! Get the frequency domain field of the given frequency index
+	const ArrayLib::ArrayNIJK<std::complex<float> >* GetFDField(size_t f_idx) const {return m_FD_Fields.at(f_idx);}
+	//! Get the raw frequency domain field data of the given frequency index, stored in (x,y,z,component) order, see GetNumLines()
+	const std::complex<float>* GetFDFieldData(size_t f_idx) const {return f_idx<m_FD_Fields.size() ? m_FD_Fields[f_idx]->data() : NULL;}
+
 protected:
 	virtual void DumpFDData();
 
-	//! frequency domain field storage
-	std::vector<std::complex<float>****> m_FD_Fields;
+	//! frequency domain field storage, one contiguous array per frequency
+	std::vector<ArrayLib::ArrayNIJK<std::complex<float> >*> m_FD_Fields;
+
+	//! Current DFT phasors exp(-j*2*pi*f*T) and their per sample increments, updated by recurrence
+	std::vector<double> m_Phasor_Re, m_Phasor_Im;
+	std::vector<double> m_PhasorStep_Re, m_PhasorStep_Im;
+	//! DFT weights of the current sample, including the single-sided spectrum and timestep scaling
+	std::vector<float> m_Weight_Re, m_Weight_Im;
+	unsigned int m_LastSampleTS;
+
+	//! Update the DFT phasors and weights for the current sample
+	void UpdatePhasors();
+	//! Add the current field of the dump x-lines \a start to \a start+\a num-1 to all frequency fields
+	void AccumulateDFT(unsigned int start, unsigned int num);
+
+	//! Persistent DFT worker threads, each one accumulates a fixed range of x-lines per sample. The last range is processed by the calling thread.
+	boost::thread_group* m_DFT_Threads;
+	boost::barrier *m_DFT_StartBarrier, *m_DFT_StopBarrier;
+	volatile bool m_DFT_StopThreads;
+	std::vector<unsigned int> m_DFT_JobStart, m_DFT_JobNum;
+
+	//! Start the DFT worker threads, if the dump is large enough to benefit from multiple threads
+	void StartDFTThreads();
+	//! Stop and join all DFT worker threads
+	void StopDFTThreads();
+	//! Worker loop: wait for a sample, accumulate the given x-lines and signal completion
+	void DFTWorker(unsigned int start, unsigned int num);
 };
 
 #endif // PROCESSFIELDS_FD_H
@@ -273,6 +273,8 @@ void ProcessFieldsSAR::DumpFDData()
 		SAR_Calculation SAR_Calc;
 		SAR_Calc.SetAveragingMethod(m_SAR_method, g_settings.GetVerboseLevel()==0);
 		SAR_Calc.SetDebugLevel(g_settings.GetVerboseLevel());
+		// use the configured number of engine threads (see --numThreads), the engine is idle during the post-processing
+		SAR_Calc.SetNumThreads(m_Eng_Interface->GetNumberOfThreads());
 		SAR_Calc.SetNumLines(numLines);
 		if (m_DumpType == SAR_LOCAL_DUMP)
 			SAR_Calc.SetAveragingMass(0);
@@ -32,6 +32,11 @@ public:
 
 	virtual std::string GetProcessingName() const {return "SAR dump";}
 
+#ifdef MPI_SUPPORT
+	//! The SAR averaging needs the neighboring cells, SAR dumps are written by each rank
+	virtual bool SupportsCollectiveDump() const {return false;}
+#endif
+
 	virtual void InitProcess();
 
 	virtual int Process();
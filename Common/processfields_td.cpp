@@ -19,25 +19,49 @@
 #include "Common/operator_base.h"
 #include "tools/vtk_file_writer.h"
 #include "tools/hdf5_file_writer.h"
+#include "tools/global.h"
 #include <iomanip>
 #include <sstream>
 #include <string>
 
 using namespace std;
+namespace po = boost::program_options;
 
 ProcessFieldsTD::ProcessFieldsTD(Engine_Interface_Base* eng_if) : ProcessFields(eng_if)
 {
 	pad_length = 8;
+	m_Async = false;
+	m_Extendible = false;
+	m_Writer = NULL;
+	m_StopWriter = false;
+	m_WriteFailed = false;
 }
 
 ProcessFieldsTD::~ProcessFieldsTD()
 {
+	StopWriter();
+	FreeBuffers();
+}
+
+po::options_description ProcessFieldsTD::optionDesc()
+{
+	po::options_description optdesc("Time domain field dump arguments");
+	optdesc.add_options()
+		(
+			"asyncFieldDumps",
+			po::bool_switch(),
+			"Write time domain field dumps in a background thread, the simulation only waits for the field snapshot"
+		);
+	return optdesc;
 }
 
 void ProcessFieldsTD::InitProcess()
 {
 	if (Enabled==false) return;
-	
+
+	StopWriter();
+	FreeBuffers();
+
 	ProcessFields::InitProcess();
 
 	if (m_Vtk_Dump_File)
@@ -45,6 +69,19 @@ void ProcessFieldsTD::InitProcess()
 
 	if (m_HDF5_Dump_File)
 		m_HDF5_Dump_File->SetCurrentGroup("/FieldData/TD");
+
+	m_WriteFailed = false;
+	m_Extendible = g_settings.hasOption("extendibleTDFieldDumps") && g_settings.getOption("extendibleTDFieldDumps").as<bool>();
+	m_Async = g_settings.hasOption("asyncFieldDumps") && g_settings.getOption("asyncFieldDumps").as<bool>();
+	// collective hdf5 writes must not run concurrently to the MPI communication of the engine
+	m_Async &= !IsCollectiveDump();
+	if (m_Async)
+	{
+		for (unsigned int n=0; n<m_NumBuffers; ++n)
+			m_FreeBuffers.push_back(Create_N_3DArray<FDTD_FLOAT>(numLines));
+		m_StopWriter = false;
+		m_Writer = new boost::thread(boost::bind(&ProcessFieldsTD::WriterLoop, this));
+	}
 }
 
 int ProcessFieldsTD::Process()
@@ -52,25 +89,80 @@ int ProcessFieldsTD::Process()
 	if (Enabled==false) return -1;
 	if (CheckTimestep()==false) return GetNextInterval();
 
-	string filename = m_filename;
+	Snapshot snap;
+	snap.timestep = m_Eng_Interface->GetNumberOfTimesteps();
+	snap.time = m_Eng_Interface->GetTime(m_dualTime);
+
+	if (m_Async)
+	{
+		FDTD_FLOAT**** buffer = NULL;
+		{
+			// wait for a free snapshot buffer
+			boost::mutex::scoped_lock lock(m_Mutex);
+			while (m_FreeBuffers.empty() && !m_WriteFailed)
+				m_Cond.wait(lock);
+			if (!m_WriteFailed)
+			{
+				buffer = m_FreeBuffers.back();
+				m_FreeBuffers.pop_back();
+			}
+		}
+		if (buffer==NULL)
+		{
+			SetEnable(false);
+			cerr << "ProcessFieldsTD::Process: can't dump to file... disabled! " << endl;
+			return GetNextInterval();
+		}
+
+		snap.field = CalcField(buffer);
+		{
+			boost::mutex::scoped_lock lock(m_Mutex);
+			m_Pending.push_back(snap);
+		}
+		m_Cond.notify_all();
+		return GetNextInterval();
+	}
+
+	snap.field = CalcField();
+	bool success = WriteSnapshot(snap);
+	Delete_N_3DArray<FDTD_FLOAT>(snap.field,numLines);
 
-	float**** field = CalcField();
+	if (success==false)
+	{
+		SetEnable(false);
+		cerr << "ProcessFieldsTD::Process: can't dump to file... disabled! " << endl;
+	}
+
+	return GetNextInterval();
+}
+
+bool ProcessFieldsTD::WriteSnapshot(const Snapshot& snap)
+{
 	bool success = true;
 
 	if (m_fileType==VTK_FILETYPE)
 	{
-		m_Vtk_Dump_File->SetTimestep(m_Eng_Interface->GetNumberOfTimesteps());
+		m_Vtk_Dump_File->SetTimestep(snap.timestep);
 		m_Vtk_Dump_File->ClearAllFields();
-		m_Vtk_Dump_File->AddVectorField(GetFieldNameByType(m_DumpType),field);
+		m_Vtk_Dump_File->AddVectorField(GetFieldNameByType(m_DumpType),snap.field);
 		success &= m_Vtk_Dump_File->Write();
 	}
+	else if ((m_fileType==HDF5_FILETYPE) && m_Extendible)
+	{
+		// one chunk per snapshot, the time and timestep datasets grow alongside
+		size_t datasize[]={numLines[0],numLines[1],numLines[2]};
+		size_t one[1] = {1};
+		success &= m_HDF5_Dump_File->AppendVectorField("values", snap.field, datasize);
+		success &= m_HDF5_Dump_File->AppendData("time", H5T_NATIVE_DOUBLE, &snap.time, 1, one, 1024);
+		success &= m_HDF5_Dump_File->AppendData("timestep", H5T_NATIVE_UINT, &snap.timestep, 1, one, 1024);
+	}
 	else if (m_fileType==HDF5_FILETYPE)
 	{
 		stringstream ss;
-		ss << std::setw( pad_length ) << std::setfill( '0' ) << m_Eng_Interface->GetNumberOfTimesteps();
+		ss << std::setw( pad_length ) << std::setfill( '0' ) << snap.timestep;
 		size_t datasize[]={numLines[0],numLines[1],numLines[2]};
-		success &= m_HDF5_Dump_File->WriteVectorField(ss.str(), field, datasize);
-		float time[1] = {(float)m_Eng_Interface->GetTime(m_dualTime)};
+		success &= m_HDF5_Dump_File->WriteVectorField(ss.str(), snap.field, datasize);
+		float time[1] = {(float)snap.time};
 		success &= m_HDF5_Dump_File->WriteAtrribute("/FieldData/TD/"+ss.str(),"time",time,1);
 	}
 	else
@@ -78,14 +170,73 @@ int ProcessFieldsTD::Process()
 		success = false;
 		cerr << "ProcessFieldsTD::Process: unknown File-Type" << endl;
 	}
+	return success;
+}
 
-	Delete_N_3DArray<FDTD_FLOAT>(field,numLines);
+void ProcessFieldsTD::WriterLoop()
+{
+	boost::mutex::scoped_lock lock(m_Mutex);
+	while (true)
+	{
+		while (m_Pending.empty() && !m_StopWriter)
+			m_Cond.wait(lock);
+		if (m_Pending.empty())
+			return;
 
-	if (success==false)
+		// keep the snapshot in the queue while writing, FlushData() waits for an empty queue
+		Snapshot snap = m_Pending.front();
+		lock.unlock();
+		bool success = m_WriteFailed ? false : WriteSnapshot(snap);
+		lock.lock();
+
+		m_Pending.pop_front();
+		m_FreeBuffers.push_back(snap.field);
+		m_WriteFailed |= !success;
+		m_Cond.notify_all();
+	}
+}
+
+void ProcessFieldsTD::FlushData()
+{
+	if (m_Writer)
+	{
+		boost::mutex::scoped_lock lock(m_Mutex);
+		while (!m_Pending.empty())
+			m_Cond.wait(lock);
+	}
+	if (m_HDF5_Dump_File)
+		m_HDF5_Dump_File->Flush();
+}
+
+void ProcessFieldsTD::PostProcess()
+{
+	StopWriter();
+	ProcessFields::PostProcess();
+}
+
+void ProcessFieldsTD::StopWriter()
+{
+	if (m_Writer==NULL)
+		return;
+	{
+		boost::mutex::scoped_lock lock(m_Mutex);
+		m_StopWriter = true;
+	}
+	m_Cond.notify_all();
+	m_Writer->join();
+	delete m_Writer;
+	m_Writer = NULL;
+
+	if (m_WriteFailed && Enabled)
 	{
 		SetEnable(false);
 		cerr << "ProcessFieldsTD::Process: can't dump to file... disabled! " << endl;
 	}
+}
 
-	return GetNextInterval();
+void ProcessFieldsTD::FreeBuffers()
+{
+	for (size_t n=0; n<m_FreeBuffers.size(); ++n)
+		Delete_N_3DArray<FDTD_FLOAT>(m_FreeBuffers.at(n),numLines);
+	m_FreeBuffers.clear();
 }
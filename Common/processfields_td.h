@@ -20,23 +20,61 @@
 
 #include "processfields.h"
 
+#include <deque>
+#include <boost/thread.hpp>
+#include <boost/program_options.hpp>
+
 class ProcessFieldsTD : public ProcessFields
 {
 public:
 	ProcessFieldsTD(Engine_Interface_Base* eng_if);
 	virtual ~ProcessFieldsTD();
 
+	static boost::program_options::options_description optionDesc();
+
 	virtual std::string GetProcessingName() const {return "time domain field dump";}
 
 	virtual void InitProcess();
 
 	virtual int Process();
 
+	//! Wait until all pending field snapshots are written
+	virtual void FlushData();
+	virtual void PostProcess();
+
 	//! Set the length of the filename timestep pad filled with zeros (default is 8)
 	void SetPadLength(int val) {pad_length=val;};
 
 protected:
 	int pad_length;
+
+	struct Snapshot
+	{
+		FDTD_FLOAT**** field;
+		unsigned int timestep;
+		double time;
+	};
+	//! Write a field snapshot to the dump file
+	bool WriteSnapshot(const Snapshot& snap);
+
+	//! Append all hdf5 snapshots to the extendible dataset /FieldData/TD/values (see option --extendibleTDFieldDumps)
+	bool m_Extendible;
+
+	//! Asynchronous dumps: the engine only waits for the snapshot copy, a writer thread writes the files (see option --asyncFieldDumps)
+	bool m_Async;
+	boost::thread* m_Writer;
+	boost::mutex m_Mutex;
+	boost::condition_variable m_Cond;
+	std::deque<Snapshot> m_Pending; //!< snapshots waiting for or being written
+	std::vector<FDTD_FLOAT****> m_FreeBuffers;
+	bool m_StopWriter;
+	bool m_WriteFailed;
+	//! Number of snapshot buffers, one is written while the next one is filled
+	static const unsigned int m_NumBuffers = 2;
+
+	void WriterLoop();
+	void StopWriter();
+	void FreeBuffers();
 };
 
 #endif // PROCESSFIELDS_TD_H
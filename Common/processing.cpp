@@ -345,6 +345,7 @@ void ProcessingArray::DeleteAll()
 		delete ProcessArray.at(i);
 	}
 	ProcessArray.clear();
+	m_SampledProcessings.clear();
 }
 
 void ProcessingArray::PreProcess()
@@ -365,11 +366,36 @@ int ProcessingArray::Process()
 	return nextProcess;
 }
 
+bool ProcessingArray::EnableEngineSampling()
+{
+	// a single timestep interval can never exceed maxInterval
+	m_SampledProcessings.clear();
+	for (size_t i=0; i<ProcessArray.size(); ++i)
+		if (ProcessArray.at(i)->EnableEngineSampling(maxInterval))
+			m_SampledProcessings.push_back(ProcessArray.at(i));
+	return m_SampledProcessings.size()>0;
+}
+
+void ProcessingArray::SampleTimestep(unsigned int part, unsigned int numParts)
+{
+	// every processing has its own engine interface and sample buffer, the parts can be sampled in parallel
+	for (size_t i=part; i<m_SampledProcessings.size(); i+=numParts)
+		m_SampledProcessings.at(i)->SampleTimestep();
+}
+
 void ProcessingArray::PostProcess()
 {
 	for (size_t i=0; i<ProcessArray.size(); ++i) ProcessArray.at(i)->PostProcess();
 }
 
+Processing* ProcessingArray::GetProcessingByName(const string& name) const
+{
+	for (size_t i=0; i<ProcessArray.size(); ++i)
+		if (ProcessArray.at(i)->GetName()==name)
+			return ProcessArray.at(i);
+	return NULL;
+}
+
 void ProcessingArray::DumpBoxes2File( string vtkfilenameprefix ) const
 {
 	for (size_t i=0; i<ProcessArray.size(); ++i)
@@ -74,6 +74,10 @@ public:
 	void AddFrequency(double freq);
 	void AddFrequency(std::vector<double> *freqs);
 
+	//! Number of frequency domain samples
+	size_t GetNumberOfFDSamples() const {return m_FD_Samples.size();}
+	const double* GetFDFrequencies() const {return m_FD_Samples.empty() ? NULL : &m_FD_Samples[0];}
+
 	bool CheckTimestep();
 
 	//! Process data prior to the simulation run.
@@ -82,6 +86,16 @@ public:
 	//! Process data during simulation run.
 	virtual int Process() {return GetNextInterval();}
 
+	//! Enable sampling by the engine, see SampleTimestep(). Returns false if this processing does not support it.
+	/*!
+	  The engine calls SampleTimestep() after every timestep while the fields are consistent, the processing
+	  has to buffer at least \a bufferSize samples until they are processed by the next Process() call.
+	  */
+	virtual bool EnableEngineSampling(unsigned int bufferSize) {UNUSED(bufferSize);return false;}
+
+	//! Sample the data of the current timestep, called from within the engine if engine sampling is enabled. Different processings may be sampled in parallel.
+	virtual void SampleTimestep() {}
+
 	//! Process data after simulation has finished.
 	virtual void PostProcess();
 
@@ -193,6 +207,12 @@ public:
 	//! Invoke Process() on all Processings. Will return the smallest next iteration interval.
 	int Process();
 
+	//! Enable engine sampling for all supporting processings. Returns false if no processing supports it.
+	bool EnableEngineSampling();
+
+	//! Invoke SampleTimestep() on the \a part of \a numParts of all Processings with engine sampling, called by the engine (threads) after every timestep.
+	void SampleTimestep(unsigned int part, unsigned int numParts);
+
 	//! Invoke PostProcess() on all Processings.
 	void PostProcess();
 
@@ -202,9 +222,13 @@ public:
 
 	Processing* GetProcessing(size_t number) {return ProcessArray.at(number);}
 
+	//! Get the first processing with the given name, returns NULL if not found.
+	Processing* GetProcessingByName(const std::string& name) const;
+
 protected:
 	unsigned int maxInterval;
 	std::vector<Processing*> ProcessArray;
+	std::vector<Processing*> m_SampledProcessings;
 };
 
 #endif // PROCESSING_H
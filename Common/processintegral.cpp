@@ -17,8 +17,11 @@
 
 #include "processintegral.h"
 #include "Common/operator_base.h"
+#include "tools/hdf5_file_writer.h"
 #include "time.h"
 #include <iomanip>
+#include <climits>
+#include <cstdio>
 
 using namespace std;
 
@@ -27,6 +30,15 @@ ProcessIntegral::ProcessIntegral(Engine_Interface_Base* eng_if)  : Processing(en
 	m_Results=NULL;
 	m_FD_Results=NULL;
 	m_normDir = -1;
+	m_FileOutput = true;
+	m_KeepTDResults = false;
+	m_fileType = ASCII_FILETYPE;
+	m_HDF5_File = NULL;
+
+	m_EngineSampling = false;
+	m_SampleBufferSize = 0;
+	m_NumSamples = 0;
+	m_LastSampleTS = UINT_MAX;
 }
 
 ProcessIntegral::~ProcessIntegral()
@@ -35,6 +47,8 @@ ProcessIntegral::~ProcessIntegral()
 	delete[] m_FD_Results;
 	m_Results = NULL;
 	m_FD_Results = NULL;
+	delete m_HDF5_File;
+	m_HDF5_File = NULL;
 }
 
 
@@ -42,6 +56,9 @@ void ProcessIntegral::InitProcess()
 {
 	delete[] m_Results; m_Results = NULL;
 	delete[] m_FD_Results; m_FD_Results = NULL;
+	m_TD_Results.clear();
+	m_TD_HDF5Buffer.clear();
+	delete m_HDF5_File; m_HDF5_File = NULL;
 
 	if (!Enabled)
 		return;
@@ -49,7 +66,42 @@ void ProcessIntegral::InitProcess()
 	m_Results = new double[GetNumberOfIntegrals()];
 	m_FD_Results = new vector<double_complex>[GetNumberOfIntegrals()];
 
+	for (int i=0;i<GetNumberOfIntegrals();++i)
+	{
+		for (size_t n=0; n<m_FD_Samples.size(); ++n)
+		{
+			m_FD_Results[i].push_back(0);
+		}
+	}
+
 	m_filename = m_Name;
+	if (!m_FileOutput)
+		return;
+
+	// remove a stale result file of the other file type from a previous run, the readers (ReadUI, python UI_data) prefer the hdf5 file
+	if (m_fileType==HDF5_FILETYPE)
+	{
+		std::remove(m_filename.c_str());
+		std::remove((m_filename + "_FD").c_str());
+	}
+	else
+		std::remove((m_filename + ".h5").c_str());
+
+	if (m_fileType==HDF5_FILETYPE)
+	{
+		m_HDF5_File = new HDF5_File_Writer(m_filename + ".h5");
+		double coords[6];
+		for (int n=0; n<3; ++n)
+		{
+			coords[n] = Op->GetDiscLine(n,start[n])*Op->GetGridDelta();
+			coords[n+3] = Op->GetDiscLine(n,stop[n])*Op->GetGridDelta();
+		}
+		m_HDF5_File->WriteAtrribute("/", "start", coords, 3);
+		m_HDF5_File->WriteAtrribute("/", "stop", coords+3, 3);
+		m_TD_HDF5Buffer.reserve(PROBE_HDF5_CHUNK_SAMPLES*(GetNumberOfIntegrals()+1));
+		return;
+	}
+
 	OpenFile(m_filename);
 
 	//write header
@@ -70,24 +122,68 @@ void ProcessIntegral::InitProcess()
 		file << "\t" << GetIntegralName(n);
 	}
 	file << endl;
-
-	for (int i=0;i<GetNumberOfIntegrals();++i)
-	{
-		for (size_t n=0; n<m_FD_Samples.size(); ++n)
-		{
-			m_FD_Results[i].push_back(0);
-		}
-	}
 }
 
 void ProcessIntegral::FlushData()
 {
-	if (!Enabled)
+	if (!Enabled || !m_FileOutput)
 		return;
+	if (m_fileType==HDF5_FILETYPE)
+	{
+		if (Write_HDF5_Data()==false)
+			cerr << "ProcessIntegral::FlushData: Error, writing the probe data of " << m_Name << " failed, keeping the samples for the next write" << endl;
+		if (m_HDF5_File)
+			m_HDF5_File->Flush();
+		return;
+	}
+	file.flush();
 	if (m_FD_Samples.size())
 		Dump_FD_Data(1.0,m_filename + "_FD");
 }
 
+void ProcessIntegral::PostProcess()
+{
+	Processing::PostProcess();
+	if (m_HDF5_File)
+		m_HDF5_File->Close();
+}
+
+bool ProcessIntegral::Write_HDF5_Data()
+{
+	if (m_HDF5_File==NULL)
+		return false;
+
+	// append all time domain samples not yet written, the buffer is only emptied if they were written successfully
+	size_t numCols = GetNumberOfIntegrals()+1;
+	if (m_TD_HDF5Buffer.size())
+	{
+		if (m_HDF5_File->AppendData("TD", &m_TD_HDF5Buffer[0], m_TD_HDF5Buffer.size()/numCols, numCols, PROBE_HDF5_CHUNK_SAMPLES)==false)
+			return false;
+		m_TD_HDF5Buffer.clear();
+	}
+
+	if (m_FD_Samples.size()==0)
+		return true;
+
+	// frequency domain results are (re-)written completely, stored as frequency x integrals
+	size_t numFreq = m_FD_Samples.size();
+	int NrInt = GetNumberOfIntegrals();
+	vector<double> re(numFreq*NrInt), im(numFreq*NrInt);
+	for (size_t n=0; n<numFreq; ++n)
+		for (int i=0; i<NrInt; ++i)
+		{
+			re[n*NrInt+i] = std::real(m_FD_Results[i].at(n));
+			im[n*NrInt+i] = std::imag(m_FD_Results[i].at(n));
+		}
+	size_t datasize[2] = {numFreq, (size_t)NrInt};
+	m_HDF5_File->SetCurrentGroup("/FD");
+	bool ok = m_HDF5_File->WriteData("frequency", &m_FD_Samples[0], 1, datasize);
+	ok = ok && m_HDF5_File->WriteData("real", &re[0], 2, datasize);
+	ok = ok && m_HDF5_File->WriteData("imag", &im[0], 2, datasize);
+	m_HDF5_File->SetCurrentGroup("/", false);
+	return ok;
+}
+
 
 void ProcessIntegral::Dump_FD_Data(double factor, string filename)
 {
@@ -134,40 +230,124 @@ void ProcessIntegral::Dump_FD_Data(double factor, string filename)
 int ProcessIntegral::Process()
 {
 	if (Enabled==false) return -1;
+
+	if (m_EngineSampling)
+	{
+		ProcessSampleBuffer();
+
+		// the engine samples every following timestep, the current one may not be sampled yet (e.g. the very first call)
+		if ((m_Eng_Interface->GetNumberOfTimesteps()!=m_LastSampleTS) && CheckTimestep())
+			ProcessResults(m_Eng_Interface->GetNumberOfTimesteps(), m_Eng_Interface->GetTime(m_dualTime), CalcMultipleIntegrals());
+		return m_SampleBufferSize;
+	}
+
 	if (CheckTimestep()==false) return GetNextInterval();
 
-	CalcMultipleIntegrals();
+	ProcessResults(m_Eng_Interface->GetNumberOfTimesteps(), m_Eng_Interface->GetTime(m_dualTime), CalcMultipleIntegrals());
+
+	return GetNextInterval();
+}
+
+void ProcessIntegral::ProcessSampleBuffer()
+{
+	int NrInt = GetNumberOfIntegrals();
+	for (unsigned int n=0; n<m_NumSamples; ++n)
+	{
+		const double* sample = &m_SampleBuffer[n*(NrInt+2)];
+		ProcessResults((unsigned int)sample[0], sample[1], sample+2);
+	}
+	m_NumSamples = 0;
+}
+
+void ProcessIntegral::ProcessResults(unsigned int ts, double time, const double* results)
+{
 	int NrInt = GetNumberOfIntegrals();
-	double time = m_Eng_Interface->GetTime(m_dualTime);
 
 	if (ProcessInterval)
 	{
-		if (m_Eng_Interface->GetNumberOfTimesteps()%ProcessInterval==0)
+		if (ts%ProcessInterval==0)
 		{
-			file << setprecision(m_precision) << time;
-			for (int n=0; n<NrInt; ++n)
-				file << "\t" << m_Results[n] * m_weight;
-			file << endl;
+			if (!m_FileOutput || m_KeepTDResults)
+			{
+				m_TD_Results.push_back(time);
+				for (int n=0; n<NrInt; ++n)
+					m_TD_Results.push_back(results[n] * m_weight);
+			}
+			if (m_FileOutput && (m_fileType==ASCII_FILETYPE))
+			{
+				file << setprecision(m_precision) << time;
+				for (int n=0; n<NrInt; ++n)
+					file << "\t" << results[n] * m_weight;
+				file << "\n";
+			}
+			else if (m_HDF5_File)
+			{
+				m_TD_HDF5Buffer.push_back(time);
+				for (int n=0; n<NrInt; ++n)
+					m_TD_HDF5Buffer.push_back(results[n] * m_weight);
+				// on a write error the samples are kept and the write is retried after the next full chunk
+				if ((m_TD_HDF5Buffer.size()%(PROBE_HDF5_CHUNK_SAMPLES*(size_t)(NrInt+1))==0) && (Write_HDF5_Data()==false))
+					cerr << "ProcessIntegral::ProcessResults: Error, writing the probe data of " << m_Name << " failed" << endl;
+			}
 		}
 	}
 
 	if (m_FD_Interval)
 	{
-		if (m_Eng_Interface->GetNumberOfTimesteps()%m_FD_Interval==0)
+		if (ts%m_FD_Interval==0)
 		{
 			for (size_t n=0; n<m_FD_Samples.size(); ++n)
 			{
 				for (int i=0; i<NrInt; ++i)
-					m_FD_Results[i].at(n) += (double)m_Results[i] * m_weight * std::exp( -2.0 * _I * M_PI * m_FD_Samples.at(n) * time ) * 2.0 * Op->GetTimestep() * (double)m_FD_Interval;
+					m_FD_Results[i].at(n) += (double)results[i] * m_weight * std::exp( -2.0 * _I * M_PI * m_FD_Samples.at(n) * time ) * 2.0 * Op->GetTimestep() * (double)m_FD_Interval;
 			}
 			++m_FD_SampleCount;
-			if (m_Flush)
-				FlushData();
-			m_Flush = false;
 		}
 	}
 
-	return GetNextInterval();
+	if (m_Flush)
+		FlushData();
+	m_Flush = false;
+}
+
+const double_complex* ProcessIntegral::GetFDData(int row) const
+{
+	if ((m_FD_Results==NULL) || (row<0) || (row>=GetNumberOfIntegrals()) || m_FD_Results[row].empty())
+		return NULL;
+	return &m_FD_Results[row][0];
+}
+
+bool ProcessIntegral::EnableEngineSampling(unsigned int bufferSize)
+{
+	if ((Enabled==false) || (bufferSize==0))
+		return false;
+	m_EngineSampling = true;
+	m_SampleBufferSize = bufferSize;
+	m_NumSamples = 0;
+	m_LastSampleTS = UINT_MAX;
+	m_SampleBuffer.assign(bufferSize*(GetNumberOfIntegrals()+2), 0.0);
+	return true;
+}
+
+void ProcessIntegral::SampleTimestep()
+{
+	if (Enabled==false) return;
+	unsigned int ts = m_Eng_Interface->GetNumberOfTimesteps();
+	m_LastSampleTS = ts;
+	if (CheckTimestep()==false) return;
+
+	// the buffer is full if Process() is not called often enough, write the buffered samples from here instead of losing them
+	if (m_NumSamples>=m_SampleBufferSize)
+		ProcessSampleBuffer();
+
+	int NrInt = GetNumberOfIntegrals();
+	CalcMultipleIntegrals();
+	double* sample = &m_SampleBuffer[m_NumSamples*(NrInt+2)];
+	sample[0] = ts;
+	sample[1] = m_Eng_Interface->GetTime(m_dualTime);
+	for (int n=0; n<NrInt; ++n)
+		sample[n+2] = m_Results[n];
+	++m_NumSamples;
 }
 
 double* ProcessIntegral::CalcMultipleIntegrals()
@@ -20,6 +20,11 @@
 
 #include "processing.h"
 
+//! Number of time domain samples per chunk of the hdf5 probe output, it is written in blocks of this size
+#define PROBE_HDF5_CHUNK_SAMPLES 4096
+
+class HDF5_File_Writer;
+
 //! Abstract base class for integral parameter processing
 /*!
   \todo Weighting is applied equally to all integral parameter --> todo: weighting for each result individually
@@ -27,6 +32,8 @@
 class ProcessIntegral : public Processing
 {
 public:
+	enum FileType {ASCII_FILETYPE, HDF5_FILETYPE};
+
 	virtual ~ProcessIntegral();
 
 	virtual void InitProcess();
@@ -37,6 +44,8 @@ public:
 
 	//! Flush FD data to disk
 	virtual void FlushData();
+	//! Flush all data and close the hdf5 file, it is re-opened if written again
+	virtual void PostProcess();
 
 	//! This method can calculate multiple integral parameter and must be overloaded for each derived class. \sa GetNumberOfIntegrals
 	/*!
@@ -57,11 +66,53 @@ public:
 	//! This method will write the TD and FD dump files using CalcIntegral() to calculate the integral parameter
 	virtual int Process();
 
+	virtual bool EnableEngineSampling(unsigned int bufferSize);
+	//! Calculate the integrals and store them in the sample buffer, they are written by the next Process() call or as soon as the buffer is full
+	virtual void SampleTimestep();
+
+	//! Enable or disable writing the TD and FD results to file (default is enabled). Without file output the TD results are kept in memory.
+	void SetFileOutput(bool val) {m_FileOutput=val;}
+	//! Keep the TD results in memory, also if they are written to file (default is disabled). The FD results are always kept in memory. \sa GetTDData
+	void SetKeepTDResults(bool val) {m_KeepTDResults=val;}
+
+	//! Set the file type, ascii (default) or hdf5. The hdf5 file contains the time domain data "/TD" (time and all integrals per sample) and the frequency domain data in "/FD".
+	void SetFileType(FileType fileType) {m_fileType=fileType;}
+
+	//! Number of stored time domain samples, only available without file output or if enabled by SetKeepTDResults(). \sa GetTDData
+	size_t GetNumberOfTDSamples() const {return m_TD_Results.size()/(GetNumberOfIntegrals()+1);}
+	//! Get the stored time domain results, each sample is stored as time followed by all (weighted) integrals.
+	const double* GetTDData() const {return m_TD_Results.empty() ? NULL : &m_TD_Results[0];}
+
+	//! Get the frequency domain result of the given integral (row), see GetFDFrequencies() for the frequencies.
+	const double_complex* GetFDData(int row) const;
+
 protected:
 	ProcessIntegral(Engine_Interface_Base* eng_if);
 
 	void Dump_FD_Data(double factor, std::string filename);
 
+	//! Append all pending TD samples and (re-)write the FD data to the hdf5 file, returns false on a write error (the pending TD samples are kept)
+	bool Write_HDF5_Data();
+
+	//! Write the TD and accumulate the FD results of all samples in the sample buffer and empty it
+	void ProcessSampleBuffer();
+
+	//! Write the TD and accumulate the FD results of the given timestep and time
+	void ProcessResults(unsigned int ts, double time, const double* results);
+
+	bool m_EngineSampling;
+	unsigned int m_SampleBufferSize; //!< max. number of samples in the sample buffer
+	unsigned int m_NumSamples; //!< number of samples currently stored
+	unsigned int m_LastSampleTS; //!< last timestep seen by SampleTimestep()
+	std::vector<double> m_SampleBuffer; //!< timestep, time and all integrals for every sample
+
+	bool m_FileOutput;
+	bool m_KeepTDResults;
+	FileType m_fileType;
+	HDF5_File_Writer* m_HDF5_File;
+	std::vector<double> m_TD_HDF5Buffer; //!< TD samples not yet appended to the hdf5 file, at most PROBE_HDF5_CHUNK_SAMPLES unless a write failed
+	std::vector<double> m_TD_Results; //!< time and all integrals for every processed timestep
+
 	std::vector<double_complex> *m_FD_Results;
 	double *m_Results;
 
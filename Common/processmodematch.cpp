@@ -29,6 +29,8 @@ ProcessModeMatch::ProcessModeMatch(Engine_Interface_Base* eng_if) : ProcessInteg
 		m_ModeParser[n] = new CSFunctionParser();
 		m_ModeDist[n] = NULL;
 	}
+	m_ModeArea = NULL;
+	m_BoxField = NULL;
 	delete[] m_Results;
 	m_Results = new double[2];
 }
@@ -134,6 +136,7 @@ void ProcessModeMatch::InitProcess()
 	{
 		m_ModeDist[n] = Create2DArray<double>(m_numLines);
 	}
+	m_ModeArea = Create2DArray<double>(m_numLines);
 
 	bool dualMesh = m_ModeFieldType==1;
 	unsigned int pos[3] = {0,0,0};
@@ -171,6 +174,7 @@ void ProcessModeMatch::InitProcess()
 				var[6] = asin(1)-atan(var[2]/var[3]); //theta (t)
 			}
 			area = Op->GetNodeArea(m_ny,pos,dualMesh);
+			m_ModeArea[posP][posPP] = area;
 			for (int n=0; n<2; ++n)
 			{
 				m_ModeDist[n][posP][posPP] = m_ModeParser[n]->Eval(var); //calc mode template
@@ -195,6 +199,20 @@ void ProcessModeMatch::InitProcess()
 //			cerr << posP << " " << posPP << " : " << m_ModeDist[0][posP][posPP] << " , " << m_ModeDist[1][posP][posPP] << endl;
 		}
 
+	// setup the bulk field access of the mode plane
+	unsigned int* boxLines[3];
+	for (int n=0; n<3; ++n)
+	{
+		m_BoxNumLines[n] = stop[n] - start[n] + 1;
+		boxLines[n] = new unsigned int[m_BoxNumLines[n]];
+		for (unsigned int i=0; i<m_BoxNumLines[n]; ++i)
+			boxLines[n][i] = start[n] + i;
+	}
+	m_Eng_Interface->SetFieldBox(m_BoxNumLines, boxLines);
+	for (int n=0; n<3; ++n)
+		delete[] boxLines[n];
+	m_BoxField = Create_N_3DArray<FDTD_FLOAT>(m_BoxNumLines);
+
 	ProcessIntegral::InitProcess();
 }
 
@@ -206,6 +224,10 @@ void ProcessModeMatch::Reset()
 		Delete2DArray<double>(m_ModeDist[n],m_numLines);
 		m_ModeDist[n] = NULL;
 	}
+	Delete2DArray<double>(m_ModeArea,m_numLines);
+	m_ModeArea = NULL;
+	Delete_N_3DArray<FDTD_FLOAT>(m_BoxField,m_BoxNumLines);
+	m_BoxField = NULL;
 }
 
 
@@ -228,31 +250,26 @@ double* ProcessModeMatch::CalcMultipleIntegrals()
 	double field = 0;
 	double purity = 0;
 	double area = 0;
-    bool dualMesh = m_ModeFieldType==1;
 
 	int nP = (m_ny+1)%3;
 	int nPP = (m_ny+2)%3;
 
-	unsigned int pos[3] = {0,0,0};
-	pos[m_ny] = start[m_ny];
-
-	double out[3]={0,0,0};
+	if (m_ModeFieldType==0)
+		m_Eng_Interface->GetFieldBox(Engine_Interface_Base::E_FIELD, m_BoxField);
+	if (m_ModeFieldType==1)
+		m_Eng_Interface->GetFieldBox(Engine_Interface_Base::H_FIELD, m_BoxField);
 
+	unsigned int pos[3] = {0,0,0};
 	for (unsigned int posP = 0; posP<m_numLines[0]; ++posP)
 	{
-		pos[nP] = start[nP] + posP;
+		pos[nP] = posP;
 		for (unsigned int posPP = 0; posPP<m_numLines[1]; ++posPP)
 		{
-			pos[nPP] = start[nPP] + posPP;
-			area = Op->GetNodeArea(m_ny,pos,dualMesh);
-			if (m_ModeFieldType==0)
-				m_Eng_Interface->GetEField(pos,out);
-			if (m_ModeFieldType==1)
-				m_Eng_Interface->GetHField(pos,out);
-
+			pos[nPP] = posPP;
+			area = m_ModeArea[posP][posPP];
 			for (int n=0; n<2; ++n)
 			{
-				field = out[(m_ny+n+1)%3];
+				field = m_BoxField[(m_ny+n+1)%3][pos[0]][pos[1]][pos[2]];
 				value += field * m_ModeDist[n][posP][posPP] * area;
 				purity += field*field * area;
 			}
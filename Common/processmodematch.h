@@ -63,6 +63,12 @@ protected:
 
 	unsigned int m_numLines[2];
 	double** m_ModeDist[2];
+	//! node area of each point of the mode plane
+	double** m_ModeArea;
+
+	//! field box of the mode plane and its field buffer \sa Engine_Interface_Base::GetFieldBox
+	unsigned int m_BoxNumLines[3];
+	FDTD_FLOAT**** m_BoxField;
 };
 
 #endif // PROCESSMODEMATCH_H
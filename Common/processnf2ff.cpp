@@ -0,0 +1,218 @@
+/*
+*	Copyright (C) 2026 Thorsten Liebig (Thorsten.Liebig@gmx.de)
+*
+*	This program is free software: you can redistribute it and/or modify
+*	it under the terms of the GNU General Public License as published by
+*	the Free Software Foundation, either version 3 of the License, or
+*	(at your option) any later version.
+*
+*	This program is distributed in the hope that it will be useful,
+*	but WITHOUT ANY WARRANTY; without even the implied warranty of
+*	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*	GNU General Public License for more details.
+*
+*	You should have received a copy of the GNU General Public License
+*	along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "processnf2ff.h"
+#include "Common/operator_base.h"
+#include "nf2ff/nf2ff.h"
+#include "nf2ff/nf2ff_calc.h"
+#include <climits>
+
+using namespace std;
+
+ProcessNF2FF::ProcessNF2FF(Engine_Interface_Base* eng_if) : Processing(eng_if)
+{
+	m_Radius = 1;
+	for (int n=0; n<3; ++n)
+	{
+		m_MirrorType[n] = MIRROR_OFF;
+		m_MirrorPos[n] = 0;
+	}
+}
+
+ProcessNF2FF::~ProcessNF2FF()
+{
+	for (size_t n=0; n<m_E_Planes.size(); ++n)
+	{
+		delete m_E_Planes.at(n);
+		delete m_H_Planes.at(n);
+	}
+	m_E_Planes.clear();
+	m_H_Planes.clear();
+}
+
+void ProcessNF2FF::AddPlane(double* dstart, double* dstop, Engine_Interface_Base* eng_if_E, Engine_Interface_Base* eng_if_H)
+{
+	ProcessFieldsFD* planes[2] = {new ProcessFieldsFD(eng_if_E), new ProcessFieldsFD(eng_if_H)};
+	for (int n=0; n<2; ++n)
+	{
+		planes[n]->SetEnable(Enabled);
+		planes[n]->SetProcessInterval(ProcessInterval);
+		planes[n]->AddFrequency(&m_FD_Samples);
+		planes[n]->SetMeshType(m_Mesh_Type);
+		planes[n]->SetFileOutput(false);
+		if (n==1)
+		{
+			planes[n]->SetDualTime(true);
+			planes[n]->SetDualMesh(true);
+		}
+		planes[n]->SetDumpType(n==0 ? ProcessFields::E_FIELD_DUMP : ProcessFields::H_FIELD_DUMP);
+		// E- and H-fields are both needed in the cell centers
+		planes[n]->SetDumpMode2Cell();
+		planes[n]->SetName(m_Name + (n==0 ? "_E" : "_H"), m_E_Planes.size());
+		planes[n]->SetFileName(planes[n]->GetName());
+		planes[n]->DefineStartStopCoord(dstart, dstop);
+	}
+	m_E_Planes.push_back(planes[0]);
+	m_H_Planes.push_back(planes[1]);
+}
+
+void ProcessNF2FF::SetMirror(int type, int dir, float pos)
+{
+	if ((dir<0) || (dir>2))
+	{
+		cerr << "ProcessNF2FF::SetMirror: Error, invalid direction!" << endl;
+		return;
+	}
+	m_MirrorType[dir] = type;
+	m_MirrorPos[dir] = pos;
+}
+
+void ProcessNF2FF::SetEnable(bool val)
+{
+	Processing::SetEnable(val);
+	for (size_t n=0; n<m_E_Planes.size(); ++n)
+	{
+		m_E_Planes.at(n)->SetEnable(val);
+		m_H_Planes.at(n)->SetEnable(val);
+	}
+}
+
+void ProcessNF2FF::ShowSnappedCoords()
+{
+	for (size_t n=0; n<m_E_Planes.size(); ++n)
+	{
+		m_E_Planes.at(n)->ShowSnappedCoords();
+		m_H_Planes.at(n)->ShowSnappedCoords();
+	}
+}
+
+void ProcessNF2FF::InitProcess()
+{
+	if (Enabled==false) return;
+
+	if ((m_FD_Samples.size()==0) || (m_Theta.size()==0) || (m_Phi.size()==0) || (m_E_Planes.size()==0))
+	{
+		cerr << "ProcessNF2FF::InitProcess: Error, no frequencies, angles or nf2ff planes found... skipping nf2ff: " << m_Name << endl;
+		SetEnable(false);
+		return;
+	}
+
+	for (size_t n=0; n<m_E_Planes.size(); ++n)
+	{
+		m_E_Planes.at(n)->InitProcess();
+		m_H_Planes.at(n)->InitProcess();
+	}
+}
+
+int ProcessNF2FF::Process()
+{
+	if (Enabled==false) return -1;
+
+	int next = INT_MAX;
+	int step;
+	for (size_t n=0; n<m_E_Planes.size(); ++n)
+	{
+		step = m_E_Planes.at(n)->Process();
+		if ((step>0) && (step<next))
+			next = step;
+		step = m_H_Planes.at(n)->Process();
+		if ((step>0) && (step<next))
+			next = step;
+	}
+	if (next==INT_MAX)
+		return -1;
+	return next;
+}
+
+void ProcessNF2FF::PostProcess()
+{
+	if (Enabled==false) return;
+
+	vector<float> freq(m_FD_Samples.begin(), m_FD_Samples.end());
+	nf2ff far_field(freq, m_Theta, m_Phi, m_Center, m_Eng_Interface->GetNumberOfThreads());
+	far_field.SetRadius(m_Radius);
+	far_field.SetPermittivity(m_Permittivity);
+	far_field.SetPermeability(m_Permeability);
+	for (int n=0; n<3; ++n)
+		if (m_MirrorType[n]!=MIRROR_OFF)
+			far_field.SetMirror(m_MirrorType[n], n, m_MirrorPos[n]);
+
+	// the nf2ff expects the mesh in meter (the cylindrical alpha direction is not scaled)
+	double scaling = Op->GetGridDelta();
+	for (size_t p=0; p<m_E_Planes.size(); ++p)
+	{
+		ProcessFieldsFD* E_plane = m_E_Planes.at(p);
+		ProcessFieldsFD* H_plane = m_H_Planes.at(p);
+
+		unsigned int numLines[3];
+		float* lines[3];
+		for (int n=0; n<3; ++n)
+		{
+			numLines[n] = E_plane->GetNumLines(n);
+			if (numLines[n]!=H_plane->GetNumLines(n))
+			{
+				cerr << "ProcessNF2FF::PostProcess: Error, E- and H-field mesh of plane " << p << " do not agree, skipping!" << endl;
+				numLines[n] = 0;
+			}
+			lines[n] = new float[numLines[n]];
+			for (unsigned int i=0; i<numLines[n]; ++i)
+			{
+				if ((m_Mesh_Type==CYLINDRICAL_MESH) && (n==1))
+					lines[n][i] = E_plane->GetDiscLines(n)[i];
+				else
+					lines[n][i] = E_plane->GetDiscLines(n)[i]*scaling;
+			}
+		}
+
+		if ((numLines[0]>0) && (numLines[1]>0) && (numLines[2]>0))
+		{
+			vector<complex<float>****> E_fields;
+			vector<complex<float>****> H_fields;
+			for (size_t fn=0; fn<m_FD_Samples.size(); ++fn)
+			{
+				const ArrayLib::ArrayNIJK<complex<float> >& E_fd = *E_plane->GetFDField(fn);
+				const ArrayLib::ArrayNIJK<complex<float> >& H_fd = *H_plane->GetFDField(fn);
+				complex<float>**** E_field = Create_N_3DArray<complex<float> >(numLines);
+				complex<float>**** H_field = Create_N_3DArray<complex<float> >(numLines);
+				for (int n=0; n<3; ++n)
+					for (unsigned int i=0; i<numLines[0]; ++i)
+						for (unsigned int j=0; j<numLines[1]; ++j)
+							for (unsigned int k=0; k<numLines[2]; ++k)
+							{
+								E_field[n][i][j][k] = E_fd(n,i,j,k);
+								H_field[n][i][j][k] = H_fd(n,i,j,k);
+							}
+				E_fields.push_back(E_field);
+				H_fields.push_back(H_field);
+			}
+			// the nf2ff will cleanup the field data
+			far_field.AddPlane(lines, numLines, E_fields, H_fields, (int)m_Mesh_Type);
+		}
+
+		for (int n=0; n<3; ++n)
+			delete[] lines[n];
+	}
+
+	if (far_field.Write2HDF5(m_filename)==false)
+		cerr << "ProcessNF2FF::PostProcess: Error, writing the far-field to file: " << m_filename << " failed!" << endl;
+}
+
+void ProcessNF2FF::DumpBox2File(std::string vtkfilenameprefix, bool dualMesh) const
+{
+	for (size_t n=0; n<m_E_Planes.size(); ++n)
+		m_E_Planes.at(n)->DumpBox2File(vtkfilenameprefix, dualMesh);
+}
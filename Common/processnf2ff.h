@@ -0,0 +1,77 @@
+/*
+*	Copyright (C) 2026 Thorsten Liebig (Thorsten.Liebig@gmx.de)
+*
+*	This program is free software: you can redistribute it and/or modify
+*	it under the terms of the GNU General Public License as published by
+*	the Free Software Foundation, either version 3 of the License, or
+*	(at your option) any later version.
+*
+*	This program is distributed in the hope that it will be useful,
+*	but WITHOUT ANY WARRANTY; without even the implied warranty of
+*	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*	GNU General Public License for more details.
+*
+*	You should have received a copy of the GNU General Public License
+*	along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef PROCESSNF2FF_H
+#define PROCESSNF2FF_H
+
+#include "processfields_fd.h"
+
+//! Near-field to far-field transformation during the simulation run
+/*!
+  The E- and H-fields of all nf2ff surfaces are transformed to the frequency domain on-the-fly,
+  only the resulting far-field is written to file after the simulation has finished (same format as the nf2ff tool).
+  With MPI the nf2ff surfaces must not be split between ranks, otherwise the transformation is deactivated.
+  */
+class ProcessNF2FF : public Processing
+{
+public:
+	ProcessNF2FF(Engine_Interface_Base* eng_if);
+	virtual ~ProcessNF2FF();
+
+	virtual std::string GetProcessingName() const {return "nf2ff transformation";}
+
+	//! Add a nf2ff surface, the E- and H-field processing will take ownership of the given engine interfaces
+	void AddPlane(double* dstart, double* dstop, Engine_Interface_Base* eng_if_E, Engine_Interface_Base* eng_if_H);
+
+	//! Set the far-field angles (in radians)
+	void SetAngles(std::vector<float> theta, std::vector<float> phi) {m_Theta=theta;m_Phi=phi;}
+	void SetCenter(std::vector<float> center) {m_Center=center;}
+	void SetRadius(float radius) {m_Radius=radius;}
+	void SetPermittivity(std::vector<float> permittivity) {m_Permittivity=permittivity;}
+	void SetPermeability(std::vector<float> permeability) {m_Permeability=permeability;}
+	void SetMirror(int type, int dir, float pos);
+
+	//! Set the far-field result file name
+	void SetFileName(std::string fn) {m_filename=fn;}
+
+	virtual void SetEnable(bool val);
+
+	virtual void ShowSnappedCoords();
+
+	virtual void InitProcess();
+	virtual int Process();
+	virtual void PostProcess();
+
+	using Processing::DumpBox2File;
+	virtual void DumpBox2File(std::string vtkfilenameprefix, bool dualMesh) const;
+
+protected:
+	std::vector<ProcessFieldsFD*> m_E_Planes;
+	std::vector<ProcessFieldsFD*> m_H_Planes;
+
+	std::vector<float> m_Theta;
+	std::vector<float> m_Phi;
+	std::vector<float> m_Center;
+	float m_Radius;
+	std::vector<float> m_Permittivity;
+	std::vector<float> m_Permeability;
+
+	int m_MirrorType[3];
+	float m_MirrorPos[3];
+};
+
+#endif // PROCESSNF2FF_H
@@ -262,6 +262,59 @@ void Engine::Apply2Current()
 		m_Eng_exts.at(n)->Apply2Current();
 }
 
+void Engine::SumFieldSquares(unsigned int startX, unsigned int numX, double &E_energy, double &H_energy) const
+{
+	E_energy = 0;
+	H_energy = 0;
+	unsigned int pos[3];
+	if (m_type!=BASIC)
+	{
+		// unknown storage model, use the (slow) virtual access functions
+		for (pos[0]=startX; pos[0]<startX+numX; ++pos[0])
+			for (pos[1]=0; pos[1]<numLines[1]-1; ++pos[1])
+				for (pos[2]=0; pos[2]<numLines[2]-1; ++pos[2])
+					for (int n=0; n<3; ++n)
+					{
+						E_energy += GetVolt(n,pos) * GetVolt(n,pos);
+						H_energy += GetCurr(n,pos) * GetCurr(n,pos);
+					}
+		return;
+	}
+
+	ArrayLib::ArrayNIJK<FDTD_FLOAT>& volt = *volt_ptr;
+	ArrayLib::ArrayNIJK<FDTD_FLOAT>& curr = *curr_ptr;
+	// the three components of a z-line are stored contiguously
+	unsigned int numValues = 3*(numLines[2]-1);
+	for (pos[0]=startX; pos[0]<startX+numX; ++pos[0])
+	{
+		for (pos[1]=0; pos[1]<numLines[1]-1; ++pos[1])
+		{
+			const FDTD_FLOAT* v = &volt(0,pos[0],pos[1],0);
+			const FDTD_FLOAT* c = &curr(0,pos[0],pos[1],0);
+			FDTD_FLOAT E_line = 0;
+			FDTD_FLOAT H_line = 0;
+			for (unsigned int m=0; m<numValues; ++m)
+			{
+				E_line += v[m]*v[m];
+				H_line += c[m]*c[m];
+			}
+			E_energy += E_line;
+			H_energy += H_line;
+		}
+	}
+}
+
+void Engine::CalcFastEnergy(double &E_energy, double &H_energy)
+{
+	// single threaded engine, the multithreaded engine lets its worker threads sum up their own x-range
+	E_energy = 0;
+	H_energy = 0;
+	if (numLines[0]<2)
+		return;
+	// the last x-line is not part of the energy
+	SumFieldSquares(0, numLines[0]-1, E_energy, H_energy);
+}
+
 bool Engine::IterateTS(unsigned int iterTS)
 {
 	for (unsigned int iter=0; iter<iterTS; ++iter)
@@ -279,6 +332,8 @@ bool Engine::IterateTS(unsigned int iterTS)
 		Apply2Current();
 
 		++numTS;
+		if (m_TimestepSampler)
+			m_TimestepSampler(0, 1);
 	}
 	return true;
 }
@@ -19,6 +19,7 @@
 #define ENGINE_H
 
 #include <fstream>
+#include <functional>
 #include "operator.h"
 
 #include "tools/arraylib/array_nijk.h"
@@ -35,7 +36,7 @@ class Engine
 public:
 	enum EngineType
 	{
-		BASIC, SSE, UNKNOWN
+		BASIC, SSE, AVX2, AVX512, UNKNOWN
 	};
 
 	static Engine* New(const Operator* op);
@@ -49,6 +50,17 @@ public:
 
 	virtual unsigned int GetNumberOfTimesteps() {return numTS;}
 
+	//! Set a function to be called after every timestep of IterateTS(), e.g. to sample probes. Returns false if not supported by this engine.
+	/*!
+	  The function is called while all fields of the timestep are complete and no engine thread is modifying them.
+	  A multithreaded engine calls it from all its worker threads in parallel, each with its own \a part of \a numParts (sampler(part, numParts)).
+	  Use an empty function to remove the sampler.
+	  */
+	virtual bool SetTimestepSampler(std::function<void(unsigned int, unsigned int)> sampler) {m_TimestepSampler=sampler; return true;}
+
+	//! Get the number of worker threads used by this engine
+	virtual unsigned int GetNumberOfThreads() const {return 1;}
+
 	virtual void NextInterval(float curr_speed) {};
 
 	//this access functions muss be overloaded by any new engine using a different storage model
@@ -100,6 +112,22 @@ public:
 		curr[n][pos[0]][pos[1]][pos[2]] = value;
 	}
 
+	//! Copy \a num voltages of component \a n along the z-line (\a x,\a y), starting at \a zStart, into \a line. Bulk access for the processing.
+	inline virtual void GetVoltLine(unsigned int n, unsigned int x, unsigned int y, unsigned int zStart, unsigned int num, FDTD_FLOAT* line) const
+	{
+		ArrayLib::ArrayNIJK<FDTD_FLOAT>& volt = *volt_ptr;
+		for (unsigned int m=0; m<num; ++m)
+			line[m] = volt(n,x,y,zStart+m);
+	}
+
+	//! Copy \a num currents of component \a n along the z-line (\a x,\a y), starting at \a zStart, into \a line. Bulk access for the processing.
+	inline virtual void GetCurrLine(unsigned int n, unsigned int x, unsigned int y, unsigned int zStart, unsigned int num, FDTD_FLOAT* line) const
+	{
+		ArrayLib::ArrayNIJK<FDTD_FLOAT>& curr = *curr_ptr;
+		for (unsigned int m=0; m<num; ++m)
+			line[m] = curr(n,x,y,zStart+m);
+	}
+
 	//! Execute Pre-Voltage extension updates
 	virtual void DoPreVoltageUpdates();
 	//! Main FDTD engine voltage updates
@@ -124,6 +152,13 @@ public:
 
 	EngineType GetType() const {return m_type;}
 
+	//! Calculate the sum of all squared voltages (\a E_energy) and currents (\a H_energy), see Engine_Interface_Base::CalcFastEnergy()
+	/*!
+	  This default implementation is single-threaded, it is used by all engines except Engine_Multithread (and the engines derived from it),
+	  which distributes the sum over its worker threads.
+	  */
+	virtual void CalcFastEnergy(double &E_energy, double &H_energy);
+
 protected:
 	EngineType m_type;
 
@@ -136,11 +171,17 @@ protected:
 	ArrayLib::ArrayNIJK<FDTD_FLOAT>* curr_ptr;
 	unsigned int numTS;
 
+	std::function<void(unsigned int, unsigned int)> m_TimestepSampler;
+
 	virtual void InitExtensions();
 	virtual void ClearExtensions();
 	vector<Engine_Extension*> m_Eng_exts;
 
+	//! Sum the squared voltages and currents of the x-lines \a startX to \a startX+numX-1 (used by CalcFastEnergy)
+	virtual void SumFieldSquares(unsigned int startX, unsigned int numX, double &E_energy, double &H_energy) const;
+
 	friend class NS_Engine_Multithread::thread; // evil hack to access numTS from multithreading context
+	friend class Engine_Ext_CPML; // direct access to the basic engine fields
 };
 
 #endif // ENGINE_H
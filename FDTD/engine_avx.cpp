@@ -0,0 +1,364 @@
+/*
+*	Copyright (C) 2026 Thorsten Liebig (Thorsten.Liebig@gmx.de)
+*
+*	This program is free software: you can redistribute it and/or modify
+*	it under the terms of the GNU General Public License as published by
+*	the Free Software Foundation, either version 3 of the License, or
+*	(at your option) any later version.
+*
+*	This program is distributed in the hope that it will be useful,
+*	but WITHOUT ANY WARRANTY; without even the implied warranty of
+*	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*	GNU General Public License for more details.
+*
+*	You should have received a copy of the GNU General Public License
+*	along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "engine_avx.h"
+#include "tools/denormal.h"
+
+// Only the update kernels are compiled for the wider instruction sets, the remaining code
+// must run on any CPU as the engine is selected at runtime (see GetCPUVectorWidth()).
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define AVX2_TARGET __attribute__((target("avx2,fma")))
+#define AVX512_TARGET __attribute__((target("avx512f")))
+#else
+#define AVX2_TARGET
+#define AVX512_TARGET
+#endif
+
+// the ISA specific update functions, defined at the end of this file
+template <> AVX2_TARGET void Engine_AVX<f8vector>::UpdateVoltages(unsigned int startX, unsigned int numX);
+template <> AVX2_TARGET void Engine_AVX<f8vector>::UpdateCurrents(unsigned int startX, unsigned int numX);
+template <> AVX512_TARGET void Engine_AVX<f16vector>::UpdateVoltages(unsigned int startX, unsigned int numX);
+template <> AVX512_TARGET void Engine_AVX<f16vector>::UpdateCurrents(unsigned int startX, unsigned int numX);
+template <> AVX2_TARGET void Engine_AVX<f8vector>::SumFieldSquares(unsigned int startX, unsigned int numX, double &E_energy, double &H_energy) const;
+template <> AVX512_TARGET void Engine_AVX<f16vector>::SumFieldSquares(unsigned int startX, unsigned int numX, double &E_energy, double &H_energy) const;
+
+//! \brief construct an Engine_AVX instance
+//! it's the responsibility of the caller to free the returned pointer
+template <typename fNvector>
+Engine_AVX<fNvector>* Engine_AVX<fNvector>::New(const Operator_AVX<fNvector>* op)
+{
+	cout << "Create FDTD engine (AVX, " << numLanes << " floats per vector)" << endl;
+	Engine_AVX<fNvector>* e = new Engine_AVX<fNvector>(op);
+	e->Init();
+	return e;
+}
+
+template <typename fNvector>
+Engine_AVX<fNvector>::Engine_AVX(const Operator_AVX<fNvector>* op) : Engine(op)
+{
+	m_type = (numLanes==16) ? AVX512 : AVX2;
+	Op = op;
+	fN_volt_ptr = NULL;
+	fN_curr_ptr = NULL;
+	numVectors = op->GetNumberOfVectors();
+
+	// speed up the calculation of denormal floating point values (flush-to-zero)
+	Denormal::Disable();
+}
+
+template <typename fNvector>
+Engine_AVX<fNvector>::~Engine_AVX()
+{
+	Reset();
+}
+
+template <typename fNvector>
+void Engine_AVX<fNvector>::Init()
+{
+	Engine::Init();
+
+	// This engine uses its own SIMD arrays to represent E&M fields, so
+	// free the arrays from the base class.
+	delete volt_ptr;
+	volt_ptr = NULL;
+	delete curr_ptr;
+	curr_ptr = NULL;
+
+	fN_volt_ptr = new ArrayLib::ArrayNIJK<fNvector>(
+		"fN_volt", {numLines[0], numLines[1], numVectors}
+	);
+	fN_curr_ptr = new ArrayLib::ArrayNIJK<fNvector>(
+		"fN_curr", {numLines[0], numLines[1], numVectors}
+	);
+}
+
+template <typename fNvector>
+void Engine_AVX<fNvector>::Reset()
+{
+	Engine::Reset();
+	delete fN_volt_ptr;
+	fN_volt_ptr = NULL;
+	delete fN_curr_ptr;
+	fN_curr_ptr = NULL;
+}
+
+template <typename fNvector>
+void Engine_AVX<fNvector>::UpdateVoltagesKernel(unsigned int startX, unsigned int numX)
+{
+	ArrayLib::ArrayNIJK<fNvector>& fN_volt = *fN_volt_ptr;
+	ArrayLib::ArrayNIJK<fNvector>& fN_curr = *fN_curr_ptr;
+	ArrayLib::ArrayNIJK<fNvector>& fN_vv = *Op->fN_vv_ptr;
+	ArrayLib::ArrayNIJK<fNvector>& fN_vi = *Op->fN_vi_ptr;
+
+	unsigned int pos[3];
+	bool shift[2];
+	fNvector temp;
+
+	pos[0] = startX;
+	for (unsigned int posX=0; posX<numX; ++posX)
+	{
+		shift[0]=pos[0];
+		for (pos[1]=0; pos[1]<numLines[1]; ++pos[1])
+		{
+			shift[1]=pos[1];
+			for (pos[2]=1; pos[2]<numVectors; ++pos[2])
+			{
+				// x-polarization
+				fN_volt[0][pos[0]][pos[1]][pos[2]].v *=
+				    fN_vv[0][pos[0]][pos[1]][pos[2]].v;
+				fN_volt[0][pos[0]][pos[1]][pos[2]].v +=
+				    fN_vi[0][pos[0]][pos[1]][pos[2]].v * (
+				        fN_curr[2][pos[0]][pos[1]         ][pos[2]].v -
+				        fN_curr[2][pos[0]][pos[1]-shift[1]][pos[2]].v -
+				        fN_curr[1][pos[0]][pos[1]         ][pos[2]].v +
+				        fN_curr[1][pos[0]][pos[1]         ][pos[2]-1].v
+				    );
+
+				// y-polarization
+				fN_volt[1][pos[0]][pos[1]][pos[2]].v *=
+				    fN_vv[1][pos[0]][pos[1]][pos[2]].v;
+				fN_volt[1][pos[0]][pos[1]][pos[2]].v +=
+				    fN_vi[1][pos[0]][pos[1]][pos[2]].v * (
+				        fN_curr[0][pos[0]         ][pos[1]][pos[2]  ].v -
+				        fN_curr[0][pos[0]         ][pos[1]][pos[2]-1].v -
+				        fN_curr[2][pos[0]         ][pos[1]][pos[2]  ].v +
+				        fN_curr[2][pos[0]-shift[0]][pos[1]][pos[2]  ].v
+				    );
+
+				// z-polarization
+				fN_volt[2][pos[0]][pos[1]][pos[2]].v *=
+				    fN_vv[2][pos[0]][pos[1]][pos[2]].v;
+				fN_volt[2][pos[0]][pos[1]][pos[2]].v +=
+				    fN_vi[2][pos[0]][pos[1]][pos[2]].v * (
+				        fN_curr[1][pos[0]         ][pos[1]         ][pos[2]].v -
+				        fN_curr[1][pos[0]-shift[0]][pos[1]         ][pos[2]].v -
+				        fN_curr[0][pos[0]         ][pos[1]         ][pos[2]].v +
+				        fN_curr[0][pos[0]         ][pos[1]-shift[1]][pos[2]].v
+				    );
+			}
+
+			// for pos[2] = 0, the neighbor is found in the last vector shifted up by one lane
+			// x-polarization
+			temp.f[0] = 0;
+			for (unsigned int l=1; l<numLanes; ++l)
+				temp.f[l] = fN_curr[1][pos[0]][pos[1]][numVectors-1].f[l-1];
+			fN_volt[0][pos[0]][pos[1]][0].v *=
+			    fN_vv[0][pos[0]][pos[1]][0].v;
+			fN_volt[0][pos[0]][pos[1]][0].v +=
+			    fN_vi[0][pos[0]][pos[1]][0].v * (
+			        fN_curr[2][pos[0]][pos[1]         ][0].v -
+			        fN_curr[2][pos[0]][pos[1]-shift[1]][0].v -
+			        fN_curr[1][pos[0]][pos[1]         ][0].v +
+			        temp.v
+			    );
+
+			// y-polarization
+			temp.f[0] = 0;
+			for (unsigned int l=1; l<numLanes; ++l)
+				temp.f[l] = fN_curr[0][pos[0]][pos[1]][numVectors-1].f[l-1];
+			fN_volt[1][pos[0]][pos[1]][0].v *=
+			    fN_vv[1][pos[0]][pos[1]][0].v;
+			fN_volt[1][pos[0]][pos[1]][0].v +=
+			    fN_vi[1][pos[0]][pos[1]][0].v * (
+			        fN_curr[0][pos[0]         ][pos[1]][0].v -
+			        temp.v -
+			        fN_curr[2][pos[0]         ][pos[1]][0].v +
+			        fN_curr[2][pos[0]-shift[0]][pos[1]][0].v
+			    );
+
+			// z-polarization
+			fN_volt[2][pos[0]][pos[1]][0].v *=
+			    fN_vv[2][pos[0]][pos[1]][0].v;
+			fN_volt[2][pos[0]][pos[1]][0].v +=
+			    fN_vi[2][pos[0]][pos[1]][0].v * (
+			        fN_curr[1][pos[0]         ][pos[1]         ][0].v -
+			        fN_curr[1][pos[0]-shift[0]][pos[1]         ][0].v -
+			        fN_curr[0][pos[0]         ][pos[1]         ][0].v +
+			        fN_curr[0][pos[0]         ][pos[1]-shift[1]][0].v
+			    );
+		}
+		++pos[0];
+	}
+}
+
+template <typename fNvector>
+void Engine_AVX<fNvector>::UpdateCurrentsKernel(unsigned int startX, unsigned int numX)
+{
+	ArrayLib::ArrayNIJK<fNvector>& fN_curr = *fN_curr_ptr;
+	ArrayLib::ArrayNIJK<fNvector>& fN_volt = *fN_volt_ptr;
+	ArrayLib::ArrayNIJK<fNvector>& fN_ii = *Op->fN_ii_ptr;
+	ArrayLib::ArrayNIJK<fNvector>& fN_iv = *Op->fN_iv_ptr;
+
+	unsigned int pos[3];
+	fNvector temp;
+
+	pos[0] = startX;
+	for (unsigned int posX=0; posX<numX; ++posX)
+	{
+		for (pos[1]=0; pos[1]<numLines[1]-1; ++pos[1])
+		{
+			for (pos[2]=0; pos[2]<numVectors-1; ++pos[2])
+			{
+				// x-pol
+				fN_curr[0][pos[0]][pos[1]][pos[2]].v *=
+				    fN_ii[0][pos[0]][pos[1]][pos[2]].v;
+				fN_curr[0][pos[0]][pos[1]][pos[2]].v +=
+				    fN_iv[0][pos[0]][pos[1]][pos[2]].v * (
+				        fN_volt[2][pos[0]][pos[1]  ][pos[2]  ].v -
+				        fN_volt[2][pos[0]][pos[1]+1][pos[2]  ].v -
+				        fN_volt[1][pos[0]][pos[1]  ][pos[2]  ].v +
+				        fN_volt[1][pos[0]][pos[1]  ][pos[2]+1].v
+				    );
+
+				// y-pol
+				fN_curr[1][pos[0]][pos[1]][pos[2]].v *=
+				    fN_ii[1][pos[0]][pos[1]][pos[2]].v;
+				fN_curr[1][pos[0]][pos[1]][pos[2]].v +=
+				    fN_iv[1][pos[0]][pos[1]][pos[2]].v * (
+				        fN_volt[0][pos[0]  ][pos[1]][pos[2]  ].v -
+				        fN_volt[0][pos[0]  ][pos[1]][pos[2]+1].v -
+				        fN_volt[2][pos[0]  ][pos[1]][pos[2]  ].v +
+				        fN_volt[2][pos[0]+1][pos[1]][pos[2]  ].v
+				    );
+
+				// z-pol
+				fN_curr[2][pos[0]][pos[1]][pos[2]].v *=
+				    fN_ii[2][pos[0]][pos[1]][pos[2]].v;
+				fN_curr[2][pos[0]][pos[1]][pos[2]].v +=
+				    fN_iv[2][pos[0]][pos[1]][pos[2]].v * (
+				        fN_volt[1][pos[0]  ][pos[1]  ][pos[2]].v -
+				        fN_volt[1][pos[0]+1][pos[1]  ][pos[2]].v -
+				        fN_volt[0][pos[0]  ][pos[1]  ][pos[2]].v +
+				        fN_volt[0][pos[0]  ][pos[1]+1][pos[2]].v
+				    );
+			}
+
+			// for pos[2] = numVectors-1, the neighbor is found in the first vector shifted down by one lane
+			// x-pol
+			for (unsigned int l=0; l<numLanes-1; ++l)
+				temp.f[l] = fN_volt[1][pos[0]][pos[1]][0].f[l+1];
+			temp.f[numLanes-1] = 0;
+			fN_curr[0][pos[0]][pos[1]][numVectors-1].v *=
+			    fN_ii[0][pos[0]][pos[1]][numVectors-1].v;
+			fN_curr[0][pos[0]][pos[1]][numVectors-1].v +=
+			    fN_iv[0][pos[0]][pos[1]][numVectors-1].v * (
+			        fN_volt[2][pos[0]][pos[1]  ][numVectors-1].v -
+			        fN_volt[2][pos[0]][pos[1]+1][numVectors-1].v -
+			        fN_volt[1][pos[0]][pos[1]  ][numVectors-1].v +
+			        temp.v
+			    );
+
+			// y-pol
+			for (unsigned int l=0; l<numLanes-1; ++l)
+				temp.f[l] = fN_volt[0][pos[0]][pos[1]][0].f[l+1];
+			temp.f[numLanes-1] = 0;
+			fN_curr[1][pos[0]][pos[1]][numVectors-1].v *=
+			    fN_ii[1][pos[0]][pos[1]][numVectors-1].v;
+			fN_curr[1][pos[0]][pos[1]][numVectors-1].v +=
+			    fN_iv[1][pos[0]][pos[1]][numVectors-1].v * (
+			        fN_volt[0][pos[0]  ][pos[1]][numVectors-1].v -
+			        temp.v -
+			        fN_volt[2][pos[0]  ][pos[1]][numVectors-1].v +
+			        fN_volt[2][pos[0]+1][pos[1]][numVectors-1].v
+			    );
+
+			// z-pol
+			fN_curr[2][pos[0]][pos[1]][numVectors-1].v *=
+			    fN_ii[2][pos[0]][pos[1]][numVectors-1].v;
+			fN_curr[2][pos[0]][pos[1]][numVectors-1].v +=
+			    fN_iv[2][pos[0]][pos[1]][numVectors-1].v * (
+			        fN_volt[1][pos[0]  ][pos[1]  ][numVectors-1].v -
+			        fN_volt[1][pos[0]+1][pos[1]  ][numVectors-1].v -
+			        fN_volt[0][pos[0]  ][pos[1]  ][numVectors-1].v +
+			        fN_volt[0][pos[0]  ][pos[1]+1][numVectors-1].v
+			    );
+		}
+		++pos[0];
+	}
+}
+
+template <typename fNvector>
+void Engine_AVX<fNvector>::SumFieldSquaresKernel(unsigned int startX, unsigned int numX, double &E_energy, double &H_energy) const
+{
+	ArrayLib::ArrayNIJK<fNvector>& fN_volt = *fN_volt_ptr;
+	ArrayLib::ArrayNIJK<fNvector>& fN_curr = *fN_curr_ptr;
+
+	E_energy = 0;
+	H_energy = 0;
+	// the three components of a z-line are stored contiguously
+	unsigned int numValues = 3*numVectors;
+	fNvector E_line, H_line;
+	for (unsigned int x=startX; x<startX+numX; ++x)
+	{
+		for (unsigned int y=0; y<numLines[1]-1; ++y)
+		{
+			const fNvector* v = &fN_volt(0,x,y,0);
+			const fNvector* c = &fN_curr(0,x,y,0);
+			E_line.v = v[0].v*v[0].v;
+			H_line.v = c[0].v*c[0].v;
+			for (unsigned int m=1; m<numValues; ++m)
+			{
+				E_line.v += v[m].v*v[m].v;
+				H_line.v += c[m].v*c[m].v;
+			}
+			for (unsigned int l=0; l<numLanes; ++l)
+			{
+				E_energy += E_line.f[l];
+				H_energy += H_line.f[l];
+			}
+		}
+	}
+}
+
+template <>
+AVX2_TARGET void Engine_AVX<f8vector>::UpdateVoltages(unsigned int startX, unsigned int numX)
+{
+	UpdateVoltagesKernel(startX, numX);
+}
+
+template <>
+AVX2_TARGET void Engine_AVX<f8vector>::UpdateCurrents(unsigned int startX, unsigned int numX)
+{
+	UpdateCurrentsKernel(startX, numX);
+}
+
+template <>
+AVX512_TARGET void Engine_AVX<f16vector>::UpdateVoltages(unsigned int startX, unsigned int numX)
+{
+	UpdateVoltagesKernel(startX, numX);
+}
+
+template <>
+AVX512_TARGET void Engine_AVX<f16vector>::UpdateCurrents(unsigned int startX, unsigned int numX)
+{
+	UpdateCurrentsKernel(startX, numX);
+}
+
+template <>
+AVX2_TARGET void Engine_AVX<f8vector>::SumFieldSquares(unsigned int startX, unsigned int numX, double &E_energy, double &H_energy) const
+{
+	SumFieldSquaresKernel(startX, numX, E_energy, H_energy);
+}
+
+template <>
+AVX512_TARGET void Engine_AVX<f16vector>::SumFieldSquares(unsigned int startX, unsigned int numX, double &E_energy, double &H_energy) const
+{
+	SumFieldSquaresKernel(startX, numX, E_energy, H_energy);
+}
+
+template class Engine_AVX<f8vector>;
+template class Engine_AVX<f16vector>;
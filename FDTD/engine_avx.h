@@ -0,0 +1,136 @@
+/*
+*	Copyright (C) 2026 Thorsten Liebig (Thorsten.Liebig@gmx.de)
+*
+*	This program is free software: you can redistribute it and/or modify
+*	it under the terms of the GNU General Public License as published by
+*	the Free Software Foundation, either version 3 of the License, or
+*	(at your option) any later version.
+*
+*	This program is distributed in the hope that it will be useful,
+*	but WITHOUT ANY WARRANTY; without even the implied warranty of
+*	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*	GNU General Public License for more details.
+*
+*	You should have received a copy of the GNU General Public License
+*	along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef ENGINE_AVX_H
+#define ENGINE_AVX_H
+
+#include "engine.h"
+#include "operator_avx.h"
+
+#include "tools/arraylib/array_nijk.h"
+
+#if defined(__GNUC__)
+#define ENGINE_AVX_KERNEL inline __attribute__((always_inline))
+#else
+#define ENGINE_AVX_KERNEL inline
+#endif
+
+//! FDTD engine using 8 (AVX2) or 16 (AVX-512) floats per vector
+/*!
+  Counterpart of Engine_sse for wider vector units. Only the update kernels are compiled for the respective instruction set,
+  the engine must only be created if the CPU supports it, see GetCPUVectorWidth().
+  The engine is single-threaded, it is not used by Engine_Multithread or Engine_Tiling which are based on Engine_SSE_Compressed.
+  */
+template <typename fNvector>
+class Engine_AVX : public Engine
+{
+public:
+	static Engine_AVX* New(const Operator_AVX<fNvector>* op);
+	virtual ~Engine_AVX();
+
+	virtual void Init();
+	virtual void Reset();
+
+	virtual unsigned int GetNumberOfTimesteps() {return numTS;};
+
+	static const unsigned int numLanes = Operator_AVX<fNvector>::numLanes;
+
+	//this access functions muss be overloaded by any new engine using a different storage model
+	inline virtual FDTD_FLOAT GetVolt(unsigned int n, unsigned int x, unsigned int y, unsigned int z) const
+	{
+		ArrayLib::ArrayNIJK<fNvector>& fN_volt = *fN_volt_ptr;
+		return fN_volt[n][x][y][z%numVectors].f[z/numVectors];
+	}
+
+	inline virtual FDTD_FLOAT GetVolt(unsigned int n, const unsigned int pos[3]) const
+	{
+		ArrayLib::ArrayNIJK<fNvector>& fN_volt = *fN_volt_ptr;
+		return fN_volt[n][pos[0]][pos[1]][pos[2]%numVectors].f[pos[2]/numVectors];
+	}
+
+	inline virtual FDTD_FLOAT GetCurr(unsigned int n, unsigned int x, unsigned int y, unsigned int z) const
+	{
+		ArrayLib::ArrayNIJK<fNvector>& fN_curr = *fN_curr_ptr;
+		return fN_curr[n][x][y][z%numVectors].f[z/numVectors];
+	}
+
+	inline virtual FDTD_FLOAT GetCurr(unsigned int n, const unsigned int pos[3]) const
+	{
+		ArrayLib::ArrayNIJK<fNvector>& fN_curr = *fN_curr_ptr;
+		return fN_curr[n][pos[0]][pos[1]][pos[2]%numVectors].f[pos[2]/numVectors];
+	}
+
+	inline virtual void SetVolt(unsigned int n, unsigned int x, unsigned int y, unsigned int z, FDTD_FLOAT value)
+	{
+		ArrayLib::ArrayNIJK<fNvector>& fN_volt = *fN_volt_ptr;
+		fN_volt[n][x][y][z%numVectors].f[z/numVectors]=value;
+	}
+
+	inline virtual void SetVolt(unsigned int n, const unsigned int pos[3], FDTD_FLOAT value)
+	{
+		ArrayLib::ArrayNIJK<fNvector>& fN_volt = *fN_volt_ptr;
+		fN_volt[n][pos[0]][pos[1]][pos[2]%numVectors].f[pos[2]/numVectors]=value;
+	}
+
+	inline virtual void SetCurr(unsigned int n, unsigned int x, unsigned int y, unsigned int z, FDTD_FLOAT value)
+	{
+		ArrayLib::ArrayNIJK<fNvector>& fN_curr = *fN_curr_ptr;
+		fN_curr[n][x][y][z%numVectors].f[z/numVectors]=value;
+	}
+
+	inline virtual void SetCurr(unsigned int n, const unsigned int pos[3], FDTD_FLOAT value)
+	{
+		ArrayLib::ArrayNIJK<fNvector>& fN_curr = *fN_curr_ptr;
+		fN_curr[n][pos[0]][pos[1]][pos[2]%numVectors].f[pos[2]/numVectors]=value;
+	}
+
+	inline virtual void GetVoltLine(unsigned int n, unsigned int x, unsigned int y, unsigned int zStart, unsigned int num, FDTD_FLOAT* line) const
+	{
+		ArrayLib::ArrayNIJK<fNvector>& fN_volt = *fN_volt_ptr;
+		for (unsigned int z=zStart; z<zStart+num; ++z)
+			line[z-zStart] = fN_volt(n,x,y,z%numVectors).f[z/numVectors];
+	}
+
+	inline virtual void GetCurrLine(unsigned int n, unsigned int x, unsigned int y, unsigned int zStart, unsigned int num, FDTD_FLOAT* line) const
+	{
+		ArrayLib::ArrayNIJK<fNvector>& fN_curr = *fN_curr_ptr;
+		for (unsigned int z=zStart; z<zStart+num; ++z)
+			line[z-zStart] = fN_curr(n,x,y,z%numVectors).f[z/numVectors];
+	}
+
+protected:
+	Engine_AVX(const Operator_AVX<fNvector>* op);
+	const Operator_AVX<fNvector>* Op;
+
+	virtual void UpdateVoltages(unsigned int startX, unsigned int numX);
+	virtual void UpdateCurrents(unsigned int startX, unsigned int numX);
+
+	//! Generic update kernels, inlined into the ISA specific UpdateVoltages()/UpdateCurrents()
+	ENGINE_AVX_KERNEL void UpdateVoltagesKernel(unsigned int startX, unsigned int numX);
+	ENGINE_AVX_KERNEL void UpdateCurrentsKernel(unsigned int startX, unsigned int numX);
+
+	virtual void SumFieldSquares(unsigned int startX, unsigned int numX, double &E_energy, double &H_energy) const;
+	ENGINE_AVX_KERNEL void SumFieldSquaresKernel(unsigned int startX, unsigned int numX, double &E_energy, double &H_energy) const;
+
+	unsigned int numVectors;
+
+public: //public access to the avx arrays for efficient extensions access... use careful...
+	ArrayLib::ArrayNIJK<fNvector>* fN_volt_ptr;
+	ArrayLib::ArrayNIJK<fNvector>* fN_curr_ptr;
+};
+
+#endif // ENGINE_AVX_H
@@ -68,7 +68,7 @@ Engine_CylinderMultiGrid::~Engine_CylinderMultiGrid()
 #endif
 
 	m_Thread_NumTS = 0;
-	m_startBarrier->wait();
+	m_IterStartBarrier->wait();
 
 	m_IteratorThread_Group.join_all();
 
@@ -82,27 +82,33 @@ Engine_CylinderMultiGrid::~Engine_CylinderMultiGrid()
 	delete m_WaitOnSync;
 	m_WaitOnSync = NULL;
 
-	delete m_startBarrier;
-	m_startBarrier = NULL;
-	delete m_stopBarrier;
-	m_stopBarrier = NULL;
+	delete m_IterStartBarrier;
+	m_IterStartBarrier = NULL;
+	delete m_IterStopBarrier;
+	m_IterStopBarrier = NULL;
 }
 
 void Engine_CylinderMultiGrid::Init()
 {
 	Engine_Multithread::Init();
 
+#ifdef MPI_SUPPORT
+	// the synchronization with the inner engine requires the blocking MPI transfer
+	m_MPI_Overlap = false;
+	m_InnerEngine->m_MPI_Overlap = false;
+#endif
+
 	m_Eng_exts.push_back(m_Eng_Ext_MG);
 
-	m_startBarrier = new boost::barrier(3); //both engines + organizer
-	m_stopBarrier = new boost::barrier(3); //both engines + organizer
+	m_IterStartBarrier = new boost::barrier(3); //both engines + organizer
+	m_IterStopBarrier = new boost::barrier(3); //both engines + organizer
 
 	boost::thread *t = NULL;
 
-	t = new boost::thread( Engine_CylinderMultiGrid_Thread(this,m_startBarrier,m_stopBarrier,&m_Thread_NumTS, true) );
+	t = new boost::thread( Engine_CylinderMultiGrid_Thread(this,m_IterStartBarrier,m_IterStopBarrier,&m_Thread_NumTS, true) );
 	m_IteratorThread_Group.add_thread( t );
 
-	t = new boost::thread( Engine_CylinderMultiGrid_Thread(m_InnerEngine,m_startBarrier,m_stopBarrier,&m_Thread_NumTS, false) );
+	t = new boost::thread( Engine_CylinderMultiGrid_Thread(m_InnerEngine,m_IterStartBarrier,m_IterStopBarrier,&m_Thread_NumTS, false) );
 	m_IteratorThread_Group.add_thread( t );
 
 	m_InnerEngine->SortExtensionByPriority();
@@ -118,9 +124,9 @@ bool Engine_CylinderMultiGrid::IterateTS(unsigned int iterTS)
 {
 	m_Thread_NumTS = iterTS;
 
-	m_startBarrier->wait(); //start base and child iterations
+	m_IterStartBarrier->wait(); //start base and child iterations
 
-	m_stopBarrier->wait();  //tell base and child to wait for another start event...
+	m_IterStopBarrier->wait();  //tell base and child to wait for another start event...
 
 	//interpolate child data to base mesh...
 	for (unsigned int n=0; n<Op_CMG->m_Split_Pos-1; ++n)
@@ -209,8 +215,8 @@ void Engine_CylinderMultiGrid::InterpolCurrChild2Base(unsigned int rPos)
 /****************************************************************************************/
 Engine_CylinderMultiGrid_Thread::Engine_CylinderMultiGrid_Thread( Engine_Multithread* engine, boost::barrier *start, boost::barrier *stop, volatile unsigned int* numTS, bool isBase)
 {
-	m_startBarrier = start;
-	m_stopBarrier = stop;
+	m_IterStartBarrier = start;
+	m_IterStopBarrier = stop;
 	m_Eng=engine;
 	m_isBase=isBase;
 	m_numTS = numTS;
@@ -218,7 +224,7 @@ Engine_CylinderMultiGrid_Thread::Engine_CylinderMultiGrid_Thread( Engine_Multith
 
 void Engine_CylinderMultiGrid_Thread::operator()()
 {
-	m_startBarrier->wait(); //wait for Base engine to start the iterations...
+	m_IterStartBarrier->wait(); //wait for Base engine to start the iterations...
 
 	while (*m_numTS>0)	//m_numTS==0 request to terminate this thread...
 	{
@@ -226,7 +232,7 @@ void Engine_CylinderMultiGrid_Thread::operator()()
 			m_Eng->Engine_Multithread::IterateTS(*m_numTS);
 		else
 			m_Eng->IterateTS(*m_numTS);
-		m_stopBarrier->wait();		//sync all workers after iterations are performed
-		m_startBarrier->wait();		//wait for Base engine to start the iterations again ...
+		m_IterStopBarrier->wait();		//sync all workers after iterations are performed
+		m_IterStartBarrier->wait();		//wait for Base engine to start the iterations again ...
 	}
 }
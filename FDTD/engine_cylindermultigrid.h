@@ -41,6 +41,9 @@ public:
 	//! Iterate \a iterTS number of timesteps
 	virtual bool IterateTS(unsigned int iterTS);
 
+	//! Sampling is not supported, the base and child engine are iterated independently
+	virtual bool SetTimestepSampler(std::function<void(unsigned int, unsigned int)> sampler) {return !sampler;}
+
 protected:
 	Engine_CylinderMultiGrid(const Operator_CylinderMultiGrid* op);
 	const Operator_CylinderMultiGrid* Op_CMG;
@@ -49,8 +52,8 @@ protected:
 
 	volatile unsigned int m_Thread_NumTS;
 	boost::thread_group m_IteratorThread_Group;
-	boost::barrier *m_startBarrier;
-	boost::barrier *m_stopBarrier;
+	boost::barrier *m_IterStartBarrier;
+	boost::barrier *m_IterStopBarrier;
 	Engine_CylinderMultiGrid_Thread* m_IteratorThread;
 	Engine_CylinderMultiGrid_Thread* m_InnerIteratorThread;
 
@@ -77,8 +80,8 @@ public:
 protected:
 	Engine_Multithread *m_Eng;
 	bool m_isBase;
-	boost::barrier *m_startBarrier;
-	boost::barrier *m_stopBarrier;
+	boost::barrier *m_IterStartBarrier;
+	boost::barrier *m_IterStopBarrier;
 	volatile unsigned int *m_numTS;
 };
 
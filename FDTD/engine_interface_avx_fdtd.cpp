@@ -0,0 +1,40 @@
+/*
+*	Copyright (C) 2026 Thorsten Liebig (Thorsten.Liebig@gmx.de)
+*
+*	This program is free software: you can redistribute it and/or modify
+*	it under the terms of the GNU General Public License as published by
+*	the Free Software Foundation, either version 3 of the License, or
+*	(at your option) any later version.
+*
+*	This program is distributed in the hope that it will be useful,
+*	but WITHOUT ANY WARRANTY; without even the implied warranty of
+*	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*	GNU General Public License for more details.
+*
+*	You should have received a copy of the GNU General Public License
+*	along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "engine_interface_avx_fdtd.h"
+
+template <typename fNvector>
+Engine_Interface_AVX_FDTD<fNvector>::Engine_Interface_AVX_FDTD(Operator_AVX<fNvector>* op) : Engine_Interface_FDTD(op)
+{
+	m_Op_AVX = op;
+	m_Eng_AVX = dynamic_cast<Engine_AVX<fNvector>*>(m_Op_AVX->GetEngine());
+	if (m_Eng_AVX==NULL)
+	{
+		cerr << "Engine_Interface_AVX_FDTD::Engine_Interface_AVX_FDTD: Error: AVX-Engine is not set! Exit!" << endl;
+		exit(1);
+	}
+}
+
+template <typename fNvector>
+Engine_Interface_AVX_FDTD<fNvector>::~Engine_Interface_AVX_FDTD()
+{
+	m_Op_AVX=NULL;
+	m_Eng_AVX=NULL;
+}
+
+template class Engine_Interface_AVX_FDTD<f8vector>;
+template class Engine_Interface_AVX_FDTD<f16vector>;
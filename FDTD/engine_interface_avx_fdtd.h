@@ -0,0 +1,37 @@
+/*
+*	Copyright (C) 2026 Thorsten Liebig (Thorsten.Liebig@gmx.de)
+*
+*	This program is free software: you can redistribute it and/or modify
+*	it under the terms of the GNU General Public License as published by
+*	the Free Software Foundation, either version 3 of the License, or
+*	(at your option) any later version.
+*
+*	This program is distributed in the hope that it will be useful,
+*	but WITHOUT ANY WARRANTY; without even the implied warranty of
+*	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*	GNU General Public License for more details.
+*
+*	You should have received a copy of the GNU General Public License
+*	along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef ENGINE_INTERFACE_AVX_FDTD_H
+#define ENGINE_INTERFACE_AVX_FDTD_H
+
+#include "engine_interface_fdtd.h"
+#include "operator_avx.h"
+#include "engine_avx.h"
+
+template <typename fNvector>
+class Engine_Interface_AVX_FDTD : public Engine_Interface_FDTD
+{
+public:
+	Engine_Interface_AVX_FDTD(Operator_AVX<fNvector>* op);
+	virtual ~Engine_Interface_AVX_FDTD();
+
+protected:
+	Operator_AVX<fNvector>* m_Op_AVX;
+	Engine_AVX<fNvector>* m_Eng_AVX;
+};
+
+#endif // ENGINE_INTERFACE_AVX_FDTD_H
@@ -34,6 +34,9 @@ protected:
 
 	//! Internal method to get an interpolated field of a given type. (0: E, 1: J, 2: rotH)
 	virtual double* GetRawInterpolatedField(const unsigned int* pos, double* out, int type) const;
+
+	//! The cylindrical edge lengths are not separable, use the generic field box access.
+	virtual bool CalcFieldBoxStencil() {return false;}
 };
 
 #endif // ENGINE_INTERFACE_CYLINDRICAL_FDTD_H
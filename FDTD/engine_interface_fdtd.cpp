@@ -17,6 +17,8 @@
 
 #include "engine_interface_fdtd.h"
 
+#include <climits>
+
 Engine_Interface_FDTD::Engine_Interface_FDTD(Operator* op) : Engine_Interface_Base(op)
 {
 	if (op==NULL)
@@ -31,6 +33,8 @@ Engine_Interface_FDTD::Engine_Interface_FDTD(Operator* op) : Engine_Interface_Ba
 		cerr << "Engine_Interface_FDTD::Engine_Interface_FDTD: Error: Engine is not set! Exit!" << endl;
 		exit(1);
 	}
+	m_BoxStencilValid = false;
+	m_BoxInterpolType = NO_INTERPOLATION;
 }
 
 Engine_Interface_FDTD::~Engine_Interface_FDTD()
@@ -200,6 +204,197 @@ double* Engine_Interface_FDTD::GetRawInterpolatedDualField(const unsigned int* p
 	return out;
 }
 
+void Engine_Interface_FDTD::SetFieldBox(unsigned int const* numLines, unsigned int const* const* posLines)
+{
+	Engine_Interface_Base::SetFieldBox(numLines, posLines);
+	m_BoxInterpolType = m_InterpolType;
+	m_BoxStencilValid = CalcFieldBoxStencil();
+}
+
+void Engine_Interface_FDTD::SetBoxStencil(FieldBoxStencil& stencil, unsigned int idx, unsigned int pos0, FDTD_FLOAT weight0, unsigned int pos1, FDTD_FLOAT weight1)
+{
+	stencil.pos[0][idx] = pos0;
+	stencil.weight[0][idx] = weight0;
+	stencil.pos[1][idx] = (weight1==0) ? pos0 : pos1;
+	stencil.weight[1][idx] = weight1;
+}
+
+bool Engine_Interface_FDTD::CalcFieldBoxStencil()
+{
+	// the edge length only depends on the position in its own direction, the stencil is separable
+	unsigned int pos[3] = {0,0,0};
+	double len, lenNext, rel;
+	for (int dual=0; dual<2; ++dual)
+		for (int n=0; n<3; ++n)
+			for (int d=0; d<3; ++d)
+			{
+				FieldBoxStencil& stencil = m_BoxStencil[dual][n][d];
+				unsigned int num = m_BoxLines[d].size();
+				unsigned int last = m_Op->GetNumberOfLines(d,true)-1;
+				for (int m=0; m<2; ++m)
+				{
+					stencil.pos[m].resize(num);
+					stencil.weight[m].resize(num);
+				}
+				for (unsigned int i=0; i<num; ++i)
+				{
+					unsigned int p = m_BoxLines[d][i];
+					pos[d] = p;
+					len = (d==n) ? m_Op->GetEdgeLength(n,pos,dual) : 1.0;
+					double inv = (len!=0) ? 1.0/len : 0.0;
+					SetBoxStencil(stencil, i, p, inv);
+					if (dual==0)
+					{
+						switch (m_InterpolType)
+						{
+						default:
+						case NO_INTERPOLATION:
+							break;
+						case NODE_INTERPOLATE:
+							if (d!=n)
+								break;
+							if (p==last) // use only the "lower value" at the upper bound
+							{
+								pos[d] = p-1;
+								len = m_Op->GetEdgeLength(n,pos);
+								SetBoxStencil(stencil, i, p-1, (len!=0) ? 1.0/len : 0.0);
+							}
+							else if ((len!=0) && (p>0))
+							{
+								pos[d] = p-1;
+								lenNext = m_Op->GetEdgeLength(n,pos);
+								rel = len / (len+lenNext);
+								SetBoxStencil(stencil, i, p, (1.0-rel)*inv, p-1, (lenNext!=0) ? rel/lenNext : 0.0);
+							}
+							break;
+						case CELL_INTERPOLATE:
+							if (p==last) // electric field outside the field domain is always zero
+								SetBoxStencil(stencil, i, p, 0);
+							else if (d!=n)
+								SetBoxStencil(stencil, i, p, 0.5, p+1, 0.5);
+							break;
+						}
+					}
+					else
+					{
+						switch (m_InterpolType)
+						{
+						default:
+						case NO_INTERPOLATION:
+							break;
+						case NODE_INTERPOLATE:
+							if ((p==last) || ((d!=n) && (p==0)))
+								SetBoxStencil(stencil, i, p, 0);
+							else if (d!=n)
+								SetBoxStencil(stencil, i, p, 0.5, p-1, 0.5);
+							break;
+						case CELL_INTERPOLATE:
+							if (d!=n)
+								break;
+							if (p>=last) // magnetic field on the outer boundaries is always zero
+							{
+								SetBoxStencil(stencil, i, p, 0);
+								break;
+							}
+							pos[d] = p+1;
+							lenNext = m_Op->GetEdgeLength(n,pos,true);
+							rel = len / (len+lenNext);
+							SetBoxStencil(stencil, i, p, (1.0-rel)*inv, p+1, (lenNext!=0) ? rel/lenNext : 0.0);
+							break;
+						}
+					}
+				}
+				pos[d] = 0;
+
+				if (d<2)
+					continue;
+				// store the z-positions relative to the first needed line
+				unsigned int zMin = UINT_MAX, zMax = 0;
+				for (int m=0; m<2; ++m)
+					for (unsigned int i=0; i<num; ++i)
+					{
+						zMin = min(zMin, stencil.pos[m][i]);
+						zMax = max(zMax, stencil.pos[m][i]);
+					}
+				if (num==0)
+					zMin = zMax = 0;
+				for (int m=0; m<2; ++m)
+					for (unsigned int i=0; i<num; ++i)
+						stencil.pos[m][i] -= zMin;
+				m_BoxZStart[dual][n] = zMin;
+				m_BoxZNum[dual][n] = zMax-zMin+1;
+			}
+	return true;
+}
+
+bool Engine_Interface_FDTD::GetFieldLine(FieldType type, unsigned int i, unsigned int j, FDTD_FLOAT* line[3]) const
+{
+	if ((m_BoxStencilValid==false) || (m_BoxInterpolType!=m_InterpolType) || (type==ROTH_FIELD))
+		return Engine_Interface_Base::GetFieldLine(type, i, j, line);
+	if ((i>=m_BoxLines[0].size()) || (j>=m_BoxLines[1].size()))
+		return false;
+
+	int dual = ((type==H_FIELD) || (type==B_FIELD));
+	ArrayLib::ArrayNIJK<float>* material = NULL;
+	if (type==J_FIELD)
+		material = m_Op->m_kappa_ptr;
+	else if (type==D_FIELD)
+		material = m_Op->m_epsR_ptr;
+	else if (type==B_FIELD)
+		material = m_Op->m_mueR_ptr;
+	bool noMaterial = ((type==J_FIELD) || (type==D_FIELD) || (type==B_FIELD)) && (material==NULL);
+
+	unsigned int numZ = m_BoxLines[2].size();
+	std::vector<FDTD_FLOAT> buffer;
+	for (int n=0; n<3; ++n)
+	{
+		FDTD_FLOAT* out = line[n];
+		for (unsigned int k=0; k<numZ; ++k)
+			out[k] = 0;
+		if (noMaterial)
+			continue;
+
+		const FieldBoxStencil& sx = m_BoxStencil[dual][n][0];
+		const FieldBoxStencil& sy = m_BoxStencil[dual][n][1];
+		const FieldBoxStencil& sz = m_BoxStencil[dual][n][2];
+		unsigned int zStart = m_BoxZStart[dual][n];
+		unsigned int zNum = m_BoxZNum[dual][n];
+		buffer.resize(zNum);
+		FDTD_FLOAT* buf = &buffer[0];
+		const unsigned int* pz0 = &sz.pos[0][0];
+		const unsigned int* pz1 = &sz.pos[1][0];
+		const FDTD_FLOAT* wz0 = &sz.weight[0][0];
+		const FDTD_FLOAT* wz1 = &sz.weight[1][0];
+
+		for (int a=0; a<2; ++a)
+		{
+			if (sx.weight[a][i]==0)
+				continue;
+			unsigned int x = sx.pos[a][i];
+			for (int b=0; b<2; ++b)
+			{
+				FDTD_FLOAT w = sx.weight[a][i]*sy.weight[b][j];
+				if (w==0)
+					continue;
+				unsigned int y = sy.pos[b][j];
+				if (dual)
+					m_Eng->GetCurrLine(n, x, y, zStart, zNum, buf);
+				else
+					m_Eng->GetVoltLine(n, x, y, zStart, zNum, buf);
+				if (material)
+				{
+					ArrayLib::ArrayNIJK<float>& mat = *material;
+					for (unsigned int m=0; m<zNum; ++m)
+						buf[m] *= mat(n, x, y, zStart+m);
+				}
+				for (unsigned int k=0; k<numZ; ++k)
+					out[k] += w*(wz0[k]*buf[pz0[k]] + wz1[k]*buf[pz1[k]]);
+			}
+		}
+	}
+	return true;
+}
+
 double Engine_Interface_FDTD::CalcVoltageIntegral(const unsigned int* start, const unsigned int* stop) const
 {
 	if (((start[0]!=stop[0]) + (start[1]!=stop[1]) + (start[2]!=stop[2]))!=1)
@@ -300,45 +495,6 @@ double Engine_Interface_FDTD::CalcFastEnergy() const
 {
 	double E_energy=0.0;
 	double H_energy=0.0;
-
-	unsigned int pos[3];
-	if (m_Eng->GetType()==Engine::BASIC)
-	{
-		for (pos[0]=0; pos[0]<m_Op->GetNumberOfLines(0)-1; ++pos[0])
-		{
-			for (pos[1]=0; pos[1]<m_Op->GetNumberOfLines(1)-1; ++pos[1])
-			{
-				for (pos[2]=0; pos[2]<m_Op->GetNumberOfLines(2)-1; ++pos[2])
-				{
-					E_energy+=m_Eng->Engine::GetVolt(0,pos[0],pos[1],pos[2]) * m_Eng->Engine::GetVolt(0,pos[0],pos[1],pos[2]);
-					E_energy+=m_Eng->Engine::GetVolt(1,pos[0],pos[1],pos[2]) * m_Eng->Engine::GetVolt(1,pos[0],pos[1],pos[2]);
-					E_energy+=m_Eng->Engine::GetVolt(2,pos[0],pos[1],pos[2]) * m_Eng->Engine::GetVolt(2,pos[0],pos[1],pos[2]);
-
-					H_energy+=m_Eng->Engine::GetCurr(0,pos[0],pos[1],pos[2]) * m_Eng->Engine::GetCurr(0,pos[0],pos[1],pos[2]);
-					H_energy+=m_Eng->Engine::GetCurr(1,pos[0],pos[1],pos[2]) * m_Eng->Engine::GetCurr(1,pos[0],pos[1],pos[2]);
-					H_energy+=m_Eng->Engine::GetCurr(2,pos[0],pos[1],pos[2]) * m_Eng->Engine::GetCurr(2,pos[0],pos[1],pos[2]);
-				}
-			}
-		}
-	}
-	else
-	{
-		for (pos[0]=0; pos[0]<m_Op->GetNumberOfLines(0)-1; ++pos[0])
-		{
-			for (pos[1]=0; pos[1]<m_Op->GetNumberOfLines(1)-1; ++pos[1])
-			{
-				for (pos[2]=0; pos[2]<m_Op->GetNumberOfLines(2)-1; ++pos[2])
-				{
-					E_energy+=m_Eng->GetVolt(0,pos[0],pos[1],pos[2]) * m_Eng->GetVolt(0,pos[0],pos[1],pos[2]);
-					E_energy+=m_Eng->GetVolt(1,pos[0],pos[1],pos[2]) * m_Eng->GetVolt(1,pos[0],pos[1],pos[2]);
-					E_energy+=m_Eng->GetVolt(2,pos[0],pos[1],pos[2]) * m_Eng->GetVolt(2,pos[0],pos[1],pos[2]);
-
-					H_energy+=m_Eng->GetCurr(0,pos[0],pos[1],pos[2]) * m_Eng->GetCurr(0,pos[0],pos[1],pos[2]);
-					H_energy+=m_Eng->GetCurr(1,pos[0],pos[1],pos[2]) * m_Eng->GetCurr(1,pos[0],pos[1],pos[2]);
-					H_energy+=m_Eng->GetCurr(2,pos[0],pos[1],pos[2]) * m_Eng->GetCurr(2,pos[0],pos[1],pos[2]);
-				}
-			}
-		}
-	}
+	m_Eng->CalcFastEnergy(E_energy, H_energy);
 	return __EPS0__*E_energy + __MUE0__*H_energy;
 }
@@ -47,17 +47,40 @@ public:
 	virtual double* GetDField(const unsigned int* pos, double* out) const;
 	virtual double* GetBField(const unsigned int* pos, double* out) const;
 
+	virtual void SetFieldBox(unsigned int const* numLines, unsigned int const* const* posLines);
+	virtual bool GetFieldLine(FieldType type, unsigned int i, unsigned int j, FDTD_FLOAT* line[3]) const;
+
 	virtual double CalcVoltageIntegral(const unsigned int* start, const unsigned int* stop) const;
 
 	virtual double GetTime(bool dualTime=false) const {return ((double)m_Eng->GetNumberOfTimesteps() + (double)dualTime*0.5)*m_Op->GetTimestep();};
 	virtual unsigned int GetNumberOfTimesteps() const {return m_Eng->GetNumberOfTimesteps();}
 
+	virtual unsigned int GetNumberOfThreads() const {return m_Eng->GetNumberOfThreads();}
+
 	virtual double CalcFastEnergy() const;
 
 protected:
 	Operator* m_Op;
 	Engine* m_Eng;
 
+	//! Interpolation stencil of a field component in one direction of the field box, each box line is interpolated from two mesh lines.
+	struct FieldBoxStencil
+	{
+		std::vector<unsigned int> pos[2];
+		std::vector<FDTD_FLOAT> weight[2];
+	};
+	//! Precomputed stencils of the field box: [0: E/J/D, 1: H/B][component][direction], z positions are relative to m_BoxZStart \sa SetFieldBox
+	FieldBoxStencil m_BoxStencil[2][3][3];
+	unsigned int m_BoxZStart[2][3];
+	unsigned int m_BoxZNum[2][3];
+	bool m_BoxStencilValid;
+	InterpolationType m_BoxInterpolType;
+
+	//! Calculate the interpolation stencils of the field box for the current interpolation type. Return false if the mesh is not supported.
+	virtual bool CalcFieldBoxStencil();
+	//! Internal method to set one stencil entry.
+	void SetBoxStencil(FieldBoxStencil& stencil, unsigned int idx, unsigned int pos0, FDTD_FLOAT weight0, unsigned int pos1=0, FDTD_FLOAT weight1=0);
+
 	//! Internal method to get an interpolated field of a given type. (0: E, 1: J, 2: rotH, 3: D)
 	virtual double* GetRawInterpolatedField(const unsigned int* pos, double* out, int type) const;
 	//! Internal method to get a raw field of a given type. (0: E, 1: J, 2: rotH, 3: D)
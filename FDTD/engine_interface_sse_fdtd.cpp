@@ -33,40 +33,3 @@ Engine_Interface_SSE_FDTD::~Engine_Interface_SSE_FDTD()
 	m_Op_SSE=NULL;
 	m_Eng_SSE=NULL;
 }
-
-double Engine_Interface_SSE_FDTD::CalcFastEnergy() const
-{
-	f4vector E_energy;
-	E_energy.f[0]=0;
-	E_energy.f[1]=0;
-	E_energy.f[2]=0;
-	E_energy.f[3]=0;
-	f4vector H_energy;
-	H_energy = E_energy;
-
-	if (m_Eng_SSE->GetType()!=Engine::SSE)
-		return Engine_Interface_FDTD::CalcFastEnergy();
-
-	unsigned int pos[3];
-	for (pos[0]=0; pos[0]<m_Op_SSE->GetNumberOfLines(0)-1; ++pos[0])
-	{
-		for (pos[1]=0; pos[1]<m_Op_SSE->GetNumberOfLines(1)-1; ++pos[1])
-		{
-			for (pos[2]=0; pos[2]<m_Op_SSE->numVectors; ++pos[2])
-			{
-				ArrayLib::ArrayNIJK<f4vector>& f4_volt = *m_Eng_SSE->Engine_sse::f4_volt_ptr;
-				ArrayLib::ArrayNIJK<f4vector>& f4_curr = *m_Eng_SSE->Engine_sse::f4_curr_ptr;
-
-				E_energy.v += f4_volt[0][pos[0]][pos[1]][pos[2]].v * f4_volt[0][pos[0]][pos[1]][pos[2]].v;
-				E_energy.v += f4_volt[1][pos[0]][pos[1]][pos[2]].v * f4_volt[1][pos[0]][pos[1]][pos[2]].v;
-				E_energy.v += f4_volt[2][pos[0]][pos[1]][pos[2]].v * f4_volt[2][pos[0]][pos[1]][pos[2]].v;
-
-				H_energy.v += f4_curr[0][pos[0]][pos[1]][pos[2]].v * f4_curr[0][pos[0]][pos[1]][pos[2]].v;
-				H_energy.v += f4_curr[1][pos[0]][pos[1]][pos[2]].v * f4_curr[1][pos[0]][pos[1]][pos[2]].v;
-				H_energy.v += f4_curr[2][pos[0]][pos[1]][pos[2]].v * f4_curr[2][pos[0]][pos[1]][pos[2]].v;
-			}
-		}
-	}
-
-	return __EPS0__*(E_energy.f[0]+E_energy.f[1]+E_energy.f[2]+E_energy.f[3]) + __MUE0__*(H_energy.f[0]+H_energy.f[1]+H_energy.f[2]+H_energy.f[3]);
-}
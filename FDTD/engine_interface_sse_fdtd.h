@@ -28,8 +28,6 @@ public:
 	Engine_Interface_SSE_FDTD(Operator_sse* op);
 	virtual ~Engine_Interface_SSE_FDTD();
 
-	virtual double CalcFastEnergy() const;
-
 protected:
 	Operator_sse* m_Op_SSE;
 	Engine_sse* m_Eng_SSE;
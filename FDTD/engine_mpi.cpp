@@ -17,6 +17,8 @@
 
 #include "engine_mpi.h"
 
+namespace po = boost::program_options;
+
 Engine_MPI* Engine_MPI::New(const Operator_MPI* op)
 {
 	cout << "Create FDTD engine (compressed SSE + MPI)" << endl;
@@ -28,6 +30,9 @@ Engine_MPI* Engine_MPI::New(const Operator_MPI* op)
 Engine_MPI::Engine_MPI(const Operator_MPI* op) : Engine_SSE_Compressed(op)
 {
 	m_Op_MPI = op;
+	m_MPI_Overlap = false;
+	m_VoltHaloPending = false;
+	m_CurrHaloPending = false;
 }
 
 Engine_MPI::~Engine_MPI()
@@ -35,6 +40,19 @@ Engine_MPI::~Engine_MPI()
 	Reset();
 }
 
+po::options_description Engine_MPI::optionDesc()
+{
+	po::options_description optdesc("MPI engine arguments");
+	optdesc.add_options()
+		(
+			"mpiOverlap",
+			po::bool_switch(),
+			"Overlap the MPI communication in x-direction with the field updates. "
+			"Extensions must not read the halo fields before the main update."
+		);
+	return optdesc;
+}
+
 void Engine_MPI::Init()
 {
 	Engine_SSE_Compressed::Init();
@@ -44,141 +62,255 @@ void Engine_MPI::Init()
 		m_BufferUp[i]=NULL;
 		m_BufferDown[i]=NULL;
 		m_BufferSize[i]=0;
+		Send_Request_Up[i]=MPI_REQUEST_NULL;
+		Send_Request_Down[i]=MPI_REQUEST_NULL;
+		Recv_Request_Up[i]=MPI_REQUEST_NULL;
+		Recv_Request_Down[i]=MPI_REQUEST_NULL;
 	}
+	m_VoltHaloPending = false;
+	m_CurrHaloPending = false;
+
+	m_MPI_Overlap = false;
+	if (g_settings.hasOption("mpiOverlap"))
+		m_MPI_Overlap = g_settings.getOption("mpiOverlap").as<bool>();
 
 	if (m_Op_MPI->GetMPIEnabled())
 	{
-		// init buffers, nx*ny*2 for the tangential electric or magnetic fields at the interface
+		// init buffers for the tangential electric or magnetic fields at the interface
+		// the x- and y-planes are copied as full vectors, including the padding in z-direction
 		for (int n=0;n<3;++n)
 		{
 			int nP  = (n+1)%3;
 			int nPP = (n+2)%3;
-			m_BufferSize[n] = m_Op_MPI->numLines[nP]*m_Op_MPI->numLines[nPP];
+			if (n==2)
+				m_BufferSize[n] = m_Op_MPI->numLines[nP]*m_Op_MPI->numLines[nPP]*2;
+			else
+				m_BufferSize[n] = m_Op_MPI->numLines[n==0 ? 1 : 0]*numVectors*4*2;
 
 			if (m_Op_MPI->m_NeighborDown[n]>=0)
 			{
-				m_BufferDown[n] = new float[m_BufferSize[n]*2];
+				m_BufferDown[n] = new f4vector[(m_BufferSize[n]+3)/4];
 			}
 			if (m_Op_MPI->m_NeighborUp[n]>=0)
 			{
-				m_BufferUp[n] = new float[m_BufferSize[n]*2];
+				m_BufferUp[n] = new f4vector[(m_BufferSize[n]+3)/4];
 			}
 		}
 	}
+	else
+		m_MPI_Overlap = false;
 }
 
 void Engine_MPI::Reset()
 {
 	for (int i=0;i<3;++i)
 	{
+		// make sure no transfer is still using the buffers
+		if (m_BufferUp[i] || m_BufferDown[i])
+		{
+			MPI_Wait(&Send_Request_Up[i],&stat);
+			MPI_Wait(&Send_Request_Down[i],&stat);
+			MPI_Wait(&Recv_Request_Up[i],&stat);
+			MPI_Wait(&Recv_Request_Down[i],&stat);
+		}
 		delete[] m_BufferUp[i];
 		delete[] m_BufferDown[i];
 		m_BufferUp[i]=NULL;
 		m_BufferDown[i]=NULL;
 		m_BufferSize[i]=0;
 	}
+	m_VoltHaloPending = false;
+	m_CurrHaloPending = false;
 
 	Engine_SSE_Compressed::Reset();
 }
 
-void Engine_MPI::SendReceiveVoltages()
+void Engine_MPI::PackPlane(ArrayLib::ArrayNIJK<f4vector>& field, int ny, unsigned int line, f4vector* buffer) const
 {
-	unsigned int pos[3];
+	int nP  = (ny+1)%3;
+	int nPP = (ny+2)%3;
+	unsigned int iPos=0;
+
+	if (ny==0)
+	{
+		for (unsigned int y=0; y<numLines[1]; ++y)
+			for (unsigned int v=0; v<numVectors; ++v)
+			{
+				buffer[iPos++].v = field[nP ][line][y][v].v;
+				buffer[iPos++].v = field[nPP][line][y][v].v;
+			}
+	}
+	else if (ny==1)
+	{
+		for (unsigned int x=0; x<numLines[0]; ++x)
+			for (unsigned int v=0; v<numVectors; ++v)
+			{
+				buffer[iPos++].v = field[nP ][x][line][v].v;
+				buffer[iPos++].v = field[nPP][x][line][v].v;
+			}
+	}
+	else
+	{
+		// a z-plane is spread over the vector lanes
+		float* buffer_f = &buffer[0].f[0];
+		unsigned int v = line%numVectors;
+		unsigned int lane = line/numVectors;
+		for (unsigned int x=0; x<numLines[0]; ++x)
+			for (unsigned int y=0; y<numLines[1]; ++y)
+			{
+				buffer_f[iPos++] = field[nP ][x][y][v].f[lane];
+				buffer_f[iPos++] = field[nPP][x][y][v].f[lane];
+			}
+	}
+}
+
+void Engine_MPI::UnpackPlane(ArrayLib::ArrayNIJK<f4vector>& field, int ny, unsigned int line, const f4vector* buffer)
+{
+	int nP  = (ny+1)%3;
+	int nPP = (ny+2)%3;
+	unsigned int iPos=0;
+
+	if (ny==0)
+	{
+		for (unsigned int y=0; y<numLines[1]; ++y)
+			for (unsigned int v=0; v<numVectors; ++v)
+			{
+				field[nP ][line][y][v].v = buffer[iPos++].v;
+				field[nPP][line][y][v].v = buffer[iPos++].v;
+			}
+	}
+	else if (ny==1)
+	{
+		for (unsigned int x=0; x<numLines[0]; ++x)
+			for (unsigned int v=0; v<numVectors; ++v)
+			{
+				field[nP ][x][line][v].v = buffer[iPos++].v;
+				field[nPP][x][line][v].v = buffer[iPos++].v;
+			}
+	}
+	else
+	{
+		const float* buffer_f = &buffer[0].f[0];
+		unsigned int v = line%numVectors;
+		unsigned int lane = line/numVectors;
+		for (unsigned int x=0; x<numLines[0]; ++x)
+			for (unsigned int y=0; y<numLines[1]; ++y)
+			{
+				field[nP ][x][y][v].f[lane] = buffer_f[iPos++];
+				field[nPP][x][y][v].f[lane] = buffer_f[iPos++];
+			}
+	}
+}
+
+void Engine_MPI::StartSendReceiveVoltages()
+{
+	ArrayLib::ArrayNIJK<f4vector>& f4_volt = *f4_volt_ptr;
 
 	//non-blocking prepare for receive...
 	for (int n=0;n<3;++n)
 		if (m_Op_MPI->m_NeighborDown[n]>=0)
-			MPI_Irecv( m_BufferDown[n] , m_BufferSize[n]*2, MPI_FLOAT, m_Op_MPI->m_NeighborDown[n], m_Op_MPI->m_MyTag, MPI_COMM_WORLD, &Recv_Request[n]);
+		{
+			// the buffer may still be in use by the last current transfer
+			MPI_Wait(&Send_Request_Down[n],&stat);
+			MPI_Irecv( m_BufferDown[n] , m_BufferSize[n], MPI_FLOAT, m_Op_MPI->m_NeighborDown[n], m_Op_MPI->m_MyTag, MPI_COMM_WORLD, &Recv_Request_Down[n]);
+		}
 
+	//send voltages
 	for (int n=0;n<3;++n)
-	{
-		int nP  = (n+1)%3;
-		int nPP = (n+2)%3;
-
-		//send voltages
-		unsigned int iPos=0;
-		pos[n]=numLines[n]-2;
 		if (m_Op_MPI->m_NeighborUp[n]>=0)
 		{
-			for (pos[nP]=0; pos[nP]<numLines[nP]; ++pos[nP])
-			{
-				for (pos[nPP]=0; pos[nPP]<numLines[nPP]; ++pos[nPP])
-				{
-					m_BufferUp[n][iPos++] = Engine_SSE_Compressed::GetVolt(nP ,pos);
-					m_BufferUp[n][iPos++] = Engine_SSE_Compressed::GetVolt(nPP,pos);
-				}
-			}
-			MPI_Isend( m_BufferUp[n] , m_BufferSize[n]*2, MPI_FLOAT, m_Op_MPI->m_NeighborUp[n], m_Op_MPI->m_MyTag, MPI_COMM_WORLD, &Send_Request[n]);
+			MPI_Wait(&Send_Request_Up[n],&stat);
+			PackPlane(f4_volt, n, numLines[n]-2, m_BufferUp[n]);
+			MPI_Isend( m_BufferUp[n] , m_BufferSize[n], MPI_FLOAT, m_Op_MPI->m_NeighborUp[n], m_Op_MPI->m_MyTag, MPI_COMM_WORLD, &Send_Request_Up[n]);
 		}
 
-		//receive voltages
-		pos[n]=0;
-		iPos=0;
+	//receive voltages
+	for (int n=0;n<3;++n)
 		if (m_Op_MPI->m_NeighborDown[n]>=0)
 		{
-			//wait for receive to finish...
-			MPI_Wait(&Recv_Request[n],&stat);
-			for (pos[nP]=0; pos[nP]<numLines[nP]; ++pos[nP])
+			if ((n==0) && OverlapDown())
 			{
-				for (pos[nPP]=0; pos[nPP]<numLines[nPP]; ++pos[nPP])
-				{
-					Engine_SSE_Compressed::SetVolt(nP ,pos,m_BufferDown[n][iPos++]);
-					Engine_SSE_Compressed::SetVolt(nPP,pos,m_BufferDown[n][iPos++]);
-				}
+				m_VoltHaloPending = true;
+				continue;
 			}
+			//wait for receive to finish...
+			MPI_Wait(&Recv_Request_Down[n],&stat);
+			UnpackPlane(f4_volt, n, 0, m_BufferDown[n]);
 		}
+}
 
-	}
+void Engine_MPI::FinishSendReceiveVoltages()
+{
+	if (!m_VoltHaloPending)
+		return;
+	MPI_Wait(&Recv_Request_Down[0],&stat);
+	UnpackPlane(*f4_volt_ptr, 0, 0, m_BufferDown[0]);
+	m_VoltHaloPending = false;
 }
 
-void Engine_MPI::SendReceiveCurrents()
+void Engine_MPI::SendReceiveVoltages()
+{
+	StartSendReceiveVoltages();
+	FinishSendReceiveVoltages();
+}
+
+void Engine_MPI::StartSendReceiveCurrents()
 {
-	unsigned int pos[3];
+	ArrayLib::ArrayNIJK<f4vector>& f4_curr = *f4_curr_ptr;
 
 	//non-blocking prepare for receive...
 	for (int n=0;n<3;++n)
 		if (m_Op_MPI->m_NeighborUp[n]>=0)
-			MPI_Irecv( m_BufferUp[n] , m_BufferSize[n]*2, MPI_FLOAT, m_Op_MPI->m_NeighborUp[n], m_Op_MPI->m_MyTag, MPI_COMM_WORLD, &Recv_Request[n]);
+		{
+			// the buffer may still be in use by the last voltage transfer
+			MPI_Wait(&Send_Request_Up[n],&stat);
+			MPI_Irecv( m_BufferUp[n] , m_BufferSize[n], MPI_FLOAT, m_Op_MPI->m_NeighborUp[n], m_Op_MPI->m_MyTag, MPI_COMM_WORLD, &Recv_Request_Up[n]);
+		}
 
+	//send currents
 	for (int n=0;n<3;++n)
-	{
-		int nP  = (n+1)%3;
-		int nPP = (n+2)%3;
-
-		//send currents
-		unsigned int iPos=0;
-		pos[n]=0;
 		if (m_Op_MPI->m_NeighborDown[n]>=0)
 		{
-			for (pos[nP]=0; pos[nP]<numLines[nP]; ++pos[nP])
-			{
-				for (pos[nPP]=0; pos[nPP]<numLines[nPP]; ++pos[nPP])
-				{
-					m_BufferDown[n][iPos++] = Engine_SSE_Compressed::GetCurr(nP ,pos);
-					m_BufferDown[n][iPos++] = Engine_SSE_Compressed::GetCurr(nPP,pos);
-				}
-			}
-			MPI_Isend( m_BufferDown[n] , m_BufferSize[n]*2, MPI_FLOAT, m_Op_MPI->m_NeighborDown[n], m_Op_MPI->m_MyTag, MPI_COMM_WORLD, &Send_Request[n]);
+			MPI_Wait(&Send_Request_Down[n],&stat);
+			PackPlane(f4_curr, n, 0, m_BufferDown[n]);
+			MPI_Isend( m_BufferDown[n] , m_BufferSize[n], MPI_FLOAT, m_Op_MPI->m_NeighborDown[n], m_Op_MPI->m_MyTag, MPI_COMM_WORLD, &Send_Request_Down[n]);
 		}
 
-		//receive currents
-		pos[n]=numLines[n]-2;
-		iPos=0;
+	//receive currents
+	for (int n=0;n<3;++n)
 		if (m_Op_MPI->m_NeighborUp[n]>=0)
 		{
-			//wait for receive to finish...
-			MPI_Wait(&Recv_Request[n],&stat);
-			for (pos[nP]=0; pos[nP]<numLines[nP]; ++pos[nP])
+			if ((n==0) && OverlapUp())
 			{
-				for (pos[nPP]=0; pos[nPP]<numLines[nPP]; ++pos[nPP])
-				{
-					Engine_SSE_Compressed::SetCurr(nP ,pos,m_BufferUp[n][iPos++]);
-					Engine_SSE_Compressed::SetCurr(nPP,pos,m_BufferUp[n][iPos++]);
-				}
+				m_CurrHaloPending = true;
+				continue;
 			}
+			//wait for receive to finish...
+			MPI_Wait(&Recv_Request_Up[n],&stat);
+			UnpackPlane(f4_curr, n, numLines[n]-2, m_BufferUp[n]);
 		}
+}
 
-	}
+void Engine_MPI::FinishSendReceiveCurrents()
+{
+	if (!m_CurrHaloPending)
+		return;
+	MPI_Wait(&Recv_Request_Up[0],&stat);
+	UnpackPlane(*f4_curr_ptr, 0, numLines[0]-2, m_BufferUp[0]);
+	m_CurrHaloPending = false;
+}
+
+void Engine_MPI::SendReceiveCurrents()
+{
+	StartSendReceiveCurrents();
+	FinishSendReceiveCurrents();
+}
+
+bool Engine_MPI::SetTimestepSampler(std::function<void(unsigned int, unsigned int)> sampler)
+{
+	if (sampler && m_Op_MPI->GetMPIEnabled())
+		return false;
+	return Engine_SSE_Compressed::SetTimestepSampler(sampler);
 }
 
 bool Engine_MPI::IterateTS(unsigned int iterTS)
@@ -192,20 +324,38 @@ bool Engine_MPI::IterateTS(unsigned int iterTS)
 	{
 		//voltage updates with extensions
 		DoPreVoltageUpdates();
-		UpdateVoltages(0,numLines[0]);
+		if (OverlapUp())
+		{
+			// the last two lines depend on the current halo, which is received while the interior is updated
+			UpdateVoltages(0,numLines[0]-2);
+			FinishSendReceiveCurrents();
+			UpdateVoltages(numLines[0]-2,2);
+		}
+		else
+			UpdateVoltages(0,numLines[0]);
 		DoPostVoltageUpdates();
 		Apply2Voltages();
-		SendReceiveVoltages();
+		StartSendReceiveVoltages();
 
 		//current updates with extensions
 		DoPreCurrentUpdates();
-		UpdateCurrents(0,numLines[0]-1);
+		if (OverlapDown())
+		{
+			// the first line depends on the voltage halo, which is received while the interior is updated
+			UpdateCurrents(1,numLines[0]-2);
+			FinishSendReceiveVoltages();
+			UpdateCurrents(0,1);
+		}
+		else
+			UpdateCurrents(0,numLines[0]-1);
 		DoPostCurrentUpdates();
 		Apply2Current();
-		SendReceiveCurrents();
+		StartSendReceiveCurrents();
 
 		++numTS;
 	}
+
+	// all fields have to be complete for the processing
+	FinishSendReceiveCurrents();
 	return true;
 }
-
@@ -30,28 +30,60 @@ public:
 	static Engine_MPI* New(const Operator_MPI* op);
 	virtual ~Engine_MPI();
 
+	//! Options of this engine, the values are read from g_settings by Init()
+	static boost::program_options::options_description optionDesc();
+
 	virtual void Init();
 	virtual void Reset();
 
 	virtual bool IterateTS(unsigned int iterTS);
 
+	//! Sampling is not supported in parallel MPI runs, the field halos are only complete after IterateTS()
+	virtual bool SetTimestepSampler(std::function<void(unsigned int, unsigned int)> sampler);
+
 protected:
 	Engine_MPI(const Operator_MPI* op);
 	const Operator_MPI* m_Op_MPI;
 
 	MPI_Status stat;
-	MPI_Request Send_Request[3];
-	MPI_Request Recv_Request[3];
+	MPI_Request Send_Request_Up[3];
+	MPI_Request Send_Request_Down[3];
+	MPI_Request Recv_Request_Up[3];
+	MPI_Request Recv_Request_Down[3];
 
 	//field buffer for MPI transfer...
-	unsigned int m_BufferSize[3];
-	float* m_BufferUp[3];
-	float* m_BufferDown[3];
+	unsigned int m_BufferSize[3]; //!< number of floats transferred for both tangential field components
+	f4vector* m_BufferUp[3];
+	f4vector* m_BufferDown[3];
+
+	//! Overlap the x-direction communication with the interior updates
+	bool m_MPI_Overlap;
+	bool m_VoltHaloPending;
+	bool m_CurrHaloPending;
+
+	//! Copy the tangential fields of the plane at \a line in direction \a ny into the transfer buffer
+	void PackPlane(ArrayLib::ArrayNIJK<f4vector>& field, int ny, unsigned int line, f4vector* buffer) const;
+	//! Copy the transfer buffer into the tangential fields of the plane at \a line in direction \a ny
+	void UnpackPlane(ArrayLib::ArrayNIJK<f4vector>& field, int ny, unsigned int line, const f4vector* buffer);
 
 	//! Transfer all tangential voltages at the upper bounds to the lower bounds of the neighbouring MPI-processes
 	virtual void SendReceiveVoltages();
 	//! Transfer all tangential currents at the lower bounds to the upper bounds of the neighbouring MPI-processes
 	virtual void SendReceiveCurrents();
+
+	//! Send all tangential voltages, receiving the x-direction voltages is postponed to FinishSendReceiveVoltages() in overlap mode
+	void StartSendReceiveVoltages();
+	//! Wait for and apply the postponed x-direction voltages, needed by the currents at x=0
+	void FinishSendReceiveVoltages();
+	//! Send all tangential currents, receiving the x-direction currents is postponed to FinishSendReceiveCurrents() in overlap mode
+	void StartSendReceiveCurrents();
+	//! Wait for and apply the postponed x-direction currents, needed by the voltages at the last two x-lines
+	void FinishSendReceiveCurrents();
+
+	//! True if the voltages at the last two x-lines have to wait for the current halo
+	bool OverlapUp() const {return m_MPI_Overlap && (m_Op_MPI->m_NeighborUp[0]>=0);}
+	//! True if the currents at x=0 have to wait for the voltage halo
+	bool OverlapDown() const {return m_MPI_Overlap && (m_Op_MPI->m_NeighborDown[0]>=0);}
 };
 
 #endif // ENGINE_MPI_H
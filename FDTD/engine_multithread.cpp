@@ -33,6 +33,9 @@
 #include "boost/date_time/posix_time/posix_time.hpp"
 #include "boost/date_time/gregorian/gregorian.hpp"
 #include <iomanip>
+#include <chrono>
+
+namespace po = boost::program_options;
 
 //! \brief construct an Engine_Multithread instance
 //! it's the responsibility of the caller to free the returned pointer
@@ -58,6 +61,10 @@ Engine_Multithread::Engine_Multithread(const Operator_Multithread* op) : ENGINE_
 	m_last_speed = 0;
 	m_opt_speed = false;
 	m_stopThreads = true;
+	m_Iterating = false;
+	m_energyTask = false;
+	m_workStealing = false;
+	m_tilesPerThread = 8;
 
 #ifdef ENABLE_DEBUG_TIME
 	m_MPI_Barrier = 0;
@@ -87,6 +94,23 @@ Engine_Multithread::~Engine_Multithread()
 	Reset();
 }
 
+po::options_description Engine_Multithread::optionDesc()
+{
+	po::options_description optdesc("Multithreaded engine arguments");
+	optdesc.add_options()
+		(
+			"workStealing",
+			po::bool_switch(),
+			"Distribute the field updates as small tiles with work stealing between the threads"
+		)
+		(
+			"tilesPerThread",
+			po::value<unsigned int>()->default_value(8),
+			"Number of tiles per thread for the work stealing scheduler"
+		);
+	return optdesc;
+}
+
 void Engine_Multithread::setNumThreads( unsigned int numThreads )
 {
 	m_numThreads = numThreads;
@@ -98,6 +122,19 @@ void Engine_Multithread::Init()
 	m_opt_speed = false;
 	ENGINE_MULTITHREAD_BASE::Init();
 
+	// engine specific options are not known before the engine is created, see tools/global.h
+	if (g_settings.hasOption("workStealing"))
+		m_workStealing = g_settings.getOption("workStealing").as<bool>();
+	if (g_settings.hasOption("tilesPerThread"))
+		m_tilesPerThread = max(1u, g_settings.getOption("tilesPerThread").as<unsigned int>());
+#ifdef MPI_SUPPORT
+	if (m_workStealing && m_MPI_Overlap)
+	{
+		cerr << "Engine_Multithread::Init: Warning: work stealing is not supported with MPI overlap, disabled." << endl;
+		m_workStealing = false;
+	}
+#endif
+
 	// initialize threads
 	m_stopThreads = false;
 	if (m_numThreads == 0)
@@ -173,6 +210,9 @@ void Engine_Multithread::changeNumThreads(unsigned int numThreads)
 	m_MPI_Barrier = 0;
 #endif
 
+	m_E_energy.assign(m_numThreads, 0.0);
+	m_H_energy.assign(m_numThreads, 0.0);
+
 	m_thread_group = new boost::thread_group();
 	for (unsigned int n=0; n<m_numThreads; n++)
 	{
@@ -196,11 +236,41 @@ void Engine_Multithread::changeNumThreads(unsigned int numThreads)
 
 	for (size_t n=0; n<m_Eng_exts.size(); ++n)
 		m_Eng_exts.at(n)->SetNumberOfThreads(m_numThreads);
+
+	if (m_workStealing)
+	{
+		m_TileScheduler.Setup(numLines[0], numLines[1], m_numThreads, m_numThreads*m_tilesPerThread);
+		if (g_settings.GetVerboseLevel()>0)
+			cout << "Multithreaded engine using work stealing with " << m_TileScheduler.GetNumberOfTiles() << " tiles." << endl;
+	}
+}
+
+void Engine_Multithread::UpdateTiles(unsigned int threadID, int set)
+{
+	unsigned int tile;
+	unsigned int start[2], num[2];
+	while (m_TileScheduler.NextTile(threadID, set, tile))
+	{
+		std::chrono::steady_clock::time_point t1 = std::chrono::steady_clock::now();
+		if (set==0)
+		{
+			if (m_TileScheduler.GetTile(tile, numLines[0], numLines[1], start, num))
+				UpdateVoltages(start[0], num[0], start[1], num[1]);
+		}
+		else
+		{
+			// no current updates for the last x- and y-line
+			if (m_TileScheduler.GetTile(tile, numLines[0]-1, numLines[1]-1, start, num))
+				UpdateCurrents(start[0], num[0], start[1], num[1]);
+		}
+		m_TileScheduler.AddTime(tile, std::chrono::duration<double>(std::chrono::steady_clock::now()-t1).count());
+	}
 }
 
 bool Engine_Multithread::IterateTS(unsigned int iterTS)
 {
 	m_iterTS = iterTS;
+	m_Iterating = true;
 
 	//cerr << "bool Engine_Multithread::IterateTS(): starting threads ...";
 	m_startBarrier->wait(); // start the threads
@@ -208,10 +278,34 @@ bool Engine_Multithread::IterateTS(unsigned int iterTS)
 	//cerr << "... threads started" << endl;
 
 	m_stopBarrier->wait(); // wait for the threads to finish <iterTS> time steps
+	m_Iterating = false;
 
 	return true;
 }
 
+void Engine_Multithread::CalcFastEnergy(double &E_energy, double &H_energy)
+{
+	// called from within the iteration (e.g. by an extension), the worker threads are busy
+	if ((m_thread_group==0) || m_Iterating)
+	{
+		ENGINE_MULTITHREAD_BASE::CalcFastEnergy(E_energy, H_energy);
+		return;
+	}
+
+	m_energyTask = true;
+	m_startBarrier->wait(); // start the threads
+	m_stopBarrier->wait(); // wait for all partial sums
+	m_energyTask = false;
+
+	E_energy = 0;
+	H_energy = 0;
+	for (unsigned int n=0; n<m_numThreads; ++n)
+	{
+		E_energy += m_E_energy.at(n);
+		H_energy += m_H_energy.at(n);
+	}
+}
+
 void Engine_Multithread::NextInterval(float curr_speed)
 {
 	ENGINE_MULTITHREAD_BASE::NextInterval(curr_speed);
@@ -296,6 +390,137 @@ void Engine_Multithread::Apply2Current(int threadID)
 namespace NS_Engine_Multithread
 {
 
+TileScheduler::TileScheduler()
+{
+	m_numThreads = 0;
+	m_Queues[0] = NULL;
+	m_Queues[1] = NULL;
+}
+
+TileScheduler::~TileScheduler()
+{
+	delete[] m_Queues[0];
+	delete[] m_Queues[1];
+}
+
+void TileScheduler::Setup(unsigned int numLinesX, unsigned int numLinesY, unsigned int numThreads, unsigned int numTiles)
+{
+	// prefer tiles spanning all y-lines (x-slabs), split in y only if there are not enough x-lines:
+	// the fields are stored x-major (x,y,z with interleaved components), thus an x-slab is one contiguous memory block
+	// and the update loops over y and z stay long. Tiles split in y are strided in memory and every tile boundary
+	// in y adds neighbor accesses of another thread, without any gain as long as there are enough slabs to balance.
+	unsigned int numX = min(numLinesX, numTiles);
+	unsigned int numY = min(numLinesY, (numTiles+numX-1)/numX);
+	vector<unsigned int> jobsX = AssignJobs2Threads(numLinesX, numX, true);
+	vector<unsigned int> jobsY = AssignJobs2Threads(numLinesY, numY, true);
+
+	m_Tiles.clear();
+	Tile tile;
+	tile.time = 0;
+	tile.start[0] = 0;
+	for (size_t i=0; i<jobsX.size(); ++i)
+	{
+		tile.num[0] = jobsX.at(i);
+		tile.start[1] = 0;
+		for (size_t j=0; j<jobsY.size(); ++j)
+		{
+			tile.num[1] = jobsY.at(j);
+			tile.cost = (double)tile.num[0]*tile.num[1]/numLinesX/numLinesY;
+			m_Tiles.push_back(tile);
+			tile.start[1] += tile.num[1];
+		}
+		tile.start[0] += tile.num[0];
+	}
+
+	m_numThreads = numThreads;
+	for (int set=0; set<2; ++set)
+	{
+		delete[] m_Queues[set];
+		m_Queues[set] = new Queue[m_numThreads];
+	}
+	Rebalance();
+}
+
+bool TileScheduler::GetTile(unsigned int tile, unsigned int maxX, unsigned int maxY, unsigned int start[2], unsigned int num[2]) const
+{
+	unsigned int max[2] = {maxX, maxY};
+	for (int n=0; n<2; ++n)
+	{
+		start[n] = m_Tiles[tile].start[n];
+		if (start[n]>=max[n])
+			return false;
+		num[n] = min(m_Tiles[tile].num[n], max[n]-start[n]);
+	}
+	return true;
+}
+
+bool TileScheduler::NextTile(unsigned int threadID, int set, unsigned int &tile)
+{
+	Queue* queues = m_Queues[set];
+	// own tiles are taken from the front
+	unsigned long long range = queues[threadID].range.load();
+	while ((range>>32) < (range&0xffffffff))
+	{
+		if (queues[threadID].range.compare_exchange_weak(range, range+(1ull<<32)))
+		{
+			tile = range>>32;
+			return true;
+		}
+	}
+	// steal from the back of the other threads, starting with the nearest neighbor
+	for (unsigned int n=1; n<m_numThreads; ++n)
+	{
+		unsigned int victim = (threadID+n)%m_numThreads;
+		range = queues[victim].range.load();
+		while ((range>>32) < (range&0xffffffff))
+		{
+			if (queues[victim].range.compare_exchange_weak(range, range-1))
+			{
+				tile = (range&0xffffffff)-1;
+				return true;
+			}
+		}
+	}
+	return false;
+}
+
+void TileScheduler::Reset(int set)
+{
+	for (unsigned int n=0; n<m_numThreads; ++n)
+		m_Queues[set][n].range.store(((unsigned long long)m_Ranges.at(n)<<32) | m_Ranges.at(n+1));
+}
+
+void TileScheduler::Rebalance()
+{
+	// update the (relative) cost estimate with the time measured since the last rebalance
+	double totalTime = 0;
+	for (size_t i=0; i<m_Tiles.size(); ++i)
+		totalTime += m_Tiles[i].time;
+	double totalCost = 0;
+	for (size_t i=0; i<m_Tiles.size(); ++i)
+	{
+		if (totalTime>0)
+			m_Tiles[i].cost = 0.5*m_Tiles[i].cost + 0.5*m_Tiles[i].time/totalTime;
+		m_Tiles[i].time = 0;
+		totalCost += m_Tiles[i].cost;
+	}
+
+	// contiguous tile ranges of (about) equal cost per thread
+	m_Ranges.assign(1, 0);
+	double cost = 0;
+	for (size_t i=0; i<m_Tiles.size(); ++i)
+	{
+		cost += m_Tiles[i].cost;
+		if ((m_Ranges.size()<m_numThreads) && (cost >= totalCost*m_Ranges.size()/m_numThreads))
+			m_Ranges.push_back(i+1);
+	}
+	while (m_Ranges.size()<=m_numThreads)
+		m_Ranges.push_back(m_Tiles.size());
+
+	Reset(0);
+	Reset(1);
+}
+
 thread::thread( Engine_Multithread* ptr, unsigned int start, unsigned int stop, unsigned int stop_h, unsigned int threadID )
 {
 	m_enginePtr = ptr;
@@ -326,6 +551,25 @@ void thread::operator()()
 			return;
 		}
 
+		if (m_enginePtr->m_energyTask)
+		{
+			// the last x-line is not part of the energy
+			unsigned int stop = min(m_stop, m_enginePtr->numLines[0]-2);
+			double E_energy=0, H_energy=0;
+			if (stop>=m_start)
+				m_enginePtr->SumFieldSquares(m_start, stop-m_start+1, E_energy, H_energy);
+			m_enginePtr->m_E_energy.at(m_threadID) = E_energy;
+			m_enginePtr->m_H_energy.at(m_threadID) = H_energy;
+			m_enginePtr->m_stopBarrier->wait();
+			continue;
+		}
+
+		if (m_enginePtr->IterateThread(m_threadID))
+		{
+			m_enginePtr->m_stopBarrier->wait();
+			continue;
+		}
+
 		DEBUG_TIME( Timer timer1 );
 
 		for (unsigned int iter=0; iter<m_enginePtr->m_iterTS; ++iter)
@@ -334,7 +578,26 @@ void thread::operator()()
 			m_enginePtr->DoPreVoltageUpdates(m_threadID);
 
 			//voltage updates
-			m_enginePtr->UpdateVoltages(m_start,m_stop-m_start+1);
+#ifdef MPI_SUPPORT
+			if (m_enginePtr->OverlapUp())
+			{
+				// the last two lines depend on the current halo, thread 0 receives and updates them after its own lines
+				unsigned int haloStart = m_enginePtr->numLines[0]-2;
+				unsigned int stop = min(m_stop, haloStart-1);
+				if (m_start<=stop)
+					m_enginePtr->UpdateVoltages(m_start,stop-m_start+1);
+				if (m_threadID==0)
+				{
+					m_enginePtr->FinishSendReceiveCurrents();
+					m_enginePtr->UpdateVoltages(haloStart,2);
+				}
+			}
+			else
+#endif
+			if (m_enginePtr->m_workStealing)
+				m_enginePtr->UpdateTiles(m_threadID, 0);
+			else
+				m_enginePtr->UpdateVoltages(m_start,m_stop-m_start+1);
 
 			// record time
 			DEBUG_TIME( m_enginePtr->m_timer_list[boost::this_thread::get_id()].push_back( timer1.elapsed() ); )
@@ -342,6 +605,10 @@ void thread::operator()()
 			//cout << "Thread " << boost::this_thread::get_id() << " m_barrier1 waiting..." << endl;
 			m_enginePtr->m_IterateBarrier->wait();
 
+			// all voltage tiles are done, refill them for the next timestep
+			if (m_enginePtr->m_workStealing && (m_threadID==0))
+				m_enginePtr->m_TileScheduler.Reset(0);
+
 			// record time
 			DEBUG_TIME( m_enginePtr->m_timer_list[boost::this_thread::get_id()].push_back( timer1.elapsed() ); )
 
@@ -354,7 +621,10 @@ void thread::operator()()
 			{
 				if (m_enginePtr->m_MPI_Barrier)
 					m_enginePtr->m_MPI_Barrier->wait();
-				m_enginePtr->SendReceiveVoltages();
+				if (m_enginePtr->m_MPI_Overlap)
+					m_enginePtr->StartSendReceiveVoltages();
+				else
+					m_enginePtr->SendReceiveVoltages();
 			}
 			m_enginePtr->m_IterateBarrier->wait();
 #endif
@@ -366,12 +636,34 @@ void thread::operator()()
 			m_enginePtr->DoPreCurrentUpdates(m_threadID);
 
 			//current updates
-			m_enginePtr->UpdateCurrents(m_start,m_stop_h-m_start+1);
+#ifdef MPI_SUPPORT
+			if (m_enginePtr->OverlapDown())
+			{
+				// the first line depends on the voltage halo, thread 0 receives and updates it after its own lines
+				unsigned int start = max(m_start, 1u);
+				if (start<=m_stop_h)
+					m_enginePtr->UpdateCurrents(start,m_stop_h-start+1);
+				if (m_threadID==0)
+				{
+					m_enginePtr->FinishSendReceiveVoltages();
+					m_enginePtr->UpdateCurrents(0,1);
+				}
+			}
+			else
+#endif
+			if (m_enginePtr->m_workStealing)
+				m_enginePtr->UpdateTiles(m_threadID, 1);
+			else
+				m_enginePtr->UpdateCurrents(m_start,m_stop_h-m_start+1);
 
 			// record time
 			DEBUG_TIME( m_enginePtr->m_timer_list[boost::this_thread::get_id()].push_back( timer1.elapsed() ); )
 			m_enginePtr->m_IterateBarrier->wait();
 
+			// all current tiles are done, refill them for the next timestep
+			if (m_enginePtr->m_workStealing && (m_threadID==0))
+				m_enginePtr->m_TileScheduler.Reset(1);
+
 			// record time
 			DEBUG_TIME( m_enginePtr->m_timer_list[boost::this_thread::get_id()].push_back( timer1.elapsed() ); )
 
@@ -384,15 +676,37 @@ void thread::operator()()
 			{
 				if (m_enginePtr->m_MPI_Barrier)
 					m_enginePtr->m_MPI_Barrier->wait();
-				m_enginePtr->SendReceiveCurrents();
+				if (m_enginePtr->m_MPI_Overlap)
+					m_enginePtr->StartSendReceiveCurrents();
+				else
+					m_enginePtr->SendReceiveCurrents();
 			}
 			m_enginePtr->m_IterateBarrier->wait();
 #endif
 
 			if (m_threadID == 0)
 				++m_enginePtr->numTS; // only the first thread increments numTS
+
+			if (m_enginePtr->m_TimestepSampler)
+			{
+				// all threads have to finish this timestep before sampling and must not start the next one during sampling,
+				// every thread samples its own share of the probes
+				m_enginePtr->m_IterateBarrier->wait();
+				m_enginePtr->m_TimestepSampler(m_threadID, m_enginePtr->m_numThreads);
+				m_enginePtr->m_IterateBarrier->wait();
+			}
 		}
 
+#ifdef MPI_SUPPORT
+		// all fields have to be complete for the processing
+		if (m_threadID==0)
+			m_enginePtr->FinishSendReceiveCurrents();
+#endif
+
+		// all other threads are done with the tiles, adapt the tile ranges to the measured costs
+		if (m_enginePtr->m_workStealing && (m_threadID==0))
+			m_enginePtr->m_TileScheduler.Rebalance();
+
 		m_enginePtr->m_stopBarrier->wait();
 	}
 
@@ -25,6 +25,8 @@
 #include <boost/fusion/include/list.hpp>
 #include <boost/fusion/container/list/list_fwd.hpp>
 #include <boost/fusion/include/list_fwd.hpp>
+#include <boost/program_options.hpp>
+#include <atomic>
 
 #include "tools/useful.h"
 #ifndef __GNUC__
@@ -66,6 +68,62 @@ protected:
 	timeval t1,t2;
 };
 
+//! Work stealing scheduler for the main field updates (see option --workStealing)
+/*!
+  The x/y-plane is split into many small tiles. Every thread owns a contiguous range of tiles which it processes
+  from the front, idle threads steal tiles from the back of the other ranges. The measured time per tile is used
+  to re-partition the ranges, so that the threads start with an (estimated) equal amount of work.
+  */
+class TileScheduler
+{
+public:
+	TileScheduler();
+	~TileScheduler();
+
+	//! Split \a numLinesX times \a numLinesY lines into about \a numTiles tiles for \a numThreads threads, the tiles are x-slabs unless there are less x-lines than tiles
+	void Setup(unsigned int numLinesX, unsigned int numLinesY, unsigned int numThreads, unsigned int numTiles);
+
+	unsigned int GetNumberOfTiles() const {return m_Tiles.size();}
+
+	//! Get start and number of lines of a tile, limited to \a maxX and \a maxY lines in x and y. Returns false for an empty tile.
+	bool GetTile(unsigned int tile, unsigned int maxX, unsigned int maxY, unsigned int start[2], unsigned int num[2]) const;
+
+	//! Get the next tile for a thread, from its own range first or stolen from another thread. Returns false if all tiles are done.
+	bool NextTile(unsigned int threadID, int set, unsigned int &tile);
+
+	//! Add the measured update time for a tile
+	void AddTime(unsigned int tile, double time) {m_Tiles[tile].time+=time;}
+
+	//! Refill all tile ranges of the given set (0: voltages, 1: currents) for the next sweep
+	/*!
+	  Must not be called while any thread is processing a sweep of this set.
+	  */
+	void Reset(int set);
+
+	//! Re-partition the tile ranges using the measured times and refill all ranges.
+	void Rebalance();
+
+protected:
+	struct Tile
+	{
+		unsigned int start[2];
+		unsigned int num[2];
+		double time;	//!< measured time since the last rebalance
+		double cost;	//!< estimated cost
+	};
+	std::vector<Tile> m_Tiles;
+	unsigned int m_numThreads;
+	std::vector<unsigned int> m_Ranges; //!< first tile of every thread, plus the total number of tiles
+
+	//! Remaining tiles of a thread, packed as (front<<32 | back), padded to avoid false sharing
+	struct Queue
+	{
+		std::atomic<unsigned long long> range;
+		char pad[64-sizeof(std::atomic<unsigned long long>)];
+	};
+	Queue* m_Queues[2];
+};
+
 class thread
 {
 public:
@@ -87,7 +145,10 @@ public:
 	static Engine_Multithread* New(const Operator_Multithread* op, unsigned int numThreads = 0);
 	virtual ~Engine_Multithread();
 
+	static boost::program_options::options_description optionDesc();
+
 	virtual void setNumThreads( unsigned int numThreads );
+	virtual unsigned int GetNumberOfThreads() const {return m_numThreads;}
 	virtual void Init();
 	virtual void Reset();
 	virtual void NextInterval(float curr_speed);
@@ -95,6 +156,9 @@ public:
 	//! Iterate \a iterTS number of timesteps
 	virtual bool IterateTS(unsigned int iterTS);
 
+	//! Calculate the field energies using the (idle) worker threads, each summing up its own x-lines
+	virtual void CalcFastEnergy(double &E_energy, double &H_energy);
+
 	virtual void DoPreVoltageUpdates(int threadID);
 	virtual void DoPostVoltageUpdates(int threadID);
 	virtual void Apply2Voltages(int threadID);
@@ -103,6 +167,10 @@ public:
 	virtual void DoPostCurrentUpdates(int threadID);
 	virtual void Apply2Current(int threadID);
 
+	//! Alternative update scheme executed by every worker thread for m_iterTS timesteps.
+	//! Return false to use the default timestep-by-timestep updates (see Engine_Tiling).
+	virtual bool IterateThread(unsigned int threadID) {UNUSED(threadID);return false;}
+
 protected:
 	Engine_Multithread(const Operator_Multithread* op);
 	void changeNumThreads(unsigned int numThreads);
@@ -114,9 +182,19 @@ protected:
 	unsigned int m_numThreads; //!< number of worker threads
 	unsigned int m_max_numThreads; //!< max. number of worker threads
 	volatile bool m_stopThreads;
+	volatile bool m_Iterating; //!< true while the worker threads iterate timesteps
+	volatile bool m_energyTask; //!< the next start of the worker threads only calculates the field energies
+	std::vector<double> m_E_energy, m_H_energy; //!< field energies per worker thread
 	bool m_opt_speed;
 	float m_last_speed;
 
+	//! Use the work stealing scheduler for the main field updates
+	bool m_workStealing;
+	unsigned int m_tilesPerThread;
+	NS_Engine_Multithread::TileScheduler m_TileScheduler;
+	//! Update voltages (set=0) or currents (set=1) of all tiles that can be acquired by this thread
+	void UpdateTiles(unsigned int threadID, int set);
+
 #ifdef MPI_SUPPORT
 	/*! Workaround needed for subgridding scheme... (see Engine_CylinderMultiGrid)
 	 Some engines may need an additional barrier for synchronizing MPI communication.
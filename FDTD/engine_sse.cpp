@@ -269,3 +269,32 @@ void Engine_sse::UpdateCurrents(unsigned int startX, unsigned int numX)
 		++pos[0];
 	}
 }
+
+void Engine_sse::SumFieldSquares(unsigned int startX, unsigned int numX, double &E_energy, double &H_energy) const
+{
+	ArrayLib::ArrayNIJK<f4vector>& f4_volt = *f4_volt_ptr;
+	ArrayLib::ArrayNIJK<f4vector>& f4_curr = *f4_curr_ptr;
+
+	E_energy = 0;
+	H_energy = 0;
+	// the three components of a z-line are stored contiguously, the unused lanes are zero
+	unsigned int numValues = 3*numVectors;
+	f4vector E_line, H_line;
+	for (unsigned int x=startX; x<startX+numX; ++x)
+	{
+		for (unsigned int y=0; y<numLines[1]-1; ++y)
+		{
+			const f4vector* v = &f4_volt(0,x,y,0);
+			const f4vector* c = &f4_curr(0,x,y,0);
+			E_line.v = v[0].v*v[0].v;
+			H_line.v = c[0].v*c[0].v;
+			for (unsigned int m=1; m<numValues; ++m)
+			{
+				E_line.v += v[m].v*v[m].v;
+				H_line.v += c[m].v*c[m].v;
+			}
+			E_energy += (double)E_line.f[0]+E_line.f[1]+E_line.f[2]+E_line.f[3];
+			H_energy += (double)H_line.f[0]+H_line.f[1]+H_line.f[2]+H_line.f[3];
+		}
+	}
+}
@@ -83,6 +83,20 @@ public:
 		f4_curr[n][pos[0]][pos[1]][pos[2]%numVectors].f[pos[2]/numVectors]=value;
 	}
 
+	inline virtual void GetVoltLine(unsigned int n, unsigned int x, unsigned int y, unsigned int zStart, unsigned int num, FDTD_FLOAT* line) const
+	{
+		ArrayLib::ArrayNIJK<f4vector>& f4_volt = *f4_volt_ptr;
+		for (unsigned int z=zStart; z<zStart+num; ++z)
+			line[z-zStart] = f4_volt(n,x,y,z%numVectors).f[z/numVectors];
+	}
+
+	inline virtual void GetCurrLine(unsigned int n, unsigned int x, unsigned int y, unsigned int zStart, unsigned int num, FDTD_FLOAT* line) const
+	{
+		ArrayLib::ArrayNIJK<f4vector>& f4_curr = *f4_curr_ptr;
+		for (unsigned int z=zStart; z<zStart+num; ++z)
+			line[z-zStart] = f4_curr(n,x,y,z%numVectors).f[z/numVectors];
+	}
+
 protected:
 	Engine_sse(const Operator_sse* op);
 	const Operator_sse* Op;
@@ -90,6 +104,8 @@ protected:
 	virtual void UpdateVoltages(unsigned int startX, unsigned int numX);
 	virtual void UpdateCurrents(unsigned int startX, unsigned int numX);
 
+	virtual void SumFieldSquares(unsigned int startX, unsigned int numX, double &E_energy, double &H_energy) const;
+
 	unsigned int numVectors;
 
 public: //public access to the sse arrays for efficient extensions access... use careful...
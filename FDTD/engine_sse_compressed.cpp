@@ -46,6 +46,11 @@ Engine_SSE_Compressed::~Engine_SSE_Compressed()
 }
 
 void Engine_SSE_Compressed::UpdateVoltages(unsigned int startX, unsigned int numX)
+{
+	UpdateVoltages(startX, numX, 0, numLines[1]);
+}
+
+void Engine_SSE_Compressed::UpdateVoltages(unsigned int startX, unsigned int numX, unsigned int startY, unsigned int numY)
 {
 	ArrayLib::ArrayNIJK<f4vector>& f4_volt = *f4_volt_ptr;
 	ArrayLib::ArrayNIJK<f4vector>& f4_curr = *f4_curr_ptr;
@@ -59,7 +64,7 @@ void Engine_SSE_Compressed::UpdateVoltages(unsigned int startX, unsigned int num
 	for (unsigned int posX=0; posX<numX; ++posX)
 	{
 		shift[0]=pos[0];
-		for (pos[1]=0; pos[1]<numLines[1]; ++pos[1])
+		for (pos[1]=startY; pos[1]<startY+numY; ++pos[1])
 		{
 			shift[1]=pos[1];
 			for (pos[2]=1; pos[2]<numVectors; ++pos[2])
@@ -159,6 +164,11 @@ void Engine_SSE_Compressed::UpdateVoltages(unsigned int startX, unsigned int num
 }
 
 void Engine_SSE_Compressed::UpdateCurrents(unsigned int startX, unsigned int numX)
+{
+	UpdateCurrents(startX, numX, 0, numLines[1]-1);
+}
+
+void Engine_SSE_Compressed::UpdateCurrents(unsigned int startX, unsigned int numX, unsigned int startY, unsigned int numY)
 {
 	ArrayLib::ArrayNIJK<f4vector>& f4_curr = *f4_curr_ptr;
 	ArrayLib::ArrayNIJK<f4vector>& f4_volt = *f4_volt_ptr;
@@ -170,7 +180,7 @@ void Engine_SSE_Compressed::UpdateCurrents(unsigned int startX, unsigned int num
 	unsigned int index;
 	for (unsigned int posX=0; posX<numX; ++posX)
 	{
-		for (pos[1]=0; pos[1]<numLines[1]-1; ++pos[1])
+		for (pos[1]=startY; pos[1]<startY+numY; ++pos[1])
 		{
 			for (pos[2]=0; pos[2]<numVectors-1; ++pos[2])
 			{
@@ -33,6 +33,11 @@ protected:
 
 	virtual void UpdateVoltages(unsigned int startX, unsigned int numX);
 	virtual void UpdateCurrents(unsigned int startX, unsigned int numX);
+
+	//! Update only the y-lines \a startY to \a startY+numY-1 of the given x-lines
+	virtual void UpdateVoltages(unsigned int startX, unsigned int numX, unsigned int startY, unsigned int numY);
+	//! Update only the y-lines \a startY to \a startY+numY-1 of the given x-lines
+	virtual void UpdateCurrents(unsigned int startX, unsigned int numX, unsigned int startY, unsigned int numY);
 };
 
 #endif // ENGINE_SSE_COMPRESSED_H
@@ -0,0 +1,263 @@
+/*
+*	Copyright (C) 2026 Thorsten Liebig (Thorsten.Liebig@gmx.de)
+*
+*	This program is free software: you can redistribute it and/or modify
+*	it under the terms of the GNU General Public License as published by
+*	the Free Software Foundation, either version 3 of the License, or
+*	(at your option) any later version.
+*
+*	This program is distributed in the hope that it will be useful,
+*	but WITHOUT ANY WARRANTY; without even the implied warranty of
+*	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*	GNU General Public License for more details.
+*
+*	You should have received a copy of the GNU General Public License
+*	along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "engine_tiling.h"
+#include "extensions/engine_extension.h"
+
+namespace po = boost::program_options;
+
+//! \brief construct an Engine_Tiling instance
+//! it's the responsibility of the caller to free the returned pointer
+Engine_Tiling* Engine_Tiling::New(const Operator_Tiling* op, unsigned int numThreads)
+{
+	cout << "Create FDTD engine (compressed SSE + multi-threading + temporal blocking)" << endl;
+	Engine_Tiling* e = new Engine_Tiling(op);
+	e->setNumThreads( numThreads );
+	e->Init();
+	return e;
+}
+
+Engine_Tiling::Engine_Tiling(const Operator_Tiling* op) : Engine_Multithread(op)
+{
+	m_tileSteps = 8;
+	m_tileWidth = 0;
+	m_useTiling = false;
+	m_tilingReported = false;
+}
+
+Engine_Tiling::~Engine_Tiling()
+{
+}
+
+po::options_description Engine_Tiling::optionDesc()
+{
+	po::options_description optdesc("Tiling engine arguments");
+	optdesc.add_options()
+		(
+			"tilingSteps",
+			po::value<unsigned int>()->default_value(8),
+			"Number of timesteps a tile is advanced at once (tiling engine only)"
+		)
+		(
+			"tilingWidth",
+			po::value<unsigned int>()->default_value(0),
+			"Width of a tile in x-lines, 0 for automatic (tiling engine only)"
+		);
+	return optdesc;
+}
+
+void Engine_Tiling::Init()
+{
+	// engine specific options are not known before the engine is created, see tools/global.h
+	if (g_settings.hasOption("tilingSteps"))
+		m_tileSteps = g_settings.getOption("tilingSteps").as<unsigned int>();
+	if (g_settings.hasOption("tilingWidth"))
+		m_tileWidth = g_settings.getOption("tilingWidth").as<unsigned int>();
+	m_useTiling = false;
+	m_tilingReported = false;
+
+	Engine_Multithread::Init();
+}
+
+bool Engine_Tiling::CalcTiles()
+{
+	m_tileStart.clear();
+	m_tileStop.clear();
+	m_tileExts.clear();
+
+#ifdef MPI_SUPPORT
+	if (m_Op_MT->GetMPIEnabled())
+		return false;
+#endif
+
+	if (m_tileSteps<2)
+		return false;
+
+	// the x-range of all extensions has to fit into a single tile
+	vector<unsigned int> extStart(m_Eng_exts.size());
+	vector<unsigned int> extStop(m_Eng_exts.size());
+	for (size_t n=0; n<m_Eng_exts.size(); ++n)
+	{
+		if (m_Eng_exts.at(n)->GetXRange(extStart.at(n), extStop.at(n)))
+			continue;
+		if ((g_settings.GetVerboseLevel()>0) && !m_tilingReported)
+			cerr << "Engine_Tiling::CalcTiles: Warning: extension \"" << m_Eng_exts.at(n)->GetExtensionName() << "\" is not limited in x-direction, temporal blocking disabled." << endl;
+		m_tilingReported = true;
+		return false;
+	}
+
+	unsigned int width = m_tileWidth;
+	if (width==0)
+	{
+		// keep voltages and currents of about 2MiB per tile
+		double lineSize = 6.0*sizeof(FDTD_FLOAT)*numLines[1]*numLines[2];
+		width = max(2*m_tileSteps, (unsigned int)(2.0*1024*1024/lineSize));
+		// but use all threads
+		width = min(width, max(1u, numLines[0]/m_numThreads));
+	}
+
+	// At a given step within a block the tile [x0, x1] updates the voltages in [x0-step, x1-step] and the currents in
+	// [x0-step-1, x1-step-1]. An extension with range [a, b] thus stays inside one tile, if no tile ends in [a, b+m_tileSteps-1].
+	unsigned int start = 0;
+	while (start<numLines[0])
+	{
+		unsigned int stop = start + width - 1;
+		bool moved = true;
+		while (moved)
+		{
+			moved = false;
+			for (size_t n=0; n<m_Eng_exts.size(); ++n)
+			{
+				if ((stop>=extStart.at(n)) && (stop<extStop.at(n)+m_tileSteps))
+				{
+					stop = extStop.at(n)+m_tileSteps;
+					moved = true;
+				}
+			}
+		}
+		if (stop>=numLines[0]-1)
+			stop = numLines[0]-1;
+		m_tileStart.push_back(start);
+		m_tileStop.push_back(stop);
+		start = stop+1;
+	}
+
+	if (m_tileStart.size()<2)
+		return false;
+
+	m_tileExts.resize(m_tileStart.size());
+	for (size_t n=0; n<m_Eng_exts.size(); ++n)
+	{
+		for (size_t t=0; t<m_tileStart.size(); ++t)
+			if ((extStart.at(n)>=m_tileStart.at(t)) && (extStart.at(n)<=m_tileStop.at(t)))
+				m_tileExts.at(t).push_back(m_Eng_exts.at(n));
+	}
+
+	m_tileProgress.assign(m_tileStart.size(), 0);
+
+	if ((g_settings.GetVerboseLevel()>0) && !m_tilingReported)
+		cout << "Engine_Tiling: using " << m_tileStart.size() << " tiles with up to " << m_tileSteps << " timesteps per block." << endl;
+	m_tilingReported = true;
+	return true;
+}
+
+bool Engine_Tiling::IterateTS(unsigned int iterTS)
+{
+	// the number of threads or extensions may have changed since the last call
+	m_useTiling = CalcTiles();
+	return Engine_Multithread::IterateTS(iterTS);
+}
+
+unsigned int Engine_Tiling::GetNumberOfTimesteps()
+{
+	unsigned int* ts = m_threadTS.get();
+	if (ts)
+		return *ts;
+	return numTS;
+}
+
+void Engine_Tiling::WaitForTile(unsigned int tile, unsigned int steps)
+{
+	boost::unique_lock<boost::mutex> lock(m_tileMutex);
+	while (m_tileProgress.at(tile)<steps)
+		m_tileCond.wait(lock);
+}
+
+void Engine_Tiling::UpdateTile(unsigned int tile, unsigned int step)
+{
+	bool first = (tile==0);
+	bool last = (tile==m_tileStart.size()-1);
+	int start = m_tileStart.at(tile);
+	int stop = m_tileStop.at(tile);
+
+	// the voltage range is shifted by one line per timestep, the current range by one additional line
+	int volt_start = first ? 0 : max(start-(int)step, 0);
+	int volt_stop  = last ? (int)numLines[0]-1 : stop-(int)step;
+	int curr_start = first ? 0 : max(start-(int)step-1, 0);
+	int curr_stop  = last ? (int)numLines[0]-2 : stop-(int)step-1;
+
+	// extensions are called in the same order as by Engine_Multithread, their thread IDs are run sequentially
+	vector<Engine_Extension*>& exts = m_tileExts.at(tile);
+	int numExts = exts.size();
+
+	for (int n=numExts-1; n>=0; --n)
+		for (unsigned int t=0; t<m_numThreads; ++t)
+			exts.at(n)->DoPreVoltageUpdates(t);
+	if (volt_stop>=volt_start)
+		UpdateVoltages(volt_start, volt_stop-volt_start+1);
+	for (int n=0; n<numExts; ++n)
+		for (unsigned int t=0; t<m_numThreads; ++t)
+			exts.at(n)->DoPostVoltageUpdates(t);
+	for (int n=0; n<numExts; ++n)
+		for (unsigned int t=0; t<m_numThreads; ++t)
+			exts.at(n)->Apply2Voltages(t);
+
+	for (int n=numExts-1; n>=0; --n)
+		for (unsigned int t=0; t<m_numThreads; ++t)
+			exts.at(n)->DoPreCurrentUpdates(t);
+	if (curr_stop>=curr_start)
+		UpdateCurrents(curr_start, curr_stop-curr_start+1);
+	for (int n=0; n<numExts; ++n)
+		for (unsigned int t=0; t<m_numThreads; ++t)
+			exts.at(n)->DoPostCurrentUpdates(t);
+	for (int n=0; n<numExts; ++n)
+		for (unsigned int t=0; t<m_numThreads; ++t)
+			exts.at(n)->Apply2Current(t);
+}
+
+bool Engine_Tiling::IterateThread(unsigned int threadID)
+{
+	if (!m_useTiling)
+		return false;
+
+	if (m_threadTS.get()==NULL)
+		m_threadTS.reset(new unsigned int(0));
+
+	unsigned int numTiles = m_tileStart.size();
+	for (unsigned int done=0; done<m_iterTS; done+=m_tileSteps)
+	{
+		unsigned int steps = min(m_tileSteps, m_iterTS-done);
+
+		// a tile may only advance to a timestep its left neighbor has already finished
+		for (unsigned int tile=threadID; tile<numTiles; tile+=m_numThreads)
+		{
+			for (unsigned int step=0; step<steps; ++step)
+			{
+				if (tile>0)
+					WaitForTile(tile-1, step+1);
+
+				*m_threadTS = numTS + step;
+				UpdateTile(tile, step);
+
+				boost::lock_guard<boost::mutex> lock(m_tileMutex);
+				m_tileProgress.at(tile) = step+1;
+				m_tileCond.notify_all();
+			}
+		}
+
+		m_IterateBarrier->wait();
+		if (threadID==0)
+		{
+			numTS += steps;
+			m_tileProgress.assign(numTiles, 0);
+		}
+		m_IterateBarrier->wait();
+	}
+
+	m_threadTS.reset();
+	return true;
+}
@@ -0,0 +1,89 @@
+/*
+*	Copyright (C) 2026 Thorsten Liebig (Thorsten.Liebig@gmx.de)
+*
+*	This program is free software: you can redistribute it and/or modify
+*	it under the terms of the GNU General Public License as published by
+*	the Free Software Foundation, either version 3 of the License, or
+*	(at your option) any later version.
+*
+*	This program is distributed in the hope that it will be useful,
+*	but WITHOUT ANY WARRANTY; without even the implied warranty of
+*	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*	GNU General Public License for more details.
+*
+*	You should have received a copy of the GNU General Public License
+*	along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef ENGINE_TILING_H
+#define ENGINE_TILING_H
+
+#include "engine_multithread.h"
+#include "operator_tiling.h"
+
+#include <boost/thread/tss.hpp>
+
+class Engine_Extension;
+
+//! Multithreaded FDTD engine using temporal blocking (wavefront tiling in x-direction)
+/*!
+  The x-range is split into tiles. Each tile is advanced by several timesteps before the next tile is processed,
+  keeping its fields in the cache. The tile boundaries are skewed by one line per timestep (one more for the currents),
+  thus a tile only depends on the tile to its left, which has to be one timestep ahead. Tiles are processed by the
+  worker threads in a pipelined fashion, no global barrier is needed within a block of timesteps.
+
+  Engine extensions are called by the tile that contains their x-range (see Engine_Extension::GetXRange) and see the
+  timestep of this tile in GetNumberOfTimesteps(). If any extension may access the entire domain, or MPI is used,
+  the engine falls back to the timestep-by-timestep update scheme of Engine_Multithread.
+  */
+class Engine_Tiling : public Engine_Multithread
+{
+public:
+	static Engine_Tiling* New(const Operator_Tiling* op, unsigned int numThreads = 0);
+	virtual ~Engine_Tiling();
+
+	//! Options of this engine, the values are read from g_settings by Init()
+	static boost::program_options::options_description optionDesc();
+
+	virtual void Init();
+
+	//! Iterate \a iterTS number of timesteps
+	virtual bool IterateTS(unsigned int iterTS);
+
+	virtual bool IterateThread(unsigned int threadID);
+
+	//! Sampling is not supported, the tiles are at different timesteps during the iteration
+	virtual bool SetTimestepSampler(std::function<void(unsigned int, unsigned int)> sampler) {return !sampler;}
+
+	//! Get the timestep of the tile the calling worker thread is updating, or the global timestep.
+	virtual unsigned int GetNumberOfTimesteps();
+
+protected:
+	Engine_Tiling(const Operator_Tiling* op);
+
+	//! Calculate the tiles for the current number of threads and extensions, returns false if tiling is not possible.
+	bool CalcTiles();
+
+	//! Advance \a tile by one timestep, \a step is counted from the start of the current block.
+	void UpdateTile(unsigned int tile, unsigned int step);
+
+	//! Wait until \a tile has finished \a steps timesteps of the current block.
+	void WaitForTile(unsigned int tile, unsigned int steps);
+
+	unsigned int m_tileSteps; //!< max. number of timesteps per block
+	unsigned int m_tileWidth; //!< requested tile width in x-lines, 0 for automatic
+	bool m_useTiling;
+	bool m_tilingReported;
+
+	vector<unsigned int> m_tileStart;
+	vector<unsigned int> m_tileStop;
+	vector<vector<Engine_Extension*> > m_tileExts;
+
+	vector<unsigned int> m_tileProgress; //!< finished timesteps per tile in the current block
+	boost::mutex m_tileMutex;
+	boost::condition_variable m_tileCond;
+
+	boost::thread_specific_ptr<unsigned int> m_threadTS;
+};
+
+#endif // ENGINE_TILING_H
@@ -0,0 +1,381 @@
+/*
+*	Copyright (C) 2026 Thorsten Liebig (Thorsten.Liebig@gmx.de)
+*
+*	This program is free software: you can redistribute it and/or modify
+*	it under the terms of the GNU General Public License as published by
+*	the Free Software Foundation, either version 3 of the License, or
+*	(at your option) any later version.
+*
+*	This program is distributed in the hope that it will be useful,
+*	but WITHOUT ANY WARRANTY; without even the implied warranty of
+*	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*	GNU General Public License for more details.
+*
+*	You should have received a copy of the GNU General Public License
+*	along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "engine_ext_cpml.h"
+#include "operator_ext_cpml.h"
+#include "tools/array_ops.h"
+#include "tools/useful.h"
+
+// element-wise access to the engine values, a value of the basic engine is a vector with a single slot
+template <typename T>
+inline decltype(T::v)& Vec(T& val) {return val.v;}
+inline FDTD_FLOAT& Vec(FDTD_FLOAT& val) {return val;}
+
+template <typename T>
+inline FDTD_FLOAT& Slot(T& val, unsigned int slot) {return val.f[slot];}
+inline FDTD_FLOAT& Slot(FDTD_FLOAT& val, unsigned int slot) {UNUSED(slot); return val;}
+
+template <typename T>
+inline void Broadcast(T& val, FDTD_FLOAT f)
+{
+	for (unsigned int n=0; n<sizeof(T)/sizeof(FDTD_FLOAT); ++n)
+		val.f[n] = f;
+}
+inline void Broadcast(FDTD_FLOAT& val, FDTD_FLOAT f) {val = f;}
+
+Engine_Ext_CPML::Engine_Ext_CPML(Operator_Ext_CPML* op_ext) : Engine_Extension(op_ext)
+{
+	m_Op_CPML = op_ext;
+
+	m_Priority = ENG_EXT_PRIO_CPML;
+
+	for (int n=0; n<3; ++n)
+		m_numLines[n] = m_Op_CPML->m_Op->GetNumberOfLines(n,true);
+
+	SetNumberOfThreads(1);
+}
+
+Engine_Ext_CPML::~Engine_Ext_CPML()
+{
+}
+
+template <> Engine_Ext_CPML::Layer<FDTD_FLOAT>& Engine_Ext_CPML::GetLayer<FDTD_FLOAT>() {return m_Layer;}
+template <> Engine_Ext_CPML::Layer<f4vector>& Engine_Ext_CPML::GetLayer<f4vector>() {return m_Layer_sse;}
+template <> Engine_Ext_CPML::Layer<f8vector>& Engine_Ext_CPML::GetLayer<f8vector>() {return m_Layer_avx2;}
+template <> Engine_Ext_CPML::Layer<f16vector>& Engine_Ext_CPML::GetLayer<f16vector>() {return m_Layer_avx512;}
+
+void Engine_Ext_CPML::SetEngine(Engine* eng)
+{
+	Engine_Extension::SetEngine(eng);
+	ENG_DISPATCH(InitLayerImpl);
+}
+
+template <typename EngType>
+void Engine_Ext_CPML::InitLayerImpl(EngType* eng)
+{
+	InitLayer(GetVoltArray(eng));
+}
+
+template <typename T>
+void Engine_Ext_CPML::InitLayer(const ArrayLib::ArrayNIJK<T>& volt)
+{
+	const Operator* op = m_Op_CPML->m_Op;
+	int ny = m_Op_CPML->m_ny;
+	unsigned int* start = m_Op_CPML->m_StartPos;
+	unsigned int* numLines = m_Op_CPML->m_numLines;
+	unsigned int numVectors = volt.extent(3);
+
+	unsigned int pos[3];
+	unsigned int loc_pos[3];
+
+	if (ny==2)
+	{
+		// layer is stored line by line, find the engine vector and slot of every z-line
+		m_Layer.volt_psi.Init("volt_psi", numLines);
+		m_Layer.volt_coeff.Init("volt_coeff", numLines);
+		m_Layer.curr_psi.Init("curr_psi", numLines);
+		m_Layer.curr_coeff.Init("curr_coeff", numLines);
+
+		m_zVector.assign(numLines[2]+2, 0);
+		m_zSlot.assign(numLines[2]+2, 0);
+		for (unsigned int n=0; n<numLines[2]+2; ++n)
+		{
+			int z = (int)start[2] + (int)n - 1;
+			if ((z<0) || (z>=(int)m_numLines[2]))
+				continue;
+			m_zVector.at(n) = z%numVectors;
+			m_zSlot.at(n) = z/numVectors;
+		}
+	}
+	else
+	{
+		// layer is stored in the packed z-layout of the engine
+		unsigned int extent[3] = {numLines[0], numLines[1], numVectors};
+		Layer<T>& layer = GetLayer<T>();
+		layer.volt_psi.Init("volt_psi", extent);
+		layer.volt_coeff.Init("volt_coeff", extent);
+		layer.curr_psi.Init("curr_psi", extent);
+		layer.curr_coeff.Init("curr_coeff", extent);
+	}
+
+	for (loc_pos[0]=0; loc_pos[0]<numLines[0]; ++loc_pos[0])
+	{
+		pos[0] = loc_pos[0] + start[0];
+		for (loc_pos[1]=0; loc_pos[1]<numLines[1]; ++loc_pos[1])
+		{
+			pos[1] = loc_pos[1] + start[1];
+			for (loc_pos[2]=0; loc_pos[2]<numLines[2]; ++loc_pos[2])
+			{
+				pos[2] = loc_pos[2] + start[2];
+				// currents on the last lines are not updated by the engine
+				bool curr_valid = (pos[0]<m_numLines[0]-1) && (pos[1]<m_numLines[1]-1) && (pos[2]<m_numLines[2]-1);
+				for (int nt=0; nt<2; ++nt)
+				{
+					int n = (ny+1+nt)%3;
+					FDTD_FLOAT volt_coeff = 0;
+					if (!m_Op_CPML->IsVoltDisabled(loc_pos, nt))
+						volt_coeff = m_Op_CPML->m_volt_a.at(loc_pos[ny]) * op->GetVI(n,pos);
+					// the metal check (IsVoltDisabled) only applies to the voltages: it detects a (lossy) conductor by the electric
+					// conductivity of the voltage edge, which does not change the current update. The same way the upml only disables
+					// its voltage part inside a metal (see Operator_Ext_UPML::BuildExtension). Inside a good conductor the tangential
+					// voltages and thus the curl driving the current psi are (nearly) zero, the current psi stays negligible there.
+					FDTD_FLOAT curr_coeff = 0;
+					if (curr_valid)
+						curr_coeff = m_Op_CPML->m_curr_a.at(loc_pos[ny]) * op->GetIV(n,pos);
+
+					if (ny==2)
+					{
+						m_Layer.volt_coeff(nt,loc_pos[0],loc_pos[1],loc_pos[2]) = volt_coeff;
+						m_Layer.curr_coeff(nt,loc_pos[0],loc_pos[1],loc_pos[2]) = curr_coeff;
+					}
+					else
+					{
+						Layer<T>& layer = GetLayer<T>();
+						Slot(layer.volt_coeff(nt,loc_pos[0],loc_pos[1],pos[2]%numVectors), pos[2]/numVectors) = volt_coeff;
+						Slot(layer.curr_coeff(nt,loc_pos[0],loc_pos[1],pos[2]%numVectors), pos[2]/numVectors) = curr_coeff;
+					}
+				}
+			}
+		}
+	}
+}
+
+void Engine_Ext_CPML::SetNumberOfThreads(int nrThread)
+{
+	Engine_Extension::SetNumberOfThreads(nrThread);
+
+	m_numX = AssignJobs2Threads(m_Op_CPML->m_numLines[0],m_NrThreads,false);
+	m_start.resize(m_NrThreads,0);
+	m_start.at(0)=0;
+	for (size_t n=1; n<m_numX.size(); ++n)
+		m_start.at(n) = m_start.at(n-1) + m_numX.at(n-1);
+}
+
+bool Engine_Ext_CPML::GetXRange(unsigned int &start, unsigned int &stop) const
+{
+	start = m_Op_CPML->m_StartPos[0];
+	stop = m_Op_CPML->m_StartPos[0] + m_Op_CPML->m_numLines[0] - 1;
+	return true;
+}
+
+template <typename T>
+void Engine_Ext_CPML::ApplyVoltageVectors(ArrayLib::ArrayNIJK<T>& volt, ArrayLib::ArrayNIJK<T>& curr, int threadID)
+{
+	Layer<T>& layer = GetLayer<T>();
+	int ny = m_Op_CPML->m_ny;
+	int n1 = (ny+1)%3;
+	int n2 = (ny+2)%3;
+	unsigned int numVectors = volt.extent(3);
+
+	unsigned int pos[3];
+	unsigned int loc_pos[3];
+	unsigned int prev[3];
+	T b;
+
+	for (unsigned int lineX=0; lineX<m_numX.at(threadID); ++lineX)
+	{
+		loc_pos[0] = lineX + m_start.at(threadID);
+		pos[0] = loc_pos[0] + m_Op_CPML->m_StartPos[0];
+		for (loc_pos[1]=0; loc_pos[1]<m_Op_CPML->m_numLines[1]; ++loc_pos[1])
+		{
+			pos[1] = loc_pos[1] + m_Op_CPML->m_StartPos[1];
+			// no normal derivative at the lower boundary (see Engine::UpdateVoltages) or outside the graded region
+			if ((pos[ny]==0) || (m_Op_CPML->m_volt_a.at(loc_pos[ny])==0))
+				continue;
+			Broadcast(b, m_Op_CPML->m_volt_b.at(loc_pos[ny]));
+			prev[0] = pos[0] - (ny==0);
+			prev[1] = pos[1] - (ny==1);
+			for (pos[2]=0; pos[2]<numVectors; ++pos[2])
+			{
+				T& psi1 = layer.volt_psi(0,loc_pos[0],loc_pos[1],pos[2]);
+				Vec(psi1) = Vec(b)*Vec(psi1) + Vec(layer.volt_coeff(0,loc_pos[0],loc_pos[1],pos[2])) *
+				            (Vec(curr(n2,prev[0],prev[1],pos[2])) - Vec(curr(n2,pos[0],pos[1],pos[2])));
+				Vec(volt(n1,pos[0],pos[1],pos[2])) += Vec(psi1);
+
+				T& psi2 = layer.volt_psi(1,loc_pos[0],loc_pos[1],pos[2]);
+				Vec(psi2) = Vec(b)*Vec(psi2) + Vec(layer.volt_coeff(1,loc_pos[0],loc_pos[1],pos[2])) *
+				            (Vec(curr(n1,pos[0],pos[1],pos[2])) - Vec(curr(n1,prev[0],prev[1],pos[2])));
+				Vec(volt(n2,pos[0],pos[1],pos[2])) += Vec(psi2);
+			}
+		}
+	}
+}
+
+template <typename T>
+void Engine_Ext_CPML::ApplyCurrentVectors(ArrayLib::ArrayNIJK<T>& volt, ArrayLib::ArrayNIJK<T>& curr, int threadID)
+{
+	Layer<T>& layer = GetLayer<T>();
+	int ny = m_Op_CPML->m_ny;
+	int n1 = (ny+1)%3;
+	int n2 = (ny+2)%3;
+	unsigned int numVectors = volt.extent(3);
+
+	unsigned int pos[3];
+	unsigned int loc_pos[3];
+	unsigned int next[3];
+	T b;
+
+	for (unsigned int lineX=0; lineX<m_numX.at(threadID); ++lineX)
+	{
+		loc_pos[0] = lineX + m_start.at(threadID);
+		pos[0] = loc_pos[0] + m_Op_CPML->m_StartPos[0];
+		if (pos[0]>=m_numLines[0]-1)
+			continue;
+		for (loc_pos[1]=0; loc_pos[1]<m_Op_CPML->m_numLines[1]; ++loc_pos[1])
+		{
+			pos[1] = loc_pos[1] + m_Op_CPML->m_StartPos[1];
+			// currents on the last lines are not updated by the engine
+			if ((pos[1]>=m_numLines[1]-1) || (m_Op_CPML->m_curr_a.at(loc_pos[ny])==0))
+				continue;
+			Broadcast(b, m_Op_CPML->m_curr_b.at(loc_pos[ny]));
+			next[0] = pos[0] + (ny==0);
+			next[1] = pos[1] + (ny==1);
+			for (pos[2]=0; pos[2]<numVectors; ++pos[2])
+			{
+				T& psi1 = layer.curr_psi(0,loc_pos[0],loc_pos[1],pos[2]);
+				Vec(psi1) = Vec(b)*Vec(psi1) + Vec(layer.curr_coeff(0,loc_pos[0],loc_pos[1],pos[2])) *
+				            (Vec(volt(n2,next[0],next[1],pos[2])) - Vec(volt(n2,pos[0],pos[1],pos[2])));
+				Vec(curr(n1,pos[0],pos[1],pos[2])) += Vec(psi1);
+
+				T& psi2 = layer.curr_psi(1,loc_pos[0],loc_pos[1],pos[2]);
+				Vec(psi2) = Vec(b)*Vec(psi2) + Vec(layer.curr_coeff(1,loc_pos[0],loc_pos[1],pos[2])) *
+				            (Vec(volt(n1,pos[0],pos[1],pos[2])) - Vec(volt(n1,next[0],next[1],pos[2])));
+				Vec(curr(n2,pos[0],pos[1],pos[2])) += Vec(psi2);
+			}
+		}
+	}
+}
+
+template <typename T>
+void Engine_Ext_CPML::ApplyVoltageLines(ArrayLib::ArrayNIJK<T>& volt, ArrayLib::ArrayNIJK<T>& curr, int threadID)
+{
+	const vector<FDTD_FLOAT>& a = m_Op_CPML->m_volt_a;
+	const vector<FDTD_FLOAT>& b = m_Op_CPML->m_volt_b;
+
+	unsigned int pos[3];
+	unsigned int loc_pos[3];
+	unsigned int vec, slot, vec_prev, slot_prev;
+
+	for (unsigned int lineX=0; lineX<m_numX.at(threadID); ++lineX)
+	{
+		loc_pos[0] = lineX + m_start.at(threadID);
+		pos[0] = loc_pos[0] + m_Op_CPML->m_StartPos[0];
+		for (loc_pos[1]=0; loc_pos[1]<m_Op_CPML->m_numLines[1]; ++loc_pos[1])
+		{
+			pos[1] = loc_pos[1] + m_Op_CPML->m_StartPos[1];
+			for (loc_pos[2]=0; loc_pos[2]<m_Op_CPML->m_numLines[2]; ++loc_pos[2])
+			{
+				// no normal derivative at the lower boundary (see Engine::UpdateVoltages) or outside the graded region
+				if ((loc_pos[2]+m_Op_CPML->m_StartPos[2]==0) || (a[loc_pos[2]]==0))
+					continue;
+				vec = m_zVector[loc_pos[2]+1];
+				slot = m_zSlot[loc_pos[2]+1];
+				vec_prev = m_zVector[loc_pos[2]];
+				slot_prev = m_zSlot[loc_pos[2]];
+
+				FDTD_FLOAT& psi_x = m_Layer.volt_psi(0,loc_pos[0],loc_pos[1],loc_pos[2]);
+				psi_x = b[loc_pos[2]]*psi_x + m_Layer.volt_coeff(0,loc_pos[0],loc_pos[1],loc_pos[2]) *
+				        (Slot(curr(1,pos[0],pos[1],vec_prev),slot_prev) - Slot(curr(1,pos[0],pos[1],vec),slot));
+				Slot(volt(0,pos[0],pos[1],vec),slot) += psi_x;
+
+				FDTD_FLOAT& psi_y = m_Layer.volt_psi(1,loc_pos[0],loc_pos[1],loc_pos[2]);
+				psi_y = b[loc_pos[2]]*psi_y + m_Layer.volt_coeff(1,loc_pos[0],loc_pos[1],loc_pos[2]) *
+				        (Slot(curr(0,pos[0],pos[1],vec),slot) - Slot(curr(0,pos[0],pos[1],vec_prev),slot_prev));
+				Slot(volt(1,pos[0],pos[1],vec),slot) += psi_y;
+			}
+		}
+	}
+}
+
+template <typename T>
+void Engine_Ext_CPML::ApplyCurrentLines(ArrayLib::ArrayNIJK<T>& volt, ArrayLib::ArrayNIJK<T>& curr, int threadID)
+{
+	const vector<FDTD_FLOAT>& a = m_Op_CPML->m_curr_a;
+	const vector<FDTD_FLOAT>& b = m_Op_CPML->m_curr_b;
+
+	unsigned int pos[3];
+	unsigned int loc_pos[3];
+	unsigned int vec, slot, vec_next, slot_next;
+
+	for (unsigned int lineX=0; lineX<m_numX.at(threadID); ++lineX)
+	{
+		loc_pos[0] = lineX + m_start.at(threadID);
+		pos[0] = loc_pos[0] + m_Op_CPML->m_StartPos[0];
+		if (pos[0]>=m_numLines[0]-1)
+			continue;
+		for (loc_pos[1]=0; loc_pos[1]<m_Op_CPML->m_numLines[1]; ++loc_pos[1])
+		{
+			pos[1] = loc_pos[1] + m_Op_CPML->m_StartPos[1];
+			if (pos[1]>=m_numLines[1]-1)
+				continue;
+			for (loc_pos[2]=0; loc_pos[2]<m_Op_CPML->m_numLines[2]; ++loc_pos[2])
+			{
+				// currents on the last lines are not updated by the engine
+				if ((loc_pos[2]+m_Op_CPML->m_StartPos[2]>=m_numLines[2]-1) || (a[loc_pos[2]]==0))
+					continue;
+				vec = m_zVector[loc_pos[2]+1];
+				slot = m_zSlot[loc_pos[2]+1];
+				vec_next = m_zVector[loc_pos[2]+2];
+				slot_next = m_zSlot[loc_pos[2]+2];
+
+				FDTD_FLOAT& psi_x = m_Layer.curr_psi(0,loc_pos[0],loc_pos[1],loc_pos[2]);
+				psi_x = b[loc_pos[2]]*psi_x + m_Layer.curr_coeff(0,loc_pos[0],loc_pos[1],loc_pos[2]) *
+				        (Slot(volt(1,pos[0],pos[1],vec_next),slot_next) - Slot(volt(1,pos[0],pos[1],vec),slot));
+				Slot(curr(0,pos[0],pos[1],vec),slot) += psi_x;
+
+				FDTD_FLOAT& psi_y = m_Layer.curr_psi(1,loc_pos[0],loc_pos[1],loc_pos[2]);
+				psi_y = b[loc_pos[2]]*psi_y + m_Layer.curr_coeff(1,loc_pos[0],loc_pos[1],loc_pos[2]) *
+				        (Slot(volt(0,pos[0],pos[1],vec),slot) - Slot(volt(0,pos[0],pos[1],vec_next),slot_next));
+				Slot(curr(1,pos[0],pos[1],vec),slot) += psi_y;
+			}
+		}
+	}
+}
+
+template <typename EngType>
+void Engine_Ext_CPML::Apply2VoltagesImpl(EngType* eng, int threadID)
+{
+	if (threadID>=m_NrThreads)
+		return;
+
+	if (m_Op_CPML->m_ny==2)
+		ApplyVoltageLines(GetVoltArray(eng), GetCurrArray(eng), threadID);
+	else
+		ApplyVoltageVectors(GetVoltArray(eng), GetCurrArray(eng), threadID);
+}
+
+void Engine_Ext_CPML::Apply2Voltages(int threadID)
+{
+	ENG_DISPATCH_ARGS(Apply2VoltagesImpl, threadID);
+}
+
+template <typename EngType>
+void Engine_Ext_CPML::Apply2CurrentImpl(EngType* eng, int threadID)
+{
+	if (threadID>=m_NrThreads)
+		return;
+
+	if (m_Op_CPML->m_ny==2)
+		ApplyCurrentLines(GetVoltArray(eng), GetCurrArray(eng), threadID);
+	else
+		ApplyCurrentVectors(GetVoltArray(eng), GetCurrArray(eng), threadID);
+}
+
+void Engine_Ext_CPML::Apply2Current(int threadID)
+{
+	ENG_DISPATCH_ARGS(Apply2CurrentImpl, threadID);
+}
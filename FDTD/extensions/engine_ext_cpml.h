@@ -0,0 +1,118 @@
+/*
+*	Copyright (C) 2026 Thorsten Liebig (Thorsten.Liebig@gmx.de)
+*
+*	This program is free software: you can redistribute it and/or modify
+*	it under the terms of the GNU General Public License as published by
+*	the Free Software Foundation, either version 3 of the License, or
+*	(at your option) any later version.
+*
+*	This program is distributed in the hope that it will be useful,
+*	but WITHOUT ANY WARRANTY; without even the implied warranty of
+*	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*	GNU General Public License for more details.
+*
+*	You should have received a copy of the GNU General Public License
+*	along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef ENGINE_EXT_CPML_H
+#define ENGINE_EXT_CPML_H
+
+#include "engine_extension.h"
+#include "FDTD/engine.h"
+#include "FDTD/operator.h"
+#include "engine_extension_dispatcher.h"
+
+class Operator_Ext_CPML;
+
+//! Engine extension of the convolutional pml, see Operator_Ext_CPML
+/*!
+  After the main engine updates, the convolutions (psi) of the normal derivatives are updated and added to the two tangential components.
+  The psi terms are stored pre-multiplied with the engine coefficients (vi resp. iv), therefore only psi and its coefficient are needed per cell and component.
+
+  For a layer with the normal direction x or y the psi terms are stored in the packed z-layout of the engine (see Engine_sse),
+  so the updates are done on whole engine vectors and the normal neighbors are found in the same vector slot.
+  A layer in z-direction is spread over all vector slots and is thus updated per line with precalculated slot positions.
+  */
+class Engine_Ext_CPML : public Engine_Extension
+{
+public:
+	Engine_Ext_CPML(Operator_Ext_CPML* op_ext);
+	virtual ~Engine_Ext_CPML();
+
+	virtual void SetEngine(Engine* eng);
+
+	virtual void SetNumberOfThreads(int nrThread);
+
+	virtual void Apply2Voltages() {Engine_Ext_CPML::Apply2Voltages(0);}
+	virtual void Apply2Voltages(int threadID);
+	virtual void Apply2Current() {Engine_Ext_CPML::Apply2Current(0);}
+	virtual void Apply2Current(int threadID);
+
+	virtual bool GetXRange(unsigned int &start, unsigned int &stop) const;
+
+protected:
+	//! psi terms and coefficients of the two tangential components (n = 0, 1)
+	template <typename T>
+	struct Layer
+	{
+		ArrayLib::ArrayNIJK<T, uint32_t, 2> volt_psi;
+		ArrayLib::ArrayNIJK<T, uint32_t, 2> volt_coeff;
+		ArrayLib::ArrayNIJK<T, uint32_t, 2> curr_psi;
+		ArrayLib::ArrayNIJK<T, uint32_t, 2> curr_coeff;
+	};
+
+	//! Get the layer storage for the engine vector type
+	template <typename T>
+	Layer<T>& GetLayer();
+
+	//! Native field access of the different engines
+	static ArrayLib::ArrayNIJK<FDTD_FLOAT>& GetVoltArray(Engine* eng) {return *eng->volt_ptr;}
+	static ArrayLib::ArrayNIJK<FDTD_FLOAT>& GetCurrArray(Engine* eng) {return *eng->curr_ptr;}
+	static ArrayLib::ArrayNIJK<f4vector>& GetVoltArray(Engine_sse* eng) {return *eng->f4_volt_ptr;}
+	static ArrayLib::ArrayNIJK<f4vector>& GetCurrArray(Engine_sse* eng) {return *eng->f4_curr_ptr;}
+	template <typename fNvector>
+	static ArrayLib::ArrayNIJK<fNvector>& GetVoltArray(Engine_AVX<fNvector>* eng) {return *eng->fN_volt_ptr;}
+	template <typename fNvector>
+	static ArrayLib::ArrayNIJK<fNvector>& GetCurrArray(Engine_AVX<fNvector>* eng) {return *eng->fN_curr_ptr;}
+
+	template <typename EngType>
+	void InitLayerImpl(EngType* eng);
+	template <typename T>
+	void InitLayer(const ArrayLib::ArrayNIJK<T>& volt);
+
+	template <typename EngType>
+	void Apply2VoltagesImpl(EngType* eng, int threadID);
+	template <typename EngType>
+	void Apply2CurrentImpl(EngType* eng, int threadID);
+
+	//! Update a layer with normal direction x or y using whole engine vectors
+	template <typename T>
+	void ApplyVoltageVectors(ArrayLib::ArrayNIJK<T>& volt, ArrayLib::ArrayNIJK<T>& curr, int threadID);
+	template <typename T>
+	void ApplyCurrentVectors(ArrayLib::ArrayNIJK<T>& volt, ArrayLib::ArrayNIJK<T>& curr, int threadID);
+
+	//! Update a layer with normal direction z line by line
+	template <typename T>
+	void ApplyVoltageLines(ArrayLib::ArrayNIJK<T>& volt, ArrayLib::ArrayNIJK<T>& curr, int threadID);
+	template <typename T>
+	void ApplyCurrentLines(ArrayLib::ArrayNIJK<T>& volt, ArrayLib::ArrayNIJK<T>& curr, int threadID);
+
+	Operator_Ext_CPML* m_Op_CPML;
+
+	unsigned int m_numLines[3];
+
+	vector<unsigned int> m_start;
+	vector<unsigned int> m_numX;
+
+	Layer<FDTD_FLOAT> m_Layer;
+	Layer<f4vector> m_Layer_sse;
+	Layer<f8vector> m_Layer_avx2;
+	Layer<f16vector> m_Layer_avx512;
+
+	//! vector and slot of the z-lines m_StartPos[2]-1 to m_StartPos[2]+m_numLines[2] for a layer in z-direction
+	vector<unsigned int> m_zVector;
+	vector<unsigned int> m_zSlot;
+};
+
+#endif // ENGINE_EXT_CPML_H
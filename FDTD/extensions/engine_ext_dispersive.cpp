@@ -18,6 +18,9 @@
 #include "engine_ext_dispersive.h"
 #include "operator_ext_dispersive.h"
 #include "FDTD/engine_sse.h"
+#include "tools/useful.h"
+
+#include <algorithm>
 
 Engine_Ext_Dispersive::Engine_Ext_Dispersive(Operator_Ext_Dispersive* op_ext_disp) : Engine_Extension(op_ext_disp)
 {
@@ -49,6 +52,38 @@ Engine_Ext_Dispersive::Engine_Ext_Dispersive(Operator_Ext_Dispersive* op_ext_dis
 				volt_ADE[o][n] = NULL;
 		}
 	}
+
+	SetNumberOfThreads(1);
+}
+
+void Engine_Ext_Dispersive::SetNumberOfThreads(int nrThread)
+{
+	Engine_Extension::SetNumberOfThreads(nrThread);
+
+	// split the dispersive cells by the same x-ranges as the engine threads, the cells are sorted by their x-position
+	vector<unsigned int> numX = AssignJobs2Threads(m_Op_Ext_Disp->m_Op->GetNumberOfLines(0,true), m_NrThreads, false);
+	int order = m_Op_Ext_Disp->m_Order;
+	m_ThreadStart.resize(order);
+	for (int o=0;o<order;++o)
+	{
+		unsigned int count = m_Op_Ext_Disp->m_LM_Count.at(o);
+		const unsigned int* posX = m_Op_Ext_Disp->m_LM_pos[o][0];
+		m_ThreadStart.at(o).assign(m_NrThreads+1, count);
+		m_ThreadStart.at(o).at(0) = 0;
+
+		bool sorted = std::is_sorted(posX, posX+count);
+		unsigned int stopX = 0;
+		for (int t=1; t<m_NrThreads; ++t)
+		{
+			if (sorted)
+			{
+				stopX += (t-1<(int)numX.size()) ? numX.at(t-1) : 0;
+				m_ThreadStart.at(o).at(t) = std::lower_bound(posX, posX+count, stopX) - posX;
+			}
+			else
+				m_ThreadStart.at(o).at(t) = (unsigned long long)count*t/m_NrThreads;
+		}
+	}
 }
 
 Engine_Ext_Dispersive::~Engine_Ext_Dispersive()
@@ -73,16 +108,33 @@ Engine_Ext_Dispersive::~Engine_Ext_Dispersive()
 	volt_ADE=NULL;
 }
 
+void Engine_Ext_Dispersive::GetThreadRange(int order, int threadID, unsigned int &start, unsigned int &stop) const
+{
+	if (threadID<0)
+	{
+		start = 0;
+		stop = m_Op_Ext_Disp->m_LM_Count.at(order);
+		return;
+	}
+	start = m_ThreadStart.at(order).at(threadID);
+	stop = m_ThreadStart.at(order).at(threadID+1);
+}
+
 template <typename EngType>
-void Engine_Ext_Dispersive::Apply2VoltagesImpl(EngType* eng)
+void Engine_Ext_Dispersive::Apply2VoltagesImpl(EngType* eng, int threadID)
 {
+	if (threadID>=m_NrThreads)
+		return;
+
+	unsigned int start, stop;
 	for (int o=0;o<m_Op_Ext_Disp->m_Order;++o)
 	{
 		if (m_Op_Ext_Disp->m_volt_ADE_On[o]==false) continue;
 
 		unsigned int **pos = m_Op_Ext_Disp->m_LM_pos[o];
 
-		for (unsigned int i=0; i<m_Op_Ext_Disp->m_LM_Count.at(o); ++i)
+		GetThreadRange(o, threadID, start, stop);
+		for (unsigned int i=start; i<stop; ++i)
 		{
 			eng->EngType::SetVolt(0,pos[0][i],pos[1][i],pos[2][i],
 				eng->EngType::GetVolt(0,pos[0][i],pos[1][i],pos[2][i]) - volt_ADE[o][0][i]
@@ -99,19 +151,29 @@ void Engine_Ext_Dispersive::Apply2VoltagesImpl(EngType* eng)
 
 void Engine_Ext_Dispersive::Apply2Voltages()
 {
-	ENG_DISPATCH(Apply2VoltagesImpl);
+	ENG_DISPATCH_ARGS(Apply2VoltagesImpl, -1);
+}
+
+void Engine_Ext_Dispersive::Apply2Voltages(int threadID)
+{
+	ENG_DISPATCH_ARGS(Apply2VoltagesImpl, threadID);
 }
 
 template <typename EngType>
-void Engine_Ext_Dispersive::Apply2CurrentImpl(EngType* eng)
+void Engine_Ext_Dispersive::Apply2CurrentImpl(EngType* eng, int threadID)
 {
+	if (threadID>=m_NrThreads)
+		return;
+
+	unsigned int start, stop;
 	for (int o=0;o<m_Op_Ext_Disp->m_Order;++o)
 	{
 		if (m_Op_Ext_Disp->m_curr_ADE_On[o]==false) continue;
 
 		unsigned int **pos = m_Op_Ext_Disp->m_LM_pos[o];
 
-		for (unsigned int i=0; i<m_Op_Ext_Disp->m_LM_Count.at(o); ++i)
+		GetThreadRange(o, threadID, start, stop);
+		for (unsigned int i=start; i<stop; ++i)
 		{
 			eng->EngType::SetCurr(0,pos[0][i],pos[1][i],pos[2][i],
 				eng->EngType::GetCurr(0,pos[0][i],pos[1][i],pos[2][i]) - curr_ADE[o][0][i]
@@ -128,5 +190,10 @@ void Engine_Ext_Dispersive::Apply2CurrentImpl(EngType* eng)
 
 void Engine_Ext_Dispersive::Apply2Current()
 {
-	ENG_DISPATCH(Apply2CurrentImpl);
+	ENG_DISPATCH_ARGS(Apply2CurrentImpl, -1);
+}
+
+void Engine_Ext_Dispersive::Apply2Current(int threadID)
+{
+	ENG_DISPATCH_ARGS(Apply2CurrentImpl, threadID);
 }
@@ -31,21 +31,32 @@ public:
 	Engine_Ext_Dispersive(Operator_Ext_Dispersive* op_ext_disp);
 	virtual ~Engine_Ext_Dispersive();
 
+	virtual void SetNumberOfThreads(int nrThread);
+
 	virtual void Apply2Voltages();
+	virtual void Apply2Voltages(int threadID);
 	virtual void Apply2Current();
+	virtual void Apply2Current(int threadID);
 
 protected:
 	template <typename EngType>
-	void Apply2VoltagesImpl(EngType* eng);
+	void Apply2VoltagesImpl(EngType* eng, int threadID);
 
 	template <typename EngType>
-	void Apply2CurrentImpl(EngType* eng);
+	void Apply2CurrentImpl(EngType* eng, int threadID);
+
+	//! Get the range [start, stop) of dispersive cells of the given order handled by a thread, a negative threadID selects all cells
+	void GetThreadRange(int order, int threadID, unsigned int &start, unsigned int &stop) const;
 
 	Operator_Ext_Dispersive* m_Op_Ext_Disp;
 
 	//! Dispersive order
 	int m_Order;
 
+	//! First dispersive cell of every thread, the cells are split by the x-ranges of the engine threads
+	// Array setup: m_ThreadStart[N_order][threadID], with an additional end index
+	std::vector< std::vector<unsigned int> > m_ThreadStart;
+
 	//! ADE currents
 	// Array setup: curr_ADE[N_order][direction][mesh_pos]
 	FDTD_FLOAT ***curr_ADE;
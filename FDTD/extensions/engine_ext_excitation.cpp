@@ -30,6 +30,29 @@ Engine_Ext_Excitation::~Engine_Ext_Excitation()
 
 }
 
+bool Engine_Ext_Excitation::GetXRange(unsigned int &start, unsigned int &stop) const
+{
+	start = stop = 0;
+	bool found = false;
+	for (unsigned int n=0; n<m_Op_Exc->Volt_Count; ++n)
+	{
+		if (!found || (m_Op_Exc->Volt_index[0][n]<start))
+			start = m_Op_Exc->Volt_index[0][n];
+		if (!found || (m_Op_Exc->Volt_index[0][n]>stop))
+			stop = m_Op_Exc->Volt_index[0][n];
+		found = true;
+	}
+	for (unsigned int n=0; n<m_Op_Exc->Curr_Count; ++n)
+	{
+		if (!found || (m_Op_Exc->Curr_index[0][n]<start))
+			start = m_Op_Exc->Curr_index[0][n];
+		if (!found || (m_Op_Exc->Curr_index[0][n]>stop))
+			stop = m_Op_Exc->Curr_index[0][n];
+		found = true;
+	}
+	return true;
+}
+
 template <typename EngType>
 void Engine_Ext_Excitation::Apply2VoltagesImpl(EngType* eng)
 {
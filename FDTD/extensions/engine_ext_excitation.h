@@ -34,6 +34,8 @@ public:
 	virtual void Apply2Voltages();
 	virtual void Apply2Current();
 
+	virtual bool GetXRange(unsigned int &start, unsigned int &stop) const;
+
 protected:
 	template <typename EngType>
 	void Apply2VoltagesImpl(EngType* eng);
@@ -77,17 +77,22 @@ Engine_Ext_LorentzMaterial::~Engine_Ext_LorentzMaterial()
 }
 
 template <typename EngType>
-void Engine_Ext_LorentzMaterial::DoPreVoltageUpdatesImpl(EngType* eng)
+void Engine_Ext_LorentzMaterial::DoPreVoltageUpdatesImpl(EngType* eng, int threadID)
 {
+	if (threadID>=m_NrThreads)
+		return;
+
+	unsigned int start, stop;
 	for (int o=0;o<m_Order;++o)
 	{
 		if (m_Op_Ext_Lor->m_volt_ADE_On[o]==false) continue;
 
 		unsigned int **pos = m_Op_Ext_Lor->m_LM_pos[o];
+		GetThreadRange(o, threadID, start, stop);
 
 		if (m_Op_Ext_Lor->m_volt_Lor_ADE_On[o])
 		{
-			for (unsigned int i=0; i<m_Op_Ext_Lor->m_LM_Count.at(o); ++i)
+			for (unsigned int i=start; i<stop; ++i)
 			{
 				volt_Lor_ADE[o][0][i]+=m_Op_Ext_Lor->v_Lor_ADE[o][0][i]*volt_ADE[o][0][i];
 				volt_ADE[o][0][i] *= m_Op_Ext_Lor->v_int_ADE[o][0][i];
@@ -104,7 +109,7 @@ void Engine_Ext_LorentzMaterial::DoPreVoltageUpdatesImpl(EngType* eng)
 		}
 		else
 		{
-			for (unsigned int i=0; i<m_Op_Ext_Lor->m_LM_Count.at(o); ++i)
+			for (unsigned int i=start; i<stop; ++i)
 			{
 				volt_ADE[o][0][i] *= m_Op_Ext_Lor->v_int_ADE[o][0][i];
 				volt_ADE[o][0][i] += m_Op_Ext_Lor->v_ext_ADE[o][0][i] * eng->EngType::GetVolt(0,pos[0][i],pos[1][i],pos[2][i]);
@@ -121,21 +126,31 @@ void Engine_Ext_LorentzMaterial::DoPreVoltageUpdatesImpl(EngType* eng)
 
 void Engine_Ext_LorentzMaterial::DoPreVoltageUpdates()
 {
-	ENG_DISPATCH(DoPreVoltageUpdatesImpl);
+	ENG_DISPATCH_ARGS(DoPreVoltageUpdatesImpl, -1);
+}
+
+void Engine_Ext_LorentzMaterial::DoPreVoltageUpdates(int threadID)
+{
+	ENG_DISPATCH_ARGS(DoPreVoltageUpdatesImpl, threadID);
 }
 
 template <typename EngType>
-void Engine_Ext_LorentzMaterial::DoPreCurrentUpdatesImpl(EngType* eng)
+void Engine_Ext_LorentzMaterial::DoPreCurrentUpdatesImpl(EngType* eng, int threadID)
 {
+	if (threadID>=m_NrThreads)
+		return;
+
+	unsigned int start, stop;
 	for (int o=0;o<m_Order;++o)
 	{
 		if (m_Op_Ext_Lor->m_curr_ADE_On[o]==false) continue;
 
 		unsigned int **pos = m_Op_Ext_Lor->m_LM_pos[o];
+		GetThreadRange(o, threadID, start, stop);
 
 		if (m_Op_Ext_Lor->m_curr_Lor_ADE_On[o])
 		{
-			for (unsigned int i=0; i<m_Op_Ext_Lor->m_LM_Count.at(o); ++i)
+			for (unsigned int i=start; i<stop; ++i)
 			{
 				curr_Lor_ADE[o][0][i]+=m_Op_Ext_Lor->i_Lor_ADE[o][0][i]*curr_ADE[o][0][i];
 				curr_ADE[o][0][i] *= m_Op_Ext_Lor->i_int_ADE[o][0][i];
@@ -152,7 +167,7 @@ void Engine_Ext_LorentzMaterial::DoPreCurrentUpdatesImpl(EngType* eng)
 		}
 		else
 		{
-			for (unsigned int i=0; i<m_Op_Ext_Lor->m_LM_Count.at(o); ++i)
+			for (unsigned int i=start; i<stop; ++i)
 			{
 				curr_ADE[o][0][i] *= m_Op_Ext_Lor->i_int_ADE[o][0][i];
 				curr_ADE[o][0][i] += m_Op_Ext_Lor->i_ext_ADE[o][0][i] * eng->EngType::GetCurr(0,pos[0][i],pos[1][i],pos[2][i]);
@@ -169,5 +184,10 @@ void Engine_Ext_LorentzMaterial::DoPreCurrentUpdatesImpl(EngType* eng)
 
 void Engine_Ext_LorentzMaterial::DoPreCurrentUpdates()
 {
-	ENG_DISPATCH(DoPreCurrentUpdatesImpl);
+	ENG_DISPATCH_ARGS(DoPreCurrentUpdatesImpl, -1);
+}
+
+void Engine_Ext_LorentzMaterial::DoPreCurrentUpdates(int threadID)
+{
+	ENG_DISPATCH_ARGS(DoPreCurrentUpdatesImpl, threadID);
 }
@@ -29,15 +29,17 @@ public:
 	virtual ~Engine_Ext_LorentzMaterial();
 
 	virtual void DoPreVoltageUpdates();
+	virtual void DoPreVoltageUpdates(int threadID);
 
 	virtual void DoPreCurrentUpdates();
+	virtual void DoPreCurrentUpdates(int threadID);
 
 protected:
 	template <typename EngType>
-	void DoPreVoltageUpdatesImpl(EngType* eng);
+	void DoPreVoltageUpdatesImpl(EngType* eng, int threadID);
 
 	template <typename EngType>
-	void DoPreCurrentUpdatesImpl(EngType* eng);
+	void DoPreCurrentUpdatesImpl(EngType* eng, int threadID);
 
 	Operator_Ext_LorentzMaterial* m_Op_Ext_Lor;
 
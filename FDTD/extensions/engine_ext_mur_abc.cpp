@@ -76,6 +76,15 @@ void Engine_Ext_Mur_ABC::SetNumberOfThreads(int nrThread)
 		m_start.at(n) = m_start.at(n-1) + m_numX.at(n-1);
 }
 
+bool Engine_Ext_Mur_ABC::GetXRange(unsigned int &start, unsigned int &stop) const
+{
+	// only an ABC in x-direction is limited to a range of x-lines
+	if (m_ny!=0)
+		return false;
+	start = min(m_LineNr, (unsigned int)m_LineNr_Shift);
+	stop = max(m_LineNr, (unsigned int)m_LineNr_Shift);
+	return true;
+}
 
 template <typename EngType>
 void Engine_Ext_Mur_ABC::DoPreVoltageUpdatesImpl(EngType* eng, int threadID)
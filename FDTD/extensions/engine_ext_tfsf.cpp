@@ -24,192 +24,150 @@ Engine_Ext_TFSF::Engine_Ext_TFSF(Operator_Ext_TFSF* op_ext) : Engine_Extension(o
 	m_Op_TFSF = op_ext;
 	m_Priority = ENG_EXT_PRIO_TFSF;
 
-	m_DelayLookup = new unsigned int[m_Op_TFSF->m_maxDelay+1];
+	// the interpolation between two delays needs one additional entry
+	m_VoltSignal = new FDTD_FLOAT[m_Op_TFSF->m_maxDelay+2];
+	m_CurrSignal = new FDTD_FLOAT[m_Op_TFSF->m_maxDelay+2];
 }
 
 Engine_Ext_TFSF::~Engine_Ext_TFSF()
 {
-	delete[] m_DelayLookup;
-	m_DelayLookup = NULL;
+	delete[] m_VoltSignal;
+	m_VoltSignal = NULL;
+	delete[] m_CurrSignal;
+	m_CurrSignal = NULL;
 }
 
-void Engine_Ext_TFSF::DoPostVoltageUpdates()
+void Engine_Ext_TFSF::UpdateSignalLookup(const FDTD_FLOAT* signal, FDTD_FLOAT* lookup)
 {
 	unsigned int numTS = m_Eng->GetNumberOfTimesteps();
 	unsigned int length = m_Op_TFSF->m_Exc->GetLength();
 
 	int p = int(m_Op_TFSF->m_Exc->GetSignalPeriod()/m_Op_TFSF->m_Exc->GetTimestep());
 
-	for (unsigned int n=0;n<=m_Op_TFSF->m_maxDelay;++n)
+	unsigned int delayed;
+	for (unsigned int n=0;n<=m_Op_TFSF->m_maxDelay+1;++n)
 	{
 		if ( numTS < n )
-			m_DelayLookup[n]=0;
+			delayed=0;
 		else if ((numTS-n >= length) && (p==0))
-			m_DelayLookup[n]=0;
+			delayed=0;
 		else
-			m_DelayLookup[n] = numTS - n;
+			delayed = numTS - n;
 		if (p>0)
-			m_DelayLookup[n] = (m_DelayLookup[n] % p);
+			delayed = (delayed % p);
+		lookup[n] = signal[delayed];
 	}
+}
 
-	//get the current signal since an H-field is added ...
-	FDTD_FLOAT* signal =  m_Op_TFSF->m_Exc->GetCurrentSignal();
-
-	int nP,nPP;
-	unsigned int ui_pos;
-	unsigned int pos[3];
-	for (int n=0;n<3;++n)
-	{
-		nP = (n+1)%3;
-		nPP = (n+2)%3;
-
-		// lower plane
-		pos[nP] = m_Op_TFSF->m_Start[nP];
-		ui_pos = 0;
-		if (m_Op_TFSF->m_ActiveDir[n][0])
-		{
-
-			for (unsigned int i=0;i<m_Op_TFSF->m_numLines[nP];++i)
-			{
-				pos[nPP] = m_Op_TFSF->m_Start[nPP];
-				for (unsigned int j=0;j<m_Op_TFSF->m_numLines[nPP];++j)
-				{
-					// current updates
-					pos[n] = m_Op_TFSF->m_Start[n];
-
-					m_Eng->SetVolt(nP,pos, m_Eng->GetVolt(nP,pos)
-								   + (1.0-m_Op_TFSF->m_VoltDelayDelta[n][0][0][ui_pos])*m_Op_TFSF->m_VoltAmp[n][0][0][ui_pos]*signal[m_DelayLookup[  m_Op_TFSF->m_VoltDelay[n][0][0][ui_pos]]]
-								   +      m_Op_TFSF->m_VoltDelayDelta[n][0][0][ui_pos] *m_Op_TFSF->m_VoltAmp[n][0][0][ui_pos]*signal[m_DelayLookup[1+m_Op_TFSF->m_VoltDelay[n][0][0][ui_pos]]] );
+void Engine_Ext_TFSF::AddIncidentWave(bool volt, int n, int l, unsigned int iStart, unsigned int iStop, unsigned int jStart, unsigned int jStop)
+{
+	int nP = (n+1)%3;
+	int nPP = (n+2)%3;
+	int comp[2] = {nP, nPP};
 
-					m_Eng->SetVolt(nPP,pos, m_Eng->GetVolt(nPP,pos)
-								   + (1.0-m_Op_TFSF->m_VoltDelayDelta[n][0][1][ui_pos])*m_Op_TFSF->m_VoltAmp[n][0][1][ui_pos]*signal[m_DelayLookup[  m_Op_TFSF->m_VoltDelay[n][0][1][ui_pos]]]
-								   +      m_Op_TFSF->m_VoltDelayDelta[n][0][1][ui_pos] *m_Op_TFSF->m_VoltAmp[n][0][1][ui_pos]*signal[m_DelayLookup[1+m_Op_TFSF->m_VoltDelay[n][0][1][ui_pos]]] );
+	unsigned int* const* delay = volt ? m_Op_TFSF->m_VoltDelay[n][l] : m_Op_TFSF->m_CurrDelay[n][l];
+	FDTD_FLOAT* const* delayDelta = volt ? m_Op_TFSF->m_VoltDelayDelta[n][l] : m_Op_TFSF->m_CurrDelayDelta[n][l];
+	FDTD_FLOAT* const* amp = volt ? m_Op_TFSF->m_VoltAmp[n][l] : m_Op_TFSF->m_CurrAmp[n][l];
+	const FDTD_FLOAT* signal = volt ? m_VoltSignal : m_CurrSignal;
 
-					++pos[nPP];
-					++ui_pos;
-				}
-				++pos[nP];
-			}
-		}
+	// the lower current plane is located half a cell outside the TFSF box
+	unsigned int pos[3];
+	if (l==1)
+		pos[n] = m_Op_TFSF->m_Stop[n];
+	else
+		pos[n] = volt ? m_Op_TFSF->m_Start[n] : m_Op_TFSF->m_Start[n]-1;
 
-		// upper plane
-		pos[nP] = m_Op_TFSF->m_Start[nP];
-		ui_pos = 0;
-		if (m_Op_TFSF->m_ActiveDir[n][1])
+	unsigned int ui_pos;
+	for (unsigned int i=iStart;i<iStop;++i)
+	{
+		pos[nP] = m_Op_TFSF->m_Start[nP] + i;
+		for (unsigned int j=jStart;j<jStop;++j)
 		{
-
-			for (unsigned int i=0;i<m_Op_TFSF->m_numLines[nP];++i)
+			pos[nPP] = m_Op_TFSF->m_Start[nPP] + j;
+			ui_pos = i*m_Op_TFSF->m_numLines[nPP] + j;
+			for (int c=0;c<2;++c)
 			{
-				pos[nPP] = m_Op_TFSF->m_Start[nPP];
-				for (unsigned int j=0;j<m_Op_TFSF->m_numLines[nPP];++j)
-				{
-					// current updates
-					pos[n] = m_Op_TFSF->m_Stop[n];
-
-					m_Eng->SetVolt(nP,pos, m_Eng->GetVolt(nP,pos)
-								   + (1.0-m_Op_TFSF->m_VoltDelayDelta[n][1][0][ui_pos])*m_Op_TFSF->m_VoltAmp[n][1][0][ui_pos]*signal[m_DelayLookup[  m_Op_TFSF->m_VoltDelay[n][1][0][ui_pos]]]
-								   +      m_Op_TFSF->m_VoltDelayDelta[n][1][0][ui_pos] *m_Op_TFSF->m_VoltAmp[n][1][0][ui_pos]*signal[m_DelayLookup[1+m_Op_TFSF->m_VoltDelay[n][1][0][ui_pos]]] );
-
-					m_Eng->SetVolt(nPP,pos, m_Eng->GetVolt(nPP,pos)
-								   + (1.0-m_Op_TFSF->m_VoltDelayDelta[n][1][1][ui_pos])*m_Op_TFSF->m_VoltAmp[n][1][1][ui_pos]*signal[m_DelayLookup[  m_Op_TFSF->m_VoltDelay[n][1][1][ui_pos]]]
-								   +      m_Op_TFSF->m_VoltDelayDelta[n][1][1][ui_pos] *m_Op_TFSF->m_VoltAmp[n][1][1][ui_pos]*signal[m_DelayLookup[1+m_Op_TFSF->m_VoltDelay[n][1][1][ui_pos]]] );
-
-					++pos[nPP];
-					++ui_pos;
-				}
-				++pos[nP];
+				FDTD_FLOAT value = (1.0-delayDelta[c][ui_pos])*amp[c][ui_pos]*signal[  delay[c][ui_pos]]
+								   +    delayDelta[c][ui_pos] *amp[c][ui_pos]*signal[1+delay[c][ui_pos]];
+				if (volt)
+					m_Eng->SetVolt(comp[c],pos, m_Eng->GetVolt(comp[c],pos) + value);
+				else
+					m_Eng->SetCurr(comp[c],pos, m_Eng->GetCurr(comp[c],pos) + value);
 			}
 		}
 	}
 }
 
-void Engine_Ext_TFSF::DoPostCurrentUpdates()
+void Engine_Ext_TFSF::AddIncidentWave(bool volt, int threadID)
 {
-	unsigned int numTS = m_Eng->GetNumberOfTimesteps();
-	unsigned int length = m_Op_TFSF->m_Exc->GetLength();
-
-	int p = int(m_Op_TFSF->m_Exc->GetSignalPeriod()/m_Op_TFSF->m_Exc->GetTimestep());
-
-	for (unsigned int n=0;n<m_Op_TFSF->m_maxDelay;++n)
-	{
-		if ( numTS < n )
-			m_DelayLookup[n]=0;
-		else if ((numTS-n >= length) && (p==0))
-			m_DelayLookup[n]=0;
-		else
-			m_DelayLookup[n] = numTS - n;
-		if (p>0)
-			m_DelayLookup[n] = (m_DelayLookup[n] % p);
-	}
-
-	//get the current signal since an E-field is added ...
-	FDTD_FLOAT* signal =  m_Op_TFSF->m_Exc->GetVoltageSignal();
+	if (threadID>=m_NrThreads)
+		return;
 
-	int nP,nPP;
-	unsigned int ui_pos;
-	unsigned int pos[3];
 	for (int n=0;n<3;++n)
 	{
-		if (!m_Op_TFSF->m_ActiveDir[n][0] && !m_Op_TFSF->m_ActiveDir[n][1])
-			continue;
+		unsigned int numP = m_Op_TFSF->m_numLines[(n+1)%3];
+		unsigned int numPP = m_Op_TFSF->m_numLines[(n+2)%3];
+		for (int l=0;l<2;++l)
+		{
+			if (!m_Op_TFSF->m_ActiveDir[n][l])
+				continue;
 
-		nP = (n+1)%3;
-		nPP = (n+2)%3;
+			if (threadID<0)
+			{
+				AddIncidentWave(volt, n, l, 0, numP, 0, numPP);
+				continue;
+			}
 
-		// lower plane
-		pos[nP] = m_Op_TFSF->m_Start[nP];
-		ui_pos = 0;
-		if (m_Op_TFSF->m_ActiveDir[n][0])
-		{
-			for (unsigned int i=0;i<m_Op_TFSF->m_numLines[nP];++i)
+			// the plane edges are shared with the neighboring planes, they are all updated by thread 0
+			if ((numP>2) && (numPP>2))
+			{
+				unsigned int iStart = 1 + (unsigned long long)(numP-2)*threadID/m_NrThreads;
+				unsigned int iStop = 1 + (unsigned long long)(numP-2)*(threadID+1)/m_NrThreads;
+				AddIncidentWave(volt, n, l, iStart, iStop, 1, numPP-1);
+			}
+			if (threadID==0)
 			{
-				pos[nPP] = m_Op_TFSF->m_Start[nPP];
-				for (unsigned int j=0;j<m_Op_TFSF->m_numLines[nPP];++j)
+				AddIncidentWave(volt, n, l, 0, 1, 0, numPP);
+				if (numP>1)
 				{
-					// current updates
-					pos[n] = m_Op_TFSF->m_Start[n]-1;
-
-					m_Eng->SetCurr(nP,pos, m_Eng->GetCurr(nP,pos)
-								   + (1.0-m_Op_TFSF->m_CurrDelayDelta[n][0][0][ui_pos])*m_Op_TFSF->m_CurrAmp[n][0][0][ui_pos]*signal[m_DelayLookup[  m_Op_TFSF->m_CurrDelay[n][0][0][ui_pos]]]
-								   +      m_Op_TFSF->m_CurrDelayDelta[n][0][0][ui_pos] *m_Op_TFSF->m_CurrAmp[n][0][0][ui_pos]*signal[m_DelayLookup[1+m_Op_TFSF->m_CurrDelay[n][0][0][ui_pos]]] );
-
-					m_Eng->SetCurr(nPP,pos, m_Eng->GetCurr(nPP,pos)
-								   + (1.0-m_Op_TFSF->m_CurrDelayDelta[n][0][1][ui_pos])*m_Op_TFSF->m_CurrAmp[n][0][1][ui_pos]*signal[m_DelayLookup[  m_Op_TFSF->m_CurrDelay[n][0][1][ui_pos]]]
-								   +      m_Op_TFSF->m_CurrDelayDelta[n][0][1][ui_pos] *m_Op_TFSF->m_CurrAmp[n][0][1][ui_pos]*signal[m_DelayLookup[1+m_Op_TFSF->m_CurrDelay[n][0][1][ui_pos]]] );
-
-					++pos[nPP];
-					++ui_pos;
+					AddIncidentWave(volt, n, l, numP-1, numP, 0, numPP);
+					AddIncidentWave(volt, n, l, 1, numP-1, 0, 1);
+					if (numPP>1)
+						AddIncidentWave(volt, n, l, 1, numP-1, numPP-1, numPP);
 				}
-				++pos[nP];
 			}
 		}
+	}
+}
 
-		// upper plane
-		pos[nP] = m_Op_TFSF->m_Start[nP];
-		ui_pos = 0;
-		if (m_Op_TFSF->m_ActiveDir[n][1])
-		{
-			for (unsigned int i=0;i<m_Op_TFSF->m_numLines[nP];++i)
-			{
-				pos[nPP] = m_Op_TFSF->m_Start[nPP];
-				for (unsigned int j=0;j<m_Op_TFSF->m_numLines[nPP];++j)
-				{
-					// current updates
-					pos[n] = m_Op_TFSF->m_Stop[n];
+void Engine_Ext_TFSF::DoPreVoltageUpdates()
+{
+	//get the current signal since an H-field is added ...
+	UpdateSignalLookup(m_Op_TFSF->m_Exc->GetCurrentSignal(), m_VoltSignal);
+}
 
-					m_Eng->SetCurr(nP,pos, m_Eng->GetCurr(nP,pos)
-								   + (1.0-m_Op_TFSF->m_CurrDelayDelta[n][1][0][ui_pos])*m_Op_TFSF->m_CurrAmp[n][1][0][ui_pos]*signal[m_DelayLookup[  m_Op_TFSF->m_CurrDelay[n][1][0][ui_pos]]]
-								   +      m_Op_TFSF->m_CurrDelayDelta[n][1][0][ui_pos] *m_Op_TFSF->m_CurrAmp[n][1][0][ui_pos]*signal[m_DelayLookup[1+m_Op_TFSF->m_CurrDelay[n][1][0][ui_pos]]] );
+void Engine_Ext_TFSF::DoPostVoltageUpdates()
+{
+	AddIncidentWave(true, -1);
+}
 
-					m_Eng->SetCurr(nPP,pos, m_Eng->GetCurr(nPP,pos)
-								   + (1.0-m_Op_TFSF->m_CurrDelayDelta[n][1][1][ui_pos])*m_Op_TFSF->m_CurrAmp[n][1][1][ui_pos]*signal[m_DelayLookup[  m_Op_TFSF->m_CurrDelay[n][1][1][ui_pos]]]
-								   +      m_Op_TFSF->m_CurrDelayDelta[n][1][1][ui_pos] *m_Op_TFSF->m_CurrAmp[n][1][1][ui_pos]*signal[m_DelayLookup[1+m_Op_TFSF->m_CurrDelay[n][1][1][ui_pos]]] );
+void Engine_Ext_TFSF::DoPostVoltageUpdates(int threadID)
+{
+	AddIncidentWave(true, threadID);
+}
 
-					++pos[nPP];
-					++ui_pos;
-				}
-				++pos[nP];
-			}
-		}
-	}
+void Engine_Ext_TFSF::DoPreCurrentUpdates()
+{
+	//get the voltage signal since an E-field is added ...
+	UpdateSignalLookup(m_Op_TFSF->m_Exc->GetVoltageSignal(), m_CurrSignal);
+}
+
+void Engine_Ext_TFSF::DoPostCurrentUpdates()
+{
+	AddIncidentWave(false, -1);
+}
+
+void Engine_Ext_TFSF::DoPostCurrentUpdates(int threadID)
+{
+	AddIncidentWave(false, threadID);
 }
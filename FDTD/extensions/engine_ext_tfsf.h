@@ -19,6 +19,7 @@
 #define ENGINE_EXT_TFSF_H
 
 #include "engine_extension.h"
+#include "FDTD/engine.h"
 
 class Operator_Ext_TFSF;
 
@@ -28,13 +29,28 @@ public:
 	Engine_Ext_TFSF(Operator_Ext_TFSF* op_ext);
 	virtual ~Engine_Ext_TFSF();
 
+	virtual void DoPreVoltageUpdates();
 	virtual void DoPostVoltageUpdates();
+	virtual void DoPostVoltageUpdates(int threadID);
+
+	virtual void DoPreCurrentUpdates();
 	virtual void DoPostCurrentUpdates();
+	virtual void DoPostCurrentUpdates(int threadID);
 
 protected:
 	Operator_Ext_TFSF* m_Op_TFSF;
 
-	unsigned int* m_DelayLookup;
+	//! Get the delayed excitation signal of the current timestep for all delays
+	void UpdateSignalLookup(const FDTD_FLOAT* signal, FDTD_FLOAT* lookup);
+
+	//! Add the incident wave to all TFSF planes, the plane rows are split over the threads, a negative threadID updates all rows
+	void AddIncidentWave(bool volt, int threadID);
+	//! Add the incident wave to the rows [iStart,iStop) and columns [jStart,jStop) of a TFSF plane
+	void AddIncidentWave(bool volt, int n, int l, unsigned int iStart, unsigned int iStop, unsigned int jStart, unsigned int jStop);
+
+	//! Delayed excitation signal for all delays, updated once per timestep
+	FDTD_FLOAT* m_VoltSignal;
+	FDTD_FLOAT* m_CurrSignal;
 };
 
 #endif // ENGINE_EXT_TFSF_H
@@ -50,6 +50,13 @@ void Engine_Ext_UPML::SetNumberOfThreads(int nrThread)
 		m_start.at(n) = m_start.at(n-1) + m_numX.at(n-1);
 }
 
+bool Engine_Ext_UPML::GetXRange(unsigned int &start, unsigned int &stop) const
+{
+	start = m_Op_UPML->m_StartPos[0];
+	stop = m_Op_UPML->m_StartPos[0] + m_Op_UPML->m_numLines[0] - 1;
+	return true;
+}
+
 template <typename EngType>
 void Engine_Ext_UPML::DoPreVoltageUpdatesImpl(EngType* eng, int threadID)
 {
@@ -23,6 +23,7 @@
 // priority definitions for some important extensions
 #define ENG_EXT_PRIO_STEADYSTATE		+2e6  //steady state extension priority
 #define ENG_EXT_PRIO_UPML				+1e6  //unaxial pml extension priority
+#define ENG_EXT_PRIO_CPML				+1e6  //convolutional pml extension priority
 #define ENG_EXT_PRIO_CYLINDER			+1e5  //cylindrial extension priority
 #define ENG_EXT_PRIO_TFSF				+5e4  //total-field/scattered-field extension priority
 #define ENG_EXT_PRIO_EXCITATION			-1000 //excitation priority
@@ -30,6 +31,8 @@
 
 #include <string>
 
+#include "tools/global.h"
+
 class Operator_Extension;
 class Engine;
 
@@ -61,6 +64,13 @@ public:
 	virtual void Apply2Current() {}
 	virtual void Apply2Current(int threadID);
 
+	//! Get the range of x-lines this extension reads from or writes to during a timestep.
+	/*!
+	  Return false (default) if the extension may access the entire domain. A limited range allows engines to call this
+	  extension for a part of the domain only, e.g. for temporal blocking (see Engine_Tiling).
+	  */
+	virtual bool GetXRange(unsigned int &start, unsigned int &stop) const {UNUSED(start);UNUSED(stop);return false;}
+
 	//! Set the Engine to this extension. This will usually done automatically by Engine::AddExtension
 	virtual void SetEngine(Engine* eng) {m_Eng=eng;}
 
@@ -21,6 +21,7 @@
 
 #include "FDTD/engine.h"
 #include "FDTD/engine_sse.h"
+#include "FDTD/engine_avx.h"
 
 // In openEMS, all extensions are subclasses from the abstract Engine_Extension
 // to implement features like Engine_Extension::Apply2Voltages(). When an
@@ -61,6 +62,12 @@
 	case Engine::SSE: \
 		(this)->template impl<Engine_sse>((Engine_sse*) m_Eng); \
 		break; \
+	case Engine::AVX2: \
+		(this)->template impl<Engine_AVX<f8vector> >((Engine_AVX<f8vector>*) m_Eng); \
+		break; \
+	case Engine::AVX512: \
+		(this)->template impl<Engine_AVX<f16vector> >((Engine_AVX<f16vector>*) m_Eng); \
+		break; \
 	case Engine::BASIC: \
 		(this)->template impl<Engine>((Engine*) m_Eng); \
 		break; \
@@ -77,6 +84,12 @@
 	case Engine::SSE: \
 		(this)->template impl<Engine_sse>((Engine_sse*) m_Eng, __VA_ARGS__); \
 		break; \
+	case Engine::AVX2: \
+		(this)->template impl<Engine_AVX<f8vector> >((Engine_AVX<f8vector>*) m_Eng, __VA_ARGS__); \
+		break; \
+	case Engine::AVX512: \
+		(this)->template impl<Engine_AVX<f16vector> >((Engine_AVX<f16vector>*) m_Eng, __VA_ARGS__); \
+		break; \
 	case Engine::BASIC: \
 		(this)->template impl<Engine>((Engine*) m_Eng, __VA_ARGS__); \
 		break; \
@@ -0,0 +1,268 @@
+/*
+*	Copyright (C) 2026 Thorsten Liebig (Thorsten.Liebig@gmx.de)
+*
+*	This program is free software: you can redistribute it and/or modify
+*	it under the terms of the GNU General Public License as published by
+*	the Free Software Foundation, either version 3 of the License, or
+*	(at your option) any later version.
+*
+*	This program is distributed in the hope that it will be useful,
+*	but WITHOUT ANY WARRANTY; without even the implied warranty of
+*	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*	GNU General Public License for more details.
+*
+*	You should have received a copy of the GNU General Public License
+*	along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "operator_ext_cpml.h"
+#include "operator_ext_upml.h"
+#include "FDTD/operator_cylinder.h"
+#ifdef MPI_SUPPORT
+#include "FDTD/operator_mpi.h"
+#endif
+#include "engine_ext_cpml.h"
+#include "fparser.hh"
+
+using namespace std;
+
+Operator_Ext_CPML::Operator_Ext_CPML(Operator* op) : Operator_Extension(op)
+{
+	setlocale(LC_NUMERIC, "en_US.UTF-8");
+	m_GradingFunction = new FunctionParser();
+	//default grading function, same as for the upml
+	SetGradingFunction(" -log(1e-6)*log(2.5)/(2*dl*Z*(pow(2.5,W/dl)-1)) * pow(2.5, D/dl) ");
+
+	for (int n=0; n<6; ++n)
+	{
+		m_BC[n]=0;
+		m_Size[n]=0;
+	}
+	for (int n=0; n<3; ++n)
+	{
+		m_StartPos[n]=0;
+		m_numLines[n]=0;
+	}
+	m_ny = 0;
+	m_upper = false;
+}
+
+Operator_Ext_CPML::~Operator_Ext_CPML()
+{
+	delete m_GradingFunction;
+	m_GradingFunction = NULL;
+}
+
+void Operator_Ext_CPML::SetBoundaryCondition(const int* BCs, const unsigned int size[6])
+{
+	for (int n=0; n<6; ++n)
+	{
+		m_BC[n]=BCs[n];
+		m_Size[n]=size[n];
+	}
+}
+
+void Operator_Ext_CPML::SetDirection(int ny, bool upper)
+{
+	m_ny = ny;
+	m_upper = upper;
+}
+
+void Operator_Ext_CPML::SetRange(const unsigned int start[3], const unsigned int stop[3])
+{
+	for (int n=0; n<3; ++n)
+	{
+		m_StartPos[n]=start[n];
+		m_numLines[n]=stop[n]-start[n]+1;
+	}
+}
+
+bool Operator_Ext_CPML::Create_CPML(Operator* op, const int ui_BC[6], const unsigned int ui_size[6], string gradFunc)
+{
+	if (dynamic_cast<Operator_Cylinder*>(op))
+	{
+		cerr << "Operator_Ext_CPML::Create_CPML: Warning: The cpml is not supported in cylindrical coordinates, using the upml instead..." << endl;
+		return Operator_Ext_UPML::Create_UPML(op, ui_BC, ui_size, gradFunc);
+	}
+#ifdef MPI_SUPPORT
+	Operator_MPI* op_mpi = dynamic_cast<Operator_MPI*>(op);
+	if (op_mpi && op_mpi->GetMPIEnabled())
+	{
+		cerr << "Operator_Ext_CPML::Create_CPML: Warning: The cpml is not supported with MPI, using the upml instead..." << endl;
+		return Operator_Ext_UPML::Create_UPML(op, ui_BC, ui_size, gradFunc);
+	}
+#endif
+
+	int BC[6]={ui_BC[0],ui_BC[1],ui_BC[2],ui_BC[3],ui_BC[4],ui_BC[5]};
+	unsigned int size[6]={ui_size[0],ui_size[1],ui_size[2],ui_size[3],ui_size[4],ui_size[5]};
+
+	//check if mesh is large enough to support the pml
+	for (int n=0; n<3; ++n)
+		if ( (size[2*n]*(BC[2*n]==3)+size[2*n+1]*(BC[2*n+1]==3)) >= op->GetNumberOfLines(n,true) )
+		{
+			cerr << "Operator_Ext_CPML::Create_CPML: Warning: Not enough lines in direction: " << n << ", resetting to PEC" << endl;
+			BC[2*n]=0;
+			size[2*n]=0;
+			BC[2*n+1]=0;
+			size[2*n+1]=0;
+		}
+
+	//create a layer for every pml side over the full width of the other two directions, the edge and corner regions are shared by multiple layers
+	for (int n=0; n<6; ++n)
+	{
+		if (BC[n]!=3)
+			continue;
+		int ny = n/2;
+		unsigned int start[3]={0 ,0 ,0};
+		unsigned int stop[3] ={op->GetNumberOfLines(0,true)-1,op->GetNumberOfLines(1,true)-1,op->GetNumberOfLines(2,true)-1};
+		if (n%2==0)
+			stop[ny] = size[n];
+		else
+			start[ny] = op->GetNumberOfLines(ny,true)-1-size[n];
+
+		Operator_Ext_CPML* op_ext_cpml = new Operator_Ext_CPML(op);
+		op_ext_cpml->SetGradingFunction(gradFunc);
+		op_ext_cpml->SetBoundaryCondition(BC, size);
+		op_ext_cpml->SetDirection(ny, n%2==1);
+		op_ext_cpml->SetRange(start,stop);
+		op->AddExtension(op_ext_cpml);
+	}
+
+	return true;
+}
+
+bool Operator_Ext_CPML::SetGradingFunction(string func)
+{
+	if (func.empty())
+		return true;
+
+	m_GradFunc = func;
+	int res = m_GradingFunction->Parse(m_GradFunc.c_str(), "D,dl,W,Z,N");
+	if (res < 0) return true;
+
+	cerr << "Operator_Ext_CPML::SetGradingFunction: Warning, an error occurred parsing the pml grading function (see below) ..." << endl;
+	cerr << func << "\n" << string(res, ' ') << "^\n" << m_GradingFunction->ErrorMsg() << "\n";
+	return false;
+}
+
+void Operator_Ext_CPML::CalcGradingKappa(unsigned int pos, double Zm, double &kappa_v, double &kappa_i)
+{
+	unsigned int edge_pos[3] = {0,0,0};
+	edge_pos[m_ny] = pos;
+	double edge = m_Op->GetEdgeLength(m_ny,edge_pos);
+	unsigned int last = m_Op->GetNumberOfLines(m_ny,true)-1;
+	unsigned int size = m_Size[2*m_ny+m_upper];
+
+	double width, depth;
+	if (m_upper)
+	{
+		width = (m_Op->GetDiscLine(m_ny,last) - m_Op->GetDiscLine(m_ny,last-size))*m_Op->GetGridDelta();
+		depth = width - (m_Op->GetDiscLine(m_ny,last) - m_Op->GetDiscLine(m_ny,pos))*m_Op->GetGridDelta();
+	}
+	else
+	{
+		width = (m_Op->GetDiscLine(m_ny,size) - m_Op->GetDiscLine(m_ny,0))*m_Op->GetGridDelta();
+		depth = width - (m_Op->GetDiscLine(m_ny,pos) - m_Op->GetDiscLine(m_ny,0))*m_Op->GetGridDelta();
+	}
+
+	//the tangential voltages are located on the nodes
+	double vars[5] = {depth, width/size, width, Zm, (double)size};
+	if (depth>0)
+		kappa_v = m_GradingFunction->Eval(vars);
+	else
+		kappa_v = 0;
+
+	//the tangential currents are located half a cell further into the domain
+	if (m_upper)
+	{
+		depth += edge/2;
+		if (depth>width)
+			depth = 0;
+	}
+	else
+	{
+		depth -= edge/2;
+		if (depth<0)
+			depth = 0;
+	}
+	vars[0] = depth;
+	if (depth>0)
+		kappa_i = m_GradingFunction->Eval(vars);
+	else
+		kappa_i = 0;
+}
+
+bool Operator_Ext_CPML::BuildExtension()
+{
+	/*Calculate the recursive convolution coefficients for a cpml with kappa=1 and alpha=0 as defined in:
+	  Allen Taflove, computational electrodynamics - the FDTD method, third edition, chapter 7.9
+	  - kappa is used for conductivities (instead of sigma), the magnetic conductivity is matched
+	*/
+	if (m_Op==NULL)
+		return false;
+
+	double dT = m_Op->GetTimestep();
+	double kappa_v = 0;
+	double kappa_i = 0;
+
+	unsigned int numNormal = m_numLines[m_ny];
+	m_volt_a.resize(numNormal);
+	m_volt_b.resize(numNormal);
+	m_curr_a.resize(numNormal);
+	m_curr_b.resize(numNormal);
+	for (unsigned int n=0; n<numNormal; ++n)
+	{
+		CalcGradingKappa(n+m_StartPos[m_ny], __Z0__, kappa_v, kappa_i);
+		double b = exp(-kappa_v*dT/__EPS0__);
+		m_volt_b.at(n) = b;
+		m_volt_a.at(n) = b - 1;
+		b = exp(-kappa_i*dT/__EPS0__);
+		m_curr_b.at(n) = b;
+		m_curr_a.at(n) = b - 1;
+	}
+
+	unsigned int pos[3];
+	unsigned int loc_pos[3];
+	double eff_Mat[4];
+	m_VoltDisabled.assign(2*m_numLines[0]*m_numLines[1]*m_numLines[2], false);
+	for (loc_pos[0]=0; loc_pos[0]<m_numLines[0]; ++loc_pos[0])
+	{
+		pos[0] = loc_pos[0] + m_StartPos[0];
+		for (loc_pos[1]=0; loc_pos[1]<m_numLines[1]; ++loc_pos[1])
+		{
+			pos[1] = loc_pos[1] + m_StartPos[1];
+			vector<CSPrimitives*> vPrims = m_Op->GetPrimitivesBoundBox(pos[0], pos[1], -1, CSProperties::MATERIAL);
+			for (loc_pos[2]=0; loc_pos[2]<m_numLines[2]; ++loc_pos[2])
+			{
+				pos[2] = loc_pos[2] + m_StartPos[2];
+				if (m_volt_a.at(loc_pos[m_ny])==0)
+					continue;
+				for (int nt=0; nt<2; ++nt)
+				{
+					// if eff_Mat[1] > 1e3 assume a metal and disable PML to continue a signal layer (see Operator_Ext_UPML)
+					m_Op->Calc_EffMatPos((m_ny+1+nt)%3,pos,eff_Mat,vPrims);
+					if (eff_Mat[1]>=1e3)
+						m_VoltDisabled.at(2*LocalIndex(loc_pos) + nt) = true;
+				}
+			}
+		}
+	}
+	return true;
+}
+
+Engine_Extension* Operator_Ext_CPML::CreateEngineExtention()
+{
+	Engine_Ext_CPML* eng_ext = new Engine_Ext_CPML(this);
+	return eng_ext;
+}
+
+void Operator_Ext_CPML::ShowStat(ostream &ostr)  const
+{
+	Operator_Extension::ShowStat(ostr);
+
+	string XYZ[3] = {"x","y","z"};
+	ostr << " PML direction\t\t: " << (m_upper ? "+" : "-") << XYZ[m_ny] << endl;
+	ostr << " PML range\t\t: " << "[" << m_StartPos[0]<< "," << m_StartPos[1]<< "," << m_StartPos[2]<< "] to ["
+	<<  m_StartPos[0]+m_numLines[0]-1 << "," << m_StartPos[1]+m_numLines[1]-1 << "," << m_StartPos[2]+m_numLines[2]-1 << "]" << endl;
+	ostr << " Grading function\t: \"" << m_GradFunc << "\"" << endl;
+}
@@ -0,0 +1,100 @@
+/*
+*	Copyright (C) 2026 Thorsten Liebig (Thorsten.Liebig@gmx.de)
+*
+*	This program is free software: you can redistribute it and/or modify
+*	it under the terms of the GNU General Public License as published by
+*	the Free Software Foundation, either version 3 of the License, or
+*	(at your option) any later version.
+*
+*	This program is distributed in the hope that it will be useful,
+*	but WITHOUT ANY WARRANTY; without even the implied warranty of
+*	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*	GNU General Public License for more details.
+*
+*	You should have received a copy of the GNU General Public License
+*	along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef OPERATOR_EXT_CPML_H
+#define OPERATOR_EXT_CPML_H
+
+#include "FDTD/operator.h"
+#include "operator_extension.h"
+
+class FunctionParser;
+
+//! Operator extension implementing a convolutional perfectly matched layer (cpml)
+/*!
+  Alternative to the Operator_Ext_UPML. Each extension handles the layer at one side of the domain with the normal direction \a ny.
+  The main engine performs the ordinary field updates, the engine extension adds the convolution (psi) of the normal derivatives of the two tangential components afterwards.
+  Layers in different directions may overlap, their corrections simply add up in the edges and corners of the domain.
+
+  Only the conductivity of the stretched coordinate is graded (kappa=1, alpha=0), using the same grading function as the upml.
+  The operator extension therefore only stores the 1D recursive convolution coefficients along the normal direction.
+  */
+class Operator_Ext_CPML : public Operator_Extension
+{
+	friend class Engine_Ext_CPML;
+public:
+	virtual ~Operator_Ext_CPML();
+
+	//! The cpml is currently only supported in cartesian coordinates, Create_CPML will create an upml for a cylindrical operator.
+	virtual bool IsCylinderCoordsSave(bool closedAlpha, bool R0_included) const { UNUSED(closedAlpha); UNUSED(R0_included); return false;}
+	virtual bool IsCylindricalMultiGridSave(bool child) const {UNUSED(child); return false;}
+
+	//! The cpml is not verified with a split (MPI) domain, Create_CPML will create an upml for an MPI operator.
+	virtual bool IsMPISave() const {return false;}
+
+	void SetBoundaryCondition(const int* BCs, const unsigned int size[6]);
+
+	//! Set the normal direction \a ny and the side (\a upper or lower) of the domain this layer belongs to
+	void SetDirection(int ny, bool upper);
+
+	void SetRange(const unsigned int start[3], const unsigned int stop[3]);
+
+	//! Set the grading function for the pml, see Operator_Ext_UPML::SetGradingFunction
+	virtual bool SetGradingFunction(string func);
+
+	virtual bool BuildExtension();
+
+	virtual Engine_Extension* CreateEngineExtention();
+
+	virtual string GetExtensionName() const {return string("Convolutional PML Extension");}
+
+	virtual void ShowStat(ostream &ostr) const;
+
+	//! Create the CPML, falls back to Operator_Ext_UPML::Create_UPML for cylindrical and MPI operators
+	static bool Create_CPML(Operator* op, const int ui_BC[6], const unsigned int ui_size[6], const string gradFunc);
+
+protected:
+	Operator_Ext_CPML(Operator* op);
+	int m_BC[6];
+	unsigned int m_Size[6];
+
+	int m_ny;
+	bool m_upper;
+
+	unsigned int m_StartPos[3];
+	unsigned int m_numLines[3];
+
+	string m_GradFunc;
+	FunctionParser* m_GradingFunction;
+
+	//! Calculate the graded conductivity at the voltage (node) and current (dual node) position \a pos in normal direction
+	void CalcGradingKappa(unsigned int pos, double Zm, double &kappa_v, double &kappa_i);
+
+	//! Check if the pml has been disabled for the tangential voltage component \a nt (0 or 1) at the given local position, e.g. inside a lossy metal
+	bool IsVoltDisabled(const unsigned int loc_pos[3], int nt) const {return m_VoltDisabled.at(2*LocalIndex(loc_pos) + nt);}
+
+	unsigned int LocalIndex(const unsigned int loc_pos[3]) const {return (loc_pos[0]*m_numLines[1] + loc_pos[1])*m_numLines[2] + loc_pos[2];}
+
+	//! Recursive convolution coefficients (psi = b*psi + a*derivative) along the normal direction for the voltages and currents
+	vector<FDTD_FLOAT> m_volt_a;
+	vector<FDTD_FLOAT> m_volt_b;
+	vector<FDTD_FLOAT> m_curr_a;
+	vector<FDTD_FLOAT> m_curr_b;
+
+	vector<bool> m_VoltDisabled;
+};
+
+#endif // OPERATOR_EXT_CPML_H
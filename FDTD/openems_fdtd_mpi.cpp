@@ -22,6 +22,7 @@
 #include "FDTD/engine_mpi.h"
 #include "Common/processfields.h"
 #include "Common/processintegral.h"
+#include "Common/processnf2ff.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <iostream>
@@ -155,6 +156,35 @@ bool openEMS_FDTD_MPI::Parse_XML_FDTDSetup(TiXmlElement* FDTD_Opts)
 	string arg_Pos_Names[] = {"SplitPos_X", "SplitPos_Y", "SplitPos_Z"};
 	string arg_N_Names[] = {"SplitN_X", "SplitN_Y", "SplitN_Z"};
 	const char* tmp = NULL;
+
+	// automatic load balanced splitting, if requested or if no explicit splits are given
+	string autoSplit;
+	tmp = m_MPI_Elem->Attribute("SplitAuto");
+	if (tmp)
+		autoSplit = string(tmp);
+	bool explicitSplits = false;
+	for (int n=0;n<3;++n)
+		explicitSplits |= (m_MPI_Elem->Attribute(arg_Pos_Names[n].c_str())!=NULL) || (m_MPI_Elem->Attribute(arg_N_Names[n].c_str())!=NULL);
+	if ((autoSplit=="1") || (autoSplit=="true") || (autoSplit.empty() && !explicitSplits))
+		autoSplit = "xyz";
+	else if ((autoSplit=="0") || (autoSplit=="false"))
+		autoSplit.clear();
+	if (!autoSplit.empty())
+	{
+		if (explicitSplits && (m_MyID==0))
+			cerr << "openEMS_FDTD_MPI::Parse_XML_FDTDSetup: Warning: automatic splitting requested, ignoring given split positions/numbers..." << endl;
+		// the cost model needs the boundary conditions, parse the basic setup first
+		bool ret = openEMS::Parse_XML_FDTDSetup(FDTD_Opts);
+		if (!CalcAutoSplits(autoSplit))
+		{
+			MPI_Barrier(MPI_COMM_WORLD);
+			if (m_MyID==0)
+				cerr << "openEMS_FDTD_MPI::Parse_XML_FDTDSetup: Error: automatic splitting into " << m_NumProc << " processes failed, exiting MPI engine... " << endl;
+			exit(-1);
+		}
+		return ret;
+	}
+
 	for (int n=0;n<3;++n)
 	{
 		m_SplitNumber[n].clear();
@@ -198,6 +228,252 @@ bool openEMS_FDTD_MPI::Parse_XML_FDTDSetup(TiXmlElement* FDTD_Opts)
 	return openEMS::Parse_XML_FDTDSetup(FDTD_Opts);
 }
 
+namespace
+{
+// additional update cost per cell, relative to a plain FDTD cell
+const double AutoSplit_PML_Weight = 2.0;
+const double AutoSplit_Dispersive_Weight = 1.0;
+const double AutoSplit_Lumped_Weight = 0.5;
+// cost of exchanging one halo cell per timestep, relative to updating a plain cell
+const double AutoSplit_Halo_Weight = 0.5;
+// minimal number of cells of a rank in each split direction
+const unsigned int AutoSplit_MinWidth = 4;
+
+struct CostBox
+{
+	unsigned int start[3]; //first cell
+	unsigned int stop[3];  //one past the last cell
+	double weight;
+};
+
+double CalcBoxCost(const vector<CostBox>& boxes, const unsigned int start[3], const unsigned int stop[3])
+{
+	double cost = (double)(stop[0]-start[0])*(double)(stop[1]-start[1])*(double)(stop[2]-start[2]);
+	for (size_t b=0;b<boxes.size();++b)
+	{
+		double vol = boxes[b].weight;
+		for (int n=0;n<3 && vol>0;++n)
+		{
+			unsigned int lo = max(start[n], boxes[b].start[n]);
+			unsigned int hi = min(stop[n], boxes[b].stop[n]);
+			vol *= (hi>lo) ? (double)(hi-lo) : 0.0;
+		}
+		cost += vol;
+	}
+	return cost;
+}
+
+// cost of the most expensive rank, including its halo exchange
+double CalcSplitCost(const vector<CostBox>& boxes, const vector<unsigned int> splits[3])
+{
+	double maxCost = 0;
+	unsigned int pos[3], start[3], stop[3];
+	for (pos[0]=0;pos[0]<splits[0].size()-1;++pos[0])
+		for (pos[1]=0;pos[1]<splits[1].size()-1;++pos[1])
+			for (pos[2]=0;pos[2]<splits[2].size()-1;++pos[2])
+			{
+				for (int n=0;n<3;++n)
+				{
+					start[n] = splits[n].at(pos[n]);
+					stop[n] = splits[n].at(pos[n]+1);
+				}
+				double cost = CalcBoxCost(boxes, start, stop);
+				for (int n=0;n<3;++n)
+				{
+					int nP = (n+1)%3;
+					int nPP = (n+2)%3;
+					double area = (double)(stop[nP]-start[nP])*(double)(stop[nPP]-start[nPP]);
+					if (pos[n]>0)
+						cost += AutoSplit_Halo_Weight*area;
+					if (pos[n]<splits[n].size()-2)
+						cost += AutoSplit_Halo_Weight*area;
+				}
+				maxCost = max(maxCost, cost);
+			}
+	return maxCost;
+}
+
+// split the cells of one direction into num slabs of (almost) equal cost
+vector<unsigned int> BalanceSplits(const vector<double>& cellCost, unsigned int num)
+{
+	unsigned int numCells = cellCost.size();
+	vector<double> sum(numCells+1,0.0);
+	for (unsigned int i=0;i<numCells;++i)
+		sum[i+1] = sum[i] + cellCost[i];
+
+	vector<unsigned int> splits(1,0);
+	unsigned int line = 0;
+	for (unsigned int n=1;n<num;++n)
+	{
+		double target = sum[numCells]*n/num;
+		while ((line<numCells) && (sum[line]<target))
+			++line;
+		line = max(line, splits.back()+AutoSplit_MinWidth);
+		line = min(line, numCells-(num-n)*AutoSplit_MinWidth);
+		splits.push_back(line);
+	}
+	splits.push_back(numCells);
+	return splits;
+}
+}
+
+bool openEMS_FDTD_MPI::CalcAutoSplits(string directions)
+{
+	unsigned int numCells[3];
+	bool allowed[3];
+	for (int n=0;n<3;++n)
+	{
+		numCells[n] = m_Original_Grid->GetQtyLines(n)-1;
+		allowed[n] = (directions.find("xyz"[n])!=string::npos) || (directions.find("XYZ"[n])!=string::npos);
+	}
+
+	// setup the cost model: weighted boxes of additional cost on top of one unit per cell
+	vector<CostBox> boxes;
+	for (int n=0;n<6;++n)
+	{
+		if ((m_BC_type[n]!=3) || (m_PML_size[n]==0))
+			continue;
+		CostBox box;
+		for (int m=0;m<3;++m)
+		{
+			box.start[m] = 0;
+			box.stop[m] = numCells[m];
+		}
+		unsigned int size = min(m_PML_size[n], numCells[n/2]);
+		if (n%2==0)
+			box.stop[n/2] = size;
+		else
+			box.start[n/2] = numCells[n/2]-size;
+		box.weight = AutoSplit_PML_Weight;
+		boxes.push_back(box);
+	}
+
+	CSProperties::PropertyType types[] = {CSProperties::LORENTZMATERIAL, CSProperties::DEBYEMATERIAL, CSProperties::LUMPED_ELEMENT};
+	double weights[] = {AutoSplit_Dispersive_Weight, AutoSplit_Dispersive_Weight, AutoSplit_Lumped_Weight};
+	for (int t=0;t<3;++t)
+	{
+		vector<CSProperties*> props = m_CSX->GetPropertyByType(types[t]);
+		for (size_t p=0;p<props.size();++p)
+		{
+			vector<CSPrimitives*> prims = props.at(p)->GetAllPrimitives();
+			for (size_t i=0;i<prims.size();++i)
+			{
+				double bb[6];
+				if (prims.at(i)->GetBoundBox(bb)==false)
+					continue;
+				CostBox box;
+				bool inside;
+				for (int m=0;m<3;++m)
+				{
+					unsigned int lo = m_Original_Grid->Snap2LineNumber(m, min(bb[2*m],bb[2*m+1]), inside);
+					unsigned int hi = m_Original_Grid->Snap2LineNumber(m, max(bb[2*m],bb[2*m+1]), inside);
+					box.start[m] = min(lo, numCells[m]-1);
+					box.stop[m] = min(max(hi, box.start[m]+1), numCells[m]);
+				}
+				box.weight = weights[t];
+				boxes.push_back(box);
+			}
+		}
+	}
+
+	// marginal cost per cell along each direction
+	vector<double> cellCost[3];
+	for (int n=0;n<3;++n)
+	{
+		int nP = (n+1)%3;
+		int nPP = (n+2)%3;
+		cellCost[n].assign(numCells[n], (double)numCells[nP]*(double)numCells[nPP]);
+		for (size_t b=0;b<boxes.size();++b)
+		{
+			double area = boxes[b].weight*(double)(boxes[b].stop[nP]-boxes[b].start[nP])*(double)(boxes[b].stop[nPP]-boxes[b].start[nPP]);
+			for (unsigned int i=boxes[b].start[n];i<boxes[b].stop[n];++i)
+				cellCost[n][i] += area;
+		}
+	}
+
+	// try all rank grids with px*py*pz == number of processes
+	double bestCost = -1;
+	vector<unsigned int> bestSplits[3];
+	for (unsigned int px=1;px<=m_NumProc;++px)
+	{
+		if (m_NumProc%px)
+			continue;
+		for (unsigned int py=1;py<=m_NumProc/px;++py)
+		{
+			if ((m_NumProc/px)%py)
+				continue;
+			unsigned int num[3] = {px, py, m_NumProc/px/py};
+			bool valid = true;
+			for (int n=0;n<3;++n)
+				valid &= ((num[n]==1) || allowed[n]) && (num[n]*AutoSplit_MinWidth<=numCells[n]);
+			if (!valid)
+				continue;
+
+			vector<unsigned int> splits[3];
+			for (int n=0;n<3;++n)
+				splits[n] = BalanceSplits(cellCost[n], num[n]);
+			double cost = CalcSplitCost(boxes, splits);
+
+			// refine the split positions by local moves with decreasing step size
+			for (unsigned int step=max(numCells[0],max(numCells[1],numCells[2]))/8;step>0;step/=2)
+			{
+				bool improved = true;
+				for (unsigned int iter=0;improved && iter<100;++iter)
+				{
+					improved = false;
+					for (int n=0;n<3;++n)
+						for (size_t i=1;i<splits[n].size()-1;++i)
+							for (int dir=-1;dir<=1;dir+=2)
+							{
+								unsigned int old_line = splits[n][i];
+								int line = (int)old_line + dir*(int)step;
+								if ((line<(int)(splits[n][i-1]+AutoSplit_MinWidth)) || (line+(int)AutoSplit_MinWidth>(int)splits[n][i+1]))
+									continue;
+								splits[n][i] = line;
+								double newCost = CalcSplitCost(boxes, splits);
+								if (newCost<cost)
+								{
+									cost = newCost;
+									improved = true;
+								}
+								else
+									splits[n][i] = old_line;
+							}
+				}
+			}
+
+			if ((bestCost<0) || (cost<bestCost))
+			{
+				bestCost = cost;
+				for (int n=0;n<3;++n)
+					bestSplits[n] = splits[n];
+			}
+		}
+	}
+
+	if (bestCost<0)
+		return false;
+
+	for (int n=0;n<3;++n)
+		m_SplitNumber[n] = bestSplits[n];
+
+	if (m_MyID==0)
+	{
+		unsigned int origin[3] = {0,0,0};
+		double totalCost = CalcBoxCost(boxes, origin, numCells);
+		cout << "openEMS_FDTD_MPI: automatic domain decomposition into " << m_SplitNumber[0].size()-1 << "x" << m_SplitNumber[1].size()-1 << "x" << m_SplitNumber[2].size()-1 << " processes:" << endl;
+		for (int n=0;n<3;++n)
+		{
+			cout << "\t" << "xyz"[n] << "-split lines: ";
+			for (size_t i=0;i<m_SplitNumber[n].size();++i)
+				cout << m_SplitNumber[n].at(i) << " ";
+			cout << endl;
+		}
+		cout << "\t" << "estimated max. rank load (incl. halo) relative to average: " << bestCost/(totalCost/m_NumProc) << endl;
+	}
+	return true;
+}
+
 bool openEMS_FDTD_MPI::SetupMPI()
 {
 	if (!m_MPI_Enabled)
@@ -383,6 +659,7 @@ bool openEMS_FDTD_MPI::SetupProcessing()
 	int active=0;
 	bool deactivate = false;
 	bool rename = false;
+	bool collective = false;
 	for (size_t n=0;n<numProc;++n)
 	{
 		Processing* proc = PA->GetProcessing(n);
@@ -391,6 +668,7 @@ bool openEMS_FDTD_MPI::SetupProcessing()
 		MPI_Reduce(&isActive, &active, 1, MPI_INT, MPI_SUM, 0, MPI_COMM_WORLD);
 		deactivate = false;
 		rename = false;
+		collective = false;
 		if ((m_MyID==0) && (active>1)) //more than one active processing...
 		{
 			deactivate = true; //default
@@ -402,7 +680,23 @@ bool openEMS_FDTD_MPI::SetupProcessing()
 				deactivate = true;
 				rename = false;
 			}
-			if (dynamic_cast<ProcessFields*>(proc)!=NULL)
+			if (dynamic_cast<ProcessNF2FF*>(proc)!=NULL)
+			{
+				//type is nf2ff transformation --> disable! The far-field of a split nf2ff box can not be combined (yet)!
+				cerr << "openEMS_FDTD_MPI::SetupProcessing(): Warning: Processing: " << proc->GetName() << " occurs multiple times and is being deactivated..." << endl;
+				cerr << "openEMS_FDTD_MPI::SetupProcessing(): Note: Processing: The far-field of a nf2ff box split between MPI ranks can not be calculated during the simulation, use a nf2ff box without far-field settings instead." << endl;
+				deactivate = true;
+				rename = false;
+			}
+			ProcessFields* ProcField = dynamic_cast<ProcessFields*>(proc);
+			if (ProcField && ProcField->SupportsCollectiveDump())
+			{
+				//type is a hdf5 field processing --> all ranks write into one file
+				cerr << "openEMS_FDTD_MPI::SetupProcessing(): Note: Processing: " << proc->GetName() << " occurs multiple times and is written collectively..." << endl;
+				deactivate = false;
+				collective = true;
+			}
+			else if (ProcField)
 			{
 				//type is field processing --> renameing! Needs to be fixed!
 				cerr << "openEMS_FDTD_MPI::SetupProcessing(): Warning: Processing: " << proc->GetName() << " occurs multiple times and is being renamed..." << endl;
@@ -413,8 +707,18 @@ bool openEMS_FDTD_MPI::SetupProcessing()
 		//broadcast information to all
 		MPI_Bcast(&deactivate, 1, MPI::BOOL, 0, MPI_COMM_WORLD);
 		MPI_Bcast(&rename, 1, MPI::BOOL, 0, MPI_COMM_WORLD);
+		MPI_Bcast(&collective, 1, MPI::BOOL, 0, MPI_COMM_WORLD);
 		if (deactivate)
 			proc->SetEnable(false);
+		if (collective)
+		{
+			//create a communicator of all ranks with an active part of this dump
+			MPI_Comm comm;
+			MPI_Comm_split(MPI_COMM_WORLD, proc->GetEnable() ? 0 : MPI_UNDEFINED, m_MyID, &comm);
+			ProcessFields* ProcField = dynamic_cast<ProcessFields*>(proc);
+			if (ProcField && (comm!=MPI_COMM_NULL))
+				ProcField->SetCollectiveDump(comm);
+		}
 		if (rename)
 		{
 			ProcessFields* ProcField = dynamic_cast<ProcessFields*>(proc);
@@ -48,6 +48,8 @@ protected:
 
 	std::vector<unsigned int> m_SplitNumber[3];
 	TiXmlElement* m_MPI_Elem;
+	//! Split the mesh into m_NumProc ranks along the given directions (e.g. "xz"), balancing the estimated per rank cost
+	bool CalcAutoSplits(std::string directions);
 	virtual bool SetupMPI();
 	virtual bool SetupOperator();
 
@@ -63,6 +65,7 @@ protected:
 	//! Calc energy in all processes and add up
 	double CalcEnergy();
 
+	//! Deactivate, rename or collectively write processings active in multiple processes. Probes and in-process nf2ff transformations are deactivated.
 	virtual bool SetupProcessing();
 
 	//output redirection to file for ranks > 0
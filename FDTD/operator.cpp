@@ -16,7 +16,12 @@
 */
 
 #include <fstream>
+#include <sstream>
+#include <iomanip>
 #include <algorithm>
+#include <typeinfo>
+#include <random>
+#include <cstdio>
 #include "operator.h"
 #include "engine.h"
 #include "extensions/operator_extension.h"
@@ -36,6 +41,37 @@
 
 #include "CSPropMaterial.h"
 #include "CSPropLumpedElement.h"
+#include "tinyxml.h"
+
+#define OPERATOR_CACHE_MAGIC "openEMS operator cache"
+#define OPERATOR_CACHE_VERSION 1
+
+namespace
+{
+//! 64bit FNV-1a hash for the operator cache
+class OperatorHash
+{
+public:
+	OperatorHash() {m_Hash = 14695981039346656037ULL;}
+	void Add(const void* data, size_t size)
+	{
+		const unsigned char* bytes = (const unsigned char*)data;
+		for (size_t n=0; n<size; ++n)
+		{
+			m_Hash ^= bytes[n];
+			m_Hash *= 1099511628211ULL;
+		}
+	}
+	void Add(const string &str) {Add(str.c_str(), str.size()+1);}
+	template <typename T> void Add(T value) {Add(&value, sizeof(T));}
+	unsigned long long Get() const {return m_Hash;}
+protected:
+	unsigned long long m_Hash;
+};
+
+template <typename T> bool CacheWrite(ofstream &file, const T &value) {return (bool)file.write((const char*)&value, sizeof(T));}
+template <typename T> bool CacheRead(ifstream &file, T &value) {return (bool)file.read((char*)&value, sizeof(T));}
+}
 
 Operator* Operator::New()
 {
@@ -97,6 +133,7 @@ void Operator::Init()
 	m_Exc = 0;
 	m_TimeStepFactor = 1;
 	SetMaterialAvgMethod(QuarterCell);
+	m_OperatorCacheDir.clear();
 }
 
 void Operator::Delete()
@@ -129,6 +166,8 @@ void Operator::Delete()
 	m_mueR_ptr = NULL;
 	delete m_sigma_ptr;
 	m_sigma_ptr = NULL;
+
+	m_PrimitiveIndex.clear();
 }
 
 void Operator::Reset()
@@ -746,18 +785,21 @@ void Operator::DumpMaterial2File(string filename)
 	ArrayLib::ArrayNIJK<FDTD_FLOAT> kappa("kappa", numLines);
 	ArrayLib::ArrayNIJK<FDTD_FLOAT> sigma("sigma", numLines);
 
+	MaterialColumnCache matCache;
 	unsigned int pos[3];
 	for (pos[0]=0; pos[0]<numLines[0]; ++pos[0])
 	{
 		for (pos[1]=0; pos[1]<numLines[1]; ++pos[1])
 		{
 			vector<CSPrimitives*> vPrims = this->GetPrimitivesBoundBox(pos[0], pos[1], -1, CSProperties::MATERIAL);
+			if (m_MatAverageMethod==CentralCell)
+				matCache.Update(this, pos[0], pos[1], vPrims);
 			for (pos[2]=0; pos[2]<numLines[2]; ++pos[2])
 			{
 				for (int n=0; n<3; ++n)
 				{
 					double inMat[4];
-					Calc_EffMatPos(n, pos, inMat, vPrims);
+					Calc_EffMatPos(n, pos, inMat, vPrims, &matCache);
 					epsilon[n][pos[0]][pos[1]][pos[2]] = inMat[0]/__EPS0__;
 					mue[n][pos[0]][pos[1]][pos[2]]     = inMat[2]/__MUE0__;
 					kappa[n][pos[0]][pos[1]][pos[2]]   = inMat[1];
@@ -982,73 +1024,97 @@ int Operator::CalcECOperator( DebugFlags debugFlags )
 	Init_EC();
 	InitDataStorage();
 
-	if (Calc_EC()==0)
-		return -1;
+	// primitive index for the EC, PEC and extension setup
+	BuildPrimitiveIndex(CSProperties::MATERIAL);
+	BuildPrimitiveIndex((CSProperties::PropertyType)(CSProperties::MATERIAL | CSProperties::METAL));
 
-	m_InvaildTimestep = false;
-	opt_dT = 0;
-	if (dT>0)
+	// the hash has to be calculated before the timestep is, both reading and writing the cache use it
+	unsigned long long cacheHash = 0;
+	if (!m_OperatorCacheDir.empty() && CSX)
+		cacheHash = CalcOperatorHash();
+	string cacheFile = GetOperatorCacheFile(debugFlags, cacheHash);
+	if (!cacheFile.empty() && ReadOperatorCache(cacheFile, cacheHash))
+	{
+		if (g_settings.GetVerboseLevel()>0)
+			cout << "Operator::CalcECOperator: Using cached operator: " << cacheFile << endl;
+		m_Exc->Reset(dT);
+	}
+	else
 	{
-		double save_dT = dT;
-		CalcTimestep();
-		opt_dT = dT;
-		if (dT<save_dT)
+		if (Calc_EC()==0)
 		{
-			cerr << "Operator::CalcECOperator: Warning, forced timestep: " << save_dT << "s is larger than calculated timestep: " << dT << "s! It is not recommended using this timestep!! " << endl;
-			m_InvaildTimestep = true;
+			ClearPrimitiveIndex();
+			return -1;
 		}
 
-		dT = save_dT;
-	}
-	else
-		CalcTimestep();
+		m_InvaildTimestep = false;
+		opt_dT = 0;
+		if (dT>0)
+		{
+			double save_dT = dT;
+			CalcTimestep();
+			opt_dT = dT;
+			if (dT<save_dT)
+			{
+				cerr << "Operator::CalcECOperator: Warning, forced timestep: " << save_dT << "s is larger than calculated timestep: " << dT << "s! It is not recommended using this timestep!! " << endl;
+				m_InvaildTimestep = true;
+			}
 
-	dT*=m_TimeStepFactor;
+			dT = save_dT;
+		}
+		else
+			CalcTimestep();
 
-	if (m_Exc->GetSignalPeriod()>0)
-	{
-		unsigned int TS = ceil(m_Exc->GetSignalPeriod()/dT);
-		double new_dT = m_Exc->GetSignalPeriod()/TS;
-		cout << "Operartor::CalcECOperator: Decreasing timestep by " << round((dT-new_dT)/dT*1000)/10.0 << "% to " << new_dT << " (" << dT << ") to match periodic signal" << endl;
-		dT = new_dT;
-	}
+		dT*=m_TimeStepFactor;
 
-	m_Exc->Reset(dT);
+		if (m_Exc->GetSignalPeriod()>0)
+		{
+			unsigned int TS = ceil(m_Exc->GetSignalPeriod()/dT);
+			double new_dT = m_Exc->GetSignalPeriod()/TS;
+			cout << "Operartor::CalcECOperator: Decreasing timestep by " << round((dT-new_dT)/dT*1000)/10.0 << "% to " << new_dT << " (" << dT << ") to match periodic signal" << endl;
+			dT = new_dT;
+		}
 
-	InitOperator();
+		m_Exc->Reset(dT);
 
-	unsigned int pos[3];
+		InitOperator();
 
-	for (int n=0; n<3; ++n)
-	{
-		for (pos[0]=0; pos[0]<numLines[0]; ++pos[0])
+		unsigned int pos[3];
+
+		for (int n=0; n<3; ++n)
 		{
-			for (pos[1]=0; pos[1]<numLines[1]; ++pos[1])
+			for (pos[0]=0; pos[0]<numLines[0]; ++pos[0])
 			{
-				for (pos[2]=0; pos[2]<numLines[2]; ++pos[2])
+				for (pos[1]=0; pos[1]<numLines[1]; ++pos[1])
 				{
-					Calc_ECOperatorPos(n,pos);
+					for (pos[2]=0; pos[2]<numLines[2]; ++pos[2])
+					{
+						Calc_ECOperatorPos(n,pos);
+					}
 				}
 			}
 		}
-	}
 
-	//Apply PEC to all boundary's
-	bool PEC[6]={1,1,1,1,1,1};
-	//make an exception for BC == -1
-	for (int n=0; n<6; ++n)
-		if (m_BC[n]==-1)
-			PEC[n] = false;
-	ApplyElectricBC(PEC);
+		//Apply PEC to all boundary's
+		bool PEC[6]={1,1,1,1,1,1};
+		//make an exception for BC == -1
+		for (int n=0; n<6; ++n)
+			if (m_BC[n]==-1)
+				PEC[n] = false;
+		ApplyElectricBC(PEC);
+
+		CalcPEC();
 
-	CalcPEC();
+		Calc_LumpedElements();
 
-	Calc_LumpedElements();
+		bool PMC[6];
+		for (int n=0; n<6; ++n)
+			PMC[n] = m_BC[n]==1;
+		ApplyMagneticBC(PMC);
 
-	bool PMC[6];
-	for (int n=0; n<6; ++n)
-		PMC[n] = m_BC[n]==1;
-	ApplyMagneticBC(PMC);
+		if (!cacheFile.empty())
+			WriteOperatorCache(cacheFile, cacheHash);
+	}
 
 	//all information available for extension... create now...
 	for (size_t n=0; n<m_Op_exts.size(); ++n)
@@ -1075,6 +1141,7 @@ int Operator::CalcECOperator( DebugFlags debugFlags )
 		DumpPEC2File( "PEC_dump" );
 
 	//cleanup
+	ClearPrimitiveIndex();
 	for (int n=0; n<3; ++n)
 	{
 		delete[] EC_C[n];
@@ -1090,6 +1157,219 @@ int Operator::CalcECOperator( DebugFlags debugFlags )
 	return 0;
 }
 
+unsigned long long Operator::CalcOperatorHash()
+{
+	OperatorHash hash;
+	hash.Add(string(OPERATOR_CACHE_MAGIC));
+	hash.Add((int)OPERATOR_CACHE_VERSION);
+	hash.Add(string(typeid(*this).name()));
+	hash.Add((int)sizeof(FDTD_FLOAT));
+
+	// mesh and boundary conditions
+	for (int n=0; n<3; ++n)
+	{
+		hash.Add(numLines[n]);
+		hash.Add(discLines[n], numLines[n]*sizeof(double));
+	}
+	hash.Add(gridDelta);
+	hash.Add(m_BC, sizeof(m_BC));
+
+	// material averaging and timestep settings, a periodic excitation changes the timestep
+	hash.Add((int)m_MatAverageMethod);
+	hash.Add(m_TimeStepVar);
+	hash.Add(m_TimeStepFactor);
+	hash.Add(dT);
+	hash.Add(m_Exc->GetSignalPeriod());
+	hash.Add(GetBackgroundEpsR());
+	hash.Add(GetBackgroundMueR());
+	hash.Add(GetBackgroundKappa());
+	hash.Add(GetBackgroundSigma());
+
+	// all properties and primitives, except for excitations, probes and dumps, which are not part of the operator
+	int skipTypes = CSProperties::EXCITATION | CSProperties::PROBEBOX | CSProperties::DUMPBOX | CSProperties::RESBOX;
+	for (size_t n=0; n<CSX->GetQtyProperties(); ++n)
+	{
+		CSProperties* prop = CSX->GetProperty(n);
+		if (prop->GetType() & skipTypes)
+			continue;
+		TiXmlElement elem("Property");
+		prop->Write2XML(elem, false, true);
+		TiXmlPrinter printer;
+		elem.Accept(&printer);
+		hash.Add(string(printer.CStr()));
+	}
+	return hash.Get();
+}
+
+string Operator::GetOperatorCacheFile(DebugFlags debugFlags, unsigned long long hash)
+{
+	if (m_OperatorCacheDir.empty() || (CSX==NULL))
+		return string();
+
+	// the material data is only available from the full operator setup
+	if (debugFlags & debugMaterial)
+		return string();
+	for (int n=0; n<4; ++n)
+		if (m_StoreMaterial[n])
+			return string();
+
+	stringstream ss;
+	ss << m_OperatorCacheDir << "/openEMS_operator_" << hex << setw(16) << setfill('0') << hash << ".bin";
+	return ss.str();
+}
+
+bool Operator::WriteOperatorCache(string filename, unsigned long long hash)
+{
+	// write to a temporary file first, concurrent runs may write the same cache file
+	stringstream ss;
+	ss << filename << "." << hex << std::random_device()() << ".tmp";
+	string tmpFile = ss.str();
+
+	ofstream file(tmpFile.c_str(), ios_base::out | ios_base::binary);
+	if (!file.is_open())
+	{
+		cerr << "Operator::WriteOperatorCache: Warning: Can't write cache file: " << tmpFile << endl;
+		return false;
+	}
+
+	file.write(OPERATOR_CACHE_MAGIC, sizeof(OPERATOR_CACHE_MAGIC));
+	CacheWrite(file, (int)OPERATOR_CACHE_VERSION);
+	CacheWrite(file, hash);
+	CacheWrite(file, numLines);
+	CacheWrite(file, (int)sizeof(FDTD_FLOAT));
+
+	CacheWrite(file, dT);
+	CacheWrite(file, opt_dT);
+	CacheWrite(file, m_InvaildTimestep);
+	CacheWrite(file, m_Nr_PEC);
+	CacheWrite(file, (unsigned int)m_Used_TS_Name.size());
+	file.write(m_Used_TS_Name.c_str(), m_Used_TS_Name.size());
+
+	// equivalent circuit, used by some extensions
+	size_t size = MainOp->GetSize();
+	for (int n=0; n<3; ++n)
+	{
+		file.write((const char*)EC_C[n], size*sizeof(FDTD_FLOAT));
+		file.write((const char*)EC_G[n], size*sizeof(FDTD_FLOAT));
+		file.write((const char*)EC_L[n], size*sizeof(FDTD_FLOAT));
+		file.write((const char*)EC_R[n], size*sizeof(FDTD_FLOAT));
+	}
+
+	// operator coefficients, written per x-plane using the access functions of the actual storage model
+	vector<FDTD_FLOAT> plane(4*numLines[1]*numLines[2]);
+	for (int n=0; n<3; ++n)
+	{
+		for (unsigned int x=0; x<numLines[0]; ++x)
+		{
+			size_t i = 0;
+			for (unsigned int y=0; y<numLines[1]; ++y)
+				for (unsigned int z=0; z<numLines[2]; ++z)
+				{
+					plane[i++] = GetVV(n,x,y,z);
+					plane[i++] = GetVI(n,x,y,z);
+					plane[i++] = GetII(n,x,y,z);
+					plane[i++] = GetIV(n,x,y,z);
+				}
+			file.write((const char*)plane.data(), plane.size()*sizeof(FDTD_FLOAT));
+		}
+	}
+
+	bool ok = file.good();
+	file.close();
+	if (!ok || (std::rename(tmpFile.c_str(), filename.c_str())!=0))
+	{
+		cerr << "Operator::WriteOperatorCache: Warning: Writing cache file " << filename << " failed!" << endl;
+		std::remove(tmpFile.c_str());
+		return false;
+	}
+	if (g_settings.GetVerboseLevel()>0)
+		cout << "Operator::WriteOperatorCache: Operator written to cache file: " << filename << endl;
+	return true;
+}
+
+bool Operator::ReadOperatorCache(string filename, unsigned long long hash)
+{
+	ifstream file(filename.c_str(), ios_base::in | ios_base::binary);
+	if (!file.is_open())
+		return false;
+
+	char magic[sizeof(OPERATOR_CACHE_MAGIC)];
+	int version = 0;
+	unsigned long long cache_hash = 0;
+	unsigned int lines[3] = {0,0,0};
+	int floatSize = 0;
+	file.read(magic, sizeof(magic));
+	CacheRead(file, version);
+	CacheRead(file, cache_hash);
+	CacheRead(file, lines);
+	CacheRead(file, floatSize);
+	if (!file || (string(magic,sizeof(magic)-1)!=OPERATOR_CACHE_MAGIC) || (version!=OPERATOR_CACHE_VERSION) || (cache_hash!=hash)
+			|| (lines[0]!=numLines[0]) || (lines[1]!=numLines[1]) || (lines[2]!=numLines[2]) || (floatSize!=sizeof(FDTD_FLOAT)))
+	{
+		cerr << "Operator::ReadOperatorCache: Warning: Cache file " << filename << " does not match, ignoring it!" << endl;
+		return false;
+	}
+
+	double cache_dT=0, cache_opt_dT=0;
+	bool invalidTS = false;
+	unsigned int nrPEC[3] = {0,0,0};
+	unsigned int nameSize = 0;
+	CacheRead(file, cache_dT);
+	CacheRead(file, cache_opt_dT);
+	CacheRead(file, invalidTS);
+	CacheRead(file, nrPEC);
+	CacheRead(file, nameSize);
+	if (!file || nameSize>1024)
+		return false;
+	string tsName(nameSize,' ');
+	file.read(&tsName[0], nameSize);
+
+	size_t size = MainOp->GetSize();
+	for (int n=0; n<3; ++n)
+	{
+		file.read((char*)EC_C[n], size*sizeof(FDTD_FLOAT));
+		file.read((char*)EC_G[n], size*sizeof(FDTD_FLOAT));
+		file.read((char*)EC_L[n], size*sizeof(FDTD_FLOAT));
+		file.read((char*)EC_R[n], size*sizeof(FDTD_FLOAT));
+	}
+
+	InitOperator();
+	vector<FDTD_FLOAT> plane(4*numLines[1]*numLines[2]);
+	for (int n=0; n<3; ++n)
+	{
+		for (unsigned int x=0; x<numLines[0]; ++x)
+		{
+			if (!file.read((char*)plane.data(), plane.size()*sizeof(FDTD_FLOAT)))
+			{
+				cerr << "Operator::ReadOperatorCache: Warning: Cache file " << filename << " is incomplete, ignoring it!" << endl;
+				return false;
+			}
+			size_t i = 0;
+			for (unsigned int y=0; y<numLines[1]; ++y)
+				for (unsigned int z=0; z<numLines[2]; ++z)
+				{
+					SetVV(n,x,y,z,plane[i++]);
+					SetVI(n,x,y,z,plane[i++]);
+					SetII(n,x,y,z,plane[i++]);
+					SetIV(n,x,y,z,plane[i++]);
+				}
+		}
+	}
+
+	dT = cache_dT;
+	opt_dT = cache_opt_dT;
+	m_InvaildTimestep = invalidTS;
+	for (int n=0; n<3; ++n)
+		m_Nr_PEC[n] = nrPEC[n];
+	m_Used_TS_Name = tsName;
+
+	// the primitives used by the cached operator are not queried, prevent "unused primitive" warnings
+	vector<CSPrimitives*> vPrims = CSX->GetAllPrimitives(false, (CSProperties::PropertyType)(CSProperties::MATERIAL | CSProperties::METAL | CSProperties::LUMPED_ELEMENT));
+	for (size_t n=0; n<vPrims.size(); ++n)
+		vPrims.at(n)->SetPrimitiveUsed(true);
+	return true;
+}
+
 void Operator::ApplyElectricBC(bool* dirs)
 {
 	if (!dirs)
@@ -1180,10 +1460,10 @@ void Operator::ApplyMagneticBC(bool* dirs)
 	}
 }
 
-bool Operator::Calc_ECPos(int ny, const unsigned int* pos, double* EC, vector<CSPrimitives*> vPrims) const
+bool Operator::Calc_ECPos(int ny, const unsigned int* pos, double* EC, const vector<CSPrimitives*>& vPrims, const MaterialColumnCache* matCache) const
 {
 	double EffMat[4];
-	Calc_EffMatPos(ny,pos,EffMat, vPrims);
+	Calc_EffMatPos(ny,pos,EffMat, vPrims, matCache);
 
 	if (m_epsR_ptr)
 	{
@@ -1267,7 +1547,14 @@ bool Operator::GetCellCenterMaterialAvgCoord(const int pos[], double coord[3]) c
 	return true;
 }
 
-double Operator::GetMaterial(int ny, const double* coords, int MatType, vector<CSPrimitives*> vPrims, bool markAsUsed) const
+double Operator::GetMaterial(int ny, const double* coords, int MatType, const vector<CSPrimitives*>& vPrims, bool markAsUsed) const
+{
+	double l_coords[] = {coords[0],coords[1],coords[2]};
+	CSPropMaterial* mat = GetMaterialProperty(l_coords, vPrims, markAsUsed);
+	return GetMaterialValue(ny, l_coords, MatType, mat);
+}
+
+CSPropMaterial* Operator::GetMaterialProperty(double* coords, const vector<CSPrimitives*>& vPrims, bool markAsUsed) const
 {
 	CSProperties* prop = CSX->GetPropertyByCoordPriority(coords,vPrims,markAsUsed);
 //	CSProperties* old_prop = CSX->GetPropertyByCoordPriority(coords,CSProperties::MATERIAL,markAsUsed);
@@ -1276,8 +1563,11 @@ double Operator::GetMaterial(int ny, const double* coords, int MatType, vector<C
 //		cerr << "ERROR: Unequal properties!" << endl;
 //		exit(-1);
 //	}
+	return dynamic_cast<CSPropMaterial*>(prop);
+}
 
-	CSPropMaterial* mat = dynamic_cast<CSPropMaterial*>(prop);
+double Operator::GetMaterialValue(int ny, const double* coords, int MatType, CSPropMaterial* mat) const
+{
 	if (mat)
 	{
 		switch (MatType)
@@ -1316,10 +1606,29 @@ double Operator::GetMaterial(int ny, const double* coords, int MatType, vector<C
 	}
 }
 
-bool Operator::AverageMatCellCenter(int ny, const unsigned int* pos, double* EffMat, vector<CSPrimitives *> vPrims) const
+bool Operator::GetCellCenterMaterial(int ny, const int pos[3], int MatType, double mat[2], const vector<CSPrimitives*>& vPrims, const MaterialColumnCache* matCache) const
 {
-	int n=ny;
+	const double* cached = matCache ? matCache->GetCell(pos) : NULL;
+	if (cached)
+	{
+		mat[0] = cached[MatType*3+ny];
+		mat[1] = cached[(MatType+1)*3+ny];
+		return true;
+	}
+
 	double coord[3];
+	if (!GetCellCenterMaterialAvgCoord(pos,coord))
+		return false;
+	CSPropMaterial* prop = GetMaterialProperty(coord, vPrims);
+	mat[0] = GetMaterialValue(ny, coord, MatType, prop);
+	mat[1] = GetMaterialValue(ny, coord, MatType+1, prop);
+	return true;
+}
+
+bool Operator::AverageMatCellCenter(int ny, const unsigned int* pos, double* EffMat, const vector<CSPrimitives*>& vPrims, const MaterialColumnCache* matCache) const
+{
+	int n=ny;
+	double mat[2];
 	int nP = (n+1)%3;
 	int nPP = (n+2)%3;
 
@@ -1333,42 +1642,42 @@ bool Operator::AverageMatCellCenter(int ny, const unsigned int* pos, double* Eff
 
 	//******************************* epsilon,kappa averaging *****************************//
 	//shift up-right
-	if (GetCellCenterMaterialAvgCoord(loc_pos,coord))
+	if (GetCellCenterMaterial(n, loc_pos, 0, mat, vPrims, matCache))
 	{
 		A_n = GetNodeArea(ny,loc_pos,true);
-		EffMat[0] += GetMaterial(n, coord, 0, vPrims)*A_n;
-		EffMat[1] += GetMaterial(n, coord, 1, vPrims)*A_n;
+		EffMat[0] += mat[0]*A_n;
+		EffMat[1] += mat[1]*A_n;
 		area+=A_n;
 	}
 
 	//shift up-left
 	--loc_pos[nP];
-	if (GetCellCenterMaterialAvgCoord(loc_pos,coord))
+	if (GetCellCenterMaterial(n, loc_pos, 0, mat, vPrims, matCache))
 	{
 		A_n = GetNodeArea(ny,loc_pos,true);
-		EffMat[0] += GetMaterial(n, coord, 0, vPrims)*A_n;
-		EffMat[1] += GetMaterial(n, coord, 1, vPrims)*A_n;
+		EffMat[0] += mat[0]*A_n;
+		EffMat[1] += mat[1]*A_n;
 		area+=A_n;
 	}
 
 	//shift down-right
 	++loc_pos[nP];
 	--loc_pos[nPP];
-	if (GetCellCenterMaterialAvgCoord(loc_pos,coord))
+	if (GetCellCenterMaterial(n, loc_pos, 0, mat, vPrims, matCache))
 	{
 		A_n = GetNodeArea(ny,loc_pos,true);
-		EffMat[0] += GetMaterial(n, coord, 0, vPrims)*A_n;
-		EffMat[1] += GetMaterial(n, coord, 1, vPrims)*A_n;
+		EffMat[0] += mat[0]*A_n;
+		EffMat[1] += mat[1]*A_n;
 		area+=A_n;
 	}
 
 	//shift down-left
 	--loc_pos[nP];
-	if (GetCellCenterMaterialAvgCoord(loc_pos,coord))
+	if (GetCellCenterMaterial(n, loc_pos, 0, mat, vPrims, matCache))
 	{
 		A_n = GetNodeArea(ny,loc_pos,true);
-		EffMat[0] += GetMaterial(n, coord, 0, vPrims)*A_n;
-		EffMat[1] += GetMaterial(n, coord, 1, vPrims)*A_n;
+		EffMat[0] += mat[0]*A_n;
+		EffMat[1] += mat[1]*A_n;
 		area+=A_n;
 	}
 
@@ -1383,11 +1692,11 @@ bool Operator::AverageMatCellCenter(int ny, const unsigned int* pos, double* Eff
 	double delta_ny,sigma;
 	//shift down
 	--loc_pos[n];
-	if (GetCellCenterMaterialAvgCoord(loc_pos,coord))
+	if (GetCellCenterMaterial(n, loc_pos, 2, mat, vPrims, matCache))
 	{
 		delta_ny = GetNodeWidth(n,loc_pos,true);
-		EffMat[2] += delta_ny / GetMaterial(n, coord, 2, vPrims);
-		sigma = GetMaterial(n, coord, 3, vPrims);
+		EffMat[2] += delta_ny / mat[0];
+		sigma = mat[1];
 		if (sigma)
 			EffMat[3] += delta_ny / sigma;
 		else
@@ -1397,11 +1706,11 @@ bool Operator::AverageMatCellCenter(int ny, const unsigned int* pos, double* Eff
 
 	//shift up
 	++loc_pos[n];
-	if (GetCellCenterMaterialAvgCoord(loc_pos,coord))
+	if (GetCellCenterMaterial(n, loc_pos, 2, mat, vPrims, matCache))
 	{
 		delta_ny = GetNodeWidth(n,loc_pos,true);
-		EffMat[2] += delta_ny / GetMaterial(n, coord, 2, vPrims);
-		sigma = GetMaterial(n, coord, 3, vPrims);
+		EffMat[2] += delta_ny / mat[0];
+		sigma = mat[1];
 		if (sigma)
 			EffMat[3] += delta_ny / sigma;
 		else
@@ -1422,11 +1731,12 @@ bool Operator::AverageMatCellCenter(int ny, const unsigned int* pos, double* Eff
 	return true;
 }
 
-bool Operator::AverageMatQuarterCell(int ny, const unsigned int* pos, double* EffMat, vector<CSPrimitives*> vPrims) const
+bool Operator::AverageMatQuarterCell(int ny, const unsigned int* pos, double* EffMat, const vector<CSPrimitives*>& vPrims) const
 {
 	int n=ny;
 	double coord[3];
 	double shiftCoord[3];
+	CSPropMaterial* mat;
 	int nP = (n+1)%3;
 	int nPP = (n+2)%3;
 	coord[0] = discLines[0][pos[0]];
@@ -1449,8 +1759,9 @@ bool Operator::AverageMatQuarterCell(int ny, const unsigned int* pos, double* Ef
 	shiftCoord[nP] = coord[nP]+deltaP*0.25;
 	shiftCoord[nPP] = coord[nPP]+deltaPP*0.25;
 	A_n = GetNodeArea(ny,loc_pos,true);
-	EffMat[0] = GetMaterial(n, shiftCoord, 0, vPrims)*A_n;
-	EffMat[1] = GetMaterial(n, shiftCoord, 1, vPrims)*A_n;
+	mat = GetMaterialProperty(shiftCoord, vPrims);
+	EffMat[0] = GetMaterialValue(n, shiftCoord, 0, mat)*A_n;
+	EffMat[1] = GetMaterialValue(n, shiftCoord, 1, mat)*A_n;
 	area+=A_n;
 
 	//shift up-left
@@ -1460,8 +1771,9 @@ bool Operator::AverageMatQuarterCell(int ny, const unsigned int* pos, double* Ef
 
 	--loc_pos[nP];
 	A_n = GetNodeArea(ny,loc_pos,true);
-	EffMat[0] += GetMaterial(n, shiftCoord, 0, vPrims)*A_n;
-	EffMat[1] += GetMaterial(n, shiftCoord, 1, vPrims)*A_n;
+	mat = GetMaterialProperty(shiftCoord, vPrims);
+	EffMat[0] += GetMaterialValue(n, shiftCoord, 0, mat)*A_n;
+	EffMat[1] += GetMaterialValue(n, shiftCoord, 1, mat)*A_n;
 	area+=A_n;
 
 	//shift down-right
@@ -1471,8 +1783,9 @@ bool Operator::AverageMatQuarterCell(int ny, const unsigned int* pos, double* Ef
 	++loc_pos[nP];
 	--loc_pos[nPP];
 	A_n = GetNodeArea(ny,loc_pos,true);
-	EffMat[0] += GetMaterial(n, shiftCoord, 0, vPrims)*A_n;
-	EffMat[1] += GetMaterial(n, shiftCoord, 1, vPrims)*A_n;
+	mat = GetMaterialProperty(shiftCoord, vPrims);
+	EffMat[0] += GetMaterialValue(n, shiftCoord, 0, mat)*A_n;
+	EffMat[1] += GetMaterialValue(n, shiftCoord, 1, mat)*A_n;
 	area+=A_n;
 
 	//shift down-left
@@ -1481,8 +1794,9 @@ bool Operator::AverageMatQuarterCell(int ny, const unsigned int* pos, double* Ef
 	shiftCoord[nPP] = coord[nPP]-deltaPP_M*0.25;
 	--loc_pos[nP];
 	A_n = GetNodeArea(ny,loc_pos,true);
-	EffMat[0] += GetMaterial(n, shiftCoord, 0, vPrims)*A_n;
-	EffMat[1] += GetMaterial(n, shiftCoord, 1, vPrims)*A_n;
+	mat = GetMaterialProperty(shiftCoord, vPrims);
+	EffMat[0] += GetMaterialValue(n, shiftCoord, 0, mat)*A_n;
+	EffMat[1] += GetMaterialValue(n, shiftCoord, 1, mat)*A_n;
 	area+=A_n;
 
 	EffMat[0]*=__EPS0__/area;
@@ -1500,8 +1814,9 @@ bool Operator::AverageMatQuarterCell(int ny, const unsigned int* pos, double* Ef
 	shiftCoord[nPP] = coord[nPP]+deltaPP*0.5;
 	--loc_pos[n];
 	double delta_ny = GetNodeWidth(n,loc_pos,true);
-	EffMat[2] = delta_ny / GetMaterial(n, shiftCoord, 2, vPrims);
-	double sigma = GetMaterial(n, shiftCoord, 3, vPrims);
+	mat = GetMaterialProperty(shiftCoord, vPrims);
+	EffMat[2] = delta_ny / GetMaterialValue(n, shiftCoord, 2, mat);
+	double sigma = GetMaterialValue(n, shiftCoord, 3, mat);
 	if (sigma)
 		EffMat[3] = delta_ny / sigma;
 	else
@@ -1514,8 +1829,9 @@ bool Operator::AverageMatQuarterCell(int ny, const unsigned int* pos, double* Ef
 	shiftCoord[nPP] = coord[nPP]+deltaPP*0.5;
 	++loc_pos[n];
 	delta_ny = GetNodeWidth(n,loc_pos,true);
-	EffMat[2] += delta_ny / GetMaterial(n, shiftCoord, 2, vPrims);
-	sigma = GetMaterial(n, shiftCoord, 3, vPrims);
+	mat = GetMaterialProperty(shiftCoord, vPrims);
+	EffMat[2] += delta_ny / GetMaterialValue(n, shiftCoord, 2, mat);
+	sigma = GetMaterialValue(n, shiftCoord, 3, mat);
 	if (sigma)
 		EffMat[3] += delta_ny / sigma;
 	else
@@ -1536,14 +1852,14 @@ bool Operator::AverageMatQuarterCell(int ny, const unsigned int* pos, double* Ef
 	return true;
 }
 
-bool Operator::Calc_EffMatPos(int ny, const unsigned int* pos, double* EffMat, vector<CSPrimitives *> vPrims) const
+bool Operator::Calc_EffMatPos(int ny, const unsigned int* pos, double* EffMat, const vector<CSPrimitives*>& vPrims, const MaterialColumnCache* matCache) const
 {
 	switch (m_MatAverageMethod)
 	{
 	case QuarterCell:
 		return AverageMatQuarterCell(ny, pos, EffMat, vPrims);
 	case CentralCell:
-		return AverageMatCellCenter(ny, pos, EffMat, vPrims);
+		return AverageMatCellCenter(ny, pos, EffMat, vPrims, matCache);
 	default:
 		cerr << "Operator:: " << __func__ << ":  Error, unknown material averaging method... exit" << endl;
 		exit(1);
@@ -1778,9 +2094,8 @@ bool Operator::Calc_EC()
 	return true;
 }
 
-vector<CSPrimitives*> Operator::GetPrimitivesBoundBox(int posX, int posY, int posZ, CSProperties::PropertyType type) const
+void Operator::GetPrimitivesBoundBoxCoords(int posX, int posY, int posZ, double boundBox[6]) const
 {
-	double boundBox[6];
 	int BBpos[3] = {posX, posY, posZ};
 	for (int n=0;n<3;++n)
 	{
@@ -1795,28 +2110,79 @@ vector<CSPrimitives*> Operator::GetPrimitivesBoundBox(int posX, int posY, int po
 			boundBox[2*n+1] = this->GetDiscLine(n, min(int(numLines[n])-1, BBpos[n]+1));
 		}
 	}
+}
+
+vector<CSPrimitives*> Operator::GetPrimitivesBoundBox(int posX, int posY, int posZ, CSProperties::PropertyType type) const
+{
+	double boundBox[6];
+	GetPrimitivesBoundBoxCoords(posX, posY, posZ, boundBox);
+
+	// the bounding box is inside the x-line bounding box, thus all overlapping primitives are in the x-line index, sorted the same way as by CSX
+	map<int, PrimitiveIndex>::const_iterator it = m_PrimitiveIndex.find(type);
+	if ((posX>=0) && (it!=m_PrimitiveIndex.end()) && (posX<(int)it->second.xLines.size()))
+	{
+		const PrimitiveIndex& index = it->second;
+		const vector<unsigned int>& xLine = index.xLines.at(posX);
+		vector<CSPrimitives*> vPrim;
+		vPrim.reserve(xLine.size());
+		for (size_t n=0; n<xLine.size(); ++n)
+		{
+			CSPrimitives* prim = index.prims.at(xLine.at(n));
+			if (prim->IsInsideBox(boundBox)!=-1)
+				vPrim.push_back(prim);
+		}
+		return vPrim;
+	}
 
 	vector<CSPrimitives*> vPrim = this->CSX->GetPrimitivesByBoundBox(boundBox, true, type);
 	return vPrim;
 }
 
+void Operator::BuildPrimitiveIndex(CSProperties::PropertyType type)
+{
+	m_PrimitiveIndex.erase(type);
+	if (CSX==NULL)
+		return;
+
+	PrimitiveIndex& index = m_PrimitiveIndex[type];
+	index.prims = CSX->GetAllPrimitives(true, type);
+	index.xLines.resize(numLines[0]);
+
+	double boundBox[6];
+	for (unsigned int x=0; x<numLines[0]; ++x)
+	{
+		GetPrimitivesBoundBoxCoords(x, -1, -1, boundBox);
+		for (unsigned int p=0; p<index.prims.size(); ++p)
+			if (index.prims.at(p)->IsInsideBox(boundBox)!=-1)
+				index.xLines.at(x).push_back(p);
+	}
+}
+
+void Operator::ClearPrimitiveIndex()
+{
+	m_PrimitiveIndex.clear();
+}
+
 void Operator::Calc_EC_Range(unsigned int xStart, unsigned int xStop)
 {
 //	vector<CSPrimitives*> vPrims = this->CSX->GetAllPrimitives(true, CSProperties::MATERIAL);
 	unsigned int ipos;
 	unsigned int pos[3];
 	double inEC[4];
+	MaterialColumnCache matCache;
 	for (pos[0]=xStart; pos[0]<=xStop; ++pos[0])
 	{
 		for (pos[1]=0; pos[1]<numLines[1]; ++pos[1])
 		{
 			vector<CSPrimitives*> vPrims = this->GetPrimitivesBoundBox(pos[0], pos[1], -1, CSProperties::MATERIAL);
+			if (m_MatAverageMethod==CentralCell)
+				matCache.Update(this, pos[0], pos[1], vPrims);
 			for (pos[2]=0; pos[2]<numLines[2]; ++pos[2])
 			{
 				ipos = MainOp->GetPos(pos[0],pos[1],pos[2]);
 				for (int n=0; n<3; ++n)
 				{
-					Calc_ECPos(n,pos,inEC,vPrims);
+					Calc_ECPos(n,pos,inEC,vPrims,&matCache);
 					EC_C[n][ipos]=inEC[0];
 					EC_G[n][ipos]=inEC[1];
 					EC_L[n][ipos]=inEC[2];
@@ -2168,3 +2534,42 @@ double Operator::CalcNumericPhaseVelocity(unsigned int start[3], unsigned int st
 
 	return phv;
 }
+
+// ----------------------------------------------------------------------------
+
+MaterialColumnCache::MaterialColumnCache()
+{
+	m_pos[0] = -1;
+	m_pos[1] = -1;
+	m_numZ = 0;
+}
+
+void MaterialColumnCache::Update(const Operator* op, unsigned int posX, unsigned int posY, const vector<CSPrimitives*>& vPrims)
+{
+	m_pos[0] = posX;
+	m_pos[1] = posY;
+	m_numZ = op->numLines[2];
+
+	// cells (posX-1..posX, posY-1..posY, -1..numZ-1), stored at z+1
+	int pos[3];
+	double coord[3];
+	for (int dx=0; dx<2; ++dx)
+		for (int dy=0; dy<2; ++dy)
+		{
+			m_Valid[dx][dy].assign(m_numZ+1, false);
+			m_Values[dx][dy].resize(12*(m_numZ+1));
+			pos[0] = m_pos[0]+dx-1;
+			pos[1] = m_pos[1]+dy-1;
+			for (pos[2]=-1; pos[2]<m_numZ; ++pos[2])
+			{
+				if (!op->GetCellCenterMaterialAvgCoord(pos,coord))
+					continue;
+				CSPropMaterial* mat = op->GetMaterialProperty(coord, vPrims);
+				double* values = &m_Values[dx][dy][12*(pos[2]+1)];
+				for (int type=0; type<4; ++type)
+					for (int ny=0; ny<3; ++ny)
+						values[type*3+ny] = op->GetMaterialValue(ny, coord, type, mat);
+				m_Valid[dx][dy][pos[2]+1] = true;
+			}
+		}
+}
@@ -25,10 +25,14 @@
 
 #include "tools/arraylib/array_nijk.h"
 
+#include <map>
+
 class Operator_Extension;
 class Operator_Ext_Excitation;
 class Engine;
 class TiXmlElement;
+class MaterialColumnCache;
+class CSPropMaterial;
 
 //! Basic FDTD-operator
 class Operator : public Operator_Base
@@ -40,9 +44,11 @@ class Operator : public Operator_Base
 	friend class Operator_Ext_PML_SF_Plane;
 	friend class Operator_Ext_Excitation;
 	friend class Operator_Ext_UPML;
+	friend class Operator_Ext_CPML;
 	friend class Operator_Ext_Cylinder;
 	friend class Operator_Ext_LumpedRLC;
 	friend class Operator_Ext_Absorbing_BC;
+	friend class MaterialColumnCache;
 	
 public:
 	enum DebugFlags {None=0,debugMaterial=1,debugOperator=2,debugPEC=4};
@@ -142,6 +148,9 @@ public:
 	//! Set the material averaging method /sa MatAverageMethods
 	void SetMaterialAvgMethod(MatAverageMethods method);
 
+	//! Set a directory to store and reload the operator, an empty string disables the operator cache (default)
+	void SetOperatorCache(string dir) {m_OperatorCacheDir=dir;}
+
 	//! Set material averaging method to the advanced quarter cell material interpolation (default)
 	void SetQuarterCellMaterialAvg() {m_MatAverageMethod=QuarterCell;}
 
@@ -233,6 +242,14 @@ public:
 
 	virtual vector<CSPrimitives*> GetPrimitivesBoundBox(int posX, int posY, int posZ, CSProperties::PropertyType type=CSProperties::ANY) const;
 
+	//! Build an index of all primitives of the given type overlapping each x-line, used by GetPrimitivesBoundBox() to avoid a search over all CSX primitives.
+	/*!
+	  The index is read-only once built and may be shared by multiple threads. It must not be built while other threads query primitives.
+	  The index is only valid as long as the CSX structure is unchanged, it is removed by ClearPrimitiveIndex() after the operator setup.
+	  */
+	virtual void BuildPrimitiveIndex(CSProperties::PropertyType type);
+	virtual void ClearPrimitiveIndex();
+
 protected:
 	//! use New() for creating a new Operator
 	Operator();
@@ -245,6 +262,17 @@ protected:
 
 	virtual bool SetupCSXGrid(CSRectGrid* grid);
 
+	//! Get the bounding box of the given position, a negative position includes the full mesh in this direction \sa GetPrimitivesBoundBox
+	void GetPrimitivesBoundBoxCoords(int posX, int posY, int posZ, double boundBox[6]) const;
+
+	struct PrimitiveIndex
+	{
+		vector<CSPrimitives*> prims;          //!< all primitives of this type, sorted by priority
+		vector< vector<unsigned int> > xLines; //!< indices of all primitives overlapping the bounding box of an x-line
+	};
+	//! Primitive index per property type \sa BuildPrimitiveIndex
+	map<int, PrimitiveIndex> m_PrimitiveIndex;
+
 	virtual Grid_Path FindPath(double start[], double stop[]);
 
 	// debug
@@ -268,8 +296,22 @@ protected:
 	double CalcTimestep_Var1();
 	double CalcTimestep_Var3();
 
+	//! Operator cache directory, see SetOperatorCache()
+	string m_OperatorCacheDir;
+	//! Hash over everything the cached operator depends on: operator type, mesh, boundary conditions, timestep settings and all non probe/dump/excitation properties
+	/*!
+	  Must be calculated before the operator setup, since the timestep is part of the settings as long as it is only the forced timestep (or zero).
+	  */
+	virtual unsigned long long CalcOperatorHash();
+	//! Get the cache file for this operator and the given \a hash, returns an empty string if the operator cache is disabled or not applicable
+	virtual string GetOperatorCacheFile(DebugFlags debugFlags, unsigned long long hash);
+	//! Read the equivalent circuit, timestep and the operator coefficients from a cache file, the file has to match the given \a hash
+	virtual bool ReadOperatorCache(string filename, unsigned long long hash);
+	//! Write the equivalent circuit, timestep and the operator coefficients to a cache file, using the \a hash calculated before the operator setup
+	virtual bool WriteOperatorCache(string filename, unsigned long long hash);
+
 	//! Calculate the FDTD equivalent circuit parameter for the given position and direction ny. \sa Calc_EffMat_Pos
-	virtual bool Calc_ECPos(int ny, const unsigned int* pos, double* EC, vector<CSPrimitives *> vPrims) const;
+	virtual bool Calc_ECPos(int ny, const unsigned int* pos, double* EC, const vector<CSPrimitives *>& vPrims, const MaterialColumnCache* matCache=NULL) const;
 
 	//! Get the FDTD raw disc delta, needed by Calc_EffMatPos() \sa Calc_EffMatPos
 	/*!
@@ -280,15 +322,21 @@ protected:
 	virtual double GetRawDiscDelta(int ny, const int pos) const;
 
 	//! Get the material at a given coordinate, direction and type from CSX (internal use only)
-	virtual double GetMaterial(int ny, const double coords[3], int MatType, vector<CSPrimitives*> vPrims, bool markAsUsed=true) const;
+	virtual double GetMaterial(int ny, const double coords[3], int MatType, const vector<CSPrimitives*>& vPrims, bool markAsUsed=true) const;
+	//! Get the material property at a given coordinate from CSX, returns NULL for background material. The coordinate may be adjusted to the material coordinate (internal use only)
+	virtual CSPropMaterial* GetMaterialProperty(double coords[3], const vector<CSPrimitives*>& vPrims, bool markAsUsed=true) const;
+	//! Get the material value of a given type and direction of a material property found by GetMaterialProperty() (internal use only)
+	double GetMaterialValue(int ny, const double coords[3], int MatType, CSPropMaterial* mat) const;
+	//! Get two consecutive material types (eps/kappa or mue/sigma) at the cell center of the given cell, using the material cache if possible
+	bool GetCellCenterMaterial(int ny, const int pos[3], int MatType, double mat[2], const vector<CSPrimitives*>& vPrims, const MaterialColumnCache* matCache) const;
 
 	MatAverageMethods m_MatAverageMethod;
 
 	//! Calculate the effective/averaged material properties at the given position and direction ny.
-	virtual bool Calc_EffMatPos(int ny, const unsigned int* pos, double* EffMat, vector<CSPrimitives*> vPrims) const;
+	virtual bool Calc_EffMatPos(int ny, const unsigned int* pos, double* EffMat, const vector<CSPrimitives*>& vPrims, const MaterialColumnCache* matCache=NULL) const;
 
-	virtual bool AverageMatCellCenter(int ny, const unsigned int* pos, double* EffMat, vector<CSPrimitives*> vPrims) const;
-	virtual bool AverageMatQuarterCell(int ny, const unsigned int* pos, double* EffMat, vector<CSPrimitives*> vPrims) const;
+	virtual bool AverageMatCellCenter(int ny, const unsigned int* pos, double* EffMat, const vector<CSPrimitives*>& vPrims, const MaterialColumnCache* matCache=NULL) const;
+	virtual bool AverageMatQuarterCell(int ny, const unsigned int* pos, double* EffMat, const vector<CSPrimitives*>& vPrims) const;
 
 	//! Calc operator at certain \a pos
 	virtual void Calc_ECOperatorPos(int n, unsigned int* pos);
@@ -336,6 +384,37 @@ public:
 	ArrayLib::ArrayNIJK<FDTD_FLOAT>* iv_ptr; //calc new current from old voltage
 };
 
+//! Material values at the cell centers of the four z-columns of cells around an (x,y) column of edges
+/*!
+  All edges of a column average the material over the same cell centers, this cache resolves the material property of every cell center only once per column.
+  */
+class MaterialColumnCache
+{
+public:
+	MaterialColumnCache();
+
+	//! Sample all cell centers around the edge column at (posX,posY), vPrims has to contain all material primitives of this column
+	void Update(const Operator* op, unsigned int posX, unsigned int posY, const vector<CSPrimitives*>& vPrims);
+
+	//! Get the cached epsilon, kappa, mue and sigma values (index: MatType*3+ny) of a cell, or NULL if the cell is not cached or has no valid cell center
+	const double* GetCell(const int pos[3]) const
+	{
+		int dx = pos[0]-m_pos[0]+1;
+		int dy = pos[1]-m_pos[1]+1;
+		if ((dx<0) || (dx>1) || (dy<0) || (dy>1) || (pos[2]<-1) || (pos[2]>=m_numZ))
+			return NULL;
+		if (!m_Valid[dx][dy][pos[2]+1])
+			return NULL;
+		return &m_Values[dx][dy][12*(pos[2]+1)];
+	}
+
+protected:
+	int m_pos[2];
+	int m_numZ;
+	vector<bool> m_Valid[2][2];
+	vector<double> m_Values[2][2];
+};
+
 inline Operator::DebugFlags operator|( Operator::DebugFlags a, Operator::DebugFlags b ) { return static_cast<Operator::DebugFlags>(static_cast<int>(a) | static_cast<int>(b)); }
 inline Operator::DebugFlags& operator|=( Operator::DebugFlags& a, const Operator::DebugFlags& b ) { return a = a | b; }
 
@@ -0,0 +1,110 @@
+/*
+*	Copyright (C) 2026 Thorsten Liebig (Thorsten.Liebig@gmx.de)
+*
+*	This program is free software: you can redistribute it and/or modify
+*	it under the terms of the GNU General Public License as published by
+*	the Free Software Foundation, either version 3 of the License, or
+*	(at your option) any later version.
+*
+*	This program is distributed in the hope that it will be useful,
+*	but WITHOUT ANY WARRANTY; without even the implied warranty of
+*	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*	GNU General Public License for more details.
+*
+*	You should have received a copy of the GNU General Public License
+*	along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "engine_avx.h"
+#include "operator_avx.h"
+#include "tools/array_ops.h"
+
+template <typename fNvector>
+Operator_AVX<fNvector>* Operator_AVX<fNvector>::New()
+{
+	cout << "Create FDTD operator (AVX, " << numLanes << " floats per vector)" << endl;
+	Operator_AVX<fNvector>* op = new Operator_AVX<fNvector>();
+	op->Init();
+	return op;
+}
+
+template <typename fNvector>
+Operator_AVX<fNvector>::Operator_AVX() : Operator()
+{
+	fN_vv_ptr = NULL;
+	fN_vi_ptr = NULL;
+	fN_iv_ptr = NULL;
+	fN_ii_ptr = NULL;
+}
+
+template <typename fNvector>
+Operator_AVX<fNvector>::~Operator_AVX()
+{
+	Delete();
+}
+
+template <typename fNvector>
+Engine* Operator_AVX<fNvector>::CreateEngine()
+{
+	//! create the matching avx-engine
+	m_Engine = Engine_AVX<fNvector>::New(this);
+	return m_Engine;
+}
+
+template <typename fNvector>
+void Operator_AVX<fNvector>::Init()
+{
+	Operator::Init();
+	fN_vv_ptr = NULL;
+	fN_vi_ptr = NULL;
+	fN_iv_ptr = NULL;
+	fN_ii_ptr = NULL;
+}
+
+template <typename fNvector>
+void Operator_AVX<fNvector>::Delete()
+{
+	delete fN_vv_ptr;
+	delete fN_vi_ptr;
+	delete fN_iv_ptr;
+	delete fN_ii_ptr;
+	fN_vv_ptr = NULL;
+	fN_vi_ptr = NULL;
+	fN_iv_ptr = NULL;
+	fN_ii_ptr = NULL;
+}
+
+template <typename fNvector>
+void Operator_AVX<fNvector>::Reset()
+{
+	Delete();
+	Operator::Reset();
+}
+
+template <typename fNvector>
+void Operator_AVX<fNvector>::InitOperator()
+{
+	delete fN_vv_ptr;
+	delete fN_vi_ptr;
+	delete fN_iv_ptr;
+	delete fN_ii_ptr;
+
+	numVectors =  ceil((double)numLines[2]/(double)numLanes);
+
+	fN_vv_ptr = new ArrayLib::ArrayNIJK<fNvector>(
+		"fN_vv", {numLines[0], numLines[1], numVectors}
+	);
+	fN_vi_ptr = new ArrayLib::ArrayNIJK<fNvector>(
+		"fN_vi", {numLines[0], numLines[1], numVectors}
+	);
+	fN_iv_ptr = new ArrayLib::ArrayNIJK<fNvector>(
+		"fN_iv", {numLines[0], numLines[1], numVectors}
+	);
+	fN_ii_ptr = new ArrayLib::ArrayNIJK<fNvector>(
+		"fN_ii", {numLines[0], numLines[1], numVectors}
+	);
+}
+
+// AVX2 and AVX-512 operators
+template class Operator_AVX<f8vector>;
+template class Operator_AVX<f16vector>;
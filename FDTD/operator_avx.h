@@ -0,0 +1,115 @@
+/*
+*	Copyright (C) 2026 Thorsten Liebig (Thorsten.Liebig@gmx.de)
+*
+*	This program is free software: you can redistribute it and/or modify
+*	it under the terms of the GNU General Public License as published by
+*	the Free Software Foundation, either version 3 of the License, or
+*	(at your option) any later version.
+*
+*	This program is distributed in the hope that it will be useful,
+*	but WITHOUT ANY WARRANTY; without even the implied warranty of
+*	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*	GNU General Public License for more details.
+*
+*	You should have received a copy of the GNU General Public License
+*	along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef OPERATOR_AVX_H
+#define OPERATOR_AVX_H
+
+#include "operator.h"
+#include "tools/array_ops.h"
+
+template <typename fNvector> class Engine_Interface_AVX_FDTD;
+
+//! FDTD operator using the wide (8 or 16 float) vector layout of the AVX engine
+/*!
+  Same storage scheme as Operator_sse, but with a vector type of \a fNvector (f8vector for AVX2, f16vector for AVX-512).
+  The z-line is split into numLanes consecutive blocks of numVectors lines each, the z-position \a z is stored in
+  vector z%numVectors at lane z/numVectors.
+  */
+template <typename fNvector>
+class Operator_AVX : public Operator
+{
+	friend class Engine_Interface_AVX_FDTD<fNvector>;
+public:
+	//! Create a new operator
+	static Operator_AVX* New();
+	virtual ~Operator_AVX();
+
+	virtual Engine* CreateEngine();
+
+	//! Number of floats per vector
+	static const unsigned int numLanes = sizeof(fNvector)/sizeof(float);
+
+	inline virtual FDTD_FLOAT GetVV(unsigned int n, unsigned int x, unsigned int y, unsigned int z) const
+	{
+		ArrayLib::ArrayNIJK<fNvector>& fN_vv = *fN_vv_ptr;
+		return fN_vv[n][x][y][z%numVectors].f[z/numVectors];
+	}
+
+	inline virtual FDTD_FLOAT GetVI(unsigned int n, unsigned int x, unsigned int y, unsigned int z) const
+	{
+		ArrayLib::ArrayNIJK<fNvector>& fN_vi = *fN_vi_ptr;
+		return fN_vi[n][x][y][z%numVectors].f[z/numVectors];
+	}
+
+	inline virtual FDTD_FLOAT GetII(unsigned int n, unsigned int x, unsigned int y, unsigned int z) const
+	{
+		ArrayLib::ArrayNIJK<fNvector>& fN_ii = *fN_ii_ptr;
+		return fN_ii[n][x][y][z%numVectors].f[z/numVectors];
+	}
+
+	inline virtual FDTD_FLOAT GetIV(unsigned int n, unsigned int x, unsigned int y, unsigned int z) const
+	{
+		ArrayLib::ArrayNIJK<fNvector>& fN_iv = *fN_iv_ptr;
+		return fN_iv[n][x][y][z%numVectors].f[z/numVectors];
+	}
+
+	inline virtual void SetVV(unsigned int n, unsigned int x, unsigned int y, unsigned int z, FDTD_FLOAT value)
+	{
+		ArrayLib::ArrayNIJK<fNvector>& fN_vv = *fN_vv_ptr;
+		fN_vv[n][x][y][z%numVectors].f[z/numVectors] = value;
+	}
+
+	inline virtual void SetVI(unsigned int n, unsigned int x, unsigned int y, unsigned int z, FDTD_FLOAT value)
+	{
+		ArrayLib::ArrayNIJK<fNvector>& fN_vi = *fN_vi_ptr;
+		fN_vi[n][x][y][z%numVectors].f[z/numVectors] = value;
+	}
+
+	inline virtual void SetII(unsigned int n, unsigned int x, unsigned int y, unsigned int z, FDTD_FLOAT value)
+	{
+		ArrayLib::ArrayNIJK<fNvector>& fN_ii = *fN_ii_ptr;
+		fN_ii[n][x][y][z%numVectors].f[z/numVectors] = value;
+	}
+
+	inline virtual void SetIV(unsigned int n, unsigned int x, unsigned int y, unsigned int z, FDTD_FLOAT value)
+	{
+		ArrayLib::ArrayNIJK<fNvector>& fN_iv = *fN_iv_ptr;
+		fN_iv[n][x][y][z%numVectors].f[z/numVectors] = value;
+	}
+
+	unsigned int GetNumberOfVectors() const {return numVectors;}
+
+protected:
+	//! use New() for creating a new Operator
+	Operator_AVX();
+
+	virtual void Init();
+	void Delete();
+	virtual void Reset();
+	virtual void InitOperator();
+
+	unsigned int numVectors;
+
+	// engine/post-proc needs access
+public:
+	ArrayLib::ArrayNIJK<fNvector>* fN_vv_ptr; //calc new voltage from old voltage
+	ArrayLib::ArrayNIJK<fNvector>* fN_vi_ptr; //calc new voltage from old current
+	ArrayLib::ArrayNIJK<fNvector>* fN_iv_ptr; //calc new current from old current
+	ArrayLib::ArrayNIJK<fNvector>* fN_ii_ptr; //calc new current from old voltage
+};
+
+#endif // OPERATOR_AVX_H
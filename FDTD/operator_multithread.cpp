@@ -110,13 +110,31 @@ int Operator_Multithread::CalcECOperator( DebugFlags debugFlags )
 	if ((m_numThreads == 0) || (m_numThreads > boost::thread::hardware_concurrency()))
 		m_numThreads = boost::thread::hardware_concurrency();
 
-	vector<unsigned int> m_Start_Lines;
-	vector<unsigned int> m_Stop_Lines;
-	CalcStartStopLines( m_numThreads, m_Start_Lines, m_Stop_Lines );
+	// only the (possibly reduced) number of threads is needed here, the lines are assigned to the threads in Calc_EC()
+	vector<unsigned int> start, stop;
+	CalcStartStopLines( m_numThreads, start, stop );
 
 	if (g_settings.GetVerboseLevel()>0)
 		cout << "Multithreaded operator using " << m_numThreads << " threads." << std::endl;
 
+	// the worker threads are started by Calc_EC(), which is skipped for a cached operator
+	m_thread_group.join_all();
+
+	return OPERATOR_MULTITHREAD_BASE::CalcECOperator( debugFlags );
+}
+
+bool Operator_Multithread::Calc_EC()
+{
+	if (CSX==NULL)
+	{
+		cerr << "CartOperator::Calc_EC: CSX not given or invalid!!!" << endl;
+		return false;
+	}
+
+	vector<unsigned int> m_Start_Lines;
+	vector<unsigned int> m_Stop_Lines;
+	CalcStartStopLines( m_numThreads, m_Start_Lines, m_Stop_Lines );
+
 	m_thread_group.join_all();
 	delete m_CalcEC_Start;
 	m_CalcEC_Start = new boost::barrier(m_numThreads+1); // numThread workers + 1 controller
@@ -134,17 +152,6 @@ int Operator_Multithread::CalcECOperator( DebugFlags debugFlags )
 		m_thread_group.add_thread( t );
 	}
 
-	return OPERATOR_MULTITHREAD_BASE::CalcECOperator( debugFlags );
-}
-
-bool Operator_Multithread::Calc_EC()
-{
-	if (CSX==NULL)
-	{
-		cerr << "CartOperator::Calc_EC: CSX not given or invalid!!!" << endl;
-		return false;
-	}
-
 	MainOp->SetPos(0,0,0);
 
 	m_CalcEC_Start->wait();
@@ -55,6 +55,8 @@ protected:
 
 	virtual int CalcECOperator( DebugFlags debugFlags = None );
 
+	virtual unsigned int GetNumberOfCompressionThreads() const {return m_numThreads;}
+
 	//Calc_EC barrier
 	boost::barrier* m_CalcEC_Start;
 	boost::barrier* m_CalcEC_Stop;
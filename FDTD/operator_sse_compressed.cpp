@@ -19,9 +19,12 @@
 #include "engine_sse_compressed.h"
 #include "engine_sse.h"
 #include "tools/array_ops.h"
+#include "tools/useful.h"
 
-#include <map>
+#include <unordered_map>
 #include <cstring>
+#include <boost/thread.hpp>
+#include <boost/bind.hpp>
 
 Operator_SSE_Compressed* Operator_SSE_Compressed::New()
 {
@@ -109,138 +112,157 @@ void Operator_SSE_Compressed::ShowStat() const
 	cout << "-----------------------------------" << endl;
 }
 
-bool Operator_SSE_Compressed::CompressOperator()
+unsigned int Operator_SSE_Compressed::GetNumberOfCompressionThreads() const
 {
-	if (g_settings.GetVerboseLevel()>0)
-		cout << "Compressing the FDTD operator... this may take a while..." << endl;
-
-	ArrayLib::ArrayNIJK<f4vector>& f4_vv = *f4_vv_ptr;
-	ArrayLib::ArrayNIJK<f4vector>& f4_vi = *f4_vi_ptr;
-	ArrayLib::ArrayNIJK<f4vector>& f4_iv = *f4_iv_ptr;
-	ArrayLib::ArrayNIJK<f4vector>& f4_ii = *f4_ii_ptr;
+	return boost::thread::hardware_concurrency();
+}
 
-	map<SSE_coeff,unsigned int> lookUpMap;
+namespace
+{
+//! The uncompressed coefficients of all cells, a cell is given by its linear index (x,y,z-vector) into the f4vector arrays
+struct SSE_CoeffCells
+{
+	const f4vector* coeff[4]; // vv, vi, iv, ii; the three directions of a cell are contiguous
+};
 
-	unsigned int pos[3];
-	for (pos[0]=0; pos[0]<numLines[0]; ++pos[0])
+//! Hash the coefficients of a cell (FNV-1a over 64bit words)
+struct SSE_CoeffHash
+{
+	const SSE_CoeffCells* cells;
+	size_t operator()(unsigned int cell) const
 	{
-		for (pos[1]=0; pos[1]<numLines[1]; ++pos[1])
+		uint64_t hash = 14695981039346656037ULL;
+		for (int c=0; c<4; ++c)
 		{
-			for (pos[2]=0; pos[2]<numVectors; ++pos[2])
-			{
-				f4vector vv[3] = { f4_vv[0][pos[0]][pos[1]][pos[2]], f4_vv[1][pos[0]][pos[1]][pos[2]], f4_vv[2][pos[0]][pos[1]][pos[2]] };
-				f4vector vi[3] = { f4_vi[0][pos[0]][pos[1]][pos[2]], f4_vi[1][pos[0]][pos[1]][pos[2]], f4_vi[2][pos[0]][pos[1]][pos[2]] };
-				f4vector iv[3] = { f4_iv[0][pos[0]][pos[1]][pos[2]], f4_iv[1][pos[0]][pos[1]][pos[2]], f4_iv[2][pos[0]][pos[1]][pos[2]] };
-				f4vector ii[3] = { f4_ii[0][pos[0]][pos[1]][pos[2]], f4_ii[1][pos[0]][pos[1]][pos[2]], f4_ii[2][pos[0]][pos[1]][pos[2]] };
-				SSE_coeff c( vv, vi, iv, ii );
-
-				map<SSE_coeff,unsigned int>::iterator it;
-				it = lookUpMap.find(c);
-				if (it == lookUpMap.end())
-				{
-					// not found -> insert
-					unsigned int index = f4_vv_Compressed[0].size();
-					for (int n=0; n<3; n++)
-					{
-						f4_vv_Compressed[n].push_back( vv[n] );
-						f4_vi_Compressed[n].push_back( vi[n] );
-						f4_iv_Compressed[n].push_back( iv[n] );
-						f4_ii_Compressed[n].push_back( ii[n] );
-					}
-					lookUpMap[c] = index;
-					m_Op_index[pos[0]][pos[1]][pos[2]] = index;
-				}
-				else
-				{
-					// this operator is already in the list
-					unsigned int index = (*it).second;
-					m_Op_index[pos[0]][pos[1]][pos[2]] = index;
-				}
-			}
+			const uint64_t* data = reinterpret_cast<const uint64_t*>(cells->coeff[c] + 3*(size_t)cell);
+			for (size_t n=0; n<3*sizeof(f4vector)/sizeof(uint64_t); ++n)
+				hash = (hash ^ data[n]) * 1099511628211ULL;
 		}
+		return hash;
 	}
+};
 
-	delete f4_vv_ptr;
-	delete f4_vi_ptr;
-	delete f4_iv_ptr;
-	delete f4_ii_ptr;
-	f4_vv_ptr = NULL;
-	f4_vi_ptr = NULL;
-	f4_iv_ptr = NULL;
-	f4_ii_ptr = NULL;
-
-	return true;
-}
-
-
-
-
-// ----------------------------------------------------------------------------
-
-SSE_coeff::SSE_coeff( f4vector vv[3], f4vector vi[3], f4vector iv[3], f4vector ii[3] )
+//! Compare the coefficients of two cells bitwise
+struct SSE_CoeffEqual
 {
-	for (int n=0; n<3; n++)
+	const SSE_CoeffCells* cells;
+	bool operator()(unsigned int a, unsigned int b) const
 	{
-		m_vv[n] = vv[n];
-		m_vi[n] = vi[n];
-		m_iv[n] = iv[n];
-		m_ii[n] = ii[n];
+		for (int c=0; c<4; ++c)
+			if (memcmp(cells->coeff[c] + 3*(size_t)a, cells->coeff[c] + 3*(size_t)b, 3*sizeof(f4vector)) != 0)
+				return false;
+		return true;
 	}
-}
+};
 
-bool SSE_coeff::operator==( const SSE_coeff& other ) const
+//! Map a representative cell to the index of its unique coefficient set
+typedef unordered_map<unsigned int, unsigned int, SSE_CoeffHash, SSE_CoeffEqual> SSE_CoeffMap;
+
+//! Find the unique coefficients of the x-lines [startX, startX+numX), store the local index of each cell in Op_index and the first cell of every unique set in unique
+void FindUniqueCoeffs(const SSE_CoeffCells* cells, unsigned int startX, unsigned int numX, unsigned int numY, unsigned int numVectors, ArrayLib::ArrayIJK<unsigned int>* Op_index, vector<unsigned int>* unique)
 {
-	for (int n=0; n<3; n++)
+	SSE_CoeffMap lookUpMap(1024, SSE_CoeffHash{cells}, SSE_CoeffEqual{cells});
+	unsigned int pos[3];
+	for (pos[0]=startX; pos[0]<startX+numX; ++pos[0])
 	{
-		if (memcmp( &(m_vv[n]), &(other.m_vv[n]), sizeof(f4vector) ) != 0) return false;
-		if (memcmp( &(m_vi[n]), &(other.m_vi[n]), sizeof(f4vector) ) != 0) return false;
-		if (memcmp( &(m_iv[n]), &(other.m_iv[n]), sizeof(f4vector) ) != 0) return false;
-		if (memcmp( &(m_ii[n]), &(other.m_ii[n]), sizeof(f4vector) ) != 0) return false;
+		for (pos[1]=0; pos[1]<numY; ++pos[1])
+		{
+			unsigned int cell = (pos[0]*numY + pos[1])*numVectors;
+			for (pos[2]=0; pos[2]<numVectors; ++pos[2], ++cell)
+			{
+				pair<SSE_CoeffMap::iterator,bool> it = lookUpMap.insert(make_pair(cell, (unsigned int)unique->size()));
+				if (it.second)
+					unique->push_back(cell); // not found -> inserted
+				(*Op_index)(pos[0],pos[1],pos[2]) = it.first->second;
+			}
+		}
 	}
-	return true;
 }
-bool SSE_coeff::operator!=( const SSE_coeff& other ) const
+
+//! Replace the local indices of the x-lines [startX, startX+numX) with the global indices
+void RemapUniqueCoeffs(const vector<unsigned int>* remap, unsigned int startX, unsigned int numX, unsigned int numY, unsigned int numVectors, ArrayLib::ArrayIJK<unsigned int>* Op_index)
 {
-	return !(*this == other);
+	unsigned int pos[3];
+	for (pos[0]=startX; pos[0]<startX+numX; ++pos[0])
+		for (pos[1]=0; pos[1]<numY; ++pos[1])
+			for (pos[2]=0; pos[2]<numVectors; ++pos[2])
+				(*Op_index)(pos[0],pos[1],pos[2]) = (*remap)[(*Op_index)(pos[0],pos[1],pos[2])];
 }
-bool SSE_coeff::operator<( const SSE_coeff& other ) const
+}
+
+bool Operator_SSE_Compressed::CompressOperator()
 {
-	for (int n=0; n<3; n++)
+	if (g_settings.GetVerboseLevel()>0)
+		cout << "Compressing the FDTD operator... this may take a while..." << endl;
+
+	SSE_CoeffCells cells;
+	cells.coeff[0] = f4_vv_ptr->data();
+	cells.coeff[1] = f4_vi_ptr->data();
+	cells.coeff[2] = f4_iv_ptr->data();
+	cells.coeff[3] = f4_ii_ptr->data();
+
+	// every thread finds the unique coefficients of its x-lines using its own hash table
+	unsigned int numThreads = max(GetNumberOfCompressionThreads(), 1u);
+	vector<unsigned int> jobs = AssignJobs2Threads(numLines[0], numThreads, true);
+	vector<unsigned int> jobStart(jobs.size(), 0);
+	for (size_t t=1; t<jobs.size(); ++t)
+		jobStart.at(t) = jobStart.at(t-1) + jobs.at(t-1);
+
+	vector< vector<unsigned int> > unique(jobs.size());
+	boost::thread_group threads;
+	for (size_t t=0; t<jobs.size()-1; ++t)
+		threads.create_thread(boost::bind(&FindUniqueCoeffs, &cells, jobStart.at(t), jobs.at(t), numLines[1], numVectors, &m_Op_index, &unique.at(t)));
+	FindUniqueCoeffs(&cells, jobStart.back(), jobs.back(), numLines[1], numVectors, &m_Op_index, &unique.back());
+	threads.join_all();
+
+	// merge the per-thread tables, only the unique sets of each thread have to be compared
+	SSE_CoeffMap lookUpMap(1024, SSE_CoeffHash{&cells}, SSE_CoeffEqual{&cells});
+	vector<unsigned int> globalUnique;
+	vector< vector<unsigned int> > remap(jobs.size());
+	for (size_t t=0; t<jobs.size(); ++t)
 	{
-		for (int c=0; c<4; c++)
+		remap.at(t).resize(unique.at(t).size());
+		for (size_t n=0; n<unique.at(t).size(); ++n)
 		{
-			if (m_vv[n].f[c] > other.m_vv[n].f[c]) return false;
-			if (m_vv[n].f[c] < other.m_vv[n].f[c]) return true;
-			if (m_vi[n].f[c] > other.m_vi[n].f[c]) return false;
-			if (m_vi[n].f[c] < other.m_vi[n].f[c]) return true;
-			if (m_iv[n].f[c] > other.m_iv[n].f[c]) return false;
-			if (m_iv[n].f[c] < other.m_iv[n].f[c]) return true;
-			if (m_ii[n].f[c] > other.m_ii[n].f[c]) return false;
-			if (m_ii[n].f[c] < other.m_ii[n].f[c]) return true;
+			pair<SSE_CoeffMap::iterator,bool> it = lookUpMap.insert(make_pair(unique.at(t).at(n), (unsigned int)globalUnique.size()));
+			if (it.second)
+				globalUnique.push_back(unique.at(t).at(n));
+			remap.at(t).at(n) = it.first->second;
 		}
+		unique.at(t).clear();
 	}
-	return false;
-}
+	lookUpMap.clear();
 
-void SSE_coeff::print( ostream& stream ) const
-{
-	stream << "SSE_coeff: (" << endl;
+	for (size_t t=0; t<jobs.size()-1; ++t)
+		threads.create_thread(boost::bind(&RemapUniqueCoeffs, &remap.at(t), jobStart.at(t), jobs.at(t), numLines[1], numVectors, &m_Op_index));
+	RemapUniqueCoeffs(&remap.back(), jobStart.back(), jobs.back(), numLines[1], numVectors, &m_Op_index);
+
+	// copy the unique coefficients while the index is remapped, the compressed tables are allocated only once
 	for (int n=0; n<3; n++)
 	{
-		stream << "n=" << n << ":" << endl;
-		stream << "vv=";
-		for (int c=0; c<4; c++)
-			stream << m_vv[n].f[c] << " ";
-		stream << endl << "vi=";
-		for (int c=0; c<4; c++)
-			stream << m_vi[n].f[c] << " ";
-		stream << endl << "iv=";
-		for (int c=0; c<4; c++)
-			stream << m_iv[n].f[c] << " ";
-		stream << endl << "ii=";
-		for (int c=0; c<4; c++)
-			stream << m_ii[n].f[c] << " ";
-		stream << endl;
+		f4_vv_Compressed[n].resize(globalUnique.size());
+		f4_vi_Compressed[n].resize(globalUnique.size());
+		f4_iv_Compressed[n].resize(globalUnique.size());
+		f4_ii_Compressed[n].resize(globalUnique.size());
+		for (size_t u=0; u<globalUnique.size(); ++u)
+		{
+			size_t cell = 3*(size_t)globalUnique.at(u)+n;
+			f4_vv_Compressed[n][u] = cells.coeff[0][cell];
+			f4_vi_Compressed[n][u] = cells.coeff[1][cell];
+			f4_iv_Compressed[n][u] = cells.coeff[2][cell];
+			f4_ii_Compressed[n][u] = cells.coeff[3][cell];
+		}
 	}
-	stream << ")" << endl;
+	threads.join_all();
+
+	delete f4_vv_ptr;
+	delete f4_vi_ptr;
+	delete f4_iv_ptr;
+	delete f4_ii_ptr;
+	f4_vv_ptr = NULL;
+	f4_vi_ptr = NULL;
+	f4_iv_ptr = NULL;
+	f4_ii_ptr = NULL;
+
+	return true;
 }
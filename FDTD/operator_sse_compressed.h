@@ -22,21 +22,6 @@
 #include "tools/aligned_allocator.h"
 #include "tools/arraylib/array_ijk.h"
 
-class SSE_coeff
-{
-public:
-	SSE_coeff( f4vector vv[3], f4vector vi[3], f4vector iv[3], f4vector ii[3] );
-	bool operator==( const SSE_coeff& ) const;
-	bool operator!=( const SSE_coeff& ) const;
-	bool operator<( const SSE_coeff& ) const;
-	void print( ostream& stream ) const;
-protected:
-	f4vector m_vv[3];
-	f4vector m_vi[3];
-	f4vector m_iv[3];
-	f4vector m_ii[3];
-};
-
 class Operator_SSE_Compressed : public Operator_sse
 {
 public:
@@ -72,6 +57,9 @@ protected:
 
 	virtual int CalcECOperator( DebugFlags debugFlags = None );
 
+	//! Number of threads used to compress the operator, default is all cores
+	virtual unsigned int GetNumberOfCompressionThreads() const;
+
 	// engine needs access
 public:
 	ArrayLib::ArrayIJK<unsigned int> m_Op_index;
@@ -0,0 +1,114 @@
+function pass = pml_reflection( openEMS_options, options )
+%pass = pml_reflection( openEMS_options, options )
+%
+% Checks the reflection of the uniaxial (upml) and convolutional pml (cpml)
+% at normal incidence. A plane wave in a parallel plate line is compared with
+% a reference of a long line, which is free of reflections in the simulated
+% time window.
+
+CLEANUP = 1;        % if enabled and result is PASS, remove simulation folder
+STOP_IF_FAILED = 1; % if enabled and result is FAILED, stop with error
+SILENT = 0;         % 0=show openEMS output
+
+if nargin < 1
+    openEMS_options = '';
+end
+if nargin < 2
+    options = '';
+end
+if any(strcmp( options, 'run_testsuite' ))
+    STOP_IF_FAILED = 0;
+    SILENT = 1;
+end
+
+% max. allowed reflection, relative to the max. of the incident wave
+max_reflection = 1e-2;
+
+Sim_Path = 'tmp_pml_reflection';
+Sim_CSX = 'line.xml';
+
+[status,message,messageid] = rmdir(Sim_Path,'s');
+[status,message,messageid] = mkdir(Sim_Path);
+
+% reference: long line, the reflections of its ends do not reach the probe
+setup( Sim_Path, Sim_CSX, 400e-3, {'MUR' 'MUR'} );
+ref = run_sim( Sim_Path, Sim_CSX, openEMS_options, SILENT );
+
+% short line terminated by the pml on both sides
+setup( Sim_Path, Sim_CSX, 30e-3, {'PML_8' 'PML_8'} );
+upml = run_sim( Sim_Path, Sim_CSX, [openEMS_options ' --pml-type=upml'], SILENT );
+cpml = run_sim( Sim_Path, Sim_CSX, [openEMS_options ' --pml-type=cpml'], SILENT );
+
+pass = 1;
+u_max = max(abs(ref.val));
+if (u_max==0) || (numel(ref.val)~=numel(upml.val)) || (numel(ref.val)~=numel(cpml.val))
+    disp( 'enginetests/pml_reflection.m: invalid probe data' );
+    pass = 0;
+else
+    refl_upml = max(abs(upml.val-ref.val)) / u_max;
+    refl_cpml = max(abs(cpml.val-ref.val)) / u_max;
+    if ~SILENT
+        disp( ['enginetests/pml_reflection.m: reflection upml: ' num2str(refl_upml) ' cpml: ' num2str(refl_cpml)] );
+    end
+    if refl_upml > max_reflection
+        disp( ['enginetests/pml_reflection.m: upml reflection too large: ' num2str(refl_upml)] );
+        pass = 0;
+    end
+    if refl_cpml > max_reflection
+        disp( ['enginetests/pml_reflection.m: cpml reflection too large: ' num2str(refl_cpml)] );
+        pass = 0;
+    end
+    % the cpml must not be significantly worse than the upml (limited by the float precision of the fields)
+    if refl_cpml > 10*max(refl_upml,1e-4)
+        disp( ['enginetests/pml_reflection.m: cpml reflection (' num2str(refl_cpml) ') much larger than the upml reflection (' num2str(refl_upml) ')'] );
+        pass = 0;
+    end
+end
+
+if pass
+    disp( 'enginetests/pml_reflection.m (upml and cpml):  pass' );
+else
+    disp( 'enginetests/pml_reflection.m (upml and cpml):  * FAILED *' );
+end
+
+if pass && CLEANUP
+    rmdir( Sim_Path, 's' );
+end
+if ~pass && STOP_IF_FAILED
+    error 'test failed'
+end
+
+return
+
+
+function u = run_sim( Sim_Path, Sim_CSX, openEMS_options, SILENT )
+Settings.Silent = SILENT;
+RunOpenEMS( Sim_Path, Sim_CSX, openEMS_options, Settings );
+UI = ReadUI( 'ut', Sim_Path );
+u = UI.TD{1};
+
+
+function setup( Sim_Path, Sim_CSX, line_length, BC_z )
+% parallel plate line along z: pec plates in y, pmc walls in x, plane wave excitation at z=0
+f_max = 10e9;
+delta = 1e-3;
+
+FDTD = InitFDTD( 1000, 0 );
+FDTD = SetGaussExcite( FDTD, f_max/2, f_max/2 );
+BC = {'PMC' 'PMC' 'PEC' 'PEC' BC_z{1} BC_z{2}};
+FDTD = SetBoundaryCond( FDTD, BC );
+
+CSX = InitCSX();
+mesh.x = (0:3)*delta;
+mesh.y = (0:3)*delta;
+mesh.z = (-round(line_length/delta):round(line_length/delta))*delta;
+CSX = DefineRectGrid( CSX, 1, mesh );
+
+CSX = AddExcitation( CSX, 'excite', 0, [0 1 0] );
+CSX = AddBox( CSX, 'excite', 0, [mesh.x(1) mesh.y(1) 0], [mesh.x(end) mesh.y(end) 0] );
+
+% voltage probe between the plates, between the excitation and the upper pml
+CSX = AddProbe( CSX, 'ut', 0 );
+CSX = AddBox( CSX, 'ut', 0, [mesh.x(2) mesh.y(1) 10*delta], [mesh.x(2) mesh.y(end) 10*delta] );
+
+WriteOpenEMS( [Sim_Path '/' Sim_CSX], FDTD, CSX );
@@ -0,0 +1,136 @@
+function pass = operator_cache( openEMS_options, options )
+%pass = operator_cache( openEMS_options, options )
+%
+% Checks, if the operator cache is written by a first run, reloaded by a
+% second run and if both runs produce identical results
+
+CLEANUP = 1;        % if enabled and result is PASS, remove simulation folder
+STOP_IF_FAILED = 1; % if enabled and result is FAILED, stop with error
+SILENT = 0;         % 0=show openEMS output
+
+if nargin < 1
+    openEMS_options = '';
+end
+if nargin < 2
+    options = '';
+end
+if any(strcmp( options, 'run_testsuite' ))
+    STOP_IF_FAILED = 0;
+    SILENT = 1;
+end
+
+Sim_Path = 'tmp_operator_cache';
+Sim_CSX = 'cavity.xml';
+Cache_Path = 'cache';
+
+[status,message,messageid] = rmdir(Sim_Path,'s');
+[status,message,messageid] = mkdir(Sim_Path);
+[status,message,messageid] = mkdir([Sim_Path '/' Cache_Path]);
+
+setup( Sim_Path, Sim_CSX );
+
+% the cache directory is relative to the simulation folder
+cache_option = [' -v --operator-cache=' Cache_Path ' ' openEMS_options];
+
+% first run: calculate the operator and write the cache
+logs{1} = run_sim( Sim_Path, Sim_CSX, cache_option, 'openEMS_write.log', SILENT );
+result{1} = ReadUI( {'E_probe','H_probe'}, Sim_Path );
+cache_files = dir( [Sim_Path '/' Cache_Path '/openEMS_operator_*.bin'] );
+
+% second run: reload the cached operator
+logs{2} = run_sim( Sim_Path, Sim_CSX, cache_option, 'openEMS_read.log', SILENT );
+result{2} = ReadUI( {'E_probe','H_probe'}, Sim_Path );
+
+pass = 1;
+if numel(cache_files) ~= 1
+    disp( ['operatortests/operator_cache.m: expected one cache file, found ' num2str(numel(cache_files))] );
+    pass = 0;
+end
+if ~isempty(strfind( logs{1}, 'Using cached operator' ))
+    disp( 'operatortests/operator_cache.m: the first run must not use a cached operator' );
+    pass = 0;
+end
+if isempty(strfind( logs{2}, 'Using cached operator' )) || ~isempty(strfind( logs{2}, 'does not match' ))
+    disp( 'operatortests/operator_cache.m: the second run did not reload the cached operator' );
+    pass = 0;
+end
+for n=1:numel(result{1}.TD)
+    if (numel(result{1}.TD{n}.val) ~= numel(result{2}.TD{n}.val)) || any(result{1}.TD{n}.val ~= result{2}.TD{n}.val)
+        disp( ['operatortests/operator_cache.m: probe ' num2str(n) ' differs after reloading the operator'] );
+        pass = 0;
+    end
+end
+
+if pass
+    disp( 'operatortests/operator_cache.m (write and reload):  pass' );
+else
+    disp( 'operatortests/operator_cache.m (write and reload):  * FAILED *' );
+end
+
+if pass && CLEANUP
+    rmdir( Sim_Path, 's' );
+end
+if ~pass && STOP_IF_FAILED
+    error 'test failed'
+end
+
+return
+
+
+function log_text = run_sim( Sim_Path, Sim_CSX, openEMS_options, logfile, SILENT )
+folder = fileparts( mfilename('fullpath') );
+Settings.LogFile = [folder '/' Sim_Path '/' logfile];
+Settings.Silent = SILENT;
+RunOpenEMS( Sim_Path, Sim_CSX, openEMS_options, Settings );
+log_text = fileread( Settings.LogFile );
+
+
+function setup( Sim_Path, Sim_CSX )
+physical_constants;
+
+a = 5e-2;
+b = 2e-2;
+d = 6e-2;
+
+f_start = 1e9;
+f_stop = 10e9;
+
+FDTD = InitFDTD( 1000, 0 );
+FDTD = SetGaussExcite(FDTD,(f_stop-f_start)/2,(f_stop-f_start)/2);
+BC = {'MUR' 'PML_8' 'PMC' 'PEC' 'PEC' 'PEC'}; % boundaries
+FDTD = SetBoundaryCond(FDTD,BC);
+
+CSX = InitCSX();
+mesh.x = linspace(0,a,27);
+mesh.y = linspace(0,b,11);
+mesh.z = linspace(0,d,33);
+CSX = DefineRectGrid(CSX, 1,mesh);
+
+% excitation
+CSX = AddExcitation(CSX,'excite1',0,[1 1 1]);
+p(1,1) = mesh.x(floor(end*2/3));
+p(2,1) = mesh.y(floor(end*2/3));
+p(3,1) = mesh.z(floor(end*2/3));
+p(1,2) = mesh.x(floor(end*2/3)+1);
+p(2,2) = mesh.y(floor(end*2/3)+1);
+p(3,2) = mesh.z(floor(end*2/3)+1);
+CSX = AddCurve( CSX, 'excite1', 0, p );
+
+% probes
+CSX = AddProbe( CSX, 'E_probe', 2 );
+p(1,1) = mesh.x(floor(end*1/3));
+p(2,1) = mesh.y(floor(end*1/3));
+p(3,1) = mesh.z(floor(end*1/3));
+CSX = AddPoint( CSX, 'E_probe', 0, p );
+CSX = AddProbe( CSX, 'H_probe', 3 );
+CSX = AddPoint( CSX, 'H_probe', 0, p );
+
+% material and metal, both are part of the cached operator
+CSX = AddMaterial( CSX, 'RO4350B', 'Epsilon', 3.66, 'Kappa', 0.01 );
+start = [mesh.x(3) mesh.y(3) mesh.z(3)];
+stop  = [mesh.x(5) mesh.y(4) mesh.z(6)];
+CSX = AddBox( CSX, 'RO4350B', 100, start, stop );
+CSX = AddMetal( CSX, 'plate' );
+CSX = AddBox( CSX, 'plate', 100, [mesh.x(10) mesh.y(1) mesh.z(20)], [mesh.x(14) mesh.y(end) mesh.z(20)] );
+
+WriteOpenEMS( [Sim_Path '/' Sim_CSX], FDTD, CSX );
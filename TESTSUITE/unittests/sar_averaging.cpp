@@ -0,0 +1,172 @@
+/*
+*	Copyright (C) 2026 Thorsten Liebig (Thorsten.Liebig@gmx.de)
+*
+*	This program is free software: you can redistribute it and/or modify
+*	it under the terms of the GNU General Public License as published by
+*	the Free Software Foundation, either version 3 of the License, or
+*	(at your option) any later version.
+*
+*	This program is distributed in the hope that it will be useful,
+*	but WITHOUT ANY WARRANTY; without even the implied warranty of
+*	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*	GNU General Public License for more details.
+*
+*	You should have received a copy of the GNU General Public License
+*	along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+// Regression test of the summed-volume SAR averaging (SAR_Calculation::CalcSAR).
+// The averaged SAR of a fixed phantom is compared with reference values of the previous
+// brute-force averaging (which summed up every trial cube voxel by voxel).
+
+#include <cmath>
+#include <complex>
+#include <iostream>
+#include "tools/sar_calculation.h"
+#include "tools/array_ops.h"
+
+using namespace std;
+
+#define SAR_TEST_LINES 14
+
+//! Reference values of the brute-force averaging for every averaging method
+struct SAR_Reference
+{
+	const char* method;
+	double sum;          //!< sum of the SAR of all voxel
+	double weighted_sum; //!< sum of the SAR of all voxel weighted with (1+linear_index%7)
+	double max;          //!< max. SAR
+	double probe[4];     //!< SAR at the probe voxel, see probe_pos
+};
+
+static const unsigned int probe_pos[4][3] = {{7,7,7}, {3,7,7}, {7,2,9}, {0,0,0}};
+
+static const SAR_Reference references[] = {
+	{"IEEE_62704", 0.703357103, 2.84646862, 0.00101092667, {0.00088082155, 0.000946786255, 0.00100222963, 0}},
+	{"IEEE_C95_3", 0.721403241, 2.91934057, 0.00101213902, {0.000880879292, 0.000998432282, 0.00101213902, 0}},
+	{"Simple",     0.691237267, 2.79552004, 0.00104081444, {0.000880879292, 0.000877557613, 0.0010022244, 0}},
+};
+
+//! Deterministic pseudo random numbers in [0,1), identical on all platforms
+static float Random()
+{
+	static unsigned int seed = 12345;
+	seed = seed*1664525u + 1013904223u;
+	return (seed>>8)/16777216.0f;
+}
+
+//! Fixed phantom: an ellipsoid with varying density and conductivity on a non-uniform mesh
+static void CreatePhantom(unsigned int numLines[3], float* cellWidth[3], float*** density, float*** volume, float*** kappa, complex<float>**** E_field)
+{
+	for (int n=0; n<3; ++n)
+		for (unsigned int i=0; i<numLines[n]; ++i)
+			cellWidth[n][i] = 2e-3*(0.7+0.6*Random());
+
+	unsigned int pos[3];
+	for (pos[0]=0; pos[0]<numLines[0]; ++pos[0])
+		for (pos[1]=0; pos[1]<numLines[1]; ++pos[1])
+			for (pos[2]=0; pos[2]<numLines[2]; ++pos[2])
+			{
+				double r = 0;
+				for (int n=0; n<3; ++n)
+					r += pow((pos[n]-numLines[n]/2.0)/(0.4*numLines[n]), 2);
+				bool inside = r<1;
+				density[pos[0]][pos[1]][pos[2]] = inside ? 900+300*Random() : 0;
+				volume[pos[0]][pos[1]][pos[2]] = cellWidth[0][pos[0]]*cellWidth[1][pos[1]]*cellWidth[2][pos[2]];
+				kappa[pos[0]][pos[1]][pos[2]] = inside ? 0.5+Random() : 0;
+				for (int n=0; n<3; ++n)
+				{
+					float re = Random();
+					E_field[n][pos[0]][pos[1]][pos[2]] = complex<float>(re, Random());
+				}
+			}
+}
+
+static bool Compare(const string& name, double value, double reference, double tolerance=1e-4)
+{
+	if (fabs(value-reference) <= tolerance*max(fabs(reference), 1e-12))
+		return true;
+	cerr << "sar_averaging: " << name << " is " << value << ", expected " << reference << endl;
+	return false;
+}
+
+//! Calculate the averaged SAR of the phantom with the given method and number of threads
+static float*** CalcAveragedSAR(const char* method, unsigned int numThreads, unsigned int numLines[3], float* cellWidth[3],
+								float*** density, float*** volume, float*** kappa, complex<float>**** E_field)
+{
+	SAR_Calculation SAR_Calc;
+	SAR_Calc.SetAveragingMethod(method, true);
+	SAR_Calc.SetNumThreads(numThreads);
+	SAR_Calc.SetNumLines(numLines);
+	SAR_Calc.SetAveragingMass(1e-3);
+	SAR_Calc.SetCellDensities(density);
+	SAR_Calc.SetCellWidth(cellWidth);
+	SAR_Calc.SetCellVolumes(volume);
+	SAR_Calc.SetCellCondictivity(kappa);
+	SAR_Calc.SetEField(E_field);
+	return SAR_Calc.CalcSAR(Create3DArray<float>(numLines));
+}
+
+int main()
+{
+	unsigned int numLines[3] = {SAR_TEST_LINES, SAR_TEST_LINES, SAR_TEST_LINES};
+	float* cellWidth[3];
+	for (int n=0; n<3; ++n)
+		cellWidth[n] = new float[numLines[n]];
+	float*** density = Create3DArray<float>(numLines);
+	float*** volume = Create3DArray<float>(numLines);
+	float*** kappa = Create3DArray<float>(numLines);
+	complex<float>**** E_field = Create_N_3DArray<complex<float> >(numLines);
+	CreatePhantom(numLines, cellWidth, density, volume, kappa, E_field);
+
+	bool pass = true;
+	for (size_t m=0; m<sizeof(references)/sizeof(references[0]); ++m)
+	{
+		const SAR_Reference& ref = references[m];
+		float*** SAR = CalcAveragedSAR(ref.method, 1, numLines, cellWidth, density, volume, kappa, E_field);
+		float*** SAR_MT = CalcAveragedSAR(ref.method, 3, numLines, cellWidth, density, volume, kappa, E_field);
+
+		double sum = 0, weighted_sum = 0, max_SAR = 0;
+		unsigned int pos[3];
+		unsigned int mismatch_MT = 0;
+		for (pos[0]=0; pos[0]<numLines[0]; ++pos[0])
+			for (pos[1]=0; pos[1]<numLines[1]; ++pos[1])
+				for (pos[2]=0; pos[2]<numLines[2]; ++pos[2])
+				{
+					double val = SAR[pos[0]][pos[1]][pos[2]];
+					sum += val;
+					weighted_sum += val*(1+((pos[0]*numLines[1]+pos[1])*numLines[2]+pos[2])%7);
+					max_SAR = max(max_SAR, val);
+					if (SAR_MT[pos[0]][pos[1]][pos[2]]!=SAR[pos[0]][pos[1]][pos[2]])
+						++mismatch_MT;
+				}
+
+		string method(ref.method);
+		pass &= Compare(method + " SAR sum", sum, ref.sum);
+		pass &= Compare(method + " weighted SAR sum", weighted_sum, ref.weighted_sum);
+		pass &= Compare(method + " max. SAR", max_SAR, ref.max);
+		for (int p=0; p<4; ++p)
+			pass &= Compare(method + " probe SAR", SAR[probe_pos[p][0]][probe_pos[p][1]][probe_pos[p][2]], ref.probe[p]);
+		if (mismatch_MT>0)
+		{
+			cerr << "sar_averaging: " << method << " multithreaded SAR differs in " << mismatch_MT << " voxel" << endl;
+			pass = false;
+		}
+
+		Delete3DArray(SAR, numLines);
+		Delete3DArray(SAR_MT, numLines);
+	}
+
+	Delete3DArray(density, numLines);
+	Delete3DArray(volume, numLines);
+	Delete3DArray(kappa, numLines);
+	Delete_N_3DArray(E_field, numLines);
+	for (int n=0; n<3; ++n)
+		delete[] cellWidth[n];
+
+	if (pass)
+		cout << "sar_averaging: pass" << endl;
+	else
+		cout << "sar_averaging: * FAILED *" << endl;
+	return pass ? 0 : 1;
+}
@@ -21,6 +21,9 @@ function hdf_fielddata = ReadHDF5FieldData(file)
 %
 %     plot( hdf_fielddata.TD.values{12}(1,:,1,3) )
 %
+% Time domain dumps written with the option --extendibleTDFieldDumps are
+% returned in the same format.
+%
 % openEMS matlab interface
 % -----------------------
 % author: Thorsten Liebig
@@ -55,7 +58,18 @@ for n=1:numel(info.GroupHierarchy.Groups)
     end
 end
 
-if (numel(TD.names)>0)
+if any(strcmp(TD.names,'/FieldData/TD/values'))
+    % extendible layout: all timesteps in one dataset (x,y,z,polarization,timestep)
+    values = double(hdf5read(file,'/FieldData/TD/values'));
+    timestep = double(hdf5read(file,'/FieldData/TD/timestep'));
+    hdf_fielddata.TD.time = double(hdf5read(file,'/FieldData/TD/time'))';
+    hdf_fielddata.TD.names = {};
+    for n=1:numel(timestep)
+        hdf_fielddata.TD.names{n} = sprintf('/FieldData/TD/%08d',timestep(n));
+        hdf_fielddata.TD.values{n} = values(:,:,:,:,n);
+    end
+    hdf_fielddata.TD.DataType = 0; %real value data
+elseif (numel(TD.names)>0)
     hdf_fielddata.TD=TD;
     hdf_fielddata.TD.DataType = 0; %real value data
     for n=1:numel(hdf_fielddata.TD.names)
@@ -90,7 +104,17 @@ hdf = load( '-hdf5', file );
 if ~isfield(hdf,'FieldData')
     error('no field data found')
 end
-if isfield(hdf.FieldData,'TD')
+if isfield(hdf.FieldData,'TD') && isfield(hdf.FieldData.TD,'values')
+    %read TD data, extendible layout: all timesteps in one dataset
+    timestep = double(hdf.FieldData.TD.timestep);
+    time = double(hdf.FieldData.TD.time);
+    for n=1:numel(timestep)
+        hdf_fielddata.TD.values{n} = double(hdf.FieldData.TD.values(:,:,:,:,n));
+        hdf_fielddata.TD.names{n} = sprintf('/FieldData/TD/%08d',timestep(n));
+        hdf_fielddata.TD.time(n) = time(n);
+    end
+    hdf_fielddata.TD.DataType = 0; %real value data
+elseif isfield(hdf.FieldData,'TD')
     %read TD data
     hdf_fielddata_names = fieldnames(hdf.FieldData.TD);
     for n=1:numel(hdf_fielddata_names)
@@ -2,6 +2,7 @@ function UI = ReadUI(files, path, freq, varargin)
 % function UI = ReadUI(files, path, freq, varargin)
 %
 % read current and voltages from multiple files found in path
+% (ascii or hdf5 probe files, e.g. 'port_ut1' or 'port_ut1.h5')
 %
 % returns voltages/currents in time and frequency-domain
 %
@@ -62,7 +63,18 @@ end
 UI.TD = {};
 UI.FD = {};
 for n=1:numel(filenames)
-    tmp = load( fullfile(path,filenames{n}) );
+    h5_file = fullfile(path,[filenames{n} '.h5']);
+    if exist(h5_file,'file')
+        % hdf5 probe file, see openEMS option --probe-file-type
+        if isOctave
+            hdf = load( '-hdf5', h5_file );
+            tmp = double(hdf.TD)';
+        else
+            tmp = double(h5read(h5_file,'/TD'))';
+        end
+    else
+        tmp = load( fullfile(path,filenames{n}) );
+    end
     t = tmp(:,1)';
     val = tmp(:,2)';
     
@@ -25,8 +25,21 @@ function RunOpenEMS(Sim_Path, Sim_File, opts, Settings)
 %          --engine=sse-compressed  engine using compressed operator + sse vector extensions
 %          --engine=MPI             engine using compressed operator + sse vector extensions + MPI parallel processing
 %          --engine=multithreaded   engine using compressed operator + sse vector extensions + MPI + multithreading
+%          --engine=tiling          multithreaded engine using temporal blocking
 %      --numThreads=<n>     Force use n threads for multithreaded engine
+%      --workStealing       Distribute the updates as small tiles with work stealing between threads
+%      --tilesPerThread=<n> Number of tiles per thread for work stealing (default 8)
+%      --tilingSteps=<n>    Number of timesteps per tile for the tiling engine (default 8)
+%      --tilingWidth=<n>    Tile width in x-lines for the tiling engine (default 0: automatic)
+%      --asyncFieldDumps    write time domain field dumps in a background thread
 %      --no-simulation      only run preprocessing; do not simulate
+%      --disable-engine-sampling  process probes from the main loop instead of
+%                           sampling them during the engine iterations
+%      --pml-type=<type>    Choose the pml implementation
+%          --pml-type=upml          uniaxial pml (default)
+%          --pml-type=cpml          convolutional pml, less memory (cartesian meshes only)
+%      --operator-cache=<dir> store the operator in <dir> and reload it for
+%                           runs with identical geometry, mesh and timestep
 %      --dump-statistics    dump simulation statistics to 'openEMS_run_stats.txt' and 'openEMS_stats.txt'
 %
 %       Additional global arguments
@@ -5,6 +5,12 @@ function FDTD = SetupMPI(FDTD, varargin)
 %     % and split the FDTD mesh in 3 parts in z-direction, split at z=-500 and z=500
 %     % this will need a Settings.MPI.NrProc of 2*3=6
 %     FDTD = SetupMPI(FDTD,'SplitN_X',2 ,'SplitPos_Z', '-500,500');
+%
+%     % example, let openEMS choose a load balanced split for all processes,
+%     % taking PML, dispersive materials and lumped elements into account.
+%     % Restrict to splits in x- and z-direction only using 'xz' instead of 1.
+%     % This is also the default if no split positions or numbers are given.
+%     FDTD = SetupMPI(FDTD,'SplitAuto',1);
 % 
 % See also RunOpenEMS_MPI
 % 
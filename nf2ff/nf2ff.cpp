@@ -51,13 +51,9 @@ nf2ff::nf2ff(vector<float> freq, vector<float> theta, vector<float> phi, vector<
 	for (size_t n=0;n<m_numPhi;++n)
 		 m_phi[n]=phi.at(n);
 
-	m_nf2ff.resize(freq.size(),NULL);
-	for (size_t fn=0;fn<freq.size();++fn)
-	{
-		m_nf2ff.at(fn) = new nf2ff_calc(freq.at(fn),theta, phi, center);
-		if (numThreads)
-			m_nf2ff.at(fn)->SetNumThreads(numThreads);
-	}
+	m_nf2ff = new nf2ff_calc(freq, theta, phi, center);
+	if (numThreads)
+		m_nf2ff->SetNumThreads(numThreads);
 	m_radius = 1;
 	m_Verbose = 0;
 }
@@ -65,9 +61,8 @@ nf2ff::nf2ff(vector<float> freq, vector<float> theta, vector<float> phi, vector<
 nf2ff::~nf2ff()
 {
 	m_freq.clear();
-	for (size_t fn=0;fn<m_nf2ff.size();++fn)
-		delete m_nf2ff.at(fn);
-	m_nf2ff.clear();
+	delete m_nf2ff;
+	m_nf2ff = NULL;
 
 	delete[] m_phi;
 	m_phi = NULL;
@@ -78,8 +73,7 @@ nf2ff::~nf2ff()
 void nf2ff::SetRadius(float radius)
 {
 	m_radius = radius;
-	for (size_t fn=0;fn<m_nf2ff.size();++fn)
-		m_nf2ff.at(fn)->SetRadius(radius);
+	m_nf2ff->SetRadius(radius);
 }
 
 void nf2ff::SetPermittivity(vector<float> permittivity)
@@ -88,20 +82,12 @@ void nf2ff::SetPermittivity(vector<float> permittivity)
 		return;
 
 	m_permittivity = permittivity;
-	if (permittivity.size()==1)
-	{
-		for (size_t fn=0;fn<m_nf2ff.size();++fn)
-			m_nf2ff.at(fn)->SetPermittivity(permittivity.at(0));
-		return;
-	}
-
-	if (permittivity.size()!=m_freq.size())
+	if ((permittivity.size()!=1) && (permittivity.size()!=m_freq.size()))
 	{
 		cerr << __func__ << ": Error, permittivity vector size must match number of set frequencies! skipping!" << endl;
 		return;
 	}
-	for (size_t fn=0;fn<m_nf2ff.size();++fn)
-		m_nf2ff.at(fn)->SetPermittivity(permittivity.at(fn));
+	m_nf2ff->SetPermittivity(permittivity);
 }
 
 void nf2ff::SetPermeability(vector<float> permeability)
@@ -110,54 +96,45 @@ void nf2ff::SetPermeability(vector<float> permeability)
 		return;
 
 	m_permeability = permeability;
-	if (permeability.size()==1)
-	{
-		for (size_t fn=0;fn<m_nf2ff.size();++fn)
-			m_nf2ff.at(fn)->SetPermeability(permeability.at(0));
-		return;
-	}
-
-	if (permeability.size()!=m_freq.size())
+	if ((permeability.size()!=1) && (permeability.size()!=m_freq.size()))
 	{
 		cerr << __func__ << ": Error, permeability vector size must match number of set frequencies! skipping!" << endl;
 		return;
 	}
-	for (size_t fn=0;fn<m_nf2ff.size();++fn)
-		m_nf2ff.at(fn)->SetPermeability(permeability.at(fn));
+	m_nf2ff->SetPermeability(permeability);
 }
 
 void nf2ff::SetMirror(int type, int dir, float pos)
 {
 	if (m_Verbose>0)
 		cerr << "Enable mirror of type: "<< type << " in direction: " << dir << " at: " << pos << endl;
-	for (size_t fn=0;fn<m_nf2ff.size();++fn)
-		m_nf2ff.at(fn)->SetMirror(type, dir, pos);
+	m_nf2ff->SetMirror(type, dir, pos);
 }
 
 
 double nf2ff::GetTotalRadPower(size_t f_idx) const
 {
-	return m_nf2ff.at(f_idx)->GetTotalRadPower();
+	return m_nf2ff->GetTotalRadPower(f_idx);
 }
 
 double nf2ff::GetMaxDirectivity(size_t f_idx) const
 {
-	return m_nf2ff.at(f_idx)->GetMaxDirectivity();
+	return m_nf2ff->GetMaxDirectivity(f_idx);
 }
 
 complex<double>** nf2ff::GetETheta(size_t f_idx) const
 {
-	return m_nf2ff.at(f_idx)->GetETheta();
+	return m_nf2ff->GetETheta(f_idx);
 }
 
 complex<double>** nf2ff::GetEPhi(size_t f_idx) const
 {
-	return m_nf2ff.at(f_idx)->GetEPhi();
+	return m_nf2ff->GetEPhi(f_idx);
 }
 
 double** nf2ff::GetRadPower(size_t f_idx) const
 {
-	return m_nf2ff.at(f_idx)->GetRadPower();
+	return m_nf2ff->GetRadPower(f_idx);
 }
 
 bool nf2ff::AnalyseXMLNode(TiXmlElement* ti_nf2ff)
@@ -465,7 +442,7 @@ bool nf2ff::AnalyseFile(string E_Field_file, string H_Field_file)
 		}
 		if ((data_size[0]!=E_numLines[0]) || (data_size[1]!=E_numLines[1]) || (data_size[2]!=E_numLines[2]) )
 		{
-			for (size_t fn=0;fn<m_nf2ff.size();++fn)
+			for (size_t fn=0;fn<m_freq.size();++fn)
 			{
 				Delete_N_3DArray<complex<float> >(E_fd_data.at(fn),data_size);
 			}
@@ -476,7 +453,7 @@ bool nf2ff::AnalyseFile(string E_Field_file, string H_Field_file)
 
 		if (H_file.CalcFDVectorData(m_freq,H_fd_data,data_size)==false)
 		{
-			for (size_t fn=0;fn<m_nf2ff.size();++fn)
+			for (size_t fn=0;fn<m_freq.size();++fn)
 				Delete_N_3DArray<complex<float> >(E_fd_data.at(fn),data_size);
 			for (int n=0;n<3;++n)
 				delete[] E_lines[n];
@@ -484,7 +461,7 @@ bool nf2ff::AnalyseFile(string E_Field_file, string H_Field_file)
 		}
 		if ((data_size[0]!=E_numLines[0]) || (data_size[1]!=E_numLines[1]) || (data_size[2]!=E_numLines[2]) )
 		{
-			for (size_t fn=0;fn<m_nf2ff.size();++fn)
+			for (size_t fn=0;fn<m_freq.size();++fn)
 			{
 				Delete_N_3DArray<complex<float> >(E_fd_data.at(fn),data_size);
 				Delete_N_3DArray<complex<float> >(H_fd_data.at(fn),data_size);
@@ -495,63 +472,49 @@ bool nf2ff::AnalyseFile(string E_Field_file, string H_Field_file)
 		}
 
 		if (m_Verbose>0)
-			cerr << "nf2ff: Analysing far-field for " <<  m_nf2ff.size() << " frequencies.  " << endl;
-
-		for (size_t fn=0;fn<m_nf2ff.size();++fn)
-		{
-			if (m_Verbose>1)
-				cerr << "nf2ff: f = " << m_freq.at(fn) << "Hz (" << fn+1 << "/" << m_freq.size() << ") ...";
-			m_nf2ff.at(fn)->AddPlane(E_lines, E_numLines, E_fd_data.at(fn), H_fd_data.at(fn),E_meshType);
-			if (m_Verbose>1)
-				cerr << " done." << endl;
-		}
+			cerr << "nf2ff: Analysing far-field for " <<  m_freq.size() << " frequencies.  " << endl;
 
+		m_nf2ff->AddPlane(E_lines, E_numLines, E_fd_data, H_fd_data, E_meshType);
 	}
 	else
 	{
-		complex<float>**** E_fd_data;
-		complex<float>**** H_fd_data;
+		vector<complex<float>****> E_fd_data;
+		vector<complex<float>****> H_fd_data;
+		complex<float>**** E_data;
+		complex<float>**** H_data;
 		unsigned int data_size[4];
 		for (size_t n=0;n<m_freq.size();++n)
 		{
-			E_fd_data = E_file.GetFDVectorData(FD_index.at(n),data_size);
-			if ((data_size[0]!=E_numLines[0]) || (data_size[1]!=E_numLines[1]) || (data_size[2]!=E_numLines[2]) )
+			E_data = E_file.GetFDVectorData(FD_index.at(n),data_size);
+			H_data = H_file.GetFDVectorData(FD_index.at(n),data_size);
+			if ((E_data==NULL) || (H_data==NULL) || (data_size[0]!=E_numLines[0]) || (data_size[1]!=E_numLines[1]) || (data_size[2]!=E_numLines[2]) )
 			{
-				cerr << data_size[0] << "," << data_size[1] << "," <<  data_size[2] << endl;
-				cerr << "nf2ff::AnalyseFile: FD data size mismatch... " << endl;
-				Delete_N_3DArray<complex<float> >(E_fd_data,data_size);
+				if ((E_data==NULL) || (H_data==NULL))
+					cerr << "nf2ff::AnalyseFile: Reaing FD data failed... " << endl;
+				else
+				{
+					cerr << data_size[0] << "," << data_size[1] << "," <<  data_size[2] << endl;
+					cerr << "nf2ff::AnalyseFile: FD data size mismatch... " << endl;
+				}
+				Delete_N_3DArray<complex<float> >(E_data,data_size);
+				Delete_N_3DArray<complex<float> >(H_data,data_size);
+				for (size_t fn=0;fn<E_fd_data.size();++fn)
+				{
+					Delete_N_3DArray<complex<float> >(E_fd_data.at(fn),E_numLines);
+					Delete_N_3DArray<complex<float> >(H_fd_data.at(fn),E_numLines);
+				}
 				for (int n=0;n<3;++n)
 					delete[] E_lines[n];
 				return false;
 			}
+			E_fd_data.push_back(E_data);
+			H_fd_data.push_back(H_data);
+		}
 
-			H_fd_data = H_file.GetFDVectorData(FD_index.at(n),data_size);
-			if ((data_size[0]!=E_numLines[0]) || (data_size[1]!=E_numLines[1]) || (data_size[2]!=E_numLines[2]) )
-			{
-				cerr << data_size[0] << "," << data_size[1] << "," <<  data_size[2] << endl;
-				cerr << "nf2ff::AnalyseFile: FD data size mismatch... " << endl;
-				Delete_N_3DArray<complex<float> >(H_fd_data,data_size);
-				Delete_N_3DArray<complex<float> >(E_fd_data,data_size);
-				for (int n=0;n<3;++n)
-					delete[] E_lines[n];
-				return false;
-			}
+		if (m_Verbose>0)
+			cerr << "nf2ff: Analysing far-field for " <<  m_freq.size() << " frequencies.  " << endl;
 
-			if ((E_fd_data==NULL) || (H_fd_data==NULL))
-			{
-				cerr << "nf2ff::AnalyseFile: Reaing FD data failed... " << endl;
-				Delete_N_3DArray<complex<float> >(E_fd_data,data_size);
-				Delete_N_3DArray<complex<float> >(H_fd_data,data_size);
-				for (int n=0;n<3;++n)
-					delete[] E_lines[n];
-				return false;
-			}
-			if (m_Verbose>1)
-				cerr << "nf2ff: f = " << m_freq.at(n) << "Hz (" << n+1 << "/" << m_freq.size() << ") ...";
-			m_nf2ff.at(n)->AddPlane(E_lines, E_numLines, E_fd_data, H_fd_data,E_meshType);
-			if (m_Verbose>1)
-				cerr << " done." << endl;
-		}
+		m_nf2ff->AddPlane(E_lines, E_numLines, E_fd_data, H_fd_data, E_meshType);
 	}
 
 	for (int n=0;n<3;++n)
@@ -560,6 +523,13 @@ bool nf2ff::AnalyseFile(string E_Field_file, string H_Field_file)
 	return true;
 }
 
+bool nf2ff::AddPlane(float **lines, unsigned int* numLines, vector<complex<float>****> &E_field, vector<complex<float>****> &H_field, int MeshType)
+{
+	if (m_Verbose>0)
+		cerr << "nf2ff: Analysing far-field for " <<  m_freq.size() << " frequencies.  " << endl;
+	return m_nf2ff->AddPlane(lines, numLines, E_field, H_field, MeshType);
+}
+
 bool nf2ff::Write2HDF5(string filename)
 {
 	HDF5_File_Writer hdf_file(filename);
@@ -48,6 +48,9 @@ public:
 
 	bool AnalyseFile(string E_Field_file, string H_Field_file);
 
+	//! Add a nf2ff plane with the E- and H-field data for all frequencies, the field data will be deleted afterwards
+	bool AddPlane(float **lines, unsigned int* numLines, vector<complex<float>****> &E_field, vector<complex<float>****> &H_field, int MeshType=0);
+
 	void SetRadius(float radius);
 	void SetPermittivity(vector<float> permittivity);
 	void SetPermeability(vector<float> permeability);
@@ -79,7 +82,7 @@ protected:
 	float* m_phi;
 	float m_radius;
 	int m_Verbose;
-	vector<nf2ff_calc*> m_nf2ff;
+	nf2ff_calc* m_nf2ff;
 };
 
 #endif // NF2FF_H
@@ -29,19 +29,65 @@
 
 using namespace std;
 
-nf2ff_calc_thread::nf2ff_calc_thread(nf2ff_calc* nfc, unsigned int start, unsigned int stop, unsigned int threadID, nf2ff_data &data)
+nf2ff_calc_thread::nf2ff_calc_thread(nf2ff_calc* nfc, unsigned int start, unsigned int stop, unsigned int jobStart, unsigned int jobStop, unsigned int threadID, nf2ff_data &data)
 {
 	m_nf_calc = nfc;
 	m_start = start;
 	m_stop = stop;
+	m_jobStart = jobStart;
+	m_jobStop = jobStop;
 	m_threadID = threadID;
 	m_data = data;
+
+	m_phP_re = m_phP_im = NULL;
+	m_phPP_re = m_phPP_im = NULL;
+	m_S = NULL;
+	m_A = NULL;
 }
 
 void nf2ff_calc_thread::operator()()
 {
 	m_nf_calc->m_Barrier->wait(); // start
 
+	// calc Js and Ms for the lines of this thread
+	CalcSurfaceCurrents();
+
+	m_nf_calc->m_Barrier->wait(); // all surface currents are available
+
+	int ny = m_data.ny;
+	unsigned int numP = m_data.numLines[(ny+1)%3];
+	unsigned int numPP = m_data.numLines[(ny+2)%3];
+
+	m_phP_re = new float[numP*NF2FF_ANGLE_BLOCK];
+	m_phP_im = new float[numP*NF2FF_ANGLE_BLOCK];
+	m_phPP_re = new float[numPP*NF2FF_ANGLE_BLOCK];
+	m_phPP_im = new float[numPP*NF2FF_ANGLE_BLOCK];
+	m_S = new float[12*NF2FF_ANGLE_BLOCK];
+	m_A = new double[12*NF2FF_ANGLE_BLOCK];
+
+	// every job is a block of angles at a single frequency
+	unsigned int numAngles = m_nf_calc->m_numAngles;
+	unsigned int numBlocks = (numAngles+NF2FF_ANGLE_BLOCK-1)/NF2FF_ANGLE_BLOCK;
+	for (unsigned int job=m_jobStart; job<m_jobStop; ++job)
+	{
+		unsigned int f_idx = job/numBlocks;
+		unsigned int a_start = (job%numBlocks)*NF2FF_ANGLE_BLOCK;
+		unsigned int a_num = min((unsigned int)NF2FF_ANGLE_BLOCK, numAngles-a_start);
+		CalcRadiationVectors(f_idx, a_start, a_num);
+	}
+
+	delete[] m_phP_re; m_phP_re=NULL;
+	delete[] m_phP_im; m_phP_im=NULL;
+	delete[] m_phPP_re; m_phPP_re=NULL;
+	delete[] m_phPP_im; m_phPP_im=NULL;
+	delete[] m_S; m_S=NULL;
+	delete[] m_A; m_A=NULL;
+
+	m_nf_calc->m_Barrier->wait(); //wait for termination
+}
+
+void nf2ff_calc_thread::CalcSurfaceCurrents()
+{
 	int ny = m_data.ny;
 	int nP = (ny+1)%3;
 	int nPP = (ny+2)%3;
@@ -49,123 +95,199 @@ void nf2ff_calc_thread::operator()()
 	unsigned int* numLines = m_data.numLines;
 	float* normDir = m_data.normDir;
 	float **lines = m_data.lines;
-	float* edge_length_P = m_data.edge_length_P;
-	float* edge_length_PP = m_data.edge_length_PP;
 
 	unsigned int pos[3];
 	unsigned int pos_t=0;
 	unsigned int num_t=m_stop-m_start+1;
 
-
-	complex<float>**** Js=m_data.Js;
-	complex<float>**** Ms=m_data.Ms;
-	complex<float>**** E_field=m_data.E_field;
-	complex<float>**** H_field=m_data.H_field;
-
 	int mesh_type = m_data.mesh_type;
 
-	// calc Js and Ms (eq. 8.15a/b)
-	pos[ny]=0;
-	for (pos_t=0; pos_t<num_t; ++pos_t)
+	for (size_t fn=0; fn<m_data.Js->size(); ++fn)
 	{
-		pos[nP] = m_start+pos_t;
-		for (pos[nPP]=0; pos[nPP]<numLines[nPP]; ++pos[nPP])
+		complex<float>**** Js=m_data.Js->at(fn);
+		complex<float>**** Ms=m_data.Ms->at(fn);
+		complex<float>**** E_field=m_data.E_field->at(fn);
+		complex<float>**** H_field=m_data.H_field->at(fn);
+
+		// calc Js and Ms (eq. 8.15a/b)
+		pos[ny]=0;
+		for (pos_t=0; pos_t<num_t; ++pos_t)
 		{
-			// Js =  n x H
-			Js[0][pos[0]][pos[1]][pos[2]] = normDir[1]*H_field[2][pos[0]][pos[1]][pos[2]] - normDir[2]*H_field[1][pos[0]][pos[1]][pos[2]];
-			Js[1][pos[0]][pos[1]][pos[2]] = normDir[2]*H_field[0][pos[0]][pos[1]][pos[2]] - normDir[0]*H_field[2][pos[0]][pos[1]][pos[2]];
-			Js[2][pos[0]][pos[1]][pos[2]] = normDir[0]*H_field[1][pos[0]][pos[1]][pos[2]] - normDir[1]*H_field[0][pos[0]][pos[1]][pos[2]];
-
-			// Ms = -n x E
-			Ms[0][pos[0]][pos[1]][pos[2]] = normDir[2]*E_field[1][pos[0]][pos[1]][pos[2]] - normDir[1]*E_field[2][pos[0]][pos[1]][pos[2]];
-			Ms[1][pos[0]][pos[1]][pos[2]] = normDir[0]*E_field[2][pos[0]][pos[1]][pos[2]] - normDir[2]*E_field[0][pos[0]][pos[1]][pos[2]];
-			Ms[2][pos[0]][pos[1]][pos[2]] = normDir[1]*E_field[0][pos[0]][pos[1]][pos[2]] - normDir[0]*E_field[1][pos[0]][pos[1]][pos[2]];
-
-			//transform to cartesian coordinates
-			if (mesh_type==1)
+			pos[nP] = m_start+pos_t;
+			for (pos[nPP]=0; pos[nPP]<numLines[nPP]; ++pos[nPP])
 			{
-				Js[0][pos[0]][pos[1]][pos[2]] = (normDir[1]*H_field[2][pos[0]][pos[1]][pos[2]] - normDir[2]*H_field[1][pos[0]][pos[1]][pos[2]])*cos(lines[1][pos[1]]) \
-						- (normDir[2]*H_field[0][pos[0]][pos[1]][pos[2]] - normDir[0]*H_field[2][pos[0]][pos[1]][pos[2]])*sin(lines[1][pos[1]]);
-				Js[1][pos[0]][pos[1]][pos[2]] = (normDir[1]*H_field[2][pos[0]][pos[1]][pos[2]] - normDir[2]*H_field[1][pos[0]][pos[1]][pos[2]])*sin(lines[1][pos[1]]) \
-						+ (normDir[2]*H_field[0][pos[0]][pos[1]][pos[2]] - normDir[0]*H_field[2][pos[0]][pos[1]][pos[2]])*cos(lines[1][pos[1]]);
-
-				Ms[0][pos[0]][pos[1]][pos[2]] = (normDir[2]*E_field[1][pos[0]][pos[1]][pos[2]] - normDir[1]*E_field[2][pos[0]][pos[1]][pos[2]])*cos(lines[1][pos[1]]) \
-						- (normDir[0]*E_field[2][pos[0]][pos[1]][pos[2]] - normDir[2]*E_field[0][pos[0]][pos[1]][pos[2]])*sin(lines[1][pos[1]]);
-				Ms[1][pos[0]][pos[1]][pos[2]] = (normDir[2]*E_field[1][pos[0]][pos[1]][pos[2]] - normDir[1]*E_field[2][pos[0]][pos[1]][pos[2]])*sin(lines[1][pos[1]]) \
-						+ (normDir[0]*E_field[2][pos[0]][pos[1]][pos[2]] - normDir[2]*E_field[0][pos[0]][pos[1]][pos[2]])*cos(lines[1][pos[1]]);
+				// Js =  n x H
+				Js[0][pos[0]][pos[1]][pos[2]] = normDir[1]*H_field[2][pos[0]][pos[1]][pos[2]] - normDir[2]*H_field[1][pos[0]][pos[1]][pos[2]];
+				Js[1][pos[0]][pos[1]][pos[2]] = normDir[2]*H_field[0][pos[0]][pos[1]][pos[2]] - normDir[0]*H_field[2][pos[0]][pos[1]][pos[2]];
+				Js[2][pos[0]][pos[1]][pos[2]] = normDir[0]*H_field[1][pos[0]][pos[1]][pos[2]] - normDir[1]*H_field[0][pos[0]][pos[1]][pos[2]];
+
+				// Ms = -n x E
+				Ms[0][pos[0]][pos[1]][pos[2]] = normDir[2]*E_field[1][pos[0]][pos[1]][pos[2]] - normDir[1]*E_field[2][pos[0]][pos[1]][pos[2]];
+				Ms[1][pos[0]][pos[1]][pos[2]] = normDir[0]*E_field[2][pos[0]][pos[1]][pos[2]] - normDir[2]*E_field[0][pos[0]][pos[1]][pos[2]];
+				Ms[2][pos[0]][pos[1]][pos[2]] = normDir[1]*E_field[0][pos[0]][pos[1]][pos[2]] - normDir[0]*E_field[1][pos[0]][pos[1]][pos[2]];
+
+				//transform to cartesian coordinates
+				if (mesh_type==1)
+				{
+					Js[0][pos[0]][pos[1]][pos[2]] = (normDir[1]*H_field[2][pos[0]][pos[1]][pos[2]] - normDir[2]*H_field[1][pos[0]][pos[1]][pos[2]])*cos(lines[1][pos[1]]) \
+							- (normDir[2]*H_field[0][pos[0]][pos[1]][pos[2]] - normDir[0]*H_field[2][pos[0]][pos[1]][pos[2]])*sin(lines[1][pos[1]]);
+					Js[1][pos[0]][pos[1]][pos[2]] = (normDir[1]*H_field[2][pos[0]][pos[1]][pos[2]] - normDir[2]*H_field[1][pos[0]][pos[1]][pos[2]])*sin(lines[1][pos[1]]) \
+							+ (normDir[2]*H_field[0][pos[0]][pos[1]][pos[2]] - normDir[0]*H_field[2][pos[0]][pos[1]][pos[2]])*cos(lines[1][pos[1]]);
+
+					Ms[0][pos[0]][pos[1]][pos[2]] = (normDir[2]*E_field[1][pos[0]][pos[1]][pos[2]] - normDir[1]*E_field[2][pos[0]][pos[1]][pos[2]])*cos(lines[1][pos[1]]) \
+							- (normDir[0]*E_field[2][pos[0]][pos[1]][pos[2]] - normDir[2]*E_field[0][pos[0]][pos[1]][pos[2]])*sin(lines[1][pos[1]]);
+					Ms[1][pos[0]][pos[1]][pos[2]] = (normDir[2]*E_field[1][pos[0]][pos[1]][pos[2]] - normDir[1]*E_field[2][pos[0]][pos[1]][pos[2]])*sin(lines[1][pos[1]]) \
+							+ (normDir[0]*E_field[2][pos[0]][pos[1]][pos[2]] - normDir[2]*E_field[0][pos[0]][pos[1]][pos[2]])*cos(lines[1][pos[1]]);
+				}
 			}
 		}
 	}
+}
+
+void nf2ff_calc_thread::CalcPhaseTable(float k, unsigned int a_start, unsigned int a_num, const float* r, unsigned int num, float* ph_re, float* ph_im)
+{
+	const float* dir_x = m_nf_calc->m_dir[0] + a_start;
+	const float* dir_y = m_nf_calc->m_dir[1] + a_start;
+	const float* dir_z = m_nf_calc->m_dir[2] + a_start;
+	float r_cos_psi;
+	for (unsigned int n=0; n<num; ++n)
+	{
+		float* p_re = ph_re + n*NF2FF_ANGLE_BLOCK;
+		float* p_im = ph_im + n*NF2FF_ANGLE_BLOCK;
+		for (unsigned int a=0; a<a_num; ++a)
+		{
+			r_cos_psi = r[3*n]*dir_x[a] + r[3*n+1]*dir_y[a] + r[3*n+2]*dir_z[a];
+			p_re[a] = cos(k*r_cos_psi);
+			p_im[a] = sin(k*r_cos_psi);
+		}
+	}
+}
+
+void nf2ff_calc_thread::CalcRadiationVectors(unsigned int f_idx, unsigned int a_start, unsigned int a_num)
+{
+	int ny = m_data.ny;
+	int nP = (ny+1)%3;
+	int nPP = (ny+2)%3;
+
+	unsigned int* numLines = m_data.numLines;
+	float* edge_length_P = m_data.edge_length_P;
+	float* edge_length_PP = m_data.edge_length_PP;
+
+	complex<float>**** Js=m_data.Js->at(f_idx);
+	complex<float>**** Ms=m_data.Ms->at(f_idx);
 
-	complex<double>** m_Nt=m_data.m_Nt;
-	complex<double>** m_Np=m_data.m_Np;
-	complex<double>** m_Lt=m_data.m_Lt;
-	complex<double>** m_Lp=m_data.m_Lp;
+	float k = m_nf_calc->GetWaveNumber(f_idx);
 
-	float center[3] = {m_nf_calc->m_centerCoord[0],m_nf_calc->m_centerCoord[1],m_nf_calc->m_centerCoord[2]};
-	if (mesh_type==1)
+	// the phase exp(jk*r*cos(psi)) is split into exp(jk*r_P*n_a) * exp(jk*r_PP*n_a) for both in-plane directions
+	if (m_data.separable)
 	{
-		center[0] = m_nf_calc->m_centerCoord[0]*cos(m_nf_calc->m_centerCoord[1]);
-		center[1] = m_nf_calc->m_centerCoord[0]*sin(m_nf_calc->m_centerCoord[1]);
+		CalcPhaseTable(k, a_start, a_num, m_data.r_P, numLines[nP], m_phP_re, m_phP_im);
+		CalcPhaseTable(k, a_start, a_num, m_data.r_PP, numLines[nPP], m_phPP_re, m_phPP_im);
 	}
-	// calc local Nt,Np,Lt and Lp
-	float area;
-	float cosT_cosP,cosP_sinT;
-	float cosT_sinP,sinT_sinP;
-	float sinT,sinP;
-	float cosP,cosT;
-	float r_cos_psi;
-	float k = 2*M_PI*m_nf_calc->m_freq/__C0__*sqrt(m_nf_calc->m_permittivity*m_nf_calc->m_permeability);
-	complex<float> exp_jkr;
-	complex<float> _I_(0,1);
-	for (unsigned int tn=0;tn<m_nf_calc->m_numTheta;++tn)
-		for (unsigned int pn=0;pn<m_nf_calc->m_numPhi;++pn)
+
+	for (int n=0;n<12*NF2FF_ANGLE_BLOCK;++n)
+		m_A[n] = 0;
+
+	unsigned int pos[3];
+	pos[ny]=0;
+	float J_re[6];
+	float J_im[6];
+	complex<float> J;
+	for (pos[nP]=0; pos[nP]<numLines[nP]; ++pos[nP])
+	{
+		// non-separable surfaces need the full phase for every surface point of this line
+		if (!m_data.separable)
+			CalcPhaseTable(k, a_start, a_num, m_data.r_PP + 3*pos[nP]*numLines[nPP], numLines[nPP], m_phPP_re, m_phPP_im);
+
+		for (int n=0;n<12*NF2FF_ANGLE_BLOCK;++n)
+			m_S[n] = 0;
+
+		for (pos[nPP]=0; pos[nPP]<numLines[nPP]; ++pos[nPP])
 		{
-			sinT = sin(m_nf_calc->m_theta[tn]);
-			sinP = sin(m_nf_calc->m_phi[pn]);
-			cosT = cos(m_nf_calc->m_theta[tn]);
-			cosP = cos(m_nf_calc->m_phi[pn]);
-			cosT_cosP = cosT*cosP;
-			cosT_sinP = cosT*sinP;
-			cosP_sinT = cosP*sinT;
-			sinT_sinP = sinP*sinT;
-
-			for (pos_t=0; pos_t<num_t; ++pos_t)
+			for (int c=0;c<3;++c)
 			{
-				pos[nP] = m_start+pos_t;
-				for (pos[nPP]=0; pos[nPP]<numLines[nPP]; ++pos[nPP])
-				{
-					if (mesh_type==0)
-						r_cos_psi = (lines[0][pos[0]]-center[0])*cosP_sinT + (lines[1][pos[1]]-center[1])*sinT_sinP + (lines[2][pos[2]]-center[2])*cosT;
-					else
-						r_cos_psi = ((lines[0][pos[0]]*cos(lines[1][pos[1]]))-center[0])*cosP_sinT + ((lines[0][pos[0]]*sin(lines[1][pos[1]]))-center[1])*sinT_sinP + (lines[2][pos[2]]-center[2])*cosT;
-					exp_jkr = exp(_I_*k*r_cos_psi);
-					area = edge_length_P[pos[nP]]*edge_length_PP[pos[nPP]];
-					m_Nt[tn][pn] += area*exp_jkr*(Js[0][pos[0]][pos[1]][pos[2]]*cosT_cosP + Js[1][pos[0]][pos[1]][pos[2]]*cosT_sinP \
-												  - Js[2][pos[0]][pos[1]][pos[2]]*sinT);
-					m_Np[tn][pn] += area*exp_jkr*(Js[1][pos[0]][pos[1]][pos[2]]*cosP - Js[0][pos[0]][pos[1]][pos[2]]*sinP);
+				J = edge_length_PP[pos[nPP]]*Js[c][pos[0]][pos[1]][pos[2]];
+				J_re[c] = real(J);
+				J_im[c] = imag(J);
+				J = edge_length_PP[pos[nPP]]*Ms[c][pos[0]][pos[1]][pos[2]];
+				J_re[c+3] = real(J);
+				J_im[c+3] = imag(J);
+			}
 
-					m_Lt[tn][pn] += area*exp_jkr*(Ms[0][pos[0]][pos[1]][pos[2]]*cosT_cosP + Ms[1][pos[0]][pos[1]][pos[2]]*cosT_sinP \
-												  - Ms[2][pos[0]][pos[1]][pos[2]]*sinT);
-					m_Lp[tn][pn] += area*exp_jkr*(Ms[1][pos[0]][pos[1]][pos[2]]*cosP - Ms[0][pos[0]][pos[1]][pos[2]]*sinP);
+			const float* p_re = m_phPP_re + pos[nPP]*NF2FF_ANGLE_BLOCK;
+			const float* p_im = m_phPP_im + pos[nPP]*NF2FF_ANGLE_BLOCK;
+			for (int c=0;c<6;++c)
+			{
+				float* S_re = m_S + 2*c*NF2FF_ANGLE_BLOCK;
+				float* S_im = S_re + NF2FF_ANGLE_BLOCK;
+				for (unsigned int a=0; a<a_num; ++a)
+				{
+					S_re[a] += p_re[a]*J_re[c] - p_im[a]*J_im[c];
+					S_im[a] += p_re[a]*J_im[c] + p_im[a]*J_re[c];
 				}
 			}
 		}
 
-	m_nf_calc->m_Barrier->wait(); //combine all thread local Nt,Np,Lt and Lp
+		// add the line sum with its phase and edge length
+		double q_re, q_im;
+		for (int c=0;c<6;++c)
+		{
+			const float* S_re = m_S + 2*c*NF2FF_ANGLE_BLOCK;
+			const float* S_im = S_re + NF2FF_ANGLE_BLOCK;
+			double* A_re = m_A + 2*c*NF2FF_ANGLE_BLOCK;
+			double* A_im = A_re + NF2FF_ANGLE_BLOCK;
+			if (m_data.separable)
+			{
+				const float* p_re = m_phP_re + pos[nP]*NF2FF_ANGLE_BLOCK;
+				const float* p_im = m_phP_im + pos[nP]*NF2FF_ANGLE_BLOCK;
+				for (unsigned int a=0; a<a_num; ++a)
+				{
+					q_re = edge_length_P[pos[nP]]*p_re[a];
+					q_im = edge_length_P[pos[nP]]*p_im[a];
+					A_re[a] += q_re*S_re[a] - q_im*S_im[a];
+					A_im[a] += q_re*S_im[a] + q_im*S_re[a];
+				}
+			}
+			else
+			{
+				for (unsigned int a=0; a<a_num; ++a)
+				{
+					A_re[a] += edge_length_P[pos[nP]]*S_re[a];
+					A_im[a] += edge_length_P[pos[nP]]*S_im[a];
+				}
+			}
+		}
+	}
 
-	m_nf_calc->m_Barrier->wait(); //wait for termination
+	// transform the cartesian radiation vectors to Nt,Np,Lt and Lp
+	complex<double> N[3];
+	complex<double> L[3];
+	unsigned int ga, idx;
+	for (unsigned int a=0; a<a_num; ++a)
+	{
+		for (int c=0;c<3;++c)
+		{
+			N[c] = complex<double>(m_A[2*c*NF2FF_ANGLE_BLOCK+a], m_A[(2*c+1)*NF2FF_ANGLE_BLOCK+a]);
+			L[c] = complex<double>(m_A[2*(c+3)*NF2FF_ANGLE_BLOCK+a], m_A[(2*(c+3)+1)*NF2FF_ANGLE_BLOCK+a]);
+		}
+		ga = a_start+a;
+		idx = f_idx*m_nf_calc->m_numAngles + ga;
+		m_data.m_Nt[idx] = N[0]*(double)m_nf_calc->m_cosT_cosP[ga] + N[1]*(double)m_nf_calc->m_cosT_sinP[ga] - N[2]*(double)m_nf_calc->m_sinT[ga];
+		m_data.m_Np[idx] = N[1]*(double)m_nf_calc->m_cosP[ga] - N[0]*(double)m_nf_calc->m_sinP[ga];
+		m_data.m_Lt[idx] = L[0]*(double)m_nf_calc->m_cosT_cosP[ga] + L[1]*(double)m_nf_calc->m_cosT_sinP[ga] - L[2]*(double)m_nf_calc->m_sinT[ga];
+		m_data.m_Lp[idx] = L[1]*(double)m_nf_calc->m_cosP[ga] - L[0]*(double)m_nf_calc->m_sinP[ga];
+	}
 }
 
 
 /***********************************************************************/
 
 
-nf2ff_calc::nf2ff_calc(float freq, vector<float> theta, vector<float> phi, vector<float> center)
+nf2ff_calc::nf2ff_calc(vector<float> freq, vector<float> theta, vector<float> phi, vector<float> center)
 {
 	m_freq = freq;
-	m_permittivity = 1;
-	m_permeability = 1;
+	m_permittivity.resize(m_freq.size(),1);
+	m_permeability.resize(m_freq.size(),1);
 
 	m_numTheta = theta.size();
 	m_theta = new float[m_numTheta];
@@ -177,12 +299,39 @@ nf2ff_calc::nf2ff_calc(float freq, vector<float> theta, vector<float> phi, vecto
 	for (size_t n=0;n<m_numPhi;++n)
 		m_phi[n]=phi.at(n);
 
+	// precompute the trig functions of all angles
+	m_numAngles = m_numTheta*m_numPhi;
+	for (int n=0;n<3;++n)
+		m_dir[n] = new float[m_numAngles];
+	m_cosT_cosP = new float[m_numAngles];
+	m_cosT_sinP = new float[m_numAngles];
+	m_sinT = new float[m_numAngles];
+	m_cosP = new float[m_numAngles];
+	m_sinP = new float[m_numAngles];
+	unsigned int a=0;
+	for (unsigned int tn=0;tn<m_numTheta;++tn)
+		for (unsigned int pn=0;pn<m_numPhi;++pn)
+		{
+			m_sinT[a] = sin(m_theta[tn]);
+			m_sinP[a] = sin(m_phi[pn]);
+			m_cosP[a] = cos(m_phi[pn]);
+			m_cosT_cosP[a] = cos(m_theta[tn])*m_cosP[a];
+			m_cosT_sinP[a] = cos(m_theta[tn])*m_sinP[a];
+			m_dir[0][a] = m_cosP[a]*m_sinT[a];
+			m_dir[1][a] = m_sinP[a]*m_sinT[a];
+			m_dir[2][a] = cos(m_theta[tn]);
+			++a;
+		}
+
 	unsigned int numLines[2] = {m_numTheta, m_numPhi};
-	m_E_theta = Create2DArray<std::complex<double> >(numLines);
-	m_E_phi = Create2DArray<std::complex<double> >(numLines);
-	m_H_theta = Create2DArray<std::complex<double> >(numLines);
-	m_H_phi = Create2DArray<std::complex<double> >(numLines);
-	m_P_rad = Create2DArray<double>(numLines);
+	for (size_t fn=0;fn<m_freq.size();++fn)
+	{
+		m_E_theta.push_back(Create2DArray<std::complex<double> >(numLines));
+		m_E_phi.push_back(Create2DArray<std::complex<double> >(numLines));
+		m_H_theta.push_back(Create2DArray<std::complex<double> >(numLines));
+		m_H_phi.push_back(Create2DArray<std::complex<double> >(numLines));
+		m_P_rad.push_back(Create2DArray<double>(numLines));
+	}
 
 	if (center.size()==3)
 	{
@@ -198,8 +347,8 @@ nf2ff_calc::nf2ff_calc(float freq, vector<float> theta, vector<float> phi, vecto
 	else
 		m_centerCoord[0]=m_centerCoord[1]=m_centerCoord[2]=0.0;
 
-	m_radPower = 0;
-	m_maxDir = 0;
+	m_radPower.resize(m_freq.size(),0);
+	m_maxDir.resize(m_freq.size(),0);
 	m_radius = 1;
 
 	for (int n=0;n<3;++n)
@@ -219,22 +368,61 @@ nf2ff_calc::~nf2ff_calc()
 	delete[] m_theta;
 	m_theta = NULL;
 
+	for (int n=0;n<3;++n)
+	{
+		delete[] m_dir[n];
+		m_dir[n] = NULL;
+	}
+	delete[] m_cosT_cosP; m_cosT_cosP = NULL;
+	delete[] m_cosT_sinP; m_cosT_sinP = NULL;
+	delete[] m_sinT; m_sinT = NULL;
+	delete[] m_cosP; m_cosP = NULL;
+	delete[] m_sinP; m_sinP = NULL;
+
 	unsigned int numLines[2] = {m_numTheta, m_numPhi};
-	Delete2DArray(m_E_theta,numLines);
-	m_E_theta = NULL;
-	Delete2DArray(m_E_phi,numLines);
-	m_E_phi = NULL;
-	Delete2DArray(m_H_theta,numLines);
-	m_H_theta = NULL;
-	Delete2DArray(m_H_phi,numLines);
-	m_H_phi = NULL;
-	Delete2DArray(m_P_rad,numLines);
-	m_P_rad = NULL;
+	for (size_t fn=0;fn<m_freq.size();++fn)
+	{
+		Delete2DArray(m_E_theta.at(fn),numLines);
+		Delete2DArray(m_E_phi.at(fn),numLines);
+		Delete2DArray(m_H_theta.at(fn),numLines);
+		Delete2DArray(m_H_phi.at(fn),numLines);
+		Delete2DArray(m_P_rad.at(fn),numLines);
+	}
+	m_E_theta.clear();
+	m_E_phi.clear();
+	m_H_theta.clear();
+	m_H_phi.clear();
+	m_P_rad.clear();
 
 	delete m_Barrier;
 	m_Barrier = NULL;
 }
 
+void nf2ff_calc::SetPermittivity(vector<float> permittivity)
+{
+	if (permittivity.size()==1)
+		m_permittivity.assign(m_freq.size(),permittivity.at(0));
+	else if (permittivity.size()==m_freq.size())
+		m_permittivity = permittivity;
+	else
+		cerr << "nf2ff_calc::SetPermittivity: Error, permittivity vector size must match number of frequencies! skipping!" << endl;
+}
+
+void nf2ff_calc::SetPermeability(vector<float> permeability)
+{
+	if (permeability.size()==1)
+		m_permeability.assign(m_freq.size(),permeability.at(0));
+	else if (permeability.size()==m_freq.size())
+		m_permeability = permeability;
+	else
+		cerr << "nf2ff_calc::SetPermeability: Error, permeability vector size must match number of frequencies! skipping!" << endl;
+}
+
+float nf2ff_calc::GetWaveNumber(size_t f_idx) const
+{
+	return 2*M_PI*m_freq.at(f_idx)/__C0__*sqrt(m_permittivity.at(f_idx)*m_permeability.at(f_idx));
+}
+
 int nf2ff_calc::GetNormalDir(unsigned int* numLines)
 {
 	int ny = -1;
@@ -265,7 +453,7 @@ void nf2ff_calc::SetMirror(int type, int dir, float pos)
 	m_MirrorPos[dir] = pos;
 }
 
-bool nf2ff_calc::AddMirrorPlane(int n, float **lines, unsigned int* numLines, complex<float>**** E_field, complex<float>**** H_field, int MeshType)
+bool nf2ff_calc::AddMirrorPlane(int n, float **lines, unsigned int* numLines, vector<complex<float>****> &E_field, vector<complex<float>****> &H_field, int MeshType)
 {
 	float E_factor[3] = {1,1,1};
 	float H_factor[3] = {1,1,1};
@@ -289,20 +477,27 @@ bool nf2ff_calc::AddMirrorPlane(int n, float **lines, unsigned int* numLines, co
 		H_factor[nPP]= -1.0;
 	}
 
-	for (int d=0;d<3;++d)
-		for (unsigned int i=0;i<numLines[0];++i)
-			for (unsigned int j=0;j<numLines[1];++j)
-				for (unsigned int k=0;k<numLines[2];++k)
-				{
-					E_field[d][i][j][k] *= E_factor[d];
-					H_field[d][i][j][k] *= H_factor[d];
-				}
+	for (size_t fn=0;fn<E_field.size();++fn)
+		for (int d=0;d<3;++d)
+			for (unsigned int i=0;i<numLines[0];++i)
+				for (unsigned int j=0;j<numLines[1];++j)
+					for (unsigned int k=0;k<numLines[2];++k)
+					{
+						E_field.at(fn)[d][i][j][k] *= E_factor[d];
+						H_field.at(fn)[d][i][j][k] *= H_factor[d];
+					}
 
 	return this->AddSinglePlane(lines, numLines, E_field, H_field, MeshType);
 }
 
-bool nf2ff_calc::AddPlane(float **lines, unsigned int* numLines, complex<float>**** E_field, complex<float>**** H_field, int MeshType)
+bool nf2ff_calc::AddPlane(float **lines, unsigned int* numLines, vector<complex<float>****> &E_field, vector<complex<float>****> &H_field, int MeshType)
 {
+	if ((E_field.size()!=m_freq.size()) || (H_field.size()!=m_freq.size()))
+	{
+		cerr << "nf2ff_calc::AddPlane: Error, field data must be given for all frequencies..." << endl;
+		return false;
+	}
+
 	this->AddSinglePlane(lines, numLines, E_field, H_field, MeshType);
 
 	for (int n=0;n<3;++n)
@@ -349,12 +544,17 @@ bool nf2ff_calc::AddPlane(float **lines, unsigned int* numLines, complex<float>*
 	}
 
 	//cleanup E- & H-Fields
-	Delete_N_3DArray(E_field,numLines);
-	Delete_N_3DArray(H_field,numLines);
+	for (size_t fn=0;fn<m_freq.size();++fn)
+	{
+		Delete_N_3DArray(E_field.at(fn),numLines);
+		Delete_N_3DArray(H_field.at(fn),numLines);
+	}
+	E_field.clear();
+	H_field.clear();
 	return true;
 }
 
-bool nf2ff_calc::AddSinglePlane(float **lines, unsigned int* numLines, complex<float>**** E_field, complex<float>**** H_field, int MeshType)
+bool nf2ff_calc::AddSinglePlane(float **lines, unsigned int* numLines, vector<complex<float>****> &E_field, vector<complex<float>****> &H_field, int MeshType)
 {
 	//find normal direction
 	int ny = this->GetNormalDir(numLines);
@@ -366,8 +566,14 @@ bool nf2ff_calc::AddSinglePlane(float **lines, unsigned int* numLines, complex<f
 	int nP  = (ny+1)%3;
 	int nPP = (ny+2)%3;
 
-	complex<float>**** Js = Create_N_3DArray<complex<float> >(numLines);
-	complex<float>**** Ms = Create_N_3DArray<complex<float> >(numLines);
+	size_t numFreq = m_freq.size();
+	vector<complex<float>****> Js(numFreq,NULL);
+	vector<complex<float>****> Ms(numFreq,NULL);
+	for (size_t fn=0;fn<numFreq;++fn)
+	{
+		Js.at(fn) = Create_N_3DArray<complex<float> >(numLines);
+		Ms.at(fn) = Create_N_3DArray<complex<float> >(numLines);
+	}
 
 	float normDir[3]= {0,0,0};
 	if (lines[ny][0]>=m_centerCoord[ny])
@@ -408,24 +614,77 @@ bool nf2ff_calc::AddSinglePlane(float **lines, unsigned int* numLines, complex<f
 
 	complex<double> power = 0;
 	double area;
-	for (pos[0]=0; pos[0]<numLines[0]; ++pos[0])
-		for (pos[1]=0; pos[1]<numLines[1]; ++pos[1])
-			for (pos[2]=0; pos[2]<numLines[2]; ++pos[2])
-			{
-				area = edge_length_P[pos[nP]]*edge_length_PP[pos[nPP]];
-				power = (E_field[nP][pos[0]][pos[1]][pos[2]]*conj(H_field[nPP][pos[0]][pos[1]][pos[2]]) \
-						 - E_field[nPP][pos[0]][pos[1]][pos[2]]*conj(H_field[nP][pos[0]][pos[1]][pos[2]]));
-				m_radPower += 0.5*area*real(power)*normDir[ny];
-			}
-	unsigned int numAngles[2] = {m_numTheta, m_numPhi};
+	for (size_t fn=0;fn<numFreq;++fn)
+	{
+		complex<float>**** E = E_field.at(fn);
+		complex<float>**** H = H_field.at(fn);
+		for (pos[0]=0; pos[0]<numLines[0]; ++pos[0])
+			for (pos[1]=0; pos[1]<numLines[1]; ++pos[1])
+				for (pos[2]=0; pos[2]<numLines[2]; ++pos[2])
+				{
+					area = edge_length_P[pos[nP]]*edge_length_PP[pos[nPP]];
+					power = (E[nP][pos[0]][pos[1]][pos[2]]*conj(H[nPP][pos[0]][pos[1]][pos[2]]) \
+							 - E[nPP][pos[0]][pos[1]][pos[2]]*conj(H[nP][pos[0]][pos[1]][pos[2]]));
+					m_radPower.at(fn) += 0.5*area*real(power)*normDir[ny];
+				}
+	}
+
+	// cartesian surface coordinates relative to the center
+	float center[3] = {m_centerCoord[0],m_centerCoord[1],m_centerCoord[2]};
+	if (MeshType==1)
+	{
+		center[0] = m_centerCoord[0]*cos(m_centerCoord[1]);
+		center[1] = m_centerCoord[0]*sin(m_centerCoord[1]);
+	}
+	// all surfaces except a cylindrical r-a surface are separable: r(i,j) = r(i,0) + r(0,j) - r(0,0)
+	bool separable = (MeshType!=1) || (ny!=2);
+	float* r_P = NULL;
+	float* r_PP = NULL;
+	float r[3];
+	float r0[3];
+	pos[ny]=0;
+	if (separable)
+	{
+		r_P = new float[3*numLines[nP]];
+		r_PP = new float[3*numLines[nPP]];
+		pos[nP]=0;
+		pos[nPP]=0;
+		GetSurfaceCoords(lines, pos, center, MeshType, r0);
+		for (pos[nP]=0; pos[nP]<numLines[nP]; ++pos[nP])
+			GetSurfaceCoords(lines, pos, center, MeshType, &r_P[3*pos[nP]]);
+		pos[nP]=0;
+		for (pos[nPP]=0; pos[nPP]<numLines[nPP]; ++pos[nPP])
+		{
+			GetSurfaceCoords(lines, pos, center, MeshType, r);
+			for (int n=0;n<3;++n)
+				r_PP[3*pos[nPP]+n] = r[n]-r0[n];
+		}
+	}
+	else
+	{
+		r_PP = new float[3*numLines[nP]*numLines[nPP]];
+		for (pos[nP]=0; pos[nP]<numLines[nP]; ++pos[nP])
+			for (pos[nPP]=0; pos[nPP]<numLines[nPP]; ++pos[nPP])
+				GetSurfaceCoords(lines, pos, center, MeshType, &r_PP[3*(pos[nP]*numLines[nPP]+pos[nPP])]);
+	}
+
+	// all frequencies and angles are processed in one pass over the surface currents
+	size_t numResults = numFreq*m_numAngles;
+	complex<double>* Nt = new complex<double>[numResults];
+	complex<double>* Np = new complex<double>[numResults];
+	complex<double>* Lt = new complex<double>[numResults];
+	complex<double>* Lp = new complex<double>[numResults];
 
-	// setup multi-threading jobs
+	// setup multi-threading jobs, the surface currents are split by lines, the far-field by angle blocks and frequencies
 	vector<unsigned int> jpt = AssignJobs2Threads(numLines[nP], m_numThreads, true);
 	m_numThreads = jpt.size();
+	unsigned int numBlocks = (m_numAngles+NF2FF_ANGLE_BLOCK-1)/NF2FF_ANGLE_BLOCK;
+	vector<unsigned int> jpt_ff = AssignJobs2Threads(numFreq*numBlocks, m_numThreads, false);
 	nf2ff_data* thread_data = new nf2ff_data[m_numThreads];
 	m_Barrier = new boost::barrier(m_numThreads+1); // numThread workers + 1 controller
 	unsigned int start=0;
 	unsigned int stop=jpt.at(0)-1;
+	unsigned int jobStart=0;
 	for (unsigned int n=0; n<m_numThreads; n++)
 	{
 		thread_data[n].ny=ny;
@@ -435,52 +694,36 @@ bool nf2ff_calc::AddSinglePlane(float **lines, unsigned int* numLines, complex<f
 		thread_data[n].lines=lines;
 		thread_data[n].edge_length_P=edge_length_P;
 		thread_data[n].edge_length_PP=edge_length_PP;
-		thread_data[n].E_field=E_field;
-		thread_data[n].H_field=H_field;
-		thread_data[n].Js=Js;
-		thread_data[n].Ms=Ms;
-		thread_data[n].m_Nt=Create2DArray<complex<double> >(numAngles);
-		thread_data[n].m_Np=Create2DArray<complex<double> >(numAngles);
-		thread_data[n].m_Lt=Create2DArray<complex<double> >(numAngles);
-		thread_data[n].m_Lp=Create2DArray<complex<double> >(numAngles);
-
-		boost::thread *t = new boost::thread( nf2ff_calc_thread(this,start,stop,n,thread_data[n]) );
+		thread_data[n].separable=separable;
+		thread_data[n].r_P=r_P;
+		thread_data[n].r_PP=r_PP;
+		thread_data[n].E_field=&E_field;
+		thread_data[n].H_field=&H_field;
+		thread_data[n].Js=&Js;
+		thread_data[n].Ms=&Ms;
+		thread_data[n].m_Nt=Nt;
+		thread_data[n].m_Np=Np;
+		thread_data[n].m_Lt=Lt;
+		thread_data[n].m_Lp=Lp;
+
+		boost::thread *t = new boost::thread( nf2ff_calc_thread(this,start,stop,jobStart,jobStart+jpt_ff.at(n),n,thread_data[n]) );
 
 		m_thread_group.add_thread( t );
 
 		start = stop+1;
 		if (n<m_numThreads-1)
 			stop = start + jpt.at(n+1)-1;
+		jobStart += jpt_ff.at(n);
 	}
 	//all threads a running and waiting for the barrier
 
 	m_Barrier->wait(); //start
 
 	// threads: calc Js and Ms (eq. 8.15a/b)
-	// threads calc their local Nt,Np,Lt and Lp
-
-	m_Barrier->wait(); //combine all thread local Nt,Np,Lt and Lp
 
-	complex<float>** Nt = Create2DArray<complex<float> >(numAngles);
-	complex<float>** Np = Create2DArray<complex<float> >(numAngles);
-	complex<float>** Lt = Create2DArray<complex<float> >(numAngles);
-	complex<float>** Lp = Create2DArray<complex<float> >(numAngles);
+	m_Barrier->wait(); //all surface currents are done
 
-	for (unsigned int n=0; n<m_numThreads; n++)
-	{
-		for (unsigned int tn=0;tn<m_numTheta;++tn)
-			for (unsigned int pn=0;pn<m_numPhi;++pn)
-			{
-				Nt[tn][pn] += thread_data[n].m_Nt[tn][pn];
-				Np[tn][pn] += thread_data[n].m_Np[tn][pn];
-				Lt[tn][pn] += thread_data[n].m_Lt[tn][pn];
-				Lp[tn][pn] += thread_data[n].m_Lp[tn][pn];
-			}
-		Delete2DArray(thread_data[n].m_Nt,numAngles);
-		Delete2DArray(thread_data[n].m_Np,numAngles);
-		Delete2DArray(thread_data[n].m_Lt,numAngles);
-		Delete2DArray(thread_data[n].m_Lp,numAngles);
-	}
+	// threads calc Nt,Np,Lt and Lp for their angles and frequencies
 
 	m_Barrier->wait(); //wait for termination
 	m_thread_group.join_all(); // wait for termination
@@ -488,41 +731,65 @@ bool nf2ff_calc::AddSinglePlane(float **lines, unsigned int* numLines, complex<f
 	m_Barrier = NULL;
 
 	//cleanup Js & Ms
-	Delete_N_3DArray(Js,numLines);
-	Delete_N_3DArray(Ms,numLines);
+	for (size_t fn=0;fn<numFreq;++fn)
+	{
+		Delete_N_3DArray(Js.at(fn),numLines);
+		Delete_N_3DArray(Ms.at(fn),numLines);
+	}
 
 	// calc equations 8.23a/b and 8.24a/b
-	float k = 2*M_PI*m_freq/__C0__*sqrt(m_permittivity*m_permeability);
-	complex<float> factor(0,k/4.0/M_PI/m_radius);
-	complex<float> f_exp(0,-1*k*m_radius);
-	factor *= exp(f_exp);
-	float fZ0 = __Z0__ * sqrt(m_permeability/m_permittivity);
-	complex<float> Z0 = fZ0;
-	float P_max = 0;
-	for (unsigned int tn=0;tn<m_numTheta;++tn)
-		for (unsigned int pn=0;pn<m_numPhi;++pn)
-		{
-			m_E_theta[tn][pn] -= factor*(Lp[tn][pn] + Z0*Nt[tn][pn]);
-			m_E_phi[tn][pn] += factor*(Lt[tn][pn] - Z0*Np[tn][pn]);
+	for (size_t fn=0;fn<numFreq;++fn)
+	{
+		double k = GetWaveNumber(fn);
+		complex<double> factor(0,k/4.0/M_PI/m_radius);
+		complex<double> f_exp(0,-1*k*m_radius);
+		factor *= exp(f_exp);
+		double fZ0 = __Z0__ * sqrt(m_permeability.at(fn)/m_permittivity.at(fn));
+		complex<double> Z0 = fZ0;
+		double P_max = 0;
+		size_t a = fn*m_numAngles;
+		for (unsigned int tn=0;tn<m_numTheta;++tn)
+			for (unsigned int pn=0;pn<m_numPhi;++pn)
+			{
+				m_E_theta.at(fn)[tn][pn] -= factor*(Lp[a] + Z0*Nt[a]);
+				m_E_phi.at(fn)[tn][pn] += factor*(Lt[a] - Z0*Np[a]);
 
-			m_H_theta[tn][pn] += factor*(Np[tn][pn] - Lt[tn][pn]/Z0);
-			m_H_phi[tn][pn] -= factor*(Nt[tn][pn] + Lp[tn][pn]/Z0);
+				m_H_theta.at(fn)[tn][pn] += factor*(Np[a] - Lt[a]/Z0);
+				m_H_phi.at(fn)[tn][pn] -= factor*(Nt[a] + Lp[a]/Z0);
 
-			m_P_rad[tn][pn] = abs((m_E_theta[tn][pn]*conj(m_E_theta[tn][pn])+m_E_phi[tn][pn]*conj(m_E_phi[tn][pn])))/(2*fZ0);
-			if (m_P_rad[tn][pn]>P_max)
-				P_max = m_P_rad[tn][pn];
-		}
+				m_P_rad.at(fn)[tn][pn] = abs((m_E_theta.at(fn)[tn][pn]*conj(m_E_theta.at(fn)[tn][pn])+m_E_phi.at(fn)[tn][pn]*conj(m_E_phi.at(fn)[tn][pn])))/(2*fZ0);
+				if (m_P_rad.at(fn)[tn][pn]>P_max)
+					P_max = m_P_rad.at(fn)[tn][pn];
+				++a;
+			}
+		m_maxDir.at(fn) = 4*M_PI*P_max / m_radPower.at(fn);
+	}
 
 	//cleanup Nx and Lx
-	Delete2DArray(Nt,numAngles);
-	Delete2DArray(Np,numAngles);
-	Delete2DArray(Lt,numAngles);
-	Delete2DArray(Lp,numAngles);
+	delete[] Nt;
+	delete[] Np;
+	delete[] Lt;
+	delete[] Lp;
+	delete[] r_P; r_P=NULL;
+	delete[] r_PP; r_PP=NULL;
 	delete[] edge_length_P; edge_length_P=NULL;
 	delete[] edge_length_PP; edge_length_PP=NULL;
 	delete[] thread_data; thread_data=NULL;
 
-	m_maxDir = 4*M_PI*P_max / m_radPower;
-
 	return true;
 }
+
+void nf2ff_calc::GetSurfaceCoords(float **lines, const unsigned int* pos, const float* center, int MeshType, float* r) const
+{
+	if (MeshType==1)
+	{
+		r[0] = lines[0][pos[0]]*cos(lines[1][pos[1]]) - center[0];
+		r[1] = lines[0][pos[0]]*sin(lines[1][pos[1]]) - center[1];
+	}
+	else
+	{
+		r[0] = lines[0][pos[0]] - center[0];
+		r[1] = lines[1][pos[1]] - center[1];
+	}
+	r[2] = lines[2][pos[2]] - center[2];
+}
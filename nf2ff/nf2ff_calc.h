@@ -32,6 +32,9 @@ class nf2ff_calc;
 #define MIRROR_PEC 1
 #define MIRROR_PMC 2
 
+//! Number of far-field angles processed together in the vectorized inner loop
+#define NF2FF_ANGLE_BLOCK 128
+
 // data structure to exchange data between thread-controller and worker-threads
 typedef struct
 {
@@ -44,30 +47,52 @@ typedef struct
 	float* edge_length_P;
 	float* edge_length_PP;
 
-	std::complex<float>**** E_field;
-	std::complex<float>**** H_field;
-	std::complex<float>**** Js;
-	std::complex<float>**** Ms;
+	// cartesian surface coordinates relative to the center, separable: r(i,j) = r_P[i] + r_PP[j]
+	// otherwise r_PP contains the full coordinates r(i,j) = r_PP[i*numLines[nPP]+j]
+	bool separable;
+	float* r_P;
+	float* r_PP;
+
+	std::vector<std::complex<float>****>* E_field;
+	std::vector<std::complex<float>****>* H_field;
+	std::vector<std::complex<float>****>* Js;
+	std::vector<std::complex<float>****>* Ms;
 
-	//local working data OUT
-	std::complex<double>** m_Nt;
-	std::complex<double>** m_Np;
-	std::complex<double>** m_Lt;
-	std::complex<double>** m_Lp;
+	//working data OUT (index: freq*numAngles + theta*numPhi + phi)
+	std::complex<double>* m_Nt;
+	std::complex<double>* m_Np;
+	std::complex<double>* m_Lt;
+	std::complex<double>* m_Lp;
 
 } nf2ff_data;
 
 class nf2ff_calc_thread
 {
 public:
-	nf2ff_calc_thread(nf2ff_calc* nfc, unsigned int start, unsigned int stop, unsigned int threadID, nf2ff_data &data);
+	nf2ff_calc_thread(nf2ff_calc* nfc, unsigned int start, unsigned int stop, unsigned int jobStart, unsigned int jobStop, unsigned int threadID, nf2ff_data &data);
 	void operator()();
 
 protected:
 	unsigned int m_start, m_stop, m_threadID;
+	unsigned int m_jobStart, m_jobStop;
 	nf2ff_calc *m_nf_calc;
 
 	nf2ff_data m_data;
+
+	//! Calculate the surface currents Js and Ms for all frequencies (eq. 8.15a/b)
+	void CalcSurfaceCurrents();
+	//! Calculate Nt,Np,Lt and Lp for one frequency and a block of angles
+	void CalcRadiationVectors(unsigned int f_idx, unsigned int a_start, unsigned int a_num);
+	//! Calculate the phase factors exp(jk r*n_a) for a block of angles at the given (relative) cartesian coordinates
+	void CalcPhaseTable(float k, unsigned int a_start, unsigned int a_num, const float* r, unsigned int num, float* ph_re, float* ph_im);
+
+	// thread local buffers
+	float* m_phP_re;
+	float* m_phP_im;
+	float* m_phPP_re;
+	float* m_phPP_im;
+	float* m_S;
+	double* m_A;
 };
 
 class nf2ff_calc
@@ -75,42 +100,47 @@ class nf2ff_calc
 	// allow full data access to nf2ff_calc_thread class
 	friend class nf2ff_calc_thread;
 public:
-	nf2ff_calc(float freq, std::vector<float> theta, std::vector<float> phi, std::vector<float> center);
+	nf2ff_calc(std::vector<float> freq, std::vector<float> theta, std::vector<float> phi, std::vector<float> center);
 	~nf2ff_calc();
 
 	void SetRadius(float radius) {m_radius=radius;}
-	void SetPermittivity(float permittivity) {m_permittivity=permittivity;}
-	void SetPermeability(float permeability) {m_permeability=permeability;}
+	//! Set the relative permittivity, either one value for all or one value per frequency
+	void SetPermittivity(std::vector<float> permittivity);
+	//! Set the relative permeability, either one value for all or one value per frequency
+	void SetPermeability(std::vector<float> permeability);
 
-	double GetTotalRadPower() const {return m_radPower;}
-	double GetMaxDirectivity() const {return m_maxDir;}
+	size_t GetNumFrequencies() const {return m_freq.size();}
 
-	std::complex<double>** GetETheta() const {return m_E_theta;}
-	std::complex<double>** GetEPhi() const {return m_E_phi;}
-	double** GetRadPower() const {return m_P_rad;}
+	double GetTotalRadPower(size_t f_idx) const {return m_radPower.at(f_idx);}
+	double GetMaxDirectivity(size_t f_idx) const {return m_maxDir.at(f_idx);}
+
+	std::complex<double>** GetETheta(size_t f_idx) const {return m_E_theta.at(f_idx);}
+	std::complex<double>** GetEPhi(size_t f_idx) const {return m_E_phi.at(f_idx);}
+	double** GetRadPower(size_t f_idx) const {return m_P_rad.at(f_idx);}
 
 	unsigned int GetNumThreads() const {return m_numThreads;}
 	void SetNumThreads(unsigned int n) {m_numThreads=n;}
 
 	void SetMirror(int type, int dir, float pos);
 
-	bool AddPlane(float **lines, unsigned int* numLines, std::complex<float>**** E_field, std::complex<float>**** H_field, int MeshType=0);
+	//! Add a nf2ff plane with the E- and H-field data for every frequency, the field data will be deleted afterwards
+	bool AddPlane(float **lines, unsigned int* numLines, std::vector<std::complex<float>****> &E_field, std::vector<std::complex<float>****> &H_field, int MeshType=0);
 
 protected:
-	float m_freq;
+	std::vector<float> m_freq;
 	float m_radius;
 
-	float m_permittivity; //relative electric permittivity
-	float m_permeability; //relative magnetic permeability
+	std::vector<float> m_permittivity; //relative electric permittivity
+	std::vector<float> m_permeability; //relative magnetic permeability
 
-	double m_radPower;
-	double m_maxDir;
+	std::vector<double> m_radPower;
+	std::vector<double> m_maxDir;
 
-	std::complex<double>** m_E_theta;
-	std::complex<double>** m_E_phi;
-	std::complex<double>** m_H_theta;
-	std::complex<double>** m_H_phi;
-	double** m_P_rad;
+	std::vector<std::complex<double>**> m_E_theta;
+	std::vector<std::complex<double>**> m_E_phi;
+	std::vector<std::complex<double>**> m_H_theta;
+	std::vector<std::complex<double>**> m_H_phi;
+	std::vector<double**> m_P_rad;
 
 	float m_centerCoord[3];
 	unsigned int m_numTheta;
@@ -118,14 +148,27 @@ protected:
 	float* m_theta;
 	float* m_phi;
 
+	// precomputed direction vector and trig functions for all angles (index: theta*numPhi + phi)
+	unsigned int m_numAngles;
+	float* m_dir[3];
+	float* m_cosT_cosP;
+	float* m_cosT_sinP;
+	float* m_sinT;
+	float* m_cosP;
+	float* m_sinP;
+
+	float GetWaveNumber(size_t f_idx) const;
+
 	//mirror settings
 	bool m_EnableMirror;
 	int m_MirrorType[3];
 	float m_MirrorPos[3];
 
 	int GetNormalDir(unsigned int* numLines);
-	bool AddSinglePlane(float **lines, unsigned int* numLines, std::complex<float>**** E_field, std::complex<float>**** H_field, int MeshType=0);
-	bool AddMirrorPlane(int n, float **lines, unsigned int* numLines, std::complex<float>**** E_field, std::complex<float>**** H_field, int MeshType=0);
+	//! Get the cartesian coordinates of a surface point relative to the (cartesian) center
+	void GetSurfaceCoords(float **lines, const unsigned int* pos, const float* center, int MeshType, float* r) const;
+	bool AddSinglePlane(float **lines, unsigned int* numLines, std::vector<std::complex<float>****> &E_field, std::vector<std::complex<float>****> &H_field, int MeshType=0);
+	bool AddMirrorPlane(int n, float **lines, unsigned int* numLines, std::vector<std::complex<float>****> &E_field, std::vector<std::complex<float>****> &H_field, int MeshType=0);
 
 	//boost multi-threading
 	unsigned int m_numThreads;
@@ -26,10 +26,12 @@
 #include "FDTD/operator_cylindermultigrid.h"
 #include "FDTD/engine_multithread.h"
 #include "FDTD/operator_multithread.h"
+#include "FDTD/engine_tiling.h"
 #include "FDTD/extensions/operator_ext_excitation.h"
 #include "FDTD/extensions/operator_ext_tfsf.h"
 #include "FDTD/extensions/operator_ext_mur_abc.h"
 #include "FDTD/extensions/operator_ext_upml.h"
+#include "FDTD/extensions/operator_ext_cpml.h"
 #include "FDTD/extensions/operator_ext_lorentzmaterial.h"
 #include "FDTD/extensions/operator_ext_lumpedRLC.h"
 #include "FDTD/extensions/operator_ext_conductingsheet.h"
@@ -38,6 +40,8 @@
 #include "FDTD/extensions/engine_ext_steadystate.h"
 #include "FDTD/engine_interface_fdtd.h"
 #include "FDTD/engine_interface_cylindrical_fdtd.h"
+#include "FDTD/engine_interface_avx_fdtd.h"
+#include "FDTD/operator_avx.h"
 #include "Common/processvoltage.h"
 #include "Common/processcurrent.h"
 #include "Common/processfieldprobe.h"
@@ -45,6 +49,7 @@
 #include "Common/processfields_td.h"
 #include "Common/processfields_fd.h"
 #include "Common/processfields_sar.h"
+#include "Common/processnf2ff.h"
 #include <hdf5.h>            // only for H5get_libversion()
 #include <boost/version.hpp> // only for BOOST_LIB_VERSION
 #include <vtkVersion.h>
@@ -81,6 +86,10 @@ openEMS::openEMS()
 	m_debugCSX = false;
 	m_debugBox = m_debugPEC = m_no_simulation = false;
 	m_DumpStats = false;
+	m_EngineSampling = true;
+	m_ResultFileOutput = true;
+	m_KeepProbeResults = false;
+	m_ProbeFileType = 0;
 	endCrit = 1e-6;
 	m_OverSampling = 4;
 	m_CellConstantMaterial=false;
@@ -96,6 +105,7 @@ openEMS::openEMS()
 	m_TS_fac=1.0;
 	m_maxTime=0.0;
 
+	m_PML_type = 0;
 	for (int n=0;n<6;++n)
 	{
 		m_BC_type[n]  = 0;
@@ -136,6 +146,13 @@ void openEMS::collectCommandLineArguments()
 	// register our supported options to g_settings
 	g_settings.appendOptionDesc(optionDesc());
 	g_settings.appendOptionDesc(g_settings.optionDesc());
+	g_settings.appendOptionDesc(Engine_Multithread::optionDesc());
+	g_settings.appendOptionDesc(ProcessFields::optionDesc());
+	g_settings.appendOptionDesc(ProcessFieldsTD::optionDesc());
+	g_settings.appendOptionDesc(Engine_Tiling::optionDesc());
+#ifdef MPI_SUPPORT
+	g_settings.appendOptionDesc(Engine_MPI::optionDesc());
+#endif
 }
 
 po::options_description
@@ -251,11 +268,21 @@ openEMS::optionDesc()
 						cout << "openEMS - enabled compressed sse engine" << endl;
 						m_engine = EngineType_SSE_Compressed;
 					}
+					else if (val == "avx")
+					{
+						cout << "openEMS - enabled avx engine" << endl;
+						m_engine = EngineType_AVX;
+					}
 					else if (val == "multithreaded")
 					{
 						cout << "openEMS - enabled multithreading" << endl;
 						m_engine = EngineType_Multithreaded;
 					}
+					else if (val == "tiling")
+					{
+						cout << "openEMS - enabled multithreading with temporal blocking" << endl;
+						m_engine = EngineType_Tiling;
+					}
 				}
 			),
 		    "Choose engine type \n\n"
@@ -264,12 +291,16 @@ openEMS::optionDesc()
 			"  sse: \tengine using SSE vector extensions\n"
 			"  sse-compressed: \tengine using compressed "
 			"operator + sse vector extensions\n"
+			"  avx: \tsingle-threaded engine using AVX2 or AVX-512 vector extensions, "
+			"chosen at runtime (falls back to sse), ignores --numThreads\n"
 			"  multithreaded: \tengine using compressed "
 #ifdef MPI_SUPPORT
 			"operator + sse vector extensions + MPI + multithreading\n"
 #else
 			"operator + sse vector extensions + multithreading\n"
 #endif
+			"  tiling: \tmultithreaded engine using temporal blocking, "
+			"see --tilingSteps and --tilingWidth\n"
 		)
 		(
 			"numThreads",
@@ -297,6 +328,96 @@ openEMS::optionDesc()
 			),
 			"only run preprocessing; do not simulate"
 		)
+		(
+			"disable-engine-sampling",
+			po::bool_switch()->notifier(
+				[&](bool val)
+				{
+					if (!val) return;
+					cout << "openEMS - disabling probe sampling by the engine" << endl;
+					m_EngineSampling = false;
+				}
+			),
+			"Process all probes from the main loop instead of sampling them during the engine iterations"
+		)
+		(
+			"no-result-files",
+			po::bool_switch()->notifier(
+				[&](bool val)
+				{
+					if (!val) return;
+					cout << "openEMS - keeping probe and frequency domain dump results in memory only" << endl;
+					m_ResultFileOutput = false;
+				}
+			),
+			"Do not write probe and frequency domain field dump results to file (library use only)"
+		)
+		(
+			"keep-probe-results",
+			po::bool_switch()->notifier(
+				[&](bool val)
+				{
+					if (!val) return;
+					cout << "openEMS - keeping the probe time domain results in memory" << endl;
+					m_KeepProbeResults = true;
+				}
+			),
+			"Keep the probe time domain results in memory, also if they are written to file (library use only)"
+		)
+		(
+			"probe-file-type",
+			po::value<std::string>()->notifier(
+				[&](std::string val)
+				{
+					if (val=="hdf5")
+						m_ProbeFileType = 1;
+					else if (val=="ascii")
+						m_ProbeFileType = 0;
+					else
+					{
+						cerr << "openEMS - unknown probe file type '" << val << "', using ascii" << endl;
+						return;
+					}
+					cout << "openEMS - writing " << val << " probe files" << endl;
+				}
+			),
+			"Choose the probe file type\n\n"
+			"  ascii: \ttext files (default)\n"
+			"  hdf5: \tbuffered and chunked binary files <probe name>.h5\n"
+		)
+		(
+			"pml-type",
+			po::value<std::string>()->notifier(
+				[&](std::string val)
+				{
+					if (val=="cpml")
+						m_PML_type = 1;
+					else if (val=="upml")
+						m_PML_type = 0;
+					else
+					{
+						cerr << "openEMS - unknown pml type '" << val << "', using upml" << endl;
+						return;
+					}
+					cout << "openEMS - using the " << val << " absorbing boundary" << endl;
+				}
+			),
+			"Choose the implementation of the PML boundary conditions\n\n"
+			"  upml: \tuniaxial pml (default)\n"
+			"  cpml: \tconvolutional pml, less memory and faster updates (cartesian meshes only)\n"
+		)
+		(
+			"operator-cache",
+			po::value<std::string>()->notifier(
+				[&](std::string val)
+				{
+					cout << "openEMS - using operator cache directory '" << val << "'" << endl;
+					m_OperatorCacheDir = val;
+				}
+			),
+			"Store the FDTD operator in the given directory and reload it "
+			"if the geometry, mesh and timestep settings are unchanged"
+		)
 		(
 			"dump-statistics",
 			po::bool_switch()->notifier(
@@ -406,8 +527,11 @@ bool openEMS::SetupBoundaryConditions()
 	}
 
 
-	//create the upml
-	Operator_Ext_UPML::Create_UPML(FDTD_Op, m_BC_type, m_PML_size, string());
+	//create the pml
+	if (m_PML_type==1)
+		Operator_Ext_CPML::Create_CPML(FDTD_Op, m_BC_type, m_PML_size, string());
+	else
+		Operator_Ext_UPML::Create_UPML(FDTD_Op, m_BC_type, m_PML_size, string());
 
 	return true;
 }
@@ -473,6 +597,12 @@ Engine_Interface_FDTD* openEMS::NewEngineInterface(int multigridlevel)
 	Operator_Cylinder* op_cyl = dynamic_cast<Operator_Cylinder*>(FDTD_Op);
 	if (op_cyl)
 		return new Engine_Interface_Cylindrical_FDTD(op_cyl);
+	Operator_AVX<f16vector>* op_avx512 = dynamic_cast<Operator_AVX<f16vector>*>(FDTD_Op);
+	if (op_avx512)
+		return new Engine_Interface_AVX_FDTD<f16vector>(op_avx512);
+	Operator_AVX<f8vector>* op_avx2 = dynamic_cast<Operator_AVX<f8vector>*>(FDTD_Op);
+	if (op_avx2)
+		return new Engine_Interface_AVX_FDTD<f8vector>(op_avx2);
 	Operator_sse* op_sse = dynamic_cast<Operator_sse*>(FDTD_Op);
 	if (op_sse)
 		return new Engine_Interface_SSE_FDTD(op_sse);
@@ -582,6 +712,10 @@ bool openEMS::SetupProcessing()
 				if (g_settings.showProbeDiscretization())
 					proc->ShowSnappedCoords();
 				proc->SetWeight(pb->GetWeighting());
+				proc->SetFileOutput(m_ResultFileOutput);
+				proc->SetKeepTDResults(m_KeepProbeResults);
+				if (m_ProbeFileType==1)
+					proc->SetFileType(ProcessIntegral::HDF5_FILETYPE);
 				PA->AddProcessing(proc);
 				prim->SetPrimitiveUsed(true);
 			}
@@ -593,6 +727,14 @@ bool openEMS::SetupProcessing()
 	{
 		ProcessFields* ProcField=NULL;
 
+		// a nf2ff box combines all its primitives into a single far-field processing
+		CSPropDumpBox* nf2ff_db = DumpProps.at(i)->ToDumpBox();
+		if (nf2ff_db && (nf2ff_db->GetDumpType()==30))
+		{
+			SetupNF2FFProcessing(nf2ff_db, Nyquist/m_OverSampling);
+			continue;
+		}
+
 		//check whether one or more probe boxes are defined
 		l_MultiBox =  (DumpProps.at(i)->GetQtyPrimitives()>1);
 
@@ -668,6 +810,8 @@ bool openEMS::SetupProcessing()
 
 						ProcField->SetDumpMode((Engine_Interface_Base::InterpolationType)db->GetDumpMode());
 						ProcField->SetFileType((ProcessFields::FileType)db->GetFileType());
+						if ((db->GetDumpType()>=10) && (db->GetDumpType()<=15))
+							ProcField->SetFileOutput(m_ResultFileOutput);
 						if (CylinderCoords)
 							ProcField->SetMeshType(Processing::CYLINDRICAL_MESH);
 						if (db->GetSubSampling())
@@ -697,6 +841,80 @@ bool openEMS::SetupProcessing()
 	return true;
 }
 
+bool openEMS::SetupNF2FFProcessing(CSPropDumpBox* db, unsigned int interval)
+{
+	vector<float> theta = SplitString2Float(db->GetAttributeValue("Theta"));
+	vector<float> phi = SplitString2Float(db->GetAttributeValue("Phi"));
+	if ((theta.size()==0) || (phi.size()==0))
+	{
+		cerr << "openEMS::SetupNF2FFProcessing: Error: No theta or phi angles defined for nf2ff box: " << db->GetName() << " ... skipping!" << endl;
+		return false;
+	}
+
+	ProcessNF2FF* proc = new ProcessNF2FF(NewEngineInterface(db->GetMultiGridLevel()));
+	proc->SetEnable(Enable_Dumps);
+	proc->SetProcessInterval(interval);
+	proc->AddFrequency(db->GetFDSamples());
+	if (CylinderCoords)
+		proc->SetMeshType(Processing::CYLINDRICAL_MESH);
+	proc->SetName(db->GetName());
+	proc->SetFileName(db->GetName()+".h5");
+	proc->SetAngles(theta, phi);
+
+	string attr = db->GetAttributeValue("Center");
+	if (!attr.empty())
+		proc->SetCenter(SplitString2Float(attr));
+	attr = db->GetAttributeValue("Radius");
+	if (!attr.empty())
+		proc->SetRadius(atof(attr.c_str()));
+	attr = db->GetAttributeValue("Eps_r");
+	if (!attr.empty())
+		proc->SetPermittivity(SplitString2Float(attr));
+	attr = db->GetAttributeValue("Mue_r");
+	if (!attr.empty())
+		proc->SetPermeability(SplitString2Float(attr));
+
+	double start[3];
+	double stop[3];
+	double nf2ff_box[6] = {0,0,0,0,0,0};
+	for (size_t nb=0; nb<db->GetQtyPrimitives(); ++nb)
+	{
+		CSPrimitives* prim = db->GetPrimitive(nb);
+		if (prim==NULL)
+			continue;
+		double bnd[6] = {0,0,0,0,0,0};
+		prim->GetBoundBox(bnd,true);
+		for (int n=0; n<3; ++n)
+		{
+			start[n] = bnd[2*n];
+			stop[n] = bnd[2*n+1];
+			if ((nb==0) || (min(start[n],stop[n])<nf2ff_box[2*n]))
+				nf2ff_box[2*n] = min(start[n],stop[n]);
+			if ((nb==0) || (max(start[n],stop[n])>nf2ff_box[2*n+1]))
+				nf2ff_box[2*n+1] = max(start[n],stop[n]);
+		}
+		proc->AddPlane(start, stop, NewEngineInterface(db->GetMultiGridLevel()), NewEngineInterface(db->GetMultiGridLevel()));
+		prim->SetPrimitiveUsed(true);
+	}
+
+	// mirror types for the lower and upper box faces in x, y and z, the nf2ff expects the positions in meter
+	vector<float> mirror = SplitString2Float(db->GetAttributeValue("Mirror"));
+	for (size_t n=0; n<mirror.size() && n<6; ++n)
+	{
+		if (mirror.at(n)<=0)
+			continue;
+		double pos = nf2ff_box[n];
+		if (!(CylinderCoords && (n/2==1)))
+			pos *= FDTD_Op->GetGridDelta();
+		proc->SetMirror((int)mirror.at(n), n/2, pos);
+	}
+
+	if (g_settings.showProbeDiscretization())
+		proc->ShowSnappedCoords();
+	PA->AddProcessing(proc);
+	return true;
+}
+
 bool openEMS::SetupMaterialStorages()
 {
 	vector<CSProperties*> DumpProps = m_CSX->GetPropertyByType(CSProperties::DUMPBOX);
@@ -747,10 +965,29 @@ bool openEMS::SetupOperator()
 	{
 		FDTD_Op = Operator_SSE_Compressed::New();
 	}
+	else if (m_engine == EngineType_AVX)
+	{
+		if (m_engine_numThreads>1)
+			cerr << "openEMS::SetupOperator: Warning: the avx engine is single-threaded, ignoring the requested number of threads" << endl;
+		unsigned int width = GetCPUVectorWidth();
+		if (width==16)
+			FDTD_Op = Operator_AVX<f16vector>::New();
+		else if (width==8)
+			FDTD_Op = Operator_AVX<f8vector>::New();
+		else
+		{
+			cerr << "openEMS::SetupOperator: Warning: CPU does not support AVX2 or AVX-512, falling back to sse engine" << endl;
+			FDTD_Op = Operator_sse::New();
+		}
+	}
 	else if (m_engine == EngineType_Multithreaded)
 	{
 		FDTD_Op = Operator_Multithread::New(m_engine_numThreads);
 	}
+	else if (m_engine == EngineType_Tiling)
+	{
+		FDTD_Op = Operator_Tiling::New(m_engine_numThreads);
+	}
 	else
 	{
 		FDTD_Op = Operator::New();
@@ -1100,6 +1337,8 @@ int openEMS::SetupFDTD()
 	if (m_TS_fac<1)
 		FDTD_Op->SetTimestepFactor(m_TS_fac);
 
+	FDTD_Op->SetOperatorCache(m_OperatorCacheDir);
+
 	// Is a steady state detection requested
 	Operator_Ext_SteadyState* Op_Ext_SSD = NULL;
 	if (m_Exc->GetSignalPeriod()>0)
@@ -1320,6 +1559,19 @@ void openEMS::RunFDTD()
 	//*************** simulate ************//
 
 	PA->PreProcess();
+
+	// let the engine sample the probes after every timestep, so it can iterate longer batches
+	if (m_EngineSampling && FDTD_Eng->SetTimestepSampler(std::bind(&ProcessingArray::SampleTimestep, PA, std::placeholders::_1, std::placeholders::_2)))
+	{
+		if (PA->EnableEngineSampling())
+		{
+			if (g_settings.GetVerboseLevel()>0)
+				cout << "RunFDTD: Probes are sampled by the engine." << endl;
+		}
+		else
+			FDTD_Eng->SetTimestepSampler(std::function<void(unsigned int, unsigned int)>());
+	}
+
 	int step=PA->Process();
 	if ((step<0) || (step>(int)NrTS)) step=NrTS;
 	while ((FDTD_Eng->GetNumberOfTimesteps()<NrTS) && (change>endCrit) && !CheckAbortCond())
@@ -1391,6 +1643,52 @@ void openEMS::RunFDTD()
 	Signal::SetupHandlerForSIGINT(SIGNAL_ORIGINAL);
 }
 
+bool openEMS::GetProbeData(const string& name, ProbeData& data) const
+{
+	if (PA==NULL)
+		return false;
+	ProcessIntegral* proc = dynamic_cast<ProcessIntegral*>(PA->GetProcessingByName(name));
+	if (proc==NULL)
+		return false;
+
+	data.numIntegrals = proc->GetNumberOfIntegrals();
+	data.names.clear();
+	data.FD.clear();
+	for (unsigned int n=0; n<data.numIntegrals; ++n)
+	{
+		data.names.push_back(proc->GetIntegralName(n));
+		data.FD.push_back(proc->GetFDData(n));
+	}
+	data.numTDSamples = proc->GetNumberOfTDSamples();
+	data.TD = proc->GetTDData();
+	data.numFDSamples = proc->GetNumberOfFDSamples();
+	data.frequencies = proc->GetFDFrequencies();
+	return true;
+}
+
+bool openEMS::GetFieldDumpData(const string& name, FieldDumpData& data) const
+{
+	if (PA==NULL)
+		return false;
+	ProcessFieldsFD* proc = dynamic_cast<ProcessFieldsFD*>(PA->GetProcessingByName(name));
+	if ((proc==NULL) || (proc->GetEnable()==false))
+		return false;
+
+	data.meshType = CylinderCoords ? 1 : 0;
+	data.gridDelta = FDTD_Op->GetGridDelta();
+	for (int n=0; n<3; ++n)
+	{
+		data.numLines[n] = proc->GetNumLines(n);
+		data.lines[n] = proc->GetDiscLines(n);
+	}
+	data.numFDSamples = proc->GetNumberOfFDSamples();
+	data.frequencies = proc->GetFDFrequencies();
+	data.FD.clear();
+	for (size_t n=0; n<data.numFDSamples; ++n)
+		data.FD.push_back(proc->GetFDFieldData(n));
+	return true;
+}
+
 bool openEMS::DumpStatistics(const string& filename, double time)
 {
 	ofstream stat_file;
@@ -26,6 +26,7 @@
 #endif
 #include <time.h>
 #include <vector>
+#include <complex>
 
 #include <boost/program_options.hpp>
 #include "openems_global.h"
@@ -42,6 +43,31 @@ class ContinuousStructure;
 class Engine_Interface_FDTD;
 class Excitation;
 class Engine_Ext_SteadyState;
+class CSPropDumpBox;
+
+//! In-memory results of a probe, see openEMS::GetProbeData(). All pointers are owned by openEMS.
+struct ProbeData
+{
+	unsigned int numIntegrals;
+	std::vector<std::string> names; //!< name of each integral
+	size_t numTDSamples;
+	const double* TD; //!< time followed by all integrals for every time domain sample
+	size_t numFDSamples;
+	const double* frequencies;
+	std::vector<const std::complex<double>*> FD; //!< frequency domain result of each integral
+};
+
+//! In-memory results of a frequency domain field dump, see openEMS::GetFieldDumpData(). All pointers are owned by openEMS.
+struct FieldDumpData
+{
+	int meshType; //!< 0 for a cartesian and 1 for a cylindrical mesh
+	double gridDelta; //!< scaling of the mesh lines (except the cylindrical alpha direction)
+	unsigned int numLines[3];
+	const double* lines[3];
+	size_t numFDSamples;
+	const double* frequencies;
+	std::vector<const std::complex<float>*> FD; //!< field of each frequency in (x,y,z,component) order
+};
 
 double CalcDiffTime(timeval t1, timeval t2);
 std::string FormatTime(int sec);
@@ -77,6 +103,15 @@ public:
 	void SetTimeStepFactor(double val) {m_TS_fac=val;}
 	void SetMaxTime(double val) {m_maxTime=val;}
 
+	//! Enable or disable writing probe and frequency domain field dump results to file. \sa GetProcessingArray
+	/*!
+	  Without file output the probe time domain results are kept in memory, with file output only if enabled by SetKeepProbeResults() (--keep-probe-results).
+	  The frequency domain results are always kept in memory.
+	  */
+	void SetResultFileOutput(bool val) {m_ResultFileOutput=val;}
+	//! Keep the probe time domain results in memory, also if they are written to file. \sa GetProbeData
+	void SetKeepProbeResults(bool val) {m_KeepProbeResults=val;}
+
 	// used by Python binding when running as a shared library
 	void SetLibraryArguments(std::vector<std::string> allOptions);
 
@@ -119,6 +154,14 @@ public:
 
 	void SetVerboseLevel(int level);
 
+	//! Get all processings, e.g. to access the probe results after RunFDTD(). They are valid until the next Reset() or SetupFDTD().
+	ProcessingArray* GetProcessingArray() const {return PA;}
+
+	//! Get the in-memory results of the probe with the given name, returns false if no such probe exists.
+	bool GetProbeData(const std::string& name, ProbeData& data) const;
+	//! Get the in-memory results of the frequency domain field dump with the given name, returns false if no such dump exists.
+	bool GetFieldDumpData(const std::string& name, FieldDumpData& data) const;
+
 protected:
 	void collectCommandLineArguments();
 
@@ -141,6 +184,11 @@ protected:
 	bool m_debugCSX;
 	bool m_DumpStats;
 	bool m_debugBox, m_debugPEC, m_no_simulation;
+	std::string m_OperatorCacheDir;
+	bool m_EngineSampling;
+	bool m_ResultFileOutput;
+	bool m_KeepProbeResults;
+	int m_ProbeFileType; //!< 0 for ascii and 1 for hdf5 probe files
 
 	double endCrit;
 	int m_OverSampling;
@@ -155,9 +203,9 @@ protected:
 	bool m_Abort;
 
 #ifdef MPI_SUPPORT
-	enum EngineType {EngineType_Basic, EngineType_SSE, EngineType_SSE_Compressed, EngineType_Multithreaded, EngineType_MPI};
+	enum EngineType {EngineType_Basic, EngineType_SSE, EngineType_SSE_Compressed, EngineType_AVX, EngineType_Multithreaded, EngineType_Tiling, EngineType_MPI};
 #else
-	enum EngineType {EngineType_Basic, EngineType_SSE, EngineType_SSE_Compressed, EngineType_Multithreaded};
+	enum EngineType {EngineType_Basic, EngineType_SSE, EngineType_SSE_Compressed, EngineType_AVX, EngineType_Multithreaded, EngineType_Tiling};
 #endif
 	EngineType m_engine;
 	unsigned int m_engine_numThreads;
@@ -169,6 +217,7 @@ protected:
 	bool SetupBoundaryConditions();
 	int m_BC_type[6];
 	unsigned int m_PML_size[6];
+	int m_PML_type; //!< 0 for the uniaxial (upml) and 1 for the convolutional pml (cpml)
 	double m_Mur_v_ph[6];
 
 	//! Setup local absorbing boundary conditions
@@ -180,6 +229,9 @@ protected:
 	//! Setup all processings.
 	virtual bool SetupProcessing();
 
+	//! Setup a near-field to far-field transformation during the simulation run for the given (DumpType 30) dump box.
+	bool SetupNF2FFProcessing(CSPropDumpBox* db, unsigned int interval);
+
 	//! Dump statistics to file
 	virtual bool DumpStatistics(const std::string& filename, double time);
 
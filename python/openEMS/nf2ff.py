@@ -34,6 +34,10 @@ class nf2ff:
     :param directions: (6,) bool array -- Enable/Disables directions.
     :param mirror: (6,) int array -- 0 (Off), 1 (PEC) or 2 (PMC) boundary mirroring
     :param frequency: array like -- List of frequencies (FD-domain recording)
+    :param far_field: dict -- Calculate the far-field during the simulation, requires `frequency`.
+                      Keys: theta, phi (in degrees), radius (default 1) and center (default [0,0,0]).
+                      No surface fields are written to disk, use CalcNF2FF to read the result.
+                      Not supported if the box is split between MPI ranks, the calculation is deactivated then.
     """
     def __init__(self, CSX, name, start, stop, **kw):
         self.CSX   = CSX
@@ -70,14 +74,34 @@ class nf2ff:
             if np.isscalar(self.freq):
                 self.freq = [self.freq]
 
+        self.far_field = None
+        if 'far_field' in kw:
+            self.far_field = kw['far_field']
+            del kw['far_field']
+            if self.freq is None:
+                raise Exception('nf2ff: a far-field calculation during the simulation requires a frequency')
+
         self.e_file = '{}_E'.format(self.name)
         self.h_file = '{}_H'.format(self.name)
 
-        self.e_dump = CSX.AddDump(self.e_file, dump_type=self.dump_type  , dump_mode=self.dump_mode, file_type=1, **kw)
-        self.h_dump = CSX.AddDump(self.h_file, dump_type=self.dump_type+1, dump_mode=self.dump_mode, file_type=1, **kw)
-        if self.freq is not None:
-            self.e_dump.SetFrequency(self.freq)
-            self.h_dump.SetFrequency(self.freq)
+        if self.far_field is not None:
+            # a single dump (type 30) for the nf2ff processing in openEMS
+            ff = self.far_field
+            self.ff_dump = CSX.AddDump(self.name, dump_type=30, dump_mode=self.dump_mode, file_type=1, **kw)
+            self.ff_dump.SetFrequency(self.freq)
+            self.ff_dump.AddAttribute('Theta', ','.join(str(v) for v in np.deg2rad(np.atleast_1d(ff['theta']))))
+            self.ff_dump.AddAttribute('Phi', ','.join(str(v) for v in np.deg2rad(np.atleast_1d(ff['phi']))))
+            self.ff_dump.AddAttribute('Radius', str(ff.get('radius', 1)))
+            self.ff_dump.AddAttribute('Center', ','.join(str(v) for v in ff.get('center', [0,0,0])))
+            self.ff_dump.AddAttribute('Mirror', ','.join(str(v) for v in self.mirror))
+            dumps = [self.ff_dump]
+        else:
+            self.e_dump = CSX.AddDump(self.e_file, dump_type=self.dump_type  , dump_mode=self.dump_mode, file_type=1, **kw)
+            self.h_dump = CSX.AddDump(self.h_file, dump_type=self.dump_type+1, dump_mode=self.dump_mode, file_type=1, **kw)
+            if self.freq is not None:
+                self.e_dump.SetFrequency(self.freq)
+                self.h_dump.SetFrequency(self.freq)
+            dumps = [self.e_dump, self.h_dump]
 
 #        print(self.directions)
         for ny in range(3):
@@ -86,19 +110,22 @@ class nf2ff:
                 l_start = np.array(start)
                 l_stop  = np.array(stop)
                 l_stop[ny] = l_start[ny]
-                self.e_dump.AddBox(l_start, l_stop)
-                self.h_dump.AddBox(l_start, l_stop)
+                for dump in dumps:
+                    dump.AddBox(l_start, l_stop)
             if self.directions[pos+1]:
                 l_start = np.array(start)
                 l_stop  = np.array(stop)
                 l_start[ny] = l_stop[ny]
-                self.e_dump.AddBox(l_start, l_stop)
-                self.h_dump.AddBox(l_start, l_stop)
+                for dump in dumps:
+                    dump.AddBox(l_start, l_stop)
 
     def CalcNF2FF(self, sim_path, freq, theta, phi, radius=1, center=[0,0,0], outfile=None, read_cached=False, verbose=0):
         """ CalcNF2FF(sim_path, freq, theta, phi, center=[0,0,0], outfile=None, read_cached=True, verbose=0):
 
-        Calculate the far-field after the simulation is done.
+        Calculate the far-field after the simulation is done, or read the result
+        if it was already calculated during the simulation (see `far_field`).
+        In the latter case freq, theta, phi, radius and center must match the
+        far-field settings and outfile is not supported.
 
         :param sim_path: str -- Simulation path
         :param freq: array like -- list of frequency for transformation
@@ -111,6 +138,22 @@ class nf2ff:
 
         :returns: nf2ff_results class instance
         """
+        if self.far_field is not None:
+            # the far-field settings were fixed at the setup, they must match the requested ones
+            ff = self.far_field
+            if outfile is not None:
+                raise Exception('CalcNF2FF:: outfile is not supported, the far-field calculated during the simulation is stored in {}.h5'.format(self.name))
+            if not utilities.Check_Array_Equal(np.atleast_1d(freq), np.atleast_1d(self.freq), 1e-6, relative=True):
+                raise Exception('CalcNF2FF:: Frequency array does not match the far-field calculated during the simulation')
+            if not utilities.Check_Array_Equal(np.atleast_1d(theta), np.atleast_1d(ff['theta']), 1e-4):
+                raise Exception('CalcNF2FF:: Theta array does not match the far-field calculated during the simulation')
+            if not utilities.Check_Array_Equal(np.atleast_1d(phi), np.atleast_1d(ff['phi']), 1e-4):
+                raise Exception('CalcNF2FF:: Phi array does not match the far-field calculated during the simulation')
+            if not np.abs((ff.get('radius', 1)-radius)/radius)<1e-6:
+                raise Exception('CalcNF2FF:: Radius does not match the far-field calculated during the simulation')
+            if not np.allclose(np.array(center, dtype=float), np.array(ff.get('center', [0,0,0]), dtype=float)):
+                raise Exception('CalcNF2FF:: Center does not match the far-field calculated during the simulation')
+
         if np.isscalar(freq):
             freq = [freq]
         self.freq  = freq
@@ -126,6 +169,12 @@ class nf2ff:
             fn = os.path.join(sim_path, self.name + '.h5')
         else:
             fn = os.path.join(sim_path,  outfile)
+        if self.far_field is not None:
+            # the far-field was already calculated during the simulation
+            fn = os.path.join(sim_path, self.name + '.h5')
+            if not os.path.exists(fn):
+                raise Exception('CalcNF2FF:: Far-field result {} not found, did the simulation run?'.format(fn))
+            read_cached = True
         if  not read_cached or not os.path.exists(fn):
             nfc = _nf2ff._nf2ff(self.freq, np.deg2rad(theta), np.deg2rad(phi), center, verbose=verbose)
 
@@ -18,11 +18,30 @@
 
 from libcpp.string cimport string
 from libcpp.vector cimport vector
+from libcpp.complex cimport complex
 from libcpp cimport bool
 
 from CSXCAD.CSXCAD cimport _ContinuousStructure, ContinuousStructure
 
 cdef extern from "openEMS/openems.h":
+    cdef cppclass ProbeData:
+        unsigned int numIntegrals
+        vector[string] names
+        size_t numTDSamples
+        const double* TD
+        size_t numFDSamples
+        const double* frequencies
+        vector[const complex[double]*] FD
+
+    cdef cppclass FieldDumpData:
+        int meshType
+        double gridDelta
+        unsigned int numLines[3]
+        const double* lines[3]
+        size_t numFDSamples
+        const double* frequencies
+        vector[const complex[float]*] FD
+
     cdef cppclass _openEMS "openEMS":
         _openEMS() nogil except +
         void Reset()
@@ -61,9 +80,13 @@ cdef extern from "openEMS/openems.h":
         int SetupFDTD() nogil
         void RunFDTD()  nogil
 
+        bool GetProbeData(string name, ProbeData& data)
+        bool GetFieldDumpData(string name, FieldDumpData& data)
+
         @staticmethod
         void WelcomeScreen()
 
 cdef class openEMS:
     cdef  _openEMS *thisptr
     cdef readonly ContinuousStructure __CSX      # hold a C++ instance which we're wrapping
+    cdef int _num_exports                        # number of result buffers exported to numpy, see GetProbeData
@@ -19,6 +19,7 @@
 import os, sys, shutil
 import numpy as np
 cimport openEMS
+from cpython.buffer cimport PyBUF_WRITABLE
 from openEMS import ports, nf2ff, automesh
 from pathlib import Path
 
@@ -72,6 +73,7 @@ cdef class openEMS:
     def __cinit__(self, *args, **kw):
         self.thisptr = new _openEMS()
         self.__CSX = None
+        self._num_exports = 0
 
         if 'NrTS' in kw:
             self.SetNumberOfTimeSteps(kw['NrTS'])
@@ -114,8 +116,13 @@ cdef class openEMS:
             self.__CSX.thisptr = NULL
 
     def Reset(self):
+        self._CheckExports()
         self.thisptr.Reset()
 
+    def _CheckExports(self):
+        if self._num_exports>0:
+            raise BufferError('{} result array(s) of the last simulation are still in use, delete or copy them first'.format(self._num_exports))
+
     def SetNumberOfTimeSteps(self, val):
         """ SetNumberOfTimeSteps(val)
 
@@ -464,7 +471,7 @@ cdef class openEMS:
 
     def _SetLibraryArguments(self, arguments):
         allOptions = []
-        integerOptions = ["verbose", "numthreads"]
+        integerOptions = ["verbose", "numthreads", "fielddumpcompression"]
 
         for key, val in arguments.items():
             key = key.replace("_", "-")
@@ -522,7 +529,17 @@ cdef class openEMS:
           for debugging
         * nativeFieldDumps (bool) - dump all fields using the native field
           components
+        * probe_file_type (str) - 'ascii' (default) or 'hdf5' probe files
+        * fieldDumpCompression (int) - deflate level (1-9) of hdf5 field dumps
+        * extendibleTDFieldDumps (bool) - write all hdf5 time domain field
+          dumps into the single dataset /FieldData/TD/values
+        * no_result_files (bool) - do not write probe and frequency domain
+          field dump files, read the results with GetProbeData() and
+          GetFieldDumpData() instead
+        * keep_probe_results (bool) - keep the probe time domain results in
+          memory for GetProbeData(), also if the probe files are written
         """
+        self._CheckExports()
         if cleanup and os.path.exists(sim_path):
             shutil.rmtree(sim_path, ignore_errors=True)
             os.mkdir(sim_path)
@@ -548,3 +565,111 @@ cdef class openEMS:
 
     def SetAbort(self, val):
         self.thisptr.SetAbort(val)
+
+    def GetProbeData(self, name):
+        """ GetProbeData(name)
+
+        Get the results of a probe of the last simulation directly from memory.
+        The returned arrays are read-only views of the openEMS result buffers,
+        the data is not copied. They are valid until the next Run() or Reset(),
+        which will raise a BufferError as long as any of them is still in use.
+        The time domain results are only kept in memory if the simulation was run
+        with no_result_files or keep_probe_results, see Run().
+
+        :param name: str -- probe name, e.g. 'port_ut_1'
+        :returns: dict -- 'names': list of the integral names,
+                          'time': (N,) array of the sample times,
+                          'td': (N, numIntegrals) array of the time domain results,
+                          'freq': (F,) array of the probe frequencies,
+                          'fd': list of (F,) complex arrays, one for each integral
+        """
+        cdef ProbeData data
+        if not self.thisptr.GetProbeData(name.encode('UTF-8'), data):
+            raise KeyError('GetProbeData: probe "{}" not found'.format(name))
+        cdef Py_ssize_t N = data.numTDSamples
+        cdef Py_ssize_t nInt = data.numIntegrals
+        cdef Py_ssize_t row = (nInt+1)*sizeof(double)
+        res = dict(names = [n.decode('UTF-8') for n in data.names])
+        res['time'] = _ResultBuffer.create(self, data.TD, b'd', sizeof(double), [N], [row])
+        res['td']   = _ResultBuffer.create(self, data.TD+1 if data.TD!=NULL else NULL, b'd', sizeof(double), [N, nInt], [row, sizeof(double)])
+        res['freq'] = _ResultBuffer.create(self, data.frequencies, b'd', sizeof(double), [data.numFDSamples], [sizeof(double)])
+        res['fd']   = [_ResultBuffer.create(self, data.FD[n], b'Zd', 2*sizeof(double), [data.numFDSamples], [2*sizeof(double)]) for n in range(nInt)]
+        return res
+
+    def GetFieldDumpData(self, name):
+        """ GetFieldDumpData(name)
+
+        Get the fields of a frequency domain field dump of the last simulation
+        directly from memory. The field arrays are read-only views of the
+        openEMS result buffers, see GetProbeData() for their lifetime.
+
+        :param name: str -- dump box name
+        :returns: dict -- 'freq': (F,) array of the dump frequencies,
+                          'mesh': list of the three (scaled) mesh line arrays,
+                          'field': list of complex (Nx, Ny, Nz, 3) field arrays, one for each frequency
+        """
+        cdef FieldDumpData data
+        if not self.thisptr.GetFieldDumpData(name.encode('UTF-8'), data):
+            raise KeyError('GetFieldDumpData: frequency domain dump "{}" not found or not enabled'.format(name))
+        cdef Py_ssize_t isz = 2*sizeof(float)
+        cdef Py_ssize_t Nx = data.numLines[0], Ny = data.numLines[1], Nz = data.numLines[2]
+        mesh = []
+        for n in range(3):
+            lines = np.array([data.lines[n][i] for i in range(data.numLines[n])])
+            if data.meshType==1 and n==1:
+                mesh.append(lines) # the cylindrical alpha direction is not scaled
+            else:
+                mesh.append(lines*data.gridDelta)
+        res = dict(mesh = mesh)
+        res['freq']  = _ResultBuffer.create(self, data.frequencies, b'd', sizeof(double), [data.numFDSamples], [sizeof(double)])
+        res['field'] = [_ResultBuffer.create(self, data.FD[n], b'Zf', isz, [Nx, Ny, Nz, 3], [Ny*Nz*3*isz, Nz*3*isz, 3*isz, isz]) for n in range(data.numFDSamples)]
+        return res
+
+cdef class _ResultBuffer:
+    """
+    Read-only buffer protocol export of an openEMS result buffer, keeps the
+    openEMS instance alive and counts its exports as long as it is in use.
+    """
+    cdef openEMS owner
+    cdef const void* ptr
+    cdef bytes fmt
+    cdef Py_ssize_t itemsize
+    cdef int ndim
+    cdef Py_ssize_t shape[4]
+    cdef Py_ssize_t strides[4]
+
+    @staticmethod
+    cdef create(openEMS owner, const void* ptr, bytes fmt, Py_ssize_t itemsize, shape, strides):
+        if ptr==NULL or np.prod(shape)==0:
+            return np.zeros(shape, dtype=np.complex64 if fmt==b'Zf' else (np.complex128 if fmt==b'Zd' else np.float64))
+        cdef _ResultBuffer buf = _ResultBuffer.__new__(_ResultBuffer)
+        buf.owner = owner
+        buf.ptr = ptr
+        buf.fmt = fmt
+        buf.itemsize = itemsize
+        buf.ndim = len(shape)
+        for n in range(buf.ndim):
+            buf.shape[n] = shape[n]
+            buf.strides[n] = strides[n]
+        return np.asarray(buf)
+
+    def __getbuffer__(self, Py_buffer *buffer, int flags):
+        if flags & PyBUF_WRITABLE:
+            raise BufferError('openEMS result buffers are read-only')
+        buffer.buf = <void*>self.ptr
+        buffer.obj = self
+        buffer.len = self.itemsize
+        for n in range(self.ndim):
+            buffer.len *= self.shape[n]
+        buffer.readonly = 1
+        buffer.itemsize = self.itemsize
+        buffer.format = self.fmt
+        buffer.ndim = self.ndim
+        buffer.shape = self.shape
+        buffer.strides = self.strides
+        buffer.suboffsets = NULL
+        buffer.internal = NULL
+        self.owner._num_exports += 1
+
+    def __releasebuffer__(self, Py_buffer *buffer):
+        self.owner._num_exports -= 1
@@ -25,6 +25,12 @@ from openEMS import utilities
 from openEMS.physical_constants import *
 
 class UI_data:
+    """
+    Voltage or current probe data in time and frequency domain.
+
+    :param fns: str or list -- probe (file) names
+    :param path: str or openEMS -- simulation path, or the openEMS instance of a finished simulation to read the probes from memory
+    """
     def __init__(self, fns, path, freq, signal_type='pulse', **kw):
         self.path = path
         if type(fns)==str:
@@ -40,10 +46,24 @@ class UI_data:
         self.ui_f_val = []
 
         for fn in fns:
-            tmp = np.loadtxt(os.path.join(path, fn),comments='%')
-            self.ui_time.append(tmp[:,0])
-            self.ui_val.append(tmp[:,1])
-            self.ui_f_val.append(utilities.DFT_time2freq(tmp[:,0], tmp[:,1], freq, signal_type=signal_type))
+            if hasattr(path, 'GetProbeData'):
+                # read the probe directly from the memory of a finished simulation
+                data = path.GetProbeData(fn)
+                if len(data['time'])==0:
+                    raise Exception('No time domain data of probe "{}" in memory, run the simulation with no_result_files=True or keep_probe_results=True'.format(fn))
+                t, val = data['time'], data['td'][:,0]
+            elif os.path.exists(os.path.join(path, fn + '.h5')):
+                # hdf5 probe file, see openEMS option --probe-file-type
+                import h5py
+                with h5py.File(os.path.join(path, fn + '.h5'), 'r') as h5_file:
+                    tmp = h5_file['TD'][:]
+                t, val = tmp[:,0], tmp[:,1]
+            else:
+                tmp = np.loadtxt(os.path.join(path, fn),comments='%')
+                t, val = tmp[:,0], tmp[:,1]
+            self.ui_time.append(t)
+            self.ui_val.append(val)
+            self.ui_f_val.append(utilities.DFT_time2freq(t, val, freq, signal_type=signal_type))
 
 # Port Base-Class
 class Port(object):
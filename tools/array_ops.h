@@ -32,6 +32,8 @@
 #include "constants.h"
 
 #define F4VECTOR_SIZE 16 // sizeof(typeid(f4vector))
+#define F8VECTOR_SIZE 32 // sizeof(typeid(f8vector))
+#define F16VECTOR_SIZE 64 // sizeof(typeid(f16vector))
 
 #ifdef __GNUC__ // GCC
 typedef float v4sf __attribute__ ((vector_size (F4VECTOR_SIZE))); // vector of four single floats
@@ -40,13 +42,38 @@ union f4vector
 	v4sf v;
 	float f[4];
 };
+
+// wide vectors used by the AVX engine, only the kernels are compiled for AVX2/AVX-512 (see engine_avx.cpp)
+typedef float v8sf __attribute__ ((vector_size (F8VECTOR_SIZE))); // vector of eight single floats
+union f8vector
+{
+	v8sf v;
+	float f[8];
+};
+
+typedef float v16sf __attribute__ ((vector_size (F16VECTOR_SIZE))); // vector of sixteen single floats
+union f16vector
+{
+	v16sf v;
+	float f[16];
+};
 #else // MSVC
-#include <emmintrin.h>
+#include <immintrin.h>
 union f4vector
 {
 	__m128 v;
 	float f[4];
 };
+union f8vector
+{
+	__m256 v;
+	float f[8];
+};
+union f16vector
+{
+	__m512 v;
+	float f[16];
+};
 inline __m128 operator + (__m128 a, __m128 b) {return _mm_add_ps(a, b);}
 inline __m128 operator - (__m128 a, __m128 b) {return _mm_sub_ps(a, b);}
 inline __m128 operator * (__m128 a, __m128 b) {return _mm_mul_ps(a, b);}
@@ -56,6 +83,26 @@ inline __m128 & operator += (__m128 & a, __m128 b){a = a + b; return a;}
 inline __m128 & operator -= (__m128 & a, __m128 b){a = a - b; return a;}
 inline __m128 & operator *= (__m128 & a, __m128 b){a = a * b; return a;}
 inline __m128 & operator /= (__m128 & a, __m128 b){a = a / b; return a;}
+
+inline __m256 operator + (__m256 a, __m256 b) {return _mm256_add_ps(a, b);}
+inline __m256 operator - (__m256 a, __m256 b) {return _mm256_sub_ps(a, b);}
+inline __m256 operator * (__m256 a, __m256 b) {return _mm256_mul_ps(a, b);}
+inline __m256 operator / (__m256 a, __m256 b) {return _mm256_div_ps(a, b);}
+
+inline __m256 & operator += (__m256 & a, __m256 b){a = a + b; return a;}
+inline __m256 & operator -= (__m256 & a, __m256 b){a = a - b; return a;}
+inline __m256 & operator *= (__m256 & a, __m256 b){a = a * b; return a;}
+inline __m256 & operator /= (__m256 & a, __m256 b){a = a / b; return a;}
+
+inline __m512 operator + (__m512 a, __m512 b) {return _mm512_add_ps(a, b);}
+inline __m512 operator - (__m512 a, __m512 b) {return _mm512_sub_ps(a, b);}
+inline __m512 operator * (__m512 a, __m512 b) {return _mm512_mul_ps(a, b);}
+inline __m512 operator / (__m512 a, __m512 b) {return _mm512_div_ps(a, b);}
+
+inline __m512 & operator += (__m512 & a, __m512 b){a = a + b; return a;}
+inline __m512 & operator -= (__m512 & a, __m512 b){a = a - b; return a;}
+inline __m512 & operator *= (__m512 & a, __m512 b){a = a * b; return a;}
+inline __m512 & operator /= (__m512 & a, __m512 b){a = a / b; return a;}
 #endif
 
 void Delete1DArray_v4sf(f4vector* array);
@@ -82,7 +82,7 @@ public:
 			throw std::bad_alloc();
 		}
 #endif
-		memset(buf, 0, numelem * sizeof(T));
+		memset((void*) buf, 0, numelem * sizeof(T));
 		for (size_t i = 0; i < numelem; i++)
 			new (buf + i) T();
 
@@ -315,6 +315,27 @@ bool HDF5_File_Reader::ReadMesh(float** lines, unsigned int* numLines, int &mesh
 	return true;
 }
 
+bool HDF5_File_Reader::IsExtendibleTD(hid_t TD_grp)
+{
+	return H5Lexists(TD_grp, "values", H5P_DEFAULT)>0;
+}
+
+hsize_t HDF5_File_Reader::GetExtendibleTDSize(hid_t TD_grp)
+{
+	hid_t dataset = H5Dopen(TD_grp, "values", H5P_DEFAULT);
+	if (dataset<0)
+		return 0;
+	hid_t space = H5Dget_space(dataset);
+	hsize_t dims[5] = {0,0,0,0,0};
+	if (H5Sget_simple_extent_ndims(space)!=5)
+		cerr << "HDF5_File_Reader::GetExtendibleTDSize: data dimension invalid" << endl;
+	else
+		H5Sget_simple_extent_dims(space, dims, NULL);
+	H5Sclose(space);
+	H5Dclose(dataset);
+	return dims[0];
+}
+
 unsigned int HDF5_File_Reader::GetNumTimeSteps()
 {
 	if (IsValid()==false)
@@ -325,6 +346,14 @@ unsigned int HDF5_File_Reader::GetNumTimeSteps()
 	if (OpenGroup(hdf5_file, TD_grp, "/FieldData/TD")==false)
 		return false;
 
+	if (IsExtendibleTD(TD_grp))
+	{
+		hsize_t numTS = GetExtendibleTDSize(TD_grp);
+		H5Gclose(TD_grp);
+		H5Fclose(hdf5_file);
+		return numTS;
+	}
+
 	hsize_t numObj;
 	if (H5Gget_num_objs(TD_grp,&numObj)<0)
 	{
@@ -348,6 +377,34 @@ bool HDF5_File_Reader::ReadTimeSteps(vector<unsigned int> &timestep, vector<stri
 	if (OpenGroup(hdf5_file, TD_grp, "/FieldData/TD")==false)
 		return false;
 
+	if (IsExtendibleTD(TD_grp))
+	{
+		// all timesteps are stored in the dataset "values", their numbers in "timestep"
+		hsize_t numTS = GetExtendibleTDSize(TD_grp);
+		timestep.clear();
+		timestep.resize(numTS,0);
+		names.clear();
+		bool ok = true;
+		if (numTS>0)
+		{
+			hid_t dataset = H5Dopen(TD_grp, "timestep", H5P_DEFAULT);
+			ok = (dataset>=0) && (H5Dread(dataset, H5T_NATIVE_UINT, H5S_ALL, H5S_ALL, H5P_DEFAULT, &timestep[0])>=0);
+			if (dataset>=0)
+				H5Dclose(dataset);
+		}
+		if (!ok)
+			cerr << "HDF5_File_Reader::ReadTimeSteps: can't read the timesteps" << endl;
+		for (hsize_t n=0;n<numTS;++n)
+		{
+			stringstream ss;
+			ss << timestep.at(n);
+			names.push_back(ss.str());
+		}
+		H5Gclose(TD_grp);
+		H5Fclose(hdf5_file);
+		return ok;
+	}
+
 	hsize_t numObj;
 	if (H5Gget_num_objs(TD_grp,&numObj)<0)
 	{
@@ -401,6 +458,14 @@ float**** HDF5_File_Reader::GetTDVectorData(size_t idx, float &time, unsigned in
 	if (OpenGroup(hdf5_file, TD_grp, "/FieldData/TD")==false)
 		return NULL;
 
+	if (IsExtendibleTD(TD_grp))
+	{
+		float**** field = GetExtendibleTDVectorData(TD_grp, idx, time, data_size);
+		H5Gclose(TD_grp);
+		H5Fclose(hdf5_file);
+		return field;
+	}
+
 	hsize_t numObj;
 	if (H5Gget_num_objs(TD_grp,&numObj)<0)
 	{
@@ -488,6 +553,81 @@ float**** HDF5_File_Reader::GetTDVectorData(size_t idx, float &time, unsigned in
 	return field;
 }
 
+float**** HDF5_File_Reader::GetExtendibleTDVectorData(hid_t TD_grp, size_t idx, float &time, unsigned int data_size[4])
+{
+	hid_t dataset = H5Dopen(TD_grp, "values", H5P_DEFAULT);
+	if (dataset<0)
+		return NULL;
+	hid_t space = H5Dget_space(dataset);
+	hsize_t dims[5];
+	if ((H5Sget_simple_extent_ndims(space)!=5) || (H5Sget_simple_extent_dims(space, dims, NULL)<0) || (dims[1]!=3))
+	{
+		cerr << "HDF5_File_Reader::GetTDVectorData: vector data dimension invalid" << endl;
+		H5Sclose(space);
+		H5Dclose(dataset);
+		return NULL;
+	}
+	if (idx>=dims[0])
+	{
+		H5Sclose(space);
+		H5Dclose(dataset);
+		return NULL;
+	}
+
+	// read the time and field of the requested timestep only
+	hid_t time_ds = H5Dopen(TD_grp, "time", H5P_DEFAULT);
+	hid_t time_space = (time_ds>=0) ? H5Dget_space(time_ds) : -1;
+	hsize_t t_offset[1] = {idx};
+	hsize_t t_count[1] = {1};
+	hid_t t_memspace = H5Screate_simple(1, t_count, NULL);
+	bool ok = (time_space>=0) && (H5Sselect_hyperslab(time_space, H5S_SELECT_SET, t_offset, NULL, t_count, NULL)>=0);
+	ok = ok && (H5Dread(time_ds, H5T_NATIVE_FLOAT, t_memspace, time_space, H5P_DEFAULT, &time)>=0);
+	H5Sclose(t_memspace);
+	if (time_space>=0)
+		H5Sclose(time_space);
+	if (time_ds>=0)
+		H5Dclose(time_ds);
+	if (!ok)
+	{
+		cerr << "HDF5_File_Reader::GetTDVectorData: can't read the time of the timestep!" << endl;
+		H5Sclose(space);
+		H5Dclose(dataset);
+		return NULL;
+	}
+
+	hsize_t offset[5] = {idx,0,0,0,0};
+	hsize_t count[5] = {1,3,dims[2],dims[3],dims[4]};
+	hid_t memspace = H5Screate_simple(5, count, NULL);
+	float* data = new float[3*dims[2]*dims[3]*dims[4]];
+	ok = (H5Sselect_hyperslab(space, H5S_SELECT_SET, offset, NULL, count, NULL)>=0);
+	ok = ok && (H5Dread(dataset, H5T_NATIVE_FLOAT, memspace, space, H5P_DEFAULT, data)>=0);
+	H5Sclose(memspace);
+	H5Sclose(space);
+	H5Dclose(dataset);
+	if (!ok)
+	{
+		cerr << "HDF5_File_Reader::GetTDVectorData: error reading data" << endl;
+		delete[] data;
+		return NULL;
+	}
+
+	data_size[0]=dims[4];
+	data_size[1]=dims[3];
+	data_size[2]=dims[2];
+	data_size[3]=3;
+	size_t pos = 0;
+	float**** field = Create_N_3DArray<float>(data_size);
+	for (unsigned int d=0;d<3;++d)
+		for (unsigned int k=0;k<data_size[2];++k)
+			for (unsigned int j=0;j<data_size[1];++j)
+				for (unsigned int i=0;i<data_size[0];++i)
+				{
+					field[d][i][j][k]=data[pos++];
+				}
+	delete[] data;
+	return field;
+}
+
 unsigned int HDF5_File_Reader::GetNumFrequencies()
 {
 	vector<float> frequencies;
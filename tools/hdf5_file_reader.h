@@ -32,7 +32,7 @@ public:
 
 	bool ReadMesh(float** lines, unsigned int* numLines, int &meshType);
 
-	//! Get the number of timesteps stored at /FieldData/TD/<NUMBER_OF_TS>
+	//! Get the number of timesteps stored at /FieldData/TD/<NUMBER_OF_TS> or in the extendible dataset /FieldData/TD/values
 	unsigned int GetNumTimeSteps();
 	bool ReadTimeSteps(std::vector<unsigned int> &timestep, std::vector<std::string> &names);
 
@@ -74,6 +74,11 @@ protected:
 	bool ReadDataSet(std::string ds_name, hsize_t &nDim, hsize_t* &dims, float* &data);
 
 	bool OpenGroup(hid_t &file, hid_t &group, std::string groupName);
+
+	//! Check for the extendible TD layout, all timesteps in /FieldData/TD/values with their "time" and "timestep" datasets
+	bool IsExtendibleTD(hid_t TD_grp);
+	hsize_t GetExtendibleTDSize(hid_t TD_grp);
+	float**** GetExtendibleTDVectorData(hid_t TD_grp, size_t idx, float &time, unsigned int data_size[4]);
 };
 
 #endif // HDF5_FILE_READER_H
@@ -19,26 +19,249 @@ using namespace std;
 
 #include "hdf5_file_writer.h"
 #include <boost/algorithm/string.hpp>
+#include <boost/thread/mutex.hpp>
 #include <hdf5.h>
 
 #include <sstream>
 #include <iostream>
 #include <iomanip>
 
+namespace
+{
+// hdf5 is usually not built thread-safe, all file accesses are serialized (see ProcessFieldsTD)
+boost::mutex& HDF5_Mutex()
+{
+	static boost::mutex mtx;
+	return mtx;
+}
+}
+
 HDF5_File_Writer::HDF5_File_Writer(string filename)
 {
 	m_filename = filename;
+#ifdef HDF5_PARALLEL_DUMPS
+	m_Comm = MPI_COMM_NULL;
+	m_Rank = 0;
+	m_HasDomain = false;
+#endif
+	Create();
+}
+
+#ifdef HDF5_PARALLEL_DUMPS
+HDF5_File_Writer::HDF5_File_Writer(string filename, MPI_Comm comm)
+{
+	m_filename = filename;
+	m_Comm = comm;
+	MPI_Comm_rank(m_Comm, &m_Rank);
+	m_HasDomain = false;
+	Create();
+}
+
+void HDF5_File_Writer::SetDomain(unsigned int const* localSize, unsigned int const* globalSize, unsigned int const* offset)
+{
+	m_HasDomain = true;
+	for (int n=0; n<3; ++n)
+	{
+		m_LocalSize[n] = localSize[n];
+		m_GlobalSize[n] = globalSize[n];
+		m_Offset[n] = offset[n];
+	}
+}
+#endif
+
+void HDF5_File_Writer::Create()
+{
 	m_Group = "/";
-	hid_t hdf5_file = H5Fcreate(m_filename.c_str(), H5F_ACC_TRUNC, H5P_DEFAULT, H5P_DEFAULT);
-	if (hdf5_file<0)
+	m_GroupID = -1;
+	m_Compression = 0;
+	boost::mutex::scoped_lock lock(HDF5_Mutex());
+	hid_t fapl = CreateFileAccessProperties();
+	m_File = H5Fcreate(m_filename.c_str(), H5F_ACC_TRUNC, H5P_DEFAULT, fapl);
+	H5Pclose(fapl);
+	if (m_File<0)
 	{
 		cerr << "HDF5_File_Writer::HDF5_File_Writer: Error, creating the given file """ << m_filename << """ failed" << endl;
 	}
-	H5Fclose(hdf5_file);
+}
+
+bool HDF5_File_Writer::IsRoot() const
+{
+#ifdef HDF5_PARALLEL_DUMPS
+	return m_Rank==0;
+#else
+	return true;
+#endif
+}
+
+hid_t HDF5_File_Writer::CreateFileAccessProperties() const
+{
+	hid_t fapl = H5Pcreate(H5P_FILE_ACCESS);
+#ifdef HDF5_PARALLEL_DUMPS
+	if (m_Comm!=MPI_COMM_NULL)
+		H5Pset_fapl_mpio(fapl, m_Comm, MPI_INFO_NULL);
+#endif
+	return fapl;
+}
+
+vector<hsize_t> HDF5_File_Writer::GetFileDims(size_t dim, size_t const* datasize, bool fieldData) const
+{
+	vector<hsize_t> dims(datasize, datasize+dim);
+#ifdef HDF5_PARALLEL_DUMPS
+	if (fieldData && m_HasDomain && (m_Comm!=MPI_COMM_NULL) && (dim>=3))
+		for (int n=0; n<3; ++n)
+			dims[dim-1-n] = m_GlobalSize[n];
+#else
+	(void)fieldData;
+#endif
+	return dims;
+}
+
+bool HDF5_File_Writer::WriteSelection(hid_t dataset, hid_t mem_type, void const* buf, size_t dim, size_t const* datasize, hsize_t const* offset, bool fieldData)
+{
+	vector<hsize_t> memDims(datasize, datasize+dim);
+	vector<hsize_t> count(memDims);
+	vector<hsize_t> fileOffset(offset, offset+dim);
+	hid_t xfer = H5P_DEFAULT;
+#ifdef HDF5_PARALLEL_DUMPS
+	if (m_Comm!=MPI_COMM_NULL)
+	{
+		if (!fieldData || !m_HasDomain || (dim<3))
+		{
+			// shared data, all ranks have created the dataset, the first rank writes it (independent)
+			if (!IsRoot())
+				return true;
+		}
+		else
+		{
+			// the lines of this rank at their position in the global (z,y,x) field
+			for (int n=0; n<3; ++n)
+			{
+				count[dim-1-n] = m_LocalSize[n];
+				fileOffset[dim-1-n] += m_Offset[n];
+			}
+			xfer = H5Pcreate(H5P_DATASET_XFER);
+			H5Pset_dxpl_mpio(xfer, H5FD_MPIO_COLLECTIVE);
+		}
+	}
+#else
+	(void)fieldData;
+#endif
+
+	hsize_t numValues = 1;
+	for (size_t n=0; n<dim; ++n)
+		numValues *= count[n];
+	vector<hsize_t> memOffset(dim, 0);
+	hid_t filespace = H5Dget_space(dataset);
+	hid_t memspace = H5Screate_simple(dim, &memDims[0], NULL);
+	bool ok;
+	if (numValues==0)
+		// a rank without any lines still has to take part in a collective write
+		ok = (H5Sselect_none(filespace)>=0) && (H5Sselect_none(memspace)>=0);
+	else
+		ok = (H5Sselect_hyperslab(filespace, H5S_SELECT_SET, &fileOffset[0], NULL, &count[0], NULL)>=0) &&
+			 (H5Sselect_hyperslab(memspace, H5S_SELECT_SET, &memOffset[0], NULL, &count[0], NULL)>=0);
+	ok = ok && (H5Dwrite(dataset, mem_type, memspace, filespace, xfer, buf)>=0);
+	H5Sclose(memspace);
+	H5Sclose(filespace);
+	if (xfer!=H5P_DEFAULT)
+		H5Pclose(xfer);
+	return ok;
 }
 
 HDF5_File_Writer::~HDF5_File_Writer()
 {
+	Close();
+}
+
+void HDF5_File_Writer::Close()
+{
+	boost::mutex::scoped_lock lock(HDF5_Mutex());
+	if (m_GroupID>=0)
+		H5Gclose(m_GroupID);
+	m_GroupID = -1;
+	if (m_File>=0)
+		H5Fclose(m_File);
+	m_File = -1;
+}
+
+bool HDF5_File_Writer::Flush()
+{
+	boost::mutex::scoped_lock lock(HDF5_Mutex());
+	if (m_File<0)
+		return true;
+	return H5Fflush(m_File, H5F_SCOPE_LOCAL)>=0;
+}
+
+void HDF5_File_Writer::SetCompression(int level)
+{
+	if (level>9)
+		level = 9;
+	if ((level>0) && ((H5Zfilter_avail(H5Z_FILTER_DEFLATE)<=0) || (H5Zfilter_avail(H5Z_FILTER_SHUFFLE)<=0)))
+	{
+		cerr << "HDF5_File_Writer::SetCompression: Warning, the deflate or shuffle filter is not available, compression disabled" << endl;
+		level = 0;
+	}
+#ifdef HDF5_PARALLEL_DUMPS
+	if ((level>0) && (m_Comm!=MPI_COMM_NULL))
+	{
+		if (IsRoot())
+			cerr << "HDF5_File_Writer::SetCompression: Warning, compression of parallel files is unsupported, compression disabled" << endl;
+		level = 0;
+	}
+#endif
+	m_Compression = level;
+}
+
+hid_t HDF5_File_Writer::OpenFile()
+{
+	if (m_File<0)
+	{
+		hid_t fapl = CreateFileAccessProperties();
+		m_File = H5Fopen( m_filename.c_str(), H5F_ACC_RDWR, fapl );
+		H5Pclose(fapl);
+	}
+	return m_File;
+}
+
+hid_t HDF5_File_Writer::GetGroup()
+{
+	if ((m_GroupID>=0) && (m_GroupName==m_Group))
+		return m_GroupID;
+	if (m_GroupID>=0)
+		H5Gclose(m_GroupID);
+	m_GroupID = OpenGroup(OpenFile(), m_Group);
+	m_GroupName = m_Group;
+	return m_GroupID;
+}
+
+hid_t HDF5_File_Writer::CreateDataSetProperties(size_t dim, hsize_t const* chunkDims, size_t typeSize, bool chunked) const
+{
+	hid_t prop = H5Pcreate(H5P_DATASET_CREATE);
+	if (!chunked && (m_Compression<=0))
+		return prop;
+
+	// split the leading (slowest) dimensions until a chunk fits into HDF5_MAX_CHUNK_BYTES
+	vector<hsize_t> chunk(dim);
+	size_t size = typeSize;
+	for (size_t n=0; n<dim; ++n)
+	{
+		chunk[n] = chunkDims[n]>0 ? chunkDims[n] : 1;
+		size *= chunk[n];
+	}
+	for (size_t n=0; (n<dim) && (size>HDF5_MAX_CHUNK_BYTES); ++n)
+		while ((chunk[n]>1) && (size>HDF5_MAX_CHUNK_BYTES))
+		{
+			size /= chunk[n];
+			chunk[n] = (chunk[n]+1)/2;
+			size *= chunk[n];
+		}
+	H5Pset_chunk(prop, dim, &chunk[0]);
+	if (m_Compression>0)
+	{
+		H5Pset_shuffle(prop);
+		H5Pset_deflate(prop, m_Compression);
+	}
+	return prop;
 }
 
 hid_t HDF5_File_Writer::OpenGroup(hid_t hdf5_file, string group)
@@ -95,17 +318,14 @@ void HDF5_File_Writer::SetCurrentGroup(std::string group, bool createGrp)
 	if (createGrp==false)
 		return;
 
-	hid_t hdf5_file = H5Fopen( m_filename.c_str(), H5F_ACC_RDWR, H5P_DEFAULT );
-	if (hdf5_file<0)
+	boost::mutex::scoped_lock lock(HDF5_Mutex());
+	if (OpenFile()<0)
 	{
 		cerr << "HDF5_File_Writer::SetCurrentGroup: Error, opening the given file """ << m_filename << """ failed" << endl;
 		return;
 	}
-	hid_t hdf5_group = OpenGroup(hdf5_file, m_Group);
-	if (hdf5_group<0)
-		cerr << "HDF5_File_Writer::WriteData: Error opening group" << endl;
-	H5Gclose(hdf5_group);
-	H5Fclose(hdf5_file);
+	if (GetGroup()<0)
+		cerr << "HDF5_File_Writer::SetCurrentGroup: Error opening group" << endl;
 }
 
 bool HDF5_File_Writer::WriteRectMesh(unsigned int const* numLines, double const* const* discLines, int MeshType, double scaling)
@@ -126,7 +346,8 @@ bool HDF5_File_Writer::WriteRectMesh(unsigned int const* numLines, double const*
 
 bool HDF5_File_Writer::WriteRectMesh(unsigned int const* numLines, float const* const* discLines, int MeshType, float scaling)
 {
-	hid_t hdf5_file = H5Fopen( m_filename.c_str(), H5F_ACC_RDWR, H5P_DEFAULT );
+	boost::mutex::scoped_lock lock(HDF5_Mutex());
+	hid_t hdf5_file = OpenFile();
 	if (hdf5_file<0)
 	{
 		cerr << "HDF5_File_Writer::WriteRectMesh: Error, opening the given file """ << m_filename << """ failed" << endl;
@@ -136,7 +357,6 @@ bool HDF5_File_Writer::WriteRectMesh(unsigned int const* numLines, float const*
 	if (H5Lexists(hdf5_file, "/Mesh", H5P_DEFAULT))
 	{
 		cerr << "HDF5_File_Writer::WriteRectMesh: Error, group ""/Mesh"" already exists" << endl;
-		H5Fclose(hdf5_file);
 		return false;
 	}
 
@@ -144,7 +364,6 @@ bool HDF5_File_Writer::WriteRectMesh(unsigned int const* numLines, float const*
 	if (mesh_grp<0)
 	{
 		cerr << "HDF5_File_Writer::WriteRectMesh: Error, creating group ""/Mesh"" failed" << endl;
-		H5Fclose(hdf5_file);
 		return false;
 	}
 
@@ -166,6 +385,13 @@ bool HDF5_File_Writer::WriteRectMesh(unsigned int const* numLines, float const*
 		hsize_t dims[1]={numLines[n]};
 		hid_t space = H5Screate_simple(1, dims, NULL);
 		hid_t dataset = H5Dcreate(mesh_grp, names[n].c_str(), H5T_NATIVE_FLOAT, space, H5P_DEFAULT, H5P_DEFAULT, H5P_DEFAULT);
+		if (!IsRoot())
+		{
+			// the mesh of a parallel file is written by the first rank
+			H5Dclose(dataset);
+			H5Sclose(space);
+			continue;
+		}
 		float* array = new float[numLines[n]];
 		for (unsigned int i=0; i<numLines[n]; ++i)
 		{
@@ -183,7 +409,6 @@ bool HDF5_File_Writer::WriteRectMesh(unsigned int const* numLines, float const*
 			H5Dclose(dataset);
 			H5Sclose(space);
 			H5Gclose(mesh_grp);
-			H5Fclose(hdf5_file);
 			return false;
 		}
 		delete[] array;
@@ -191,7 +416,6 @@ bool HDF5_File_Writer::WriteRectMesh(unsigned int const* numLines, float const*
 		H5Sclose(space);
 	}
 	H5Gclose(mesh_grp);
-	H5Fclose(hdf5_file);
 	return true;
 }
 
@@ -207,7 +431,7 @@ bool HDF5_File_Writer::WriteScalarField(std::string dataSetName, float const* co
 			{
 				buffer[pos++]=field[i][j][k];
 			}
-	bool success = WriteData(dataSetName,buffer,3,n_size);
+	bool success = WriteFieldData(dataSetName,buffer,3,n_size);
 	delete[] buffer;
 	return success;
 }
@@ -224,7 +448,7 @@ bool HDF5_File_Writer::WriteScalarField(std::string dataSetName, double const* c
 			{
 				buffer[pos++]=field[i][j][k];
 			}
-	bool success = WriteData(dataSetName,buffer,3,n_size);
+	bool success = WriteFieldData(dataSetName,buffer,3,n_size);
 	delete[] buffer;
 	return success;
 }
@@ -241,7 +465,7 @@ bool HDF5_File_Writer::WriteScalarField(std::string dataSetName, std::complex<fl
 			{
 				buffer[pos++]=real(field[i][j][k]);
 			}
-	bool success = WriteData(dataSetName + "_real",buffer,3,n_size);
+	bool success = WriteFieldData(dataSetName + "_real",buffer,3,n_size);
 
 	pos = 0;
 	for (size_t k=0;k<datasize[2];++k)
@@ -250,7 +474,7 @@ bool HDF5_File_Writer::WriteScalarField(std::string dataSetName, std::complex<fl
 			{
 				buffer[pos++]=imag(field[i][j][k]);
 			}
-	success &= WriteData(dataSetName + "_imag",buffer,3,n_size);
+	success &= WriteFieldData(dataSetName + "_imag",buffer,3,n_size);
 
 	delete[] buffer;
 	return success;
@@ -268,7 +492,7 @@ bool HDF5_File_Writer::WriteScalarField(std::string dataSetName, std::complex<do
 			{
 				buffer[pos++]=real(field[i][j][k]);
 			}
-	bool success = WriteData(dataSetName + "_real",buffer,3,n_size);
+	bool success = WriteFieldData(dataSetName + "_real",buffer,3,n_size);
 
 	pos = 0;
 	for (size_t k=0;k<datasize[2];++k)
@@ -277,7 +501,7 @@ bool HDF5_File_Writer::WriteScalarField(std::string dataSetName, std::complex<do
 			{
 				buffer[pos++]=imag(field[i][j][k]);
 			}
-	success &= WriteData(dataSetName + "_imag",buffer,3,n_size);
+	success &= WriteFieldData(dataSetName + "_imag",buffer,3,n_size);
 
 	delete[] buffer;
 	return success;
@@ -286,19 +510,16 @@ bool HDF5_File_Writer::WriteScalarField(std::string dataSetName, std::complex<do
 bool HDF5_File_Writer::WriteVectorField(std::string dataSetName, float const* const* const* const* field, size_t datasize[3])
 {
 	size_t pos = 0;
-	size_t size = datasize[0]*datasize[1]*datasize[2]*3;
-	float* buffer = new float[size];
+	m_FloatBuffer.resize(datasize[0]*datasize[1]*datasize[2]*3);
 	for (int n=0;n<3;++n)
 		for (size_t k=0;k<datasize[2];++k)
 			for (size_t j=0;j<datasize[1];++j)
 				for (size_t i=0;i<datasize[0];++i)
 				{
-					buffer[pos++]=field[n][i][j][k];
+					m_FloatBuffer[pos++]=field[n][i][j][k];
 				}
 	size_t n_size[4]={3,datasize[2],datasize[1],datasize[0]};
-	bool success = WriteData(dataSetName,buffer,4,n_size);
-	delete[] buffer;
-	return success;
+	return WriteFieldData(dataSetName,&m_FloatBuffer[0],4,n_size);
 }
 
 bool HDF5_File_Writer::WriteVectorField(std::string dataSetName, double const* const* const* const* field, size_t datasize[3])
@@ -314,7 +535,7 @@ bool HDF5_File_Writer::WriteVectorField(std::string dataSetName, double const* c
 					buffer[pos++]=field[n][i][j][k];
 				}
 	size_t n_size[4]={3,datasize[2],datasize[1],datasize[0]};
-	bool success = WriteData(dataSetName,buffer,4,n_size);
+	bool success = WriteFieldData(dataSetName,buffer,4,n_size);
 	delete[] buffer;
 	return success;
 }
@@ -332,7 +553,7 @@ bool HDF5_File_Writer::WriteVectorField(std::string dataSetName, std::complex<fl
 				{
 					buffer[pos++]=real(field[n][i][j][k]);
 				}
-	bool success = WriteData(dataSetName + "_real",buffer,4,n_size);
+	bool success = WriteFieldData(dataSetName + "_real",buffer,4,n_size);
 
 	pos = 0;
 	for (int n=0;n<3;++n)
@@ -342,7 +563,7 @@ bool HDF5_File_Writer::WriteVectorField(std::string dataSetName, std::complex<fl
 				{
 					buffer[pos++]=imag(field[n][i][j][k]);
 				}
-	success &= WriteData(dataSetName + "_imag",buffer,4,n_size);
+	success &= WriteFieldData(dataSetName + "_imag",buffer,4,n_size);
 
 	delete[] buffer;
 	return success;
@@ -361,7 +582,7 @@ bool HDF5_File_Writer::WriteVectorField(std::string dataSetName, std::complex<do
 				{
 					buffer[pos++]=real(field[n][i][j][k]);
 				}
-	bool success = WriteData(dataSetName + "_real",buffer,4,n_size);
+	bool success = WriteFieldData(dataSetName + "_real",buffer,4,n_size);
 
 	pos = 0;
 	for (int n=0;n<3;++n)
@@ -371,12 +592,38 @@ bool HDF5_File_Writer::WriteVectorField(std::string dataSetName, std::complex<do
 				{
 					buffer[pos++]=imag(field[n][i][j][k]);
 				}
-	success &= WriteData(dataSetName + "_imag",buffer,4,n_size);
+	success &= WriteFieldData(dataSetName + "_imag",buffer,4,n_size);
 
 	delete[] buffer;
 	return success;
 }
 
+bool HDF5_File_Writer::WriteVectorField(std::string dataSetName, const ArrayLib::ArrayNIJK<std::complex<float> >& field, size_t datasize[3])
+{
+	size_t pos = 0;
+	size_t size = datasize[0]*datasize[1]*datasize[2]*3;
+	size_t n_size[4]={3,datasize[2],datasize[1],datasize[0]};
+	float* buffer_re = new float[size];
+	float* buffer_im = new float[size];
+	// walk the source array in memory order, write in (n,k,j,i) order
+	for (size_t i=0;i<datasize[0];++i)
+		for (size_t j=0;j<datasize[1];++j)
+			for (size_t k=0;k<datasize[2];++k)
+				for (int n=0;n<3;++n)
+				{
+					pos = ((n*datasize[2]+k)*datasize[1]+j)*datasize[0]+i;
+					const std::complex<float>& value = field(n,i,j,k);
+					buffer_re[pos]=real(value);
+					buffer_im[pos]=imag(value);
+				}
+	bool success = WriteFieldData(dataSetName + "_real",buffer_re,4,n_size);
+	success &= WriteFieldData(dataSetName + "_imag",buffer_im,4,n_size);
+
+	delete[] buffer_re;
+	delete[] buffer_im;
+	return success;
+}
+
 bool HDF5_File_Writer::WriteData(std::string dataSetName, float const* field_buf, size_t dim, size_t* datasize)
 {
 	return WriteData(dataSetName, H5T_NATIVE_FLOAT, field_buf,dim, datasize);
@@ -387,48 +634,171 @@ bool HDF5_File_Writer::WriteData(std::string dataSetName, double const* field_bu
 	return WriteData(dataSetName, H5T_NATIVE_DOUBLE, field_buf,dim, datasize);
 }
 
-bool HDF5_File_Writer::WriteData(std::string dataSetName,  hid_t mem_type, void const* field_buf, size_t dim, size_t* datasize)
+bool HDF5_File_Writer::WriteFieldData(std::string dataSetName, float const* field_buf, size_t dim, size_t* datasize)
 {
-	hid_t hdf5_file = H5Fopen( m_filename.c_str(), H5F_ACC_RDWR, H5P_DEFAULT );
+	return WriteData(dataSetName, H5T_NATIVE_FLOAT, field_buf, dim, datasize, true);
+}
+
+bool HDF5_File_Writer::WriteFieldData(std::string dataSetName, double const* field_buf, size_t dim, size_t* datasize)
+{
+	return WriteData(dataSetName, H5T_NATIVE_DOUBLE, field_buf, dim, datasize, true);
+}
+
+bool HDF5_File_Writer::WriteData(std::string dataSetName,  hid_t mem_type, void const* field_buf, size_t dim, size_t* datasize, bool fieldData)
+{
+	boost::mutex::scoped_lock lock(HDF5_Mutex());
+	hid_t hdf5_file = OpenFile();
 	if (hdf5_file<0)
 	{
 		cerr << "HDF5_File_Writer::WriteData: Error, opening the given file """ << m_filename << """ failed" << endl;
 		return false;
 	}
 
-	hid_t group = OpenGroup(hdf5_file,m_Group);
+	hid_t group = GetGroup();
 	if (group<0)
 	{
 		cerr << "HDF5_File_Writer::WriteData: Error opening group" << endl;
-		H5Fclose(hdf5_file);
 		return false;
 	}
 
-	hsize_t* dims = new hsize_t[dim];
-	for (size_t n=0;n<dim;++n)
-		dims[n]=datasize[n];
-	hid_t space = H5Screate_simple(dim, dims, NULL);
-	hid_t dataset = H5Dcreate(group, dataSetName.c_str(), mem_type, space, H5P_DEFAULT, H5P_DEFAULT, H5P_DEFAULT);
-	if (H5Dwrite(dataset, mem_type, space, H5P_DEFAULT, H5P_DEFAULT, field_buf))
+	vector<hsize_t> dims = GetFileDims(dim, datasize, fieldData);
+	hid_t dataset = -1;
+	if (H5Lexists(group, dataSetName.c_str(), H5P_DEFAULT)>0)
 	{
-		cerr << "HDF5_File_Writer::WriteData: Error, writing to dataset failed" << endl;
-		H5Dclose(dataset);
+		// overwrite an existing dataset of the same size in place, e.g. frequency domain data written on every flush
+		// (deleting and re-creating it would not free the file space of the old dataset)
+		dataset = H5Dopen(group, dataSetName.c_str(), H5P_DEFAULT);
+		hid_t space = H5Dget_space(dataset);
+		vector<hsize_t> old_dims(dim);
+		bool valid = (H5Sget_simple_extent_ndims(space)==(int)dim) && (H5Sget_simple_extent_dims(space, &old_dims[0], NULL)>=0);
+		for (size_t n=0; n<dim; ++n)
+			valid &= (old_dims[n]==dims[n]);
 		H5Sclose(space);
-		H5Gclose(group);
-		H5Fclose(hdf5_file);
+		if (!valid)
+		{
+			cerr << "HDF5_File_Writer::WriteData: Error, existing dataset """ << dataSetName << """ has a different size" << endl;
+			H5Dclose(dataset);
+			return false;
+		}
+	}
+	else
+	{
+		hid_t space = H5Screate_simple(dim, &dims[0], NULL);
+		hid_t prop = CreateDataSetProperties(dim, &dims[0], H5Tget_size(mem_type), false);
+		dataset = H5Dcreate(group, dataSetName.c_str(), mem_type, space, H5P_DEFAULT, prop, H5P_DEFAULT);
+		H5Pclose(prop);
+		H5Sclose(space);
+	}
+	vector<hsize_t> offset(dim, 0);
+	if ((dataset<0) || !WriteSelection(dataset, mem_type, field_buf, dim, datasize, &offset[0], fieldData))
+	{
+		cerr << "HDF5_File_Writer::WriteData: Error, writing to dataset failed" << endl;
+		if (dataset>=0)
+			H5Dclose(dataset);
 		return false;
 	}
 	H5Dclose(dataset);
-	H5Sclose(space);
-	H5Gclose(group);
-	H5Fclose(hdf5_file);
-	delete[] dims; dims=NULL;
 	return true;
 }
 
+bool HDF5_File_Writer::AppendData(std::string dataSetName, double const* buf, size_t numRows, size_t numCols, size_t chunkRows)
+{
+	size_t datasize[2] = {numRows, numCols};
+	return AppendData(dataSetName, H5T_NATIVE_DOUBLE, buf, 2, datasize, chunkRows);
+}
+
+bool HDF5_File_Writer::AppendData(std::string dataSetName, hid_t mem_type, void const* buf, size_t dim, size_t* datasize, size_t chunkRows, bool fieldData)
+{
+	// the dataset grows along its first dimension, all other dimensions are fixed
+	vector<hsize_t> dims = GetFileDims(dim, datasize, fieldData);
+	for (size_t n=0; n<dim; ++n)
+		if (dims[n]==0)
+			return true;
+
+	boost::mutex::scoped_lock lock(HDF5_Mutex());
+	hid_t hdf5_file = OpenFile();
+	if (hdf5_file<0)
+	{
+		cerr << "HDF5_File_Writer::AppendData: Error, opening the given file """ << m_filename << """ failed" << endl;
+		return false;
+	}
+
+	hid_t group = GetGroup();
+	if (group<0)
+	{
+		cerr << "HDF5_File_Writer::AppendData: Error opening group" << endl;
+		return false;
+	}
+
+	hsize_t numRows = dims[0];
+	dims[0] = 0;
+	hid_t dataset = -1;
+	if (H5Lexists(group, dataSetName.c_str(), H5P_DEFAULT)>0)
+	{
+		dataset = H5Dopen(group, dataSetName.c_str(), H5P_DEFAULT);
+		hid_t space = H5Dget_space(dataset);
+		vector<hsize_t> old_dims(dim);
+		bool valid = (H5Sget_simple_extent_ndims(space)==(int)dim) && (H5Sget_simple_extent_dims(space, &old_dims[0], NULL)>=0);
+		for (size_t n=1; n<dim; ++n)
+			valid &= (old_dims[n]==dims[n]);
+		H5Sclose(space);
+		if (!valid)
+		{
+			cerr << "HDF5_File_Writer::AppendData: Error, dataset """ << dataSetName << """ has an incompatible size" << endl;
+			H5Dclose(dataset);
+			return false;
+		}
+		dims[0] = old_dims[0];
+	}
+	else
+	{
+		vector<hsize_t> maxdims(dims);
+		maxdims[0] = H5S_UNLIMITED;
+		vector<hsize_t> chunk(dims);
+		chunk[0] = chunkRows;
+		hid_t space = H5Screate_simple(dim, &dims[0], &maxdims[0]);
+		hid_t prop = CreateDataSetProperties(dim, &chunk[0], H5Tget_size(mem_type), true);
+		dataset = H5Dcreate(group, dataSetName.c_str(), mem_type, space, H5P_DEFAULT, prop, H5P_DEFAULT);
+		H5Pclose(prop);
+		H5Sclose(space);
+	}
+	if (dataset<0)
+	{
+		cerr << "HDF5_File_Writer::AppendData: Error, creating dataset """ << dataSetName << """ failed" << endl;
+		return false;
+	}
+
+	vector<hsize_t> offset(dim, 0);
+	offset[0] = dims[0];
+	dims[0] += numRows;
+	bool ok = (H5Dset_extent(dataset, &dims[0])>=0);
+	ok = ok && WriteSelection(dataset, mem_type, buf, dim, datasize, &offset[0], fieldData);
+	if (!ok)
+		cerr << "HDF5_File_Writer::AppendData: Error, writing to dataset failed" << endl;
+	H5Dclose(dataset);
+	return ok;
+}
+
+bool HDF5_File_Writer::AppendVectorField(std::string dataSetName, float const* const* const* const* field, size_t datasize[3])
+{
+	// reuse the conversion buffer, this is called for every time domain snapshot
+	size_t pos = 0;
+	m_FloatBuffer.resize(datasize[0]*datasize[1]*datasize[2]*3);
+	for (int n=0;n<3;++n)
+		for (size_t k=0;k<datasize[2];++k)
+			for (size_t j=0;j<datasize[1];++j)
+				for (size_t i=0;i<datasize[0];++i)
+				{
+					m_FloatBuffer[pos++]=field[n][i][j][k];
+				}
+	size_t n_size[5]={1,3,datasize[2],datasize[1],datasize[0]};
+	return AppendData(dataSetName, H5T_NATIVE_FLOAT, &m_FloatBuffer[0], 5, n_size, 1, true);
+}
+
 bool HDF5_File_Writer::WriteAtrribute(std::string locName, std::string attr_name, void const* value, hsize_t size, hid_t mem_type)
 {
-	hid_t hdf5_file = H5Fopen( m_filename.c_str(), H5F_ACC_RDWR, H5P_DEFAULT );
+	boost::mutex::scoped_lock lock(HDF5_Mutex());
+	hid_t hdf5_file = OpenFile();
 	if (hdf5_file<0)
 	{
 		cerr << "HDF5_File_Writer::WriteAtrribute: Error, opening the given file """ << m_filename << """ failed" << endl;
@@ -438,14 +808,12 @@ bool HDF5_File_Writer::WriteAtrribute(std::string locName, std::string attr_name
 	if (H5Lexists(hdf5_file, locName.c_str(), H5P_DEFAULT)<0)
 	{
 		cerr << "HDF5_File_Writer::WriteAtrribute: Error, failed to find location: """ << locName << """" << endl;
-		H5Fclose(hdf5_file);
 		return false;
 	}
 	hid_t loc = H5Oopen(hdf5_file, locName.c_str(), H5P_DEFAULT);
 	if (loc<0)
 	{
 		cerr << "HDF5_File_Writer::WriteAtrribute: Error, failed to open location: """ << locName << """" << endl;
-		H5Fclose(hdf5_file);
 		return false;
 	}
 
@@ -458,7 +826,6 @@ bool HDF5_File_Writer::WriteAtrribute(std::string locName, std::string attr_name
 		cerr << "HDF5_File_Writer::WriteAtrribute: Error, failed to create the attribute" << endl;
 		H5Sclose(dataspace_id);
 		H5Oclose(loc);
-		H5Fclose(hdf5_file);
 		return false;
 	}
 
@@ -469,13 +836,11 @@ bool HDF5_File_Writer::WriteAtrribute(std::string locName, std::string attr_name
 		H5Aclose(attribute_id);
 		H5Sclose(dataspace_id);
 		H5Oclose(loc);
-		H5Fclose(hdf5_file);
 		return false;
 	}
 	H5Aclose(attribute_id);
 	H5Sclose(dataspace_id);
 	H5Oclose(loc);
-	H5Fclose(hdf5_file);
 	return true;
 }
 
@@ -23,12 +23,49 @@
 #include <complex>
 #include <hdf5.h>
 
+#include "arraylib/array_nijk.h"
+
+#if defined(MPI_SUPPORT) && defined(H5_HAVE_PARALLEL)
+//! hdf5 supports MPI-IO, field dumps of all MPI ranks can be written collectively into one file
+#define HDF5_PARALLEL_DUMPS
+#endif
+
+//! Max. size of a dataset chunk (chunked datasets only), the leading dimensions are split to fit
+#define HDF5_MAX_CHUNK_BYTES (4*1024*1024)
+
+//! Simple hdf5 file writer, all file accesses of all instances are serialized and may be done from different threads
+/*!
+  The file and the current group are kept open until Close() or the destruction of the writer,
+  any following write access will reopen the file.
+
+  A parallel file (see HDF5_PARALLEL_DUMPS) is shared by all ranks of its communicator, all ranks have to call
+  the same methods in the same order. Fields are written collectively, each rank writes its part (see SetDomain())
+  into the global dataset. All other data, e.g. mesh and time, has to be identical and is written by the first rank.
+  */
 class HDF5_File_Writer
 {
 public:
 	HDF5_File_Writer(std::string filename);
+#ifdef HDF5_PARALLEL_DUMPS
+	//! Create a file shared by all ranks of \a comm (collective)
+	HDF5_File_Writer(std::string filename, MPI_Comm comm);
+
+	//! Define the part of all following fields written by this rank, given as number of lines and offset in the global field (x,y,z).
+	/*!
+	  The fields passed to the writer may be larger, only the leading \a localSize lines are written.
+	  */
+	void SetDomain(unsigned int const* localSize, unsigned int const* globalSize, unsigned int const* offset);
+#endif
 	~HDF5_File_Writer();
 
+	//! Close the file, e.g. to allow other readers to access it.
+	void Close();
+	//! Flush all written data to disk, the file stays open.
+	bool Flush();
+
+	//! Set the deflate compression level (1..9) of all following datasets (using the shuffle filter as well), 0 disables compression (default).
+	void SetCompression(int level);
+
 	bool WriteRectMesh(unsigned int const* numLines, double const* const* discLines, int MeshType=0, double scaling=1);
 	bool WriteRectMesh(unsigned int const* numLines, float const* const* discLines, int MeshType=0, float scaling=1);
 
@@ -43,10 +80,23 @@ public:
 
 	bool WriteVectorField(std::string dataSetName, std::complex<float> const* const* const* const* field, size_t datasize[3]);
 	bool WriteVectorField(std::string dataSetName, std::complex<double> const* const* const* const* field, size_t datasize[3]);
+	bool WriteVectorField(std::string dataSetName, const ArrayLib::ArrayNIJK<std::complex<float> >& field, size_t datasize[3]);
 
+	//! Write a dataset, an existing dataset of the same size is overwritten in place.
 	bool WriteData(std::string dataSetName, float const* field_buf, size_t dim, size_t* datasize);
 	bool WriteData(std::string dataSetName, double const* field_buf, size_t dim, size_t* datasize);
 
+	//! Append \a numRows rows of \a numCols values to a 2D dataset, the dataset is created chunked and extendible on first use.
+	bool AppendData(std::string dataSetName, double const* buf, size_t numRows, size_t numCols, size_t chunkRows);
+	//! Append \a datasize[0] entries to a dataset extendible in its first dimension, the dataset is created on first use.
+	/*!
+	  If \a fieldData is set, the last three dimensions are a (z,y,x) field, a parallel file stores the global field (see SetDomain()).
+	  */
+	bool AppendData(std::string dataSetName, hid_t mem_type, void const* buf, size_t dim, size_t* datasize, size_t chunkRows, bool fieldData=false);
+
+	//! Append a vector field to the extendible dataset (N,3,z,y,x), each field is stored in its own chunk(s).
+	bool AppendVectorField(std::string dataSetName, float const* const* const* const* field, size_t datasize[3]);
+
 	bool WriteAtrribute(std::string locName, std::string attr_name, void const* value, hsize_t size, hid_t mem_type);
 	bool WriteAtrribute(std::string locName, std::string attr_name, float const* value, hsize_t size);
 	bool WriteAtrribute(std::string locName, std::string attr_name, double const* value, hsize_t size);
@@ -61,8 +111,43 @@ protected:
 	std::string m_filename;
 	std::string m_Group;
 
+	hid_t m_File; //!< open file handle, -1 if closed
+	hid_t m_GroupID; //!< open handle of group m_GroupName, -1 if closed
+	std::string m_GroupName;
+	int m_Compression;
+	//! Conversion buffer reused for all float vector fields
+	std::vector<float> m_FloatBuffer;
+
+#ifdef HDF5_PARALLEL_DUMPS
+	MPI_Comm m_Comm; //!< communicator of a parallel file, MPI_COMM_NULL for a serial file
+	int m_Rank;
+	bool m_HasDomain;
+	hsize_t m_LocalSize[3];
+	hsize_t m_GlobalSize[3];
+	hsize_t m_Offset[3];
+#endif
+
+	void Create();
+	//! Data shared by all ranks of a parallel file is written by the first rank only, always true for a serial file
+	bool IsRoot() const;
+	//! Create the file access properties, using MPI-IO for a parallel file
+	hid_t CreateFileAccessProperties() const;
+	//! Get the dimensions of a dataset in the file, the global field for \a fieldData in a parallel file
+	std::vector<hsize_t> GetFileDims(size_t dim, size_t const* datasize, bool fieldData) const;
+	//! Write \a buf to \a dataset at \a offset, \a fieldData is written collectively to the global position of this rank
+	bool WriteSelection(hid_t dataset, hid_t mem_type, void const* buf, size_t dim, size_t const* datasize, hsize_t const* offset, bool fieldData);
+
 	hid_t OpenGroup(hid_t hdf5_file, std::string group);
-	bool WriteData(std::string dataSetName, hid_t mem_type, void const* field_buf, size_t dim, size_t* datasize);
+	//! Get the open file, the caller has to hold the file access lock
+	hid_t OpenFile();
+	//! Get the open current group, the caller has to hold the file access lock
+	hid_t GetGroup();
+	//! Create the dataset creation properties, chunked with the given chunk dimensions if requested or for compression
+	hid_t CreateDataSetProperties(size_t dim, hsize_t const* chunkDims, size_t typeSize, bool chunked) const;
+	bool WriteData(std::string dataSetName, hid_t mem_type, void const* field_buf, size_t dim, size_t* datasize, bool fieldData=false);
+	//! Write field data, the last three dimensions of \a datasize are (z,y,x)
+	bool WriteFieldData(std::string dataSetName, float const* field_buf, size_t dim, size_t* datasize);
+	bool WriteFieldData(std::string dataSetName, double const* field_buf, size_t dim, size_t* datasize);
 };
 
 #endif // HDF5_FILE_WRITER_H
@@ -17,10 +17,14 @@
 
 
 #include <algorithm>
+#include <cstring>
 #include "sar_calculation.h"
 #include "cfloat"
 #include "array_ops.h"
 #include "global.h"
+#include "useful.h"
+#include <boost/thread.hpp>
+#include <boost/bind.hpp>
 
 using namespace std;
 
@@ -29,6 +33,7 @@ SAR_Calculation::SAR_Calculation()
 	m_Vx_Used = NULL;
 	m_Vx_Valid = NULL;
 	m_DebugLevel = 0;
+	m_numThreads = boost::thread::hardware_concurrency();
 	SetAveragingMethod(SIMPLE, true);
 	Reset();
 }
@@ -181,7 +186,7 @@ double SAR_Calculation::CalcSARPower()
 	return power;
 }
 
-double SAR_Calculation::CalcLocalPowerDensity(unsigned int pos[3])
+double SAR_Calculation::CalcLocalPowerDensity(unsigned int pos[3]) const
 {
 	double l_pow=0;
 	if (m_cell_conductivity==NULL)
@@ -230,7 +235,7 @@ float*** SAR_Calculation::CalcLocalSAR(float*** SAR)
 }
 
 int SAR_Calculation::FindFittingCubicalMass(unsigned int pos[3], float box_size, unsigned int start[3], unsigned int stop[3],
-					float partial_start[3], float partial_stop[3], double &mass, double &volume, double &bg_ratio, int disabledFace, bool ignoreFaceValid)
+					float partial_start[3], float partial_stop[3], double &mass, double &volume, double &bg_ratio, int disabledFace, bool ignoreFaceValid) const
 {
 	unsigned int mass_iterations = 0;
 	double old_mass=0;
@@ -298,7 +303,7 @@ int SAR_Calculation::FindFittingCubicalMass(unsigned int pos[3], float box_size,
 }
 
 bool SAR_Calculation::GetCubicalMass(unsigned int pos[3], double box_size, unsigned int start[3], unsigned int stop[3],
-									 float partial_start[3], float partial_stop[3], double &mass, double &volume, double &bg_ratio, int disabledFace)
+									 float partial_start[3], float partial_stop[3], double &mass, double &volume, double &bg_ratio, int disabledFace) const
 {
 	if ((box_size<=0) || std::isnan(box_size) || std::isinf(box_size))
 	{
@@ -373,113 +378,46 @@ bool SAR_Calculation::GetCubicalMass(unsigned int pos[3], double box_size, unsig
 			face_valid=false;
 	}
 
-	mass = 0;
-	volume = 0;
-	double bg_volume=0;
-	double weight[3];
-	unsigned int f_pos[3];
-	bool face_intersect[6] = {false,false,false,false,false,false};
-	for (f_pos[0]=start[0];f_pos[0]<=stop[0];++f_pos[0])
-	{
-		weight[0]=1;
-		if (f_pos[0]==start[0])
-			weight[0]*=abs(partial_start[0]);
-		if (f_pos[0]==stop[0])
-			weight[0]*=abs(partial_stop[0]);
-
-		for (f_pos[1]=start[1];f_pos[1]<=stop[1];++f_pos[1])
-		{
-			weight[1]=1;
-			if (f_pos[1]==start[1])
-				weight[1]*=abs(partial_start[1]);
-			if (f_pos[1]==stop[1])
-				weight[1]*=abs(partial_stop[1]);
-
-			for (f_pos[2]=start[2];f_pos[2]<=stop[2];++f_pos[2])
-			{
-				weight[2]=1;
-				if (f_pos[2]==start[2])
-					weight[2]*=abs(partial_start[2]);
-				if (f_pos[2]==stop[2])
-					weight[2]*=abs(partial_stop[2]);
-
-				mass += CellMass(f_pos)*weight[0]*weight[1]*weight[2];
-				volume += CellVolume(f_pos)*weight[0]*weight[1]*weight[2];
+	mass = GetPartialBoxSum(m_SumMass, start, stop, partial_start, partial_stop);
+	volume = GetPartialBoxSum(m_SumVolume, start, stop, partial_start, partial_stop);
+	double bg_volume = GetPartialBoxSum(m_SumBGVolume, start, stop, partial_start, partial_stop);
 
-				if (m_cell_density[f_pos[0]][f_pos[1]][f_pos[2]]==0)
-					bg_volume += CellVolume(f_pos)*weight[0]*weight[1]*weight[2];
-				else
-				{
-					for (int n=0;n<3;++n)
-					{
-						if (start[n]==f_pos[n])
-							face_intersect[2*n]=true;
-						if (stop[n]==f_pos[n])
-							face_intersect[2*n+1]=true;
-					}
-				}
-			}
-		}
-	}
 	//check if all bounds have intersected a material boundary
-	for (int n=0;n<6;++n)
-		face_valid *= face_intersect[n];
+	unsigned int f_start[3];
+	unsigned int f_stop[3];
+	for (int n=0;n<3;++n)
+	{
+		f_start[n] = start[n];
+		f_stop[n] = stop[n];
+	}
+	for (int n=0;n<3;++n)
+	{
+		f_stop[n] = start[n];
+		face_valid = face_valid && (GetBoxSum(m_SumMaterial, f_start, f_stop)>0);
+		f_stop[n] = stop[n];
+		f_start[n] = stop[n];
+		face_valid = face_valid && (GetBoxSum(m_SumMaterial, f_start, f_stop)>0);
+		f_start[n] = start[n];
+	}
 
 	bg_ratio = bg_volume/volume;
 
 	return face_valid;
 }
 
-float SAR_Calculation::CalcCubicalSAR(float*** SAR, unsigned int pos[3], unsigned int start[3], unsigned int stop[3], float partial_start[3], float partial_stop[3], bool assignUsed)
+float SAR_Calculation::CalcCubicalSAR(unsigned int start[3], unsigned int stop[3], float partial_start[3], float partial_stop[3]) const
 {
-	double power_mass=0;
-	double mass=0;
-	double weight[3];
-	unsigned int f_pos[3];
-	for (f_pos[0]=start[0];f_pos[0]<=stop[0];++f_pos[0])
-	{
-		weight[0]=1;
-		if (f_pos[0]==start[0])
-			weight[0]*=abs(partial_start[0]);
-		if (f_pos[0]==stop[0])
-			weight[0]*=abs(partial_stop[0]);
-
-		for (f_pos[1]=start[1];f_pos[1]<=stop[1];++f_pos[1])
-		{
-			weight[1]=1;
-			if (f_pos[1]==start[1])
-				weight[1]*=abs(partial_start[1]);
-			if (f_pos[1]==stop[1])
-				weight[1]*=abs(partial_stop[1]);
-
-			for (f_pos[2]=start[2];f_pos[2]<=stop[2];++f_pos[2])
-			{
-				weight[2]=1;
-				if (f_pos[2]==start[2])
-					weight[2]*=abs(partial_start[2]);
-				if (f_pos[2]==stop[2])
-					weight[2]*=abs(partial_stop[2]);
-
-				if (m_cell_density[f_pos[0]][f_pos[1]][f_pos[2]]>=0)
-				{
-					mass += CellMass(f_pos)*weight[0]*weight[1]*weight[2];
-					power_mass += CalcLocalPowerDensity(f_pos) * CellVolume(f_pos)*weight[0]*weight[1]*weight[2];
-				}
-			}
-		}
-	}
-	float vx_SAR = power_mass/mass;
-	if (SAR==NULL)
-		return vx_SAR;
-
-	SAR[pos[0]][pos[1]][pos[2]]=vx_SAR;
-
-	if (assignUsed==false)
-		return vx_SAR;
+	double power_mass = GetPartialBoxSum(m_SumPower, start, stop, partial_start, partial_stop);
+	double mass = GetPartialBoxSum(m_SumMass, start, stop, partial_start, partial_stop);
+	return power_mass/mass;
+}
 
+void SAR_Calculation::AssignCubicalSAR(float*** SAR, float vx_SAR, unsigned int start[3], unsigned int stop[3], float partial_start[3], float partial_stop[3], unsigned int xStart, unsigned int xStop)
+{
 	// assign SAR to all used voxel
+	unsigned int f_pos[3];
 	bool is_partial[3];
-	for (f_pos[0]=start[0];f_pos[0]<=stop[0];++f_pos[0])
+	for (f_pos[0]=max(start[0],xStart);f_pos[0]<=stop[0] && f_pos[0]<xStop;++f_pos[0])
 	{
 		if ( ((f_pos[0]==start[0]) && (partial_start[0]!=1)) || ((f_pos[0]==stop[0]) && (partial_stop[0]!=1)) )
 			is_partial[0]=true;
@@ -511,16 +449,255 @@ float SAR_Calculation::CalcCubicalSAR(float*** SAR, unsigned int pos[3], unsigne
 			}
 		}
 	}
-	return vx_SAR;
 }
 
+void SAR_Calculation::CalcSummedVolumeTables()
+{
+	// memory: 4 tables with 64bit sums and the 32bit material count for (numLines+1)^3 entries, about 36 bytes per voxel
+	// (plus 4 bytes for the candidate count created later), the tables are freed right after the averaging
+	SummedVolumeTable* tables[4] = {&m_SumMass, &m_SumVolume, &m_SumBGVolume, &m_SumPower};
+	double cell_value[4];
+	double total[4] = {0,0,0,0};
+	unsigned int pos[3];
+	for (int pass=0; pass<2; ++pass)
+	{
+		if (pass==1)
+		{
+			// scale the fixed-point values to make full use of the 64bit range without an overflow of the total sum
+			size_t size = SumIndex(m_numLines[0],m_numLines[1],m_numLines[2])+1;
+			for (int t=0; t<4; ++t)
+			{
+				tables[t]->sum.assign(size, 0);
+				tables[t]->scale = (total[t]>0) ? pow(2.0,62)/total[t] : 1.0;
+			}
+			m_SumMaterial.assign(size, 0);
+		}
+		for (pos[0]=0; pos[0]<m_numLines[0]; ++pos[0])
+			for (pos[1]=0; pos[1]<m_numLines[1]; ++pos[1])
+				for (pos[2]=0; pos[2]<m_numLines[2]; ++pos[2])
+				{
+					double volume = CellVolume(pos);
+					float density = m_cell_density[pos[0]][pos[1]][pos[2]];
+					cell_value[0] = max(density*volume, 0.0);
+					cell_value[1] = volume;
+					cell_value[2] = (density==0) ? volume : 0;
+					cell_value[3] = (density>=0) ? CalcLocalPowerDensity(pos)*volume : 0;
+					if (pass==0)
+					{
+						for (int t=0; t<4; ++t)
+							total[t] += cell_value[t];
+						continue;
+					}
+					size_t idx = SumIndex(pos[0]+1,pos[1]+1,pos[2]+1);
+					for (int t=0; t<4; ++t)
+						tables[t]->sum[idx] = (unsigned long long)(cell_value[t]*tables[t]->scale+0.5);
+					if (density!=0)
+						m_SumMaterial[idx] = 1;
+				}
+	}
+
+	for (int t=0; t<4; ++t)
+		SumUpTable(tables[t]->sum);
+	SumUpTable(m_SumMaterial);
+}
+
+void SAR_Calculation::ClearSummedVolumeTables()
+{
+	// release the memory, the tables are as large as the SAR domain
+	std::vector<unsigned long long>().swap(m_SumMass.sum);
+	std::vector<unsigned long long>().swap(m_SumVolume.sum);
+	std::vector<unsigned long long>().swap(m_SumBGVolume.sum);
+	std::vector<unsigned long long>().swap(m_SumPower.sum);
+	std::vector<unsigned int>().swap(m_SumMaterial);
+	std::vector<unsigned int>().swap(m_SumCandidate);
+}
+
+template <typename T>
+void SAR_Calculation::SumUpTable(std::vector<T>& table) const
+{
+	unsigned int i,j,k;
+	for (i=1; i<=m_numLines[0]; ++i)
+		for (j=1; j<=m_numLines[1]; ++j)
+			for (k=1; k<=m_numLines[2]; ++k)
+				table[SumIndex(i,j,k)] += table[SumIndex(i,j,k-1)];
+	for (i=1; i<=m_numLines[0]; ++i)
+		for (j=1; j<=m_numLines[1]; ++j)
+			for (k=1; k<=m_numLines[2]; ++k)
+				table[SumIndex(i,j,k)] += table[SumIndex(i,j-1,k)];
+	for (i=1; i<=m_numLines[0]; ++i)
+		for (j=1; j<=m_numLines[1]; ++j)
+			for (k=1; k<=m_numLines[2]; ++k)
+				table[SumIndex(i,j,k)] += table[SumIndex(i-1,j,k)];
+}
+
+template <typename T>
+T SAR_Calculation::GetBoxSum(const std::vector<T>& table, const unsigned int start[3], const unsigned int stop[3]) const
+{
+	unsigned int i0=start[0], i1=stop[0]+1;
+	unsigned int j0=start[1], j1=stop[1]+1;
+	unsigned int k0=start[2], k1=stop[2]+1;
+	return table[SumIndex(i1,j1,k1)] - table[SumIndex(i0,j1,k1)] - table[SumIndex(i1,j0,k1)] - table[SumIndex(i1,j1,k0)]
+		 + table[SumIndex(i0,j0,k1)] + table[SumIndex(i0,j1,k0)] + table[SumIndex(i1,j0,k0)] - table[SumIndex(i0,j0,k0)];
+}
+
+double SAR_Calculation::GetPartialBoxSum(const SummedVolumeTable& table, const unsigned int start[3], const unsigned int stop[3], const float partial_start[3], const float partial_stop[3]) const
+{
+	// split the (separable) cell weights into at most three weighted intervals per direction:
+	// the full interval and the corrections of the partial start and stop cell
+	unsigned int i_start[3][3];
+	unsigned int i_stop[3][3];
+	double weight[3][3];
+	int num[3];
+	for (int n=0;n<3;++n)
+	{
+		if (start[n]==stop[n])
+		{
+			i_start[n][0] = i_stop[n][0] = start[n];
+			weight[n][0] = abs(partial_start[n])*abs(partial_stop[n]);
+			num[n] = 1;
+			continue;
+		}
+		i_start[n][0] = start[n];
+		i_stop[n][0] = stop[n];
+		weight[n][0] = 1;
+		num[n] = 1;
+		if (abs(partial_start[n])!=1)
+		{
+			i_start[n][num[n]] = i_stop[n][num[n]] = start[n];
+			weight[n][num[n]] = abs(partial_start[n])-1;
+			++num[n];
+		}
+		if (abs(partial_stop[n])!=1)
+		{
+			i_start[n][num[n]] = i_stop[n][num[n]] = stop[n];
+			weight[n][num[n]] = abs(partial_stop[n])-1;
+			++num[n];
+		}
+	}
+
+	double sum = 0;
+	unsigned int b_start[3];
+	unsigned int b_stop[3];
+	for (int a=0;a<num[0];++a)
+	{
+		b_start[0] = i_start[0][a];
+		b_stop[0] = i_stop[0][a];
+		for (int b=0;b<num[1];++b)
+		{
+			b_start[1] = i_start[1][b];
+			b_stop[1] = i_stop[1][b];
+			for (int c=0;c<num[2];++c)
+			{
+				b_start[2] = i_start[2][c];
+				b_stop[2] = i_stop[2][c];
+				sum += weight[0][a]*weight[1][b]*weight[2][c]*(double)GetBoxSum(table.sum, b_start, b_stop);
+			}
+		}
+	}
+	return sum/table.scale;
+}
 
 float*** SAR_Calculation::CalcAveragedSAR(float*** SAR)
 {
-	unsigned int pos[3];
+	Delete3DArray(m_Vx_Used,m_numLines);
 	m_Vx_Used = Create3DArray<bool>(m_numLines);
+	Delete3DArray(m_Vx_Valid,m_numLines);
 	m_Vx_Valid = Create3DArray<bool>(m_numLines);
 
+	CalcSummedVolumeTables();
+
+	SARStats stats;
+	memset(&stats, 0, sizeof(SARStats));
+
+	// find all valid cubes and their SAR
+	RunAveragedSARStep(FIND_VALID_CUBES, SAR, stats);
+	m_Valid = stats.valid;
+	m_AirVoxel = stats.air;
+	unsigned int reach = stats.reach;
+
+	if (stats.noConvergence>0)
+	{
+		cerr << "SAR_Calculation::CalcAveragedSAR: Warning, for some voxel a valid averaging cube could not be found (no convergence)... " << endl;
+	}
+	if (m_DebugLevel>0)
+	{
+		cerr << "Number of invalid cubes (case 1): " << stats.case1 << endl;
+		cerr << "Number of invalid cubes (case 2): " << stats.case2 << endl;
+		cerr << "Number of invalid cubes (failed to converge): " << stats.noConvergence << endl;
+	}
+
+	// count all non-valid non-background voxel, only valid cubes containing some of these have to assign their SAR
+	unsigned int pos[3];
+	m_SumCandidate.assign(m_SumMaterial.size(), 0);
+	for (pos[0]=0;pos[0]<m_numLines[0];++pos[0])
+		for (pos[1]=0;pos[1]<m_numLines[1];++pos[1])
+			for (pos[2]=0;pos[2]<m_numLines[2];++pos[2])
+				if ((m_cell_density[pos[0]][pos[1]][pos[2]]>0) && !m_Vx_Valid[pos[0]][pos[1]][pos[2]])
+					m_SumCandidate[SumIndex(pos[0]+1,pos[1]+1,pos[2]+1)] = 1;
+	SumUpTable(m_SumCandidate);
+
+	// assign the SAR of all valid cubes to the used voxel
+	stats.reach = reach;
+	RunAveragedSARStep(ASSIGN_USED_VOXEL, SAR, stats);
+
+	// count all used and unused etc. + special handling of unused voxels!!
+	RunAveragedSARStep(CALC_UNUSED_VOXEL, SAR, stats);
+	m_Used = stats.used;
+	m_Unused = stats.unused;
+
+	ClearSummedVolumeTables();
+
+	if (m_Valid+m_Used+m_Unused+m_AirVoxel!=m_numLines[0]*m_numLines[1]*m_numLines[2])
+	{
+		cerr << "SAR_Calculation::CalcAveragedSAR: critical error, mismatch in voxel status count... EXIT" << endl;
+		exit(1);
+	}
+
+	if (m_DebugLevel>0)
+		cerr << "SAR_Calculation::CalcAveragedSAR: Stats: Valid=" << m_Valid << " Used=" << m_Used << " Unused=" << m_Unused << " Air-Voxel=" << m_AirVoxel << endl;
+
+	return SAR;
+}
+
+void SAR_Calculation::RunAveragedSARStep(SARAveragingStep step, float*** SAR, SARStats& stats)
+{
+	unsigned int reach = stats.reach;
+	unsigned int numThreads = max(1u, min(m_numThreads, m_numLines[0]));
+	vector<unsigned int> jobs = AssignJobs2Threads(m_numLines[0], numThreads, true);
+	vector<SARStats> job_stats(jobs.size());
+	for (size_t n=0; n<jobs.size(); ++n)
+	{
+		memset(&job_stats.at(n), 0, sizeof(SARStats));
+		job_stats.at(n).reach = reach;
+	}
+
+	boost::thread_group threads;
+	unsigned int start = 0;
+	for (size_t n=0; n<jobs.size()-1; ++n)
+	{
+		threads.create_thread(boost::bind(&SAR_Calculation::CalcAveragedSARJob, this, step, SAR, start, jobs.at(n), &job_stats.at(n)));
+		start += jobs.at(n);
+	}
+	CalcAveragedSARJob(step, SAR, start, jobs.back(), &job_stats.back());
+	threads.join_all();
+
+	memset(&stats, 0, sizeof(SARStats));
+	for (size_t n=0; n<jobs.size(); ++n)
+	{
+		stats.valid += job_stats.at(n).valid;
+		stats.used += job_stats.at(n).used;
+		stats.unused += job_stats.at(n).unused;
+		stats.air += job_stats.at(n).air;
+		stats.case1 += job_stats.at(n).case1;
+		stats.case2 += job_stats.at(n).case2;
+		stats.noConvergence += job_stats.at(n).noConvergence;
+		stats.reach = max(stats.reach, job_stats.at(n).reach);
+	}
+}
+
+void SAR_Calculation::CalcAveragedSARJob(SARAveragingStep step, float*** SAR, unsigned int xStart, unsigned int numX, SARStats* stats)
+{
+	unsigned int pos[3];
 	double voxel_volume;
 	double total_mass;
 	unsigned int start[3];
@@ -530,123 +707,120 @@ float*** SAR_Calculation::CalcAveragedSAR(float*** SAR)
 	double bg_ratio;
 	int EC=0;
 
-	// debug counter
-	unsigned int cnt_case1=0;
-	unsigned int cnt_case2=0;
-	unsigned int cnt_NoConvergence=0;
-
-	m_Valid=0;
-	m_Used=0;
-	m_Unused=0;
-	m_AirVoxel=0;
+	unsigned int xStop = xStart+numX;
+	unsigned int pos_start[3] = {xStart,0,0};
+	unsigned int pos_stop[3] = {xStop,m_numLines[1],m_numLines[2]};
+	if (step==ASSIGN_USED_VOXEL)
+	{
+		// all valid cubes reaching into the own x-lines
+		pos_start[0] = (xStart>stats->reach) ? xStart-stats->reach : 0;
+		pos_stop[0] = min(xStop+stats->reach, m_numLines[0]);
+	}
 
-	for (pos[0]=0; pos[0]<m_numLines[0]; ++pos[0])
+	for (pos[0]=pos_start[0]; pos[0]<pos_stop[0]; ++pos[0])
 	{
-		for (pos[1]=0; pos[1]<m_numLines[1]; ++pos[1])
+		for (pos[1]=pos_start[1]; pos[1]<pos_stop[1]; ++pos[1])
 		{
-			for (pos[2]=0; pos[2]<m_numLines[2]; ++pos[2])
+			for (pos[2]=pos_start[2]; pos[2]<pos_stop[2]; ++pos[2])
 			{
-				if (m_cell_density[pos[0]][pos[1]][pos[2]]==0)
+				if (step==FIND_VALID_CUBES)
 				{
 					SAR[pos[0]][pos[1]][pos[2]] = 0;
-					++m_AirVoxel;
-					continue;
-				}
+					if (m_cell_density[pos[0]][pos[1]][pos[2]]==0)
+					{
+						++stats->air;
+						continue;
+					}
 
-				// guess an initial box size and find a fitting cube
-				EC = FindFittingCubicalMass(pos, pow(m_avg_mass/m_cell_density[pos[0]][pos[1]][pos[2]],1.0/3.0)/2, start, stop,
-											partial_start, partial_stop, total_mass, voxel_volume, bg_ratio, -1, m_IgnoreFaceValid);
+					// guess an initial box size and find a fitting cube
+					EC = FindFittingCubicalMass(pos, pow(m_avg_mass/m_cell_density[pos[0]][pos[1]][pos[2]],1.0/3.0)/2, start, stop,
+												partial_start, partial_stop, total_mass, voxel_volume, bg_ratio, -1, m_IgnoreFaceValid);
 
-				if (EC==0)
-				{
-					m_Vx_Valid[pos[0]][pos[1]][pos[2]] = true;
-					m_Vx_Used[pos[0]][pos[1]][pos[2]] = true;
-					++m_Valid;
-					CalcCubicalSAR(SAR, pos, start, stop, partial_start, partial_stop, true);
+					if (EC==0)
+					{
+						m_Vx_Valid[pos[0]][pos[1]][pos[2]] = true;
+						m_Vx_Used[pos[0]][pos[1]][pos[2]] = true;
+						++stats->valid;
+						SAR[pos[0]][pos[1]][pos[2]] = CalcCubicalSAR(start, stop, partial_start, partial_stop);
+						for (int n=0;n<3;++n)
+							stats->reach = max(stats->reach, max(pos[n]-start[n], stop[n]-pos[n]));
+					}
+					else if (EC==1)
+						++stats->case1;
+					else if (EC==2)
+						++stats->case2;
+					else if (EC==-1)
+						++stats->noConvergence;
+					else
+						cerr << "other EC" << EC << endl;
 				}
-				else if (EC==1)
-					++cnt_case1;
-				else if (EC==2)
-					++cnt_case2;
-				else if (EC==-1)
-					++cnt_NoConvergence;
-				else
-					cerr << "other EC" << EC << endl;
-			}
-		}
-	}
-	if (cnt_NoConvergence>0)
-	{
-		cerr << "SAR_Calculation::CalcAveragedSAR: Warning, for some voxel a valid averaging cube could not be found (no convergence)... " << endl;
-	}
-	if (m_DebugLevel>0)
-	{
-		cerr << "Number of invalid cubes (case 1): " << cnt_case1 << endl;
-		cerr << "Number of invalid cubes (case 2): " << cnt_case2 << endl;
-		cerr << "Number of invalid cubes (failed to converge): " << cnt_NoConvergence << endl;
-	}
+				else if (step==ASSIGN_USED_VOXEL)
+				{
+					if (!m_Vx_Valid[pos[0]][pos[1]][pos[2]])
+						continue;
 
-	// count all used and unused etc. + special handling of unused voxels!!
-	m_Used=0;
-	m_Unused=0;
-	for (pos[0]=0;pos[0]<m_numLines[0];++pos[0])
-	{
-		for (pos[1]=0;pos[1]<m_numLines[1];++pos[1])
-		{
-			for (pos[2]=0;pos[2]<m_numLines[2];++pos[2])
-			{
-				if (!m_Vx_Valid[pos[0]][pos[1]][pos[2]] && m_Vx_Used[pos[0]][pos[1]][pos[2]])
-					++m_Used;
-				if ((m_cell_density[pos[0]][pos[1]][pos[2]]>0) && !m_Vx_Valid[pos[0]][pos[1]][pos[2]] && !m_Vx_Used[pos[0]][pos[1]][pos[2]])
+					// skip cubes without any not valid voxel in the own x-lines
+					unsigned int c_start[3];
+					unsigned int c_stop[3];
+					for (int n=0;n<3;++n)
+					{
+						c_start[n] = (pos[n]>stats->reach) ? pos[n]-stats->reach : 0;
+						c_stop[n] = min(pos[n]+stats->reach, m_numLines[n]-1);
+					}
+					c_start[0] = max(c_start[0], xStart);
+					c_stop[0] = min(c_stop[0], xStop-1);
+					if ((c_start[0]>c_stop[0]) || (GetBoxSum(m_SumCandidate, c_start, c_stop)==0))
+						continue;
+
+					// find the (same) valid cube again
+					FindFittingCubicalMass(pos, pow(m_avg_mass/m_cell_density[pos[0]][pos[1]][pos[2]],1.0/3.0)/2, start, stop,
+										   partial_start, partial_stop, total_mass, voxel_volume, bg_ratio, -1, m_IgnoreFaceValid);
+					AssignCubicalSAR(SAR, SAR[pos[0]][pos[1]][pos[2]], start, stop, partial_start, partial_stop, xStart, xStop);
+				}
+				else if (step==CALC_UNUSED_VOXEL)
 				{
-					++m_Unused;
+					if (!m_Vx_Valid[pos[0]][pos[1]][pos[2]] && m_Vx_Used[pos[0]][pos[1]][pos[2]])
+						++stats->used;
+					if ((m_cell_density[pos[0]][pos[1]][pos[2]]>0) && !m_Vx_Valid[pos[0]][pos[1]][pos[2]] && !m_Vx_Used[pos[0]][pos[1]][pos[2]])
+					{
+						++stats->unused;
 
-					SAR[pos[0]][pos[1]][pos[2]] = 0;
-					double unused_volumes[6];
-					float unused_SAR[6];
+						SAR[pos[0]][pos[1]][pos[2]] = 0;
+						double unused_volumes[6];
+						float unused_SAR[6];
 
-					double min_Vol=FLT_MAX;
+						double min_Vol=FLT_MAX;
 
-					// special handling of unused voxels:
-					for (int n=0;n<6;++n)
-					{
-						EC = FindFittingCubicalMass(pos, pow(m_avg_mass/m_cell_density[pos[0]][pos[1]][pos[2]],1.0/3.0)/2, start, stop,
-													partial_start, partial_stop, total_mass, unused_volumes[n], bg_ratio, n, true);
-						if ((EC!=0) && (EC!=2))
+						// special handling of unused voxels:
+						for (int n=0;n<6;++n)
 						{
-							// this should not happen
-							cerr << "SAR_Calculation::CalcAveragedSAR: Error handling unused voxels, can't find fitting cubical averaging volume' " << endl;
-							unused_SAR[n]=0;
+							EC = FindFittingCubicalMass(pos, pow(m_avg_mass/m_cell_density[pos[0]][pos[1]][pos[2]],1.0/3.0)/2, start, stop,
+														partial_start, partial_stop, total_mass, unused_volumes[n], bg_ratio, n, true);
+							if ((EC!=0) && (EC!=2))
+							{
+								// this should not happen
+								cerr << "SAR_Calculation::CalcAveragedSAR: Error handling unused voxels, can't find fitting cubical averaging volume' " << endl;
+								unused_SAR[n]=0;
+							}
+							else
+							{
+								unused_SAR[n]=CalcCubicalSAR(start, stop, partial_start, partial_stop);
+								min_Vol = min(min_Vol,unused_volumes[n]);
+							}
 						}
-						else
+						for (int n=0;n<6;++n)
 						{
-							unused_SAR[n]=CalcCubicalSAR(NULL, pos, start, stop, partial_start, partial_stop, false);
-							min_Vol = min(min_Vol,unused_volumes[n]);
+							if (unused_volumes[n]<=m_UnusedRelativeVolLimit*min_Vol)
+								SAR[pos[0]][pos[1]][pos[2]] = max(SAR[pos[0]][pos[1]][pos[2]],unused_SAR[n]);
 						}
 					}
-					for (int n=0;n<6;++n)
-					{
-						if (unused_volumes[n]<=m_UnusedRelativeVolLimit*min_Vol)
-							SAR[pos[0]][pos[1]][pos[2]] = max(SAR[pos[0]][pos[1]][pos[2]],unused_SAR[n]);
-					}
 				}
 			}
 		}
 	}
-
-	if (m_Valid+m_Used+m_Unused+m_AirVoxel!=m_numLines[0]*m_numLines[1]*m_numLines[2])
-	{
-		cerr << "SAR_Calculation::CalcAveragedSAR: critical error, mismatch in voxel status count... EXIT" << endl;
-		exit(1);
-	}
-
-	if (m_DebugLevel>0)
-		cerr << "SAR_Calculation::CalcAveragedSAR: Stats: Valid=" << m_Valid << " Used=" << m_Used << " Unused=" << m_Unused << " Air-Voxel=" << m_AirVoxel << endl;
-
-	return SAR;
 }
 
-double SAR_Calculation::CellVolume(unsigned int pos[3])
+double SAR_Calculation::CellVolume(unsigned int pos[3]) const
 {
 	if (m_cell_volume)
 		return m_cell_volume[pos[0]][pos[1]][pos[2]];
@@ -657,7 +831,7 @@ double SAR_Calculation::CellVolume(unsigned int pos[3])
 	return volume;
 }
 
-double SAR_Calculation::CellMass(unsigned int pos[3])
+double SAR_Calculation::CellMass(unsigned int pos[3]) const
 {
 	return m_cell_density[pos[0]][pos[1]][pos[2]]*CellVolume(pos);
 }
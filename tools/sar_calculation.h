@@ -19,6 +19,7 @@
 #define SAR_CALCULATION_H
 
 #include <complex>
+#include <vector>
 
 class SAR_Calculation
 {
@@ -33,6 +34,10 @@ public:
 	//! Set the debug level
 	void SetDebugLevel(int level) {m_DebugLevel=level;}
 
+	//! Set the number of threads used for the SAR averaging (default: number of cores)
+	void SetNumThreads(unsigned int n) {m_numThreads=n;}
+	unsigned int GetNumThreads() const {return m_numThreads;}
+
 	//! Set the used averaging method
 	void SetAveragingMethod(SARAveragingMethod method, bool silent=false);
 
@@ -61,7 +66,7 @@ public:
 	//! Set the current density field (mandatory if no conductivity distribution is given)
 	void SetJField(std::complex<float>**** field) {m_J_field=field;}
 
-	//! Calculate the SAR, requires a preallocated 3D array
+	//! Calculate the SAR, requires a preallocated 3D array. The averaging temporarily needs about 40 bytes per voxel for its summed-volume tables.
 	float*** CalcSAR(float*** SAR);
 
 	//! Calculate the total power dumped
@@ -87,6 +92,7 @@ protected:
 	unsigned int m_AirVoxel;
 
 	int m_DebugLevel;
+	unsigned int m_numThreads;
 
 	/*********** SAR calculation parameter and settings ***********/
 	float m_massTolerance;
@@ -97,7 +103,7 @@ protected:
 	bool m_IgnoreFaceValid;
 
 	/*********** SAR calculations methods ********/
-	double CalcLocalPowerDensity(unsigned int pos[3]);
+	double CalcLocalPowerDensity(unsigned int pos[3]) const;
 
 	//! Calculate the local SAR
 	float*** CalcLocalSAR(float*** SAR);
@@ -106,17 +112,64 @@ protected:
 	//! Calculate the averaged SAR
 	float*** CalcAveragedSAR(float*** SAR);
 
+	//! Voxel statistics of a SAR averaging job
+	struct SARStats
+	{
+		unsigned int valid, used, unused, air;
+		unsigned int case1, case2, noConvergence;
+		unsigned int reach; //!< max distance (in voxel) of a valid cube face to its center voxel
+	};
+	enum SARAveragingStep { FIND_VALID_CUBES, ASSIGN_USED_VOXEL, CALC_UNUSED_VOXEL };
+	//! Run the given averaging step for all voxels of the x-lines xStart..xStart+numX-1
+	void CalcAveragedSARJob(SARAveragingStep step, float*** SAR, unsigned int xStart, unsigned int numX, SARStats* stats);
+	//! Run the given averaging step for all x-lines, distributed over all threads.
+	void RunAveragedSARStep(SARAveragingStep step, float*** SAR, SARStats& stats);
+
+	//! Summed-volume table, the sum over all cells below index i,j,k is at SumIndex(i,j,k)
+	/*!
+	  The cell values are stored as fixed-point integers, thus all cubical sums are exact and e.g. adding background cells does not change the mass.
+	  */
+	struct SummedVolumeTable
+	{
+		std::vector<unsigned long long> sum;
+		double scale; //!< scaling of the cell values to the fixed-point integers
+	};
+	/*!
+	  Summed-volume tables of the cell mass, volume, background (air) volume and power, to calculate any cubical sum in O(1).
+	  The material count is the number of non-background cells, the candidate count the number of not valid non-background cells.
+	  All tables together need about 40 bytes per voxel (4x 8 byte sums and 2x 4 byte counts), in addition to the input fields.
+	  */
+	SummedVolumeTable m_SumMass;
+	SummedVolumeTable m_SumVolume;
+	SummedVolumeTable m_SumBGVolume;
+	SummedVolumeTable m_SumPower;
+	std::vector<unsigned int> m_SumMaterial;
+	std::vector<unsigned int> m_SumCandidate;
+
+	size_t SumIndex(unsigned int i, unsigned int j, unsigned int k) const {return ((size_t)i*(m_numLines[1]+1)+j)*(m_numLines[2]+1)+k;}
+	//! Create the summed-volume tables (except for the candidate count), about 36 bytes per voxel
+	void CalcSummedVolumeTables();
+	//! Sum up a table which contains the cell values at SumIndex(i+1,j+1,k+1)
+	template <typename T> void SumUpTable(std::vector<T>& table) const;
+	//! Get the sum over all cells from \a start to \a stop (including).
+	template <typename T> T GetBoxSum(const std::vector<T>& table, const unsigned int start[3], const unsigned int stop[3]) const;
+	//! Get the sum over all cells from \a start to \a stop (including), weighted with the partial start and stop cells.
+	double GetPartialBoxSum(const SummedVolumeTable& table, const unsigned int start[3], const unsigned int stop[3], const float partial_start[3], const float partial_stop[3]) const;
+	void ClearSummedVolumeTables();
+
 	int FindFittingCubicalMass(unsigned int pos[3], float box_size, unsigned int start[3], unsigned int stop[3],
-						float partial_start[3], float partial_stop[3], double &mass, double &volume, double &bg_ratio, int disabledFace=-1, bool ignoreFaceValid=false);
+						float partial_start[3], float partial_stop[3], double &mass, double &volume, double &bg_ratio, int disabledFace=-1, bool ignoreFaceValid=false) const;
 	bool GetCubicalMass(unsigned int pos[3], double box_size, unsigned int start[3], unsigned int stop[3],
-						float partial_start[3], float partial_stop[3], double &mass, double &volume, double &bg_ratio, int disabledFace=-1);
+						float partial_start[3], float partial_stop[3], double &mass, double &volume, double &bg_ratio, int disabledFace=-1) const;
 
-	float CalcCubicalSAR(float*** SAR, unsigned int pos[3], unsigned int start[3], unsigned int stop[3], float partial_start[3], float partial_stop[3], bool assignUsed=false);
+	float CalcCubicalSAR(unsigned int start[3], unsigned int stop[3], float partial_start[3], float partial_stop[3]) const;
+	//! Assign the cubical SAR to all used (not valid) voxel of the cube within the x-lines xStart..xStop-1
+	void AssignCubicalSAR(float*** SAR, float vx_SAR, unsigned int start[3], unsigned int stop[3], float partial_start[3], float partial_stop[3], unsigned int xStart, unsigned int xStop);
 	/****** end SAR averaging and all necessary methods ********/
 
 	bool CheckValid();
-	double CellVolume(unsigned int pos[3]);
-	double CellMass(unsigned int pos[3]);
+	double CellVolume(unsigned int pos[3]) const;
+	double CellMass(unsigned int pos[3]) const;
 };
 
 #endif // SAR_CALCULATION_H
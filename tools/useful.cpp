@@ -74,6 +74,19 @@ std::vector<unsigned int> AssignJobs2Threads(unsigned int jobs, unsigned int nrT
 	return jpt;
 }
 
+unsigned int GetCPUVectorWidth()
+{
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+	// also checks that the OS saves the extended register state
+	__builtin_cpu_init();
+	if (__builtin_cpu_supports("avx512f"))
+		return 16;
+	if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma"))
+		return 8;
+#endif
+	return 4;
+}
+
 std::vector<float> SplitString2Float(std::string str, std::string delimiter)
 {
 	std::vector<float> v_f;
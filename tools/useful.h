@@ -30,6 +30,9 @@ double CalcNyquistFrequency(unsigned int nyquist, double dT);
 //! Calculate an optimal job distribution to a given number of threads. Will return a vector with the jobs for each thread.
 std::vector<unsigned int> AssignJobs2Threads(unsigned int jobs, unsigned int nrThreads, bool RemoveEmpty=false);
 
+//! Get the widest single float vector supported by this CPU at runtime. Returns the number of floats per vector (4: SSE, 8: AVX2+FMA, 16: AVX-512F)
+unsigned int GetCPUVectorWidth();
+
 std::vector<float> SplitString2Float(std::string str, std::string delimiter=",");
 std::vector<double> SplitString2Double(std::string str, std::string delimiter=",");
 